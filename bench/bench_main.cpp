@@ -0,0 +1,1158 @@
+// Performance regression suite. Generates synthetic buildings of several
+// sizes and times the hot paths a site deployment depends on: full and
+// incremental exit-field recompute, contingency tables, criticality analysis, evacuation planning, district exchange rounds,
+// batched guidance,
+// versioned edge costs, guidance feed fan-out, crowd ticks, level-of-detail crowd ticks on towers, sensor ingestion, occupancy fusion, exit signage, the
+// device gateway, cold model load and standby checkpoints. Results go to bench_output.txt as one JSON
+// object per line:
+//
+//   {"bench":"route_repair","building":"f20_r80_s3","nodes":2063,"arcs":4244,
+//    "param":"flips=8","metric":"median_us","value":41.7}
+//
+// Seeds are fixed, so two runs on the same machine measure the same work.
+//
+//   bench [--quick] [--out path] [--only name[,name...]]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "analysis/criticality.hpp"
+#include "checkpoint/checkpoint_writer.hpp"
+#include "checkpoint/mapped_checkpoint.hpp"
+#include "crowd/agents.hpp"
+#include "crowd/crowd_sim.hpp"
+#include "crowd/hybrid_crowd.hpp"
+#include "district/district.hpp"
+#include "district/region_partition.hpp"
+#include "exec/epoch_domain.hpp"
+#include "exec/work_stealing_pool.hpp"
+#include "gateway/gateway_server.hpp"
+#include "gateway/modbus.hpp"
+#include "gateway/mqtt.hpp"
+#include "ingest/ingest_pipeline.hpp"
+#include "ingest/occupancy_fusion.hpp"
+#include "model/mapped_model.hpp"
+#include "net/event_loop.hpp"
+#include "net/guidance_server.hpp"
+#include "net/guidance_wire.hpp"
+#include "planner/flow_planner.hpp"
+#include "routing/contingency_tables.hpp"
+#include "routing/cost_policy.hpp"
+#include "routing/edge_cost_versions.hpp"
+#include "routing/exit_field.hpp"
+#include "routing/guidance_snapshot.hpp"
+#include "routing/incremental_router.hpp"
+#include "routing/overlay_router.hpp"
+#include "signage/signage_controller.hpp"
+#include "synth/synthetic_building.hpp"
+#include "util/rng.hpp"
+
+namespace {
+
+// Every heap allocation in the process, so the suite can check that the
+// steady state of a tick or query allocates nothing.
+std::atomic<std::uint64_t> g_allocations{0};
+
+}  // namespace
+
+// The replacements pair malloc with free; GCC cannot see that they match.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(std::size_t bytes) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(bytes ? bytes : 1)) return p;
+  throw std::bad_alloc();
+}
+void* operator new(std::size_t bytes, std::align_val_t align) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  const auto a = static_cast<std::size_t>(align);
+  if (void* p = std::aligned_alloc(a, (bytes + a - 1) / a * a)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+using namespace evac;
+using Clock = std::chrono::steady_clock;
+
+std::uint64_t allocations() { return g_allocations.load(std::memory_order_relaxed); }
+
+struct Result {
+  std::string bench;
+  std::string building;
+  std::size_t nodes;
+  std::size_t arcs;
+  std::string param;
+  std::string metric;
+  double value;
+};
+
+class Report {
+ public:
+  void add(const std::string& bench, const SyntheticSpec& spec, const BuildingGraph& g,
+           const std::string& param, const std::string& metric, double value) {
+    results_.push_back({bench, spec.tag(), g.node_count(), g.edge_count(), param, metric, value});
+    std::printf("%-14s %-14s %-14s %-14s %14.3f\n", bench.c_str(), spec.tag().c_str(), param.c_str(),
+                metric.c_str(), value);
+    std::fflush(stdout);
+  }
+
+  bool write(const std::string& path) const {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    for (const Result& r : results_) {
+      std::fprintf(f,
+                   "{\"bench\":\"%s\",\"building\":\"%s\",\"nodes\":%zu,\"arcs\":%zu,\"param\":\"%s\","
+                   "\"metric\":\"%s\",\"value\":%.4f}\n",
+                   r.bench.c_str(), r.building.c_str(), r.nodes, r.arcs, r.param.c_str(), r.metric.c_str(),
+                   r.value);
+    }
+    return std::fclose(f) == 0;
+  }
+
+ private:
+  std::vector<Result> results_;
+};
+
+// Wall time of `reps` calls of fn in microseconds, sorted ascending.
+std::vector<double> time_us(std::size_t reps, const std::function<void()>& fn) {
+  std::vector<double> samples(reps);
+  for (double& s : samples) {
+    const auto t0 = Clock::now();
+    fn();
+    s = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+  }
+  std::sort(samples.begin(), samples.end());
+  return samples;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  const auto i = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+  return sorted[i];
+}
+
+void bench_route_full(Report& report, const SyntheticSpec& spec, const BuildingGraph& g, bool quick) {
+  ExitField field;
+  solve_exit_field(g, field);  // warm the field and the thread's arena
+  const std::size_t reps = quick ? 5 : 21;
+  const auto samples = time_us(reps, [&] { solve_exit_field(g, field); });
+  const std::uint64_t before = allocations();
+  for (std::size_t i = 0; i < reps; ++i) solve_exit_field(g, field);
+  const double allocs = static_cast<double>(allocations() - before) / reps;
+  report.add("route_full", spec, g, "-", "median_us", percentile(samples, 0.5));
+  report.add("route_full", spec, g, "-", "allocs_per_query", allocs);
+
+  // The other cost models, each through its own specialised solver.
+  const auto time_model = [&](auto policy) {
+    using Policy = decltype(policy);
+    solve_exit_field<Policy>(g, field, scratch_arena());
+    const auto model_samples = time_us(reps, [&] { solve_exit_field<Policy>(g, field, scratch_arena()); });
+    const std::string param = std::string("cost=") + to_string(Policy::kModel);
+    report.add("route_full", spec, g, param, "median_us", percentile(model_samples, 0.5));
+  };
+  time_model(DistanceCost{});
+  time_model(AccessibleCost{});
+
+  // Same search on the radix heap; its distances must match the binary heap's.
+  ExitField radix;
+  solve_exit_field<SmokeCost, RadixHeapQueue>(g, radix, scratch_arena());
+  const auto radix_samples =
+      time_us(reps, [&] { solve_exit_field<SmokeCost, RadixHeapQueue>(g, radix, scratch_arena()); });
+  const std::uint64_t radix_before = allocations();
+  for (std::size_t i = 0; i < reps; ++i) solve_exit_field<SmokeCost, RadixHeapQueue>(g, radix, scratch_arena());
+  const double radix_allocs = static_cast<double>(allocations() - radix_before) / reps;
+  solve_exit_field(g, field);
+  std::size_t mismatches = 0;
+  for (std::size_t v = 0; v < field.distance.size(); ++v) mismatches += radix.distance[v] != field.distance[v];
+  report.add("route_full", spec, g, "queue=radix", "median_us", percentile(radix_samples, 0.5));
+  report.add("route_full", spec, g, "queue=radix", "allocs_per_query", radix_allocs);
+  report.add("route_full", spec, g, "queue=radix", "distance_mismatches", static_cast<double>(mismatches));
+}
+
+// Random connections flip between clear and heavily smoked; each repair
+// recomputes only what the flips affect.
+void bench_route_repair(Report& report, const SyntheticSpec& spec, BuildingGraph& g, bool quick) {
+  IncrementalRouter router(g);
+  for (const std::size_t flips : {std::size_t{1}, std::size_t{8}, std::size_t{64}}) {
+    SplitMix64 rng(spec.seed * 31 + flips);
+    const auto samples = time_us(quick ? 20 : 200, [&] {
+      for (std::size_t k = 0; k < flips; ++k) {
+        const EdgeId e = rng.below(static_cast<std::uint32_t>(g.edge_count()));
+        const float h = rng.below(2) ? 0.9f : 0.0f;
+        router.set_edge_hazard(e, h);
+        if (g.edge_twin(e) != kInvalidEdge) router.set_edge_hazard(g.edge_twin(e), h);
+      }
+      router.repair();
+    });
+    const std::string param = "flips=" + std::to_string(flips);
+    report.add("route_repair", spec, g, param, "median_us", percentile(samples, 0.5));
+    report.add("route_repair", spec, g, param, "p95_us", percentile(samples, 0.95));
+  }
+  for (EdgeId e = 0; e < g.edge_count(); ++e) router.set_edge_hazard(e, 0.0f);
+  router.repair();
+}
+
+// The 16 most loaded connections and nodes, each closed on the clear
+// building: tables built offline on the pool, then for every blockage the
+// O(1) table match and a repair started from the matching table, against a
+// plain repair of the same closure. The result must equal a full solve.
+void bench_contingency(Report& report, const SyntheticSpec& spec, BuildingGraph& g, WorkStealingPool& pool,
+                       bool quick) {
+  constexpr std::size_t kTables = 16;
+  const auto t0 = Clock::now();
+  const ContingencyTables tables =
+      ContingencyTables::from_build(g, build_contingency_tables(g, rank_contingencies(g, kTables), pool));
+  const double build_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  const std::string param = "k=" + std::to_string(tables.size());
+  report.add("contingency", spec, g, param, "build_ms_per_table", build_ms / static_cast<double>(tables.size()));
+  report.add("contingency", spec, g, param, "table_bytes",
+             static_cast<double>(tables.size() * g.node_count() * (sizeof(EdgeId) + sizeof(Cost))));
+
+  IncrementalRouter router(g);
+  std::vector<EdgeId> arcs;
+  std::vector<double> plain_us;
+  std::vector<double> table_us;
+  std::vector<double> match_ns;
+  std::size_t mismatches = 0;
+  std::size_t refined_hops = 0;
+  ExitField exact;
+  ExitField got;
+  const auto set_arcs = [&](float h) {
+    for (EdgeId e : arcs) router.set_edge_hazard(e, h);
+  };
+  for (std::size_t rep = 0; rep < (quick ? 1u : 5u); ++rep) {
+    for (std::uint32_t i = 0; i < tables.size(); ++i) {
+      const ContingencyEntry& c = tables.entry(i);
+      contingency_arcs(g, c, arcs);
+      set_arcs(kImpassableHazard);
+      plain_us.push_back(time_us(1, [&] { router.repair(); })[0]);
+      set_arcs(0.0f);
+      router.repair();
+
+      set_arcs(kImpassableHazard);
+      std::uint32_t match = ContingencyTables::kNone;
+      const auto m0 = Clock::now();
+      for (int k = 0; k < 1000; ++k) {
+        match = c.kind == static_cast<std::uint32_t>(ContingencyKind::Connection) ? tables.match_connection(arcs[0])
+                                                                                  : tables.match_node(c.element);
+      }
+      match_ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - m0).count() / 1000.0);
+      if (match != i) std::abort();
+      table_us.push_back(time_us(1, [&] { router.repair_from(tables.distances(i), tables.next_edges(i)); })[0]);
+      if (rep == 0) {
+        const std::span<const EdgeId> row = tables.next_edges(i);
+        for (NodeId v = 0; v < g.node_count(); ++v) refined_hops += router.next_edge(v) != row[v];
+        solve_exit_field(g, exact);
+        router.export_field(got);
+        for (NodeId v = 0; v < g.node_count(); ++v) mismatches += got.distance[v] != exact.distance[v];
+      }
+      set_arcs(0.0f);
+      router.repair();
+    }
+  }
+  std::sort(plain_us.begin(), plain_us.end());
+  std::sort(table_us.begin(), table_us.end());
+  std::sort(match_ns.begin(), match_ns.end());
+  report.add("contingency", spec, g, param, "match_ns", percentile(match_ns, 0.5));
+  report.add("contingency", spec, g, param, "repair_median_us", percentile(plain_us, 0.5));
+  report.add("contingency", spec, g, param, "from_table_median_us", percentile(table_us, 0.5));
+  report.add("contingency", spec, g, param, "refined_next_hops", static_cast<double>(refined_hops));
+  report.add("contingency", spec, g, param, "distance_mismatches", static_cast<double>(mismatches));
+}
+
+// Offline criticality analysis: sampled Brandes betweenness on the pool at two
+// sample counts, with the rank agreement of the top 20 connections against the
+// larger sample, and the site exit min cut.
+void bench_criticality(Report& report, const SyntheticSpec& spec, const BuildingGraph& g, WorkStealingPool& pool,
+                       bool quick) {
+  const std::size_t reps = quick ? 1 : 3;
+  std::vector<std::vector<ConnectionLoad>> ranked;
+  for (const std::size_t samples : {std::size_t{64}, std::size_t{256}}) {
+    std::vector<float> betweenness;
+    const auto samples_us =
+        time_us(reps, [&] { betweenness = sampled_edge_betweenness(g, {samples, 1}, pool); });
+    const std::string param = "samples=" + std::to_string(samples);
+    report.add("criticality", spec, g, param, "median_ms", percentile(samples_us, 0.5) / 1000.0);
+    report.add("criticality", spec, g, param, "us_per_source",
+               percentile(samples_us, 0.5) / static_cast<double>(std::min(samples, g.node_count())));
+    ranked.push_back(rank_connections(g, betweenness));
+  }
+  constexpr std::size_t kTop = 20;
+  std::size_t shared = 0;
+  for (std::size_t i = 0; i < kTop && i < ranked[0].size(); ++i) {
+    for (std::size_t j = 0; j < kTop && j < ranked[1].size(); ++j) shared += ranked[0][i].edge == ranked[1][j].edge;
+  }
+  report.add("criticality", spec, g, "samples=64", "top20_shared", static_cast<double>(shared));
+
+  ExitCut cut;
+  const auto cut_us = time_us(reps, [&] { cut = exit_min_cut(g); });
+  report.add("criticality", spec, g, "cut=site", "median_ms", percentile(cut_us, 0.5) / 1000.0);
+  report.add("criticality", spec, g, "cut=site", "capacity_pps", cut.capacity_pps);
+  report.add("criticality", spec, g, "cut=site", "cut_arcs", static_cast<double>(cut.arcs.size()));
+}
+
+// Same flips through the floor-overlay router: a repair re-customises the
+// touched floors and the overlay, then one query derives its floor's field.
+void bench_route_overlay(Report& report, const SyntheticSpec& spec, BuildingGraph& g, bool quick) {
+  OverlayRouter router(g);
+  report.add("route_overlay", spec, g, "-", "portals", static_cast<double>(router.portal_count()));
+  for (const std::size_t flips : {std::size_t{1}, std::size_t{8}, std::size_t{64}}) {
+    SplitMix64 rng(spec.seed * 31 + flips);
+    const auto samples = time_us(quick ? 20 : 200, [&] {
+      for (std::size_t k = 0; k < flips; ++k) {
+        const EdgeId e = rng.below(static_cast<std::uint32_t>(g.edge_count()));
+        const float h = rng.below(2) ? 0.9f : 0.0f;
+        router.set_edge_hazard(e, h);
+        if (g.edge_twin(e) != kInvalidEdge) router.set_edge_hazard(g.edge_twin(e), h);
+      }
+      router.repair();
+      router.distance(rng.below(static_cast<std::uint32_t>(g.node_count())));
+    });
+    const std::string param = "flips=" + std::to_string(flips);
+    report.add("route_overlay", spec, g, param, "median_us", percentile(samples, 0.5));
+    report.add("route_overlay", spec, g, param, "p95_us", percentile(samples, 0.95));
+  }
+  for (EdgeId e = 0; e < g.edge_count(); ++e) router.set_edge_hazard(e, 0.0f);
+  router.repair();
+}
+
+// The same flips on a partitioned site: the owning regions re-customise and
+// broadcast, every region re-solves the boundary overlay, and the assembled
+// field must equal a site-wide solve after that one round.
+void bench_district(Report& report, const SyntheticSpec& spec, BuildingGraph& g, WorkStealingPool& pool,
+                    bool quick) {
+  ExitField assembled;
+  ExitField reference;
+  for (const std::uint32_t regions : {4u, 16u}) {
+    PartitionParams params;
+    params.regions = regions;
+    const auto t0 = Clock::now();
+    RegionPartition partition = partition_building(g, params);
+    const double partition_us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+    const std::string param = "regions=" + std::to_string(partition.regions);
+    report.add("district", spec, g, param, "partition_us", partition_us);
+    report.add("district", spec, g, param, "cut_arcs", static_cast<double>(partition.cut_arcs.size()));
+    District district(g, std::move(partition), pool);
+    district.exchange();
+
+    SplitMix64 rng(spec.seed * 37 + regions);
+    std::size_t label_bytes = 0;
+    std::size_t rounds = 0;
+    std::size_t mismatched = 0;
+    const auto samples = time_us(quick ? 20 : 200, [&] {
+      for (std::size_t k = 0; k < 8; ++k) {
+        const EdgeId e = rng.below(static_cast<std::uint32_t>(g.edge_count()));
+        const float h = rng.below(2) ? 0.9f : 0.0f;
+        g.set_edge_hazard(e, h);
+        district.set_edge_hazard(e, h);
+      }
+      label_bytes += district.exchange().label_bytes;
+      ++rounds;
+    });
+    district.export_field(assembled);
+    solve_exit_field(g, reference);
+    for (std::size_t v = 0; v < g.node_count(); ++v) mismatched += assembled.distance[v] != reference.distance[v];
+    report.add("district", spec, g, param, "round_median_us", percentile(samples, 0.5));
+    report.add("district", spec, g, param, "round_p95_us", percentile(samples, 0.95));
+    report.add("district", spec, g, param, "label_bytes_per_round", static_cast<double>(label_bytes) / rounds);
+    report.add("district", spec, g, param, "mismatched_nodes", static_cast<double>(mismatched));
+    for (EdgeId e = 0; e < g.edge_count(); ++e) g.set_edge_hazard(e, 0.0f);
+  }
+}
+
+// A poll wave of app requests: answer N random origins with one batched
+// sweep, versus building the full snapshot once and serving them as table
+// lookups (what request threads do between repairs).
+void bench_guidance(Report& report, const SyntheticSpec& spec, const BuildingGraph& g, bool quick) {
+  SplitMix64 rng(spec.seed * 17);
+  std::vector<NodeId> origins(30000);
+  for (NodeId& v : origins) v = rng.below(static_cast<std::uint32_t>(g.node_count()));
+  std::vector<GuidanceAnswer> answers(origins.size());
+  Arena scratch;
+  const std::size_t reps = quick ? 5 : 21;
+  for (const std::size_t batch : {std::size_t{1}, std::size_t{100}, origins.size()}) {
+    const std::span<const NodeId> some(origins.data(), batch);
+    answer_batch(g, some, answers, scratch);
+    const auto samples = time_us(reps, [&] { answer_batch(g, some, answers, scratch); });
+    report.add("guidance", spec, g, "batch=" + std::to_string(batch), "sweep_us", percentile(samples, 0.5));
+  }
+  {
+    const std::span<const NodeId> some(origins.data(), 100);
+    answer_batch<AccessibleCost>(g, some, answers, scratch);
+    const auto samples = time_us(reps, [&] { answer_batch<AccessibleCost>(g, some, answers, scratch); });
+    report.add("guidance", spec, g, "batch=100,cost=accessible", "sweep_us", percentile(samples, 0.5));
+  }
+
+  ExitField field;
+  solve_exit_field(g, field);
+  std::uint64_t version = 0;
+  const auto build = time_us(reps, [&] {
+    GuidanceSnapshot snapshot(g, field.distance, field.next_edge, ++version);
+  });
+  report.add("guidance", spec, g, "-", "snapshot_build_us", percentile(build, 0.5));
+  GuidancePublisher publisher;
+  publisher.publish(std::make_shared<const GuidanceSnapshot>(g, field.distance, field.next_edge, ++version));
+  const auto lookup = time_us(reps, [&] { publisher.current()->answer(origins, answers); });
+  report.add("guidance", spec, g, "batch=" + std::to_string(origins.size()), "lookup_us",
+             percentile(lookup, 0.5));
+}
+
+// Quickest-evacuation plan with every room full: plan time, how many
+// occupants it gets out and how many batches (searches) it took. The tallest
+// building is left out; its 960k occupants need more than the planner's
+// 65536-layer horizon.
+void bench_planner(Report& report, const SyntheticSpec& spec, const BuildingGraph& g) {
+  if (spec.floors > 20) return;
+  std::vector<OccupantGroup> occupants;
+  for (NodeId v = 0; v < g.node_count(); ++v) {
+    if (g.node_kind(v) == NodeKind::Room) occupants.push_back({v, g.node_capacity(v)});
+  }
+  for (const bool contraflow : {false, true}) {
+    PlannerOptions options;
+    options.contraflow = contraflow;
+    const auto t0 = Clock::now();
+    FlowPlanner planner(g, options);
+    const EvacuationPlan plan = planner.plan(occupants);
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    const std::string param = contraflow ? "contraflow" : "-";
+    report.add("planner", spec, g, param, "plan_ms", ms);
+    report.add("planner", spec, g, param, "evacuated", static_cast<double>(plan.evacuated));
+    report.add("planner", spec, g, param, "stranded", static_cast<double>(plan.stranded));
+    report.add("planner", spec, g, param, "batches", static_cast<double>(plan.routes.size()));
+    report.add("planner", spec, g, param, "egress_s", plan.egress_seconds());
+  }
+}
+
+// Versioned costs under load: reader threads pin an epoch and sum random arc
+// costs while the router repairs 8-arc hazard changes back to back, each
+// repair publishing a cost version. Reports the repair-plus-publish latency,
+// the chunks a version clones, and the read rate sustained alongside it.
+void bench_cost_versions(Report& report, const SyntheticSpec& spec, BuildingGraph& g, bool quick) {
+  IncrementalRouter router(g);
+  EpochDomain domain;
+  EdgeCostVersions versions(g, domain);
+  router.publish_costs(&versions);
+  const std::size_t reader_threads = 2;
+  std::atomic<bool> running{true};
+  std::atomic<std::uint64_t> reads{0};
+  std::atomic<std::uint64_t> checksum{0};  // keeps the reads observable
+  std::vector<std::thread> readers;
+  for (std::size_t r = 0; r < reader_threads; ++r) {
+    readers.emplace_back([&, r] {
+      EpochDomain::Reader reader(domain);
+      SplitMix64 rng(spec.seed * 13 + r);
+      std::uint64_t done = 0;
+      Cost sink = 0;
+      while (running.load(std::memory_order_relaxed)) {
+        const auto pin = reader.pin();
+        const CostVersion& costs = versions.current();
+        const auto m = static_cast<std::uint32_t>(costs.edge_count());
+        for (int k = 0; k < 64; ++k) sink += costs.cost(rng.below(m));
+        ++done;
+      }
+      reads.fetch_add(done, std::memory_order_relaxed);
+      checksum.fetch_add(sink, std::memory_order_relaxed);
+    });
+  }
+
+  // Repairs for a fixed wall time so the readers get scheduled even on a
+  // single core; the writer yields between versions.
+  SplitMix64 rng(spec.seed * 29);
+  std::vector<double> samples;
+  double cloned = 0.0;
+  const auto window = std::chrono::milliseconds(quick ? 50 : 250);
+  const auto t0 = Clock::now();
+  while (Clock::now() - t0 < window) {
+    const auto p0 = Clock::now();
+    for (int k = 0; k < 8; ++k) {
+      router.set_edge_hazard(rng.below(static_cast<std::uint32_t>(g.edge_count())), rng.below(2) ? 0.9f : 0.0f);
+    }
+    router.repair();
+    samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - p0).count());
+    cloned += static_cast<double>(versions.last_cloned_chunks());
+    std::this_thread::yield();
+  }
+  running.store(false, std::memory_order_relaxed);
+  for (std::thread& t : readers) t.join();
+  const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+  std::sort(samples.begin(), samples.end());
+  versions.reclaim();
+  report.add("cost_versions", spec, g, "flips=8", "repair_publish_median_us", percentile(samples, 0.5));
+  report.add("cost_versions", spec, g, "flips=8", "repair_publish_p95_us", percentile(samples, 0.95));
+  report.add("cost_versions", spec, g, "flips=8", "cloned_chunks_mean",
+             samples.empty() ? 0.0 : cloned / static_cast<double>(samples.size()));
+  report.add("cost_versions", spec, g, "-", "chunks", static_cast<double>(versions.chunk_count()));
+  report.add("cost_versions", spec, g, "readers=2", "pinned_reads_per_s",
+             secs > 0.0 ? static_cast<double>(reads.load()) / secs : 0.0);
+  report.add("cost_versions", spec, g, "-", "versions", static_cast<double>(versions.current().version()));
+  report.add("cost_versions", spec, g, "-", "retired_after", static_cast<double>(versions.retired_count()));
+  router.publish_costs(nullptr);
+  for (EdgeId e = 0; e < g.edge_count(); ++e) router.set_edge_hazard(e, 0.0f);
+  router.repair();
+}
+
+// Guidance feed fan-out: loopback subscribers keep replicas while this
+// thread plays the router, publishing versions with 8 arc flips each.
+// Reports the router's share of a version (repair, snapshot, publish,
+// notify), the time until every replica holds it and the bytes per client
+// per version. Every replica must end identical to the last snapshot.
+void bench_guidance_feed(Report& report, const SyntheticSpec& spec, BuildingGraph& g, bool quick) {
+  struct Subscriber {
+    int fd;
+    GuidanceReplica replica;
+  };
+  const std::size_t client_count = quick ? 100 : 500;
+  IncrementalRouter router(g);
+  GuidancePublisher publisher;
+  std::uint64_t version = 0;
+  auto snapshot = std::make_shared<const GuidanceSnapshot>(g, router.distances(), router.next_edges(), ++version);
+  publisher.publish(snapshot);
+  GuidanceServer server(publisher, 0);
+
+  std::vector<Subscriber> subs(client_count);
+  std::vector<pollfd> fds(client_count);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(server.port());
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const std::uint64_t hello = 0;
+  for (std::size_t i = 0; i < client_count; ++i) {
+    subs[i].fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (::connect(subs[i].fd, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0 ||
+        ::send(subs[i].fd, &hello, sizeof hello, MSG_NOSIGNAL) != sizeof hello) {
+      std::abort();
+    }
+    fds[i] = {subs[i].fd, POLLIN, 0};
+  }
+  // Reads until every replica holds `target`.
+  std::vector<std::byte> buf(1 << 16);
+  const auto pump = [&](std::uint64_t target) {
+    for (;;) {
+      bool current = true;
+      for (const Subscriber& s : subs) current = current && s.replica.version() == target;
+      if (current) return;
+      if (::poll(fds.data(), fds.size(), 5000) <= 0) std::abort();
+      for (std::size_t i = 0; i < client_count; ++i) {
+        if (!(fds[i].revents & POLLIN)) continue;
+        const ssize_t n = ::recv(subs[i].fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (n <= 0 || subs[i].replica.feed(std::span(buf.data(), static_cast<std::size_t>(n))) != WireStatus::Ok) {
+          std::abort();
+        }
+      }
+    }
+  };
+  const auto s0 = Clock::now();
+  pump(version);
+  const double initial_ms = std::chrono::duration<double, std::milli>(Clock::now() - s0).count();
+  const std::uint64_t initial_bytes = server.counters().bytes_sent;
+
+  SplitMix64 rng(spec.seed * 31);
+  const std::size_t versions = quick ? 10 : 40;
+  std::vector<double> router_us, fanout_us;
+  for (std::size_t k = 0; k < versions; ++k) {
+    const auto t0 = Clock::now();
+    for (int f = 0; f < 8; ++f) {
+      router.set_edge_hazard(rng.below(static_cast<std::uint32_t>(g.edge_count())), rng.below(2) ? 0.9f : 0.0f);
+    }
+    router.repair();
+    snapshot = std::make_shared<const GuidanceSnapshot>(g, router.distances(), router.next_edges(), ++version);
+    publisher.publish(snapshot);
+    server.notify();
+    const auto t1 = Clock::now();
+    pump(version);
+    router_us.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+    fanout_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t1).count());
+  }
+  for (const Subscriber& s : subs) {
+    if (!std::equal(s.replica.next_hops().begin(), s.replica.next_hops().end(), snapshot->next_hops().begin()) ||
+        !std::equal(s.replica.distances().begin(), s.replica.distances().end(), snapshot->distances().begin()) ||
+        !std::equal(s.replica.hazards().begin(), s.replica.hazards().end(), snapshot->hazards().begin())) {
+      std::abort();
+    }
+    ::close(s.fd);
+  }
+  std::sort(router_us.begin(), router_us.end());
+  std::sort(fanout_us.begin(), fanout_us.end());
+  const GuidanceServerCounters c = server.counters();
+  const std::string param = "clients=" + std::to_string(client_count);
+  report.add("guidance_feed", spec, g, param, "initial_sync_ms", initial_ms);
+  report.add("guidance_feed", spec, g, param, "router_median_us", percentile(router_us, 0.5));
+  report.add("guidance_feed", spec, g, param, "fanout_median_us", percentile(fanout_us, 0.5));
+  report.add("guidance_feed", spec, g, param, "fanout_p95_us", percentile(fanout_us, 0.95));
+  report.add("guidance_feed", spec, g, param, "delta_bytes_per_client",
+             static_cast<double>(c.bytes_sent - initial_bytes) / static_cast<double>(versions * client_count));
+  report.add("guidance_feed", spec, g, param, "full_frame_bytes",
+             static_cast<double>(sizeof(WireHeader) + full_frame_header(*snapshot).payload_bytes));
+}
+
+void bench_crowd(Report& report, const SyntheticSpec& spec, BuildingGraph& g, WorkStealingPool& pool,
+                 bool quick) {
+  IncrementalRouter router(g);
+  for (const std::size_t count : {std::size_t{1000}, std::size_t{10000}, std::size_t{50000}}) {
+    if (quick && count > 10000) break;
+    AgentPopulation agents;
+    spawn_agents(g, count, spec.seed, agents);
+    CrowdSimulator sim(g, pool, CrowdParams{});
+    sim.set_next_edges(router.next_edges());
+    for (int i = 0; i < 5; ++i) sim.step(agents);  // warm the grid and scratch
+    const std::size_t ticks = quick ? 20 : 100;
+    const std::uint64_t before = allocations();
+    const auto t0 = Clock::now();
+    for (std::size_t i = 0; i < ticks; ++i) sim.step(agents);
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    const double allocs = static_cast<double>(allocations() - before) / ticks;
+    const std::string param =
+        "agents=" + std::to_string(count) + ",workers=" + std::to_string(pool.workers());
+    report.add("crowd_tick", spec, g, param, "ticks_per_s", ticks / secs);
+    report.add("crowd_tick", spec, g, param, "agent_updates_per_s", ticks * count / secs);
+    report.add("crowd_tick", spec, g, param, "allocs_per_tick", allocs);
+  }
+}
+
+// Full social-force ticks against HybridCrowd on the tall buildings, with
+// hazard on two floors so they run as agents and the rest as flow. Both run
+// the same horizon from the same spawn; evacuated counts show how far the
+// flow model's door capacities hold the crowd back against free walking.
+void bench_crowd_lod(Report& report, const SyntheticSpec& spec, BuildingGraph& g, WorkStealingPool& pool,
+                     bool quick) {
+  if (spec.floors < 20) return;
+  const std::int16_t hot[] = {static_cast<std::int16_t>(g.min_floor() + 1),
+                              static_cast<std::int16_t>(g.min_floor() + g.floor_count() / 2)};
+  std::vector<EdgeId> touched;
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    const std::int16_t f = g.node_floor(g.edge_source(e));
+    if ((f == hot[0] || f == hot[1]) && g.edge_kind(e) == EdgeKind::Corridor) {
+      g.set_edge_hazard(e, 0.3f);
+      touched.push_back(e);
+    }
+  }
+  IncrementalRouter router(g);
+  const std::size_t count = std::size_t{2} * spec.floors * spec.rooms_per_floor;
+  const std::size_t ticks = quick ? 100 : 300;
+  AgentPopulation spawned;
+  spawn_agents(g, count, spec.seed, spawned);
+  const std::string param = "agents=" + std::to_string(count) + ",ticks=" + std::to_string(ticks);
+
+  AgentPopulation agents = spawned;
+  CrowdSimulator full(g, pool, CrowdParams{});
+  full.set_next_edges(router.next_edges());
+  auto t0 = Clock::now();
+  TickStats last;
+  for (std::size_t i = 0; i < ticks; ++i) last = full.step(agents);
+  const double full_us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / ticks;
+
+  HybridCrowd lod(g, pool);
+  lod.set_next_edges(router.next_edges());
+  lod.load(spawned);
+  const double total = lod.people();
+  std::size_t peak = 0;
+  HybridStats stats;
+  t0 = Clock::now();
+  for (std::size_t i = 0; i < ticks; ++i) {
+    stats = lod.step();
+    peak = std::max(peak, stats.agents);
+  }
+  const double lod_us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / ticks;
+
+  report.add("crowd_lod", spec, g, param, "full_us_per_tick", full_us);
+  report.add("crowd_lod", spec, g, param, "lod_us_per_tick", lod_us);
+  report.add("crowd_lod", spec, g, param, "speedup", full_us / lod_us);
+  report.add("crowd_lod", spec, g, param, "peak_agents", static_cast<double>(peak));
+  report.add("crowd_lod", spec, g, param, "active_floors", static_cast<double>(stats.active_floors));
+  report.add("crowd_lod", spec, g, param, "full_evacuated", static_cast<double>(count - last.active));
+  report.add("crowd_lod", spec, g, param, "lod_evacuated", stats.evacuated);
+  report.add("crowd_lod", spec, g, param, "mass_error", std::abs(lod.people() - total));
+  for (const EdgeId e : touched) g.set_edge_hazard(e, 0.0f);
+}
+
+// Producers encode random readings for the synthetic sensors while this
+// thread drains, coalesces and repairs, as in `main ingest`.
+void bench_ingest(Report& report, const SyntheticSpec& spec, BuildingGraph& g, bool quick) {
+  const SensorMap sensors = make_synthetic_sensors(g);
+  if (sensors.sensor_count() == 0) return;
+  IncrementalRouter router(g);
+  constexpr std::size_t kProducers = 4;
+  IngestOptions options;
+  options.producers = kProducers;
+  options.shards = kProducers;
+  IngestPipeline pipeline(sensors, g.edge_count(), options);
+  const std::uint64_t events = quick ? 100000 : 1000000;
+
+  std::atomic<std::size_t> finished{0};
+  std::vector<std::thread> threads;
+  const auto t0 = Clock::now();
+  for (std::size_t p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&, p] {
+      SplitMix64 rng(spec.seed * 7919 + p);
+      std::vector<SensorEvent> batch(64);
+      std::vector<std::byte> frame;
+      for (std::uint64_t sent = 0; sent < events / kProducers; sent += batch.size()) {
+        for (SensorEvent& e : batch) {
+          const std::uint32_t s = rng.below(static_cast<std::uint32_t>(sensors.sensor_count()));
+          e.sensor_id = sensors.sensor_id(s);
+          e.kind = sensors.kind(s);
+          e.timestamp_us = sent;
+          e.value = rng.uniform() < 0.9f ? 0.0f : rng.uniform();
+        }
+        frame.clear();
+        encode_event_frame(batch, frame);
+        pipeline.submit_frame(static_cast<unsigned>(p), frame);
+      }
+      finished.fetch_add(1, std::memory_order_release);
+    });
+  }
+  std::uint64_t repairs = 0;
+  for (;;) {
+    const bool last = finished.load(std::memory_order_acquire) == kProducers;
+    const std::span<const HazardUpdate> updates = pipeline.drain();
+    if (!updates.empty()) {
+      for (const HazardUpdate& u : updates) router.set_edge_hazard(u.edge, u.hazard);
+      router.repair();
+      ++repairs;
+    }
+    if (last && updates.empty() && pipeline.drained_readings() == pipeline.counters().accepted) break;
+    if (updates.empty()) std::this_thread::yield();
+  }
+  for (std::thread& t : threads) t.join();
+  const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+  const std::string param = "producers=" + std::to_string(kProducers);
+  report.add("ingest", spec, g, param, "readings_per_s", pipeline.drained_readings() / secs);
+  report.add("ingest", spec, g, param, "repairs", static_cast<double>(repairs));
+}
+
+// A camera on every door and a Wi-Fi access point on every fourth corridor
+// segment, each reporting once per snapshot (every 100 ms). Reports the cost
+// of folding one reading into its ring and of the per-snapshot fused update,
+// which depends on the zone count and not on how many readings the window holds.
+void bench_occupancy(Report& report, const SyntheticSpec& spec, BuildingGraph& g, bool quick) {
+  SensorMap sensors;
+  std::uint32_t next_id = 1;
+  std::size_t corridors = 0;
+  std::vector<EdgeId> covered;
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    const EdgeId twin = g.edge_twin(e);
+    if (twin != kInvalidEdge && twin < e) continue;
+    SensorKind kind;
+    if (g.edge_kind(e) == EdgeKind::Door) kind = SensorKind::Occupancy;
+    else if (g.edge_kind(e) == EdgeKind::Corridor && corridors++ % 4 == 0) kind = SensorKind::Wifi;
+    else continue;
+    covered.assign({e});
+    if (twin != kInvalidEdge) covered.push_back(twin);
+    sensors.add_sensor(next_id++, kind, covered);
+  }
+  sensors.finalize(g.edge_count());
+  if (sensors.sensor_count() == 0) return;
+  OccupancyFusion fusion(sensors, g);
+  IncrementalRouter router(g);
+
+  SplitMix64 rng(spec.seed * 131);
+  std::vector<OccupancyReading> readings(sensors.sensor_count());
+  const std::size_t snapshots = quick ? 20 : 100;
+  std::vector<double> add_ns;
+  std::vector<double> update_us;
+  std::vector<double> repair_us;
+  std::size_t changed = 0;
+  for (std::size_t t = 1; t <= snapshots; ++t) {
+    for (std::uint32_t s = 0; s < readings.size(); ++s) readings[s] = {s, rng.uniform(0.0f, 30.0f), t * 100000};
+    auto t0 = Clock::now();
+    fusion.add(readings);
+    auto t1 = Clock::now();
+    add_ns.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / readings.size());
+    const std::span<const CongestionUpdate> updates = fusion.update(t * 100000);
+    auto t2 = Clock::now();
+    update_us.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+    for (const CongestionUpdate& u : updates) router.set_edge_congestion(u.edge, u.delay_s);
+    router.repair();
+    repair_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t2).count());
+    changed += updates.size();
+  }
+  std::sort(add_ns.begin(), add_ns.end());
+  std::sort(update_us.begin(), update_us.end());
+  std::sort(repair_us.begin(), repair_us.end());
+  const std::string param = "zones=" + std::to_string(fusion.zone_count());
+  report.add("occupancy", spec, g, param, "add_ns_per_reading", percentile(add_ns, 0.5));
+  report.add("occupancy", spec, g, param, "update_us", percentile(update_us, 0.5));
+  report.add("occupancy", spec, g, param, "repair_us", percentile(repair_us, 0.5));
+  report.add("occupancy", spec, g, param, "arcs_changed_per_snapshot", static_cast<double>(changed) / snapshots);
+  for (EdgeId e = 0; e < g.edge_count(); ++e) g.set_edge_congestion(e, 0.0f);
+}
+
+// A sign at every corridor and stair node, one gateway per floor, fed by a
+// router taking 8 light-smoke flips per snapshot (every 100 ms); the links
+// flush every snapshot. Reports the controller's time per snapshot, the next
+// hops the router changed at signed nodes against the sign states actually
+// sent, and bus bytes against sending every sign's state each snapshot.
+void bench_signage(Report& report, const SyntheticSpec& spec, BuildingGraph& g, bool quick) {
+  SignMap signs;
+  for (NodeId v = 0; v < g.node_count(); ++v) {
+    const NodeKind kind = g.node_kind(v);
+    if (kind != NodeKind::Corridor && kind != NodeKind::Stairwell) continue;
+    signs.add_sign(v + 1, static_cast<std::uint32_t>(g.node_floor(v) - g.min_floor()), v);
+  }
+  signs.finalize();
+  if (signs.sign_count() == 0) return;
+  IncrementalRouter router(g);
+  SignOutbox outbox(signs);
+  SignageController controller(g, signs, outbox);
+  std::uint64_t version = 0;
+  GuidanceSnapshot first(g, router.distances(), router.next_edges(), ++version);
+  controller.update(first, 0);
+  std::vector<std::byte> frame;
+  const auto flush = [&] {
+    for (std::uint32_t gw = 0; gw < signs.gateway_count(); ++gw) {
+      frame.clear();
+      outbox.take(gw, frame);
+    }
+  };
+  flush();
+  const SignOutboxCounters initial = outbox.counters();
+  const std::uint64_t changes_before = controller.stats().changes;
+
+  SplitMix64 rng(spec.seed * 613);
+  const std::size_t snapshots = quick ? 50 : 300;
+  std::vector<double> update_us;
+  std::size_t router_flips = 0;
+  for (std::size_t t = 1; t <= snapshots; ++t) {
+    for (int k = 0; k < 8; ++k) {
+      const EdgeId e = rng.below(static_cast<std::uint32_t>(g.edge_count()));
+      const float h = rng.below(2) ? rng.uniform(0.0f, 0.3f) : 0.0f;
+      router.set_edge_hazard(e, h);
+      if (g.edge_twin(e) != kInvalidEdge) router.set_edge_hazard(g.edge_twin(e), h);
+    }
+    router.repair();
+    router.for_each_changed_next_hop([&](NodeId v) {
+      const NodeKind kind = g.node_kind(v);
+      router_flips += kind == NodeKind::Corridor || kind == NodeKind::Stairwell;
+    });
+    const GuidanceSnapshot snapshot(g, router.distances(), router.next_edges(), ++version);
+    const auto t0 = Clock::now();
+    controller.update(snapshot, t * 100000);
+    update_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+    flush();
+  }
+  const SignOutboxCounters c = outbox.counters();
+  std::size_t full_bytes = 0;
+  for (std::uint32_t gw = 0; gw < signs.gateway_count(); ++gw) {
+    full_bytes += kSignFrameHeaderSize + signs.signs_of(gw).size() * kSignCommandSize;
+  }
+  std::sort(update_us.begin(), update_us.end());
+  const std::string param = "signs=" + std::to_string(signs.sign_count());
+  const double n = static_cast<double>(snapshots);
+  report.add("signage", spec, g, param, "update_us", percentile(update_us, 0.5));
+  report.add("signage", spec, g, param, "router_flips_per_snapshot", router_flips / n);
+  report.add("signage", spec, g, param, "sign_changes_per_snapshot",
+             static_cast<double>(controller.stats().changes - changes_before) / n);
+  report.add("signage", spec, g, param, "bus_bytes_per_snapshot", static_cast<double>(c.bytes - initial.bytes) / n);
+  report.add("signage", spec, g, param, "full_bytes_per_snapshot", static_cast<double>(full_bytes));
+  for (EdgeId e = 0; e < g.edge_count(); ++e) router.set_edge_hazard(e, 0.0f);
+  router.repair();
+}
+
+// Reads until `buf` holds at least `want` bytes; false on EOF or error.
+#define EVAC_BENCH_READ_AT_LEAST(socket, buf, want)                               \
+  for (std::size_t got_ = 0; got_ < (want);) {                                   \
+    const ssize_t n_ = co_await (socket).read_some(std::span(buf).subspan(got_)); \
+    if (n_ <= 0) co_return;                                                      \
+    got_ += static_cast<std::size_t>(n_);                                        \
+  }
+
+// A simulated MQTT device: connect, publish `readings` QoS 1 readings one
+// acknowledgement at a time, then idle on the connection.
+Task mqtt_device(AsyncSocket socket, std::uint32_t sensor_id, std::size_t readings, std::atomic<std::size_t>& done) {
+  std::vector<std::byte> out;
+  std::array<std::byte, 64> in;
+  encode_mqtt_connect("bench-" + std::to_string(sensor_id), 60, out);
+  if (co_await socket.write_all(out) < 0) co_return;
+  EVAC_BENCH_READ_AT_LEAST(socket, in, 4);  // CONNACK
+  const std::string topic = "evac/sensor/" + std::to_string(sensor_id);
+  for (std::size_t k = 0; k < readings; ++k) {
+    const std::string value = k % 2 ? "0.8" : "0";
+    out.clear();
+    encode_mqtt_publish(topic, std::as_bytes(std::span(value)), 1, static_cast<std::uint16_t>(k + 1), out);
+    if (co_await socket.write_all(out) < 0) co_return;
+    EVAC_BENCH_READ_AT_LEAST(socket, in, 4);  // PUBACK
+  }
+  done.fetch_add(1, std::memory_order_relaxed);
+  co_await socket.read_some(in);
+}
+
+// A simulated Modbus gateway writing one sensor's register pair per request.
+Task modbus_device(AsyncSocket socket, std::uint32_t index, std::size_t readings, std::atomic<std::size_t>& done) {
+  std::vector<std::byte> out;
+  std::array<std::byte, 64> in;
+  const std::size_t reg = std::size_t{index} * 2;
+  for (std::size_t k = 0; k < readings; ++k) {
+    const float value = k % 2 ? 0.8f : 0.0f;
+    out.clear();
+    encode_modbus_write_registers(static_cast<std::uint16_t>(k), static_cast<std::uint8_t>(reg >> 16),
+                                  static_cast<std::uint16_t>(reg), {&value, 1}, out);
+    if (co_await socket.write_all(out) < 0) co_return;
+    EVAC_BENCH_READ_AT_LEAST(socket, in, 12);  // write response
+  }
+  done.fetch_add(1, std::memory_order_relaxed);
+  co_await socket.read_some(in);
+}
+
+#undef EVAC_BENCH_READ_AT_LEAST
+
+// Device swarm against the gateway: one connection per device, four in five
+// MQTT and the rest Modbus, each sending a few acknowledged readings and then
+// staying connected. The devices run as coroutines on their own loop; this
+// thread drains and repairs as the router. Reports connect time for the
+// swarm, end-to-end reading throughput and the connections left parked.
+void bench_gateway(Report& report, const SyntheticSpec& spec, BuildingGraph& g, bool quick) {
+  const SensorMap sensors = make_synthetic_sensors(g);
+  if (sensors.sensor_count() == 0) return;
+  const std::size_t devices = quick ? 1000 : 5000;
+  const std::size_t readings = quick ? 5 : 20;
+  IncrementalRouter router(g);
+  IngestOptions ingest;
+  ingest.ring_capacity = 1 << 16;
+  IngestPipeline pipeline(sensors, g.edge_count(), ingest);
+  GatewayOptions options;
+  options.mqtt_port = 0;
+  options.modbus_port = 0;
+  GatewayServer gateway(pipeline, sensors, options);
+
+  EventLoop device_loop;
+  std::atomic<std::size_t> done{0};
+  const auto t0 = Clock::now();
+  for (std::size_t d = 0; d < devices; ++d) {
+    const bool mqtt = d % 5 != 4;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(mqtt ? gateway.mqtt_port() : gateway.modbus_port());
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0) std::abort();
+    const auto index = static_cast<std::uint32_t>(d % sensors.sensor_count());
+    if (mqtt) {
+      mqtt_device(AsyncSocket(device_loop, fd), sensors.sensor_id(index), readings, done);
+    } else {
+      modbus_device(AsyncSocket(device_loop, fd), index, readings, done);
+    }
+  }
+  const double connect_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  std::thread device_thread([&] { device_loop.run(); });
+
+  const std::uint64_t expected = devices * readings;
+  const auto t1 = Clock::now();
+  std::uint64_t repairs = 0;
+  while (pipeline.drained_readings() < expected) {
+    const std::span<const HazardUpdate> updates = pipeline.drain();
+    if (!updates.empty()) {
+      for (const HazardUpdate& u : updates) router.set_edge_hazard(u.edge, u.hazard);
+      router.repair();
+      ++repairs;
+    } else {
+      std::this_thread::yield();
+    }
+    if (Clock::now() - t1 > std::chrono::seconds(60)) std::abort();
+  }
+  const double secs = std::chrono::duration<double>(Clock::now() - t1).count();
+  while (done.load(std::memory_order_relaxed) < devices) std::this_thread::yield();
+  const GatewayCounters c = gateway.counters();
+  device_loop.stop();
+  device_thread.join();
+  if (c.rejected != 0 || c.protocol_errors != 0 || c.readings != expected) std::abort();
+
+  const std::string param = "devices=" + std::to_string(devices);
+  report.add("gateway", spec, g, param, "connect_ms", connect_ms);
+  report.add("gateway", spec, g, param, "readings_per_s", static_cast<double>(expected) / secs);
+  report.add("gateway", spec, g, param, "repairs", static_cast<double>(repairs));
+  report.add("gateway", spec, g, param, "parked_connections", static_cast<double>(c.connections));
+}
+
+// Cold start of a replica: map the compiled model, wrap it and build the
+// first exit field. The file stays in the page cache between repetitions,
+// which is the case that matters for failover on a warm host.
+void bench_model_load(Report& report, const SyntheticSpec& spec, const BuildingGraph& g, bool quick) {
+  const std::string path = "bench_model_" + spec.tag() + ".evm";
+  const auto compile = time_us(quick ? 1 : 5, [&] { write_graph_model(g, path); });
+  const auto map = time_us(quick ? 5 : 51, [&] {
+    BuildingGraph mapped = graph_from_model(MappedModel::open(path));
+    if (mapped.edge_count() != g.edge_count()) std::abort();
+  });
+  const auto ready = time_us(quick ? 5 : 21, [&] {
+    BuildingGraph mapped = graph_from_model(MappedModel::open(path));
+    IncrementalRouter router(mapped);
+  });
+  std::remove(path.c_str());
+  report.add("model_load", spec, g, "-", "compile_us", percentile(compile, 0.5));
+  report.add("model_load", spec, g, "-", "map_us", percentile(map, 0.5));
+  report.add("model_load", spec, g, "-", "routing_ready_us", percentile(ready, 0.5));
+}
+
+// Periodic checkpoints of a running incident: every interval flips a few
+// connections, repairs and ticks the crowd, then submits a capture. Captures
+// are timed on the controller thread and writes on the checkpoint thread;
+// dirty pages count from the third write on, once both slots hold a
+// checkpoint. The agent-free run is what `main ingest` writes. Restore is a
+// standby mapping the file and building its router from the stored field,
+// against the cold solve it replaces.
+void bench_checkpoint(Report& report, const SyntheticSpec& spec, BuildingGraph& g, WorkStealingPool& pool,
+                      bool quick) {
+  const std::string path = "bench_checkpoint_" + spec.tag() + ".ckpt";
+  const std::size_t intervals = quick ? 10 : 40;
+  for (const std::size_t count : {std::size_t{0}, std::size_t{4} * spec.floors * spec.rooms_per_floor}) {
+    IncrementalRouter router(g);
+    AgentPopulation agents;
+    spawn_agents(g, count, spec.seed, agents);
+    CrowdSimulator sim(g, pool, CrowdParams{});
+    SplitMix64 rng(spec.seed * 43 + count);
+    std::vector<double> capture_us;
+    std::vector<double> write_us;
+    std::uint64_t pages_written = 0;
+    std::uint64_t pages_total = 0;
+    {
+      CheckpointWriter writer(path, CheckpointShape{g.node_count(), g.edge_count(), 0, count});
+      for (std::size_t i = 0; i < intervals; ++i) {
+        for (int k = 0; k < 8; ++k) {
+          const EdgeId e = rng.below(static_cast<std::uint32_t>(g.edge_count()));
+          const float h = rng.below(2) ? 0.9f : 0.0f;
+          router.set_edge_hazard(e, h);
+          if (g.edge_twin(e) != kInvalidEdge) router.set_edge_hazard(g.edge_twin(e), h);
+        }
+        router.repair();
+        sim.set_next_edges(router.next_edges());
+        for (int t = 0; t < 10 && count != 0; ++t) sim.step(agents);
+        CheckpointState state;
+        state.time_us = i * 1000000;
+        state.version = i + 1;
+        state.edge_hazard = g.edge_hazards();
+        state.edge_congestion = g.edge_congestions();
+        state.distance = router.distances();
+        state.next_edge = router.next_edges();
+        state.agents = &agents;
+        const auto t0 = Clock::now();
+        writer.submit(state);
+        capture_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        writer.flush();
+        const CheckpointCounters c = writer.counters();
+        write_us.push_back(c.last_write_us);
+        if (i == 1) {
+          pages_written = c.pages_written;
+          pages_total = c.pages_total;
+        } else if (i + 1 == intervals) {
+          pages_written = c.pages_written - pages_written;
+          pages_total = c.pages_total - pages_total;
+        }
+        if (writer.failed()) std::abort();
+      }
+    }
+    std::sort(capture_us.begin(), capture_us.end());
+    std::sort(write_us.begin(), write_us.end());
+    const std::string param = "agents=" + std::to_string(count);
+    report.add("checkpoint", spec, g, param, "capture_us", percentile(capture_us, 0.5));
+    report.add("checkpoint", spec, g, param, "write_us", percentile(write_us, 0.5));
+    report.add("checkpoint", spec, g, param, "dirty_fraction",
+               pages_total != 0 ? static_cast<double>(pages_written) / static_cast<double>(pages_total) : 0.0);
+    report.add("checkpoint", spec, g, param, "slot_kib",
+               static_cast<double>(make_checkpoint_header({g.node_count(), g.edge_count(), 0, count}).data_bytes) /
+                   1024.0);
+
+    BuildingGraph standby = make_synthetic_building(spec);
+    const auto open = time_us(quick ? 5 : 21, [&] { MappedCheckpoint::open(path); });
+    const auto checkpoint = MappedCheckpoint::open(path);
+    RestoredState restored;
+    const auto read = time_us(quick ? 5 : 21, [&] {
+      if (!read_latest_checkpoint(*checkpoint, restored)) std::abort();
+    });
+    apply_checkpoint(restored, standby);
+    const auto warm = time_us(quick ? 5 : 21, [&] {
+      IncrementalRouter r(standby, restored.distance, restored.next_edge);
+    });
+    const auto cold = time_us(quick ? 5 : 21, [&] { IncrementalRouter r(standby); });
+    report.add("checkpoint", spec, g, param, "open_us", percentile(open, 0.5));
+    report.add("checkpoint", spec, g, param, "read_us", percentile(read, 0.5));
+    report.add("checkpoint", spec, g, param, "warm_router_us", percentile(warm, 0.5));
+    report.add("checkpoint", spec, g, param, "cold_router_us", percentile(cold, 0.5));
+    std::remove(path.c_str());
+    for (EdgeId e = 0; e < g.edge_count(); ++e) router.set_edge_hazard(e, 0.0f);
+  }
+}
+
+bool wanted(const std::string& only, const char* name) {
+  if (only.empty()) return true;
+  const std::string n = name;
+  std::size_t start = 0;
+  while (start <= only.size()) {
+    const std::size_t end = std::min(only.find(',', start), only.size());
+    if (only.compare(start, end - start, n) == 0) return true;
+    start = end + 1;
+  }
+  return false;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool quick = false;
+  std::string out = "bench_output.txt";
+  std::string only;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--quick") {
+      quick = true;
+    } else if (a == "--out" && i + 1 < argc) {
+      out = argv[++i];
+    } else if (a == "--only" && i + 1 < argc) {
+      only = argv[++i];
+    } else {
+      std::fprintf(stderr, "usage: bench [--quick] [--out path] [--only name[,name...]]\n");
+      return 2;
+    }
+  }
+
+  std::vector<SyntheticSpec> specs = {{4, 20, 2}, {20, 80, 3}, {80, 400, 6}};
+  if (quick) specs.pop_back();
+
+  Report report;
+  WorkStealingPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  for (const SyntheticSpec& spec : specs) {
+    BuildingGraph g = make_synthetic_building(spec);
+    if (wanted(only, "route_full")) bench_route_full(report, spec, g, quick);
+    if (wanted(only, "route_repair")) bench_route_repair(report, spec, g, quick);
+    if (wanted(only, "contingency")) bench_contingency(report, spec, g, pool, quick);
+    if (wanted(only, "criticality")) bench_criticality(report, spec, g, pool, quick);
+    if (wanted(only, "planner")) bench_planner(report, spec, g);
+    if (wanted(only, "route_overlay")) bench_route_overlay(report, spec, g, quick);
+    if (wanted(only, "district")) bench_district(report, spec, g, pool, quick);
+    if (wanted(only, "guidance")) bench_guidance(report, spec, g, quick);
+    if (wanted(only, "cost_versions")) bench_cost_versions(report, spec, g, quick);
+    if (wanted(only, "guidance_feed")) bench_guidance_feed(report, spec, g, quick);
+    if (wanted(only, "crowd_tick")) bench_crowd(report, spec, g, pool, quick);
+    if (wanted(only, "crowd_lod")) bench_crowd_lod(report, spec, g, pool, quick);
+    if (wanted(only, "ingest")) bench_ingest(report, spec, g, quick);
+    if (wanted(only, "occupancy")) bench_occupancy(report, spec, g, quick);
+    if (wanted(only, "signage")) bench_signage(report, spec, g, quick);
+    if (wanted(only, "gateway")) bench_gateway(report, spec, g, quick);
+    if (wanted(only, "model_load")) bench_model_load(report, spec, g, quick);
+    if (wanted(only, "checkpoint")) bench_checkpoint(report, spec, g, pool, quick);
+  }
+  if (!report.write(out)) {
+    std::fprintf(stderr, "%s: cannot write results\n", out.c_str());
+    return 1;
+  }
+  return 0;
+}
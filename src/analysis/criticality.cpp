@@ -0,0 +1,252 @@
+#include "analysis/criticality.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include "routing/cost.hpp"
+#include "routing/search_queue.hpp"
+#include "util/arena.hpp"
+#include "util/rng.hpp"
+
+namespace evac {
+namespace {
+
+// Per-worker Brandes state; dist doubles as the visited mark, reset through
+// `order` after each source.
+struct BrandesScratch {
+  std::vector<Cost> dist;
+  std::vector<double> sigma;
+  std::vector<double> delta;
+  std::vector<NodeId> order;
+  std::vector<double> acc;  // per arc
+};
+
+void brandes_from(const BuildingGraph& g, std::span<const Cost> cost, NodeId s, BrandesScratch& w) {
+  ArenaScope scope(scratch_arena());
+  BinaryHeapQueue queue(scope.arena(), 64);
+  w.order.clear();
+  w.dist[s] = 0;
+  w.sigma[s] = 1.0;
+  queue.push(0, s);
+  while (!queue.empty()) {
+    const auto [d, u] = queue.pop();
+    if (d != w.dist[u]) continue;  // stale: labels only ever drop strictly
+    w.order.push_back(u);
+    for (EdgeId e : g.out_edges(u)) {
+      if (cost[e] == kInfiniteCost) continue;
+      const NodeId v = g.edge_target(e);
+      const Cost nd = saturating_add(d, cost[e]);
+      if (nd < w.dist[v]) {
+        w.dist[v] = nd;
+        w.sigma[v] = w.sigma[u];
+        queue.push(nd, v);
+      } else if (nd == w.dist[v]) {
+        w.sigma[v] += w.sigma[u];
+      }
+    }
+  }
+  // Arc costs are at least 1, so settle order is a topological order of the
+  // shortest-path DAG and predecessors can be found again from in-arcs.
+  for (std::size_t i = w.order.size(); i-- > 0;) {
+    const NodeId v = w.order[i];
+    const double share = (1.0 + w.delta[v]) / w.sigma[v];
+    for (EdgeId e : g.in_edges(v)) {
+      const NodeId u = g.edge_source(e);
+      if (cost[e] == kInfiniteCost || saturating_add(w.dist[u], cost[e]) != w.dist[v]) continue;
+      const double c = w.sigma[u] * share;
+      w.acc[e] += c;
+      w.delta[u] += c;
+    }
+  }
+  for (const NodeId v : w.order) {
+    w.dist[v] = kInfiniteCost;
+    w.sigma[v] = 0.0;
+    w.delta[v] = 0.0;
+  }
+}
+
+// Dinic's max flow on a residual copy of the building with a super source and
+// sink; small enough per query that it is rebuilt for each cut.
+class ResidualNetwork {
+ public:
+  static constexpr double kUnbounded = 1e18;
+
+  explicit ResidualNetwork(std::size_t nodes) : first_(nodes, kNone), level_(nodes), cursor_(nodes) {}
+
+  void add_arc(std::uint32_t u, std::uint32_t v, double capacity) {
+    arcs_.push_back({v, first_[u], capacity});
+    first_[u] = static_cast<std::uint32_t>(arcs_.size() - 1);
+    arcs_.push_back({u, first_[v], 0.0});
+    first_[v] = static_cast<std::uint32_t>(arcs_.size() - 1);
+  }
+
+  double max_flow(std::uint32_t s, std::uint32_t t) {
+    double total = 0.0;
+    while (levels_from(s, t)) {
+      std::copy(first_.begin(), first_.end(), cursor_.begin());
+      while (const double f = push(s, t, kUnbounded)) total += f;
+    }
+    return total;
+  }
+
+  // After max_flow(): whether u is on the source side of the minimum cut.
+  bool source_side(std::uint32_t u) const { return level_[u] != kNone; }
+
+ private:
+  static constexpr std::uint32_t kNone = 0xffffffffu;
+  static constexpr double kEpsilon = 1e-9;
+
+  struct Arc {
+    std::uint32_t to;
+    std::uint32_t next;
+    double capacity;
+  };
+
+  // Breadth-first levels over arcs with residual capacity; false once t is cut off.
+  bool levels_from(std::uint32_t s, std::uint32_t t) {
+    std::fill(level_.begin(), level_.end(), kNone);
+    std::vector<std::uint32_t> frontier{s};
+    level_[s] = 0;
+    for (std::size_t i = 0; i < frontier.size(); ++i) {
+      const std::uint32_t u = frontier[i];
+      for (std::uint32_t a = first_[u]; a != kNone; a = arcs_[a].next) {
+        if (arcs_[a].capacity > kEpsilon && level_[arcs_[a].to] == kNone) {
+          level_[arcs_[a].to] = level_[u] + 1;
+          frontier.push_back(arcs_[a].to);
+        }
+      }
+    }
+    return level_[t] != kNone;
+  }
+
+  double push(std::uint32_t u, std::uint32_t t, double limit) {
+    if (u == t) return limit;
+    for (std::uint32_t& a = cursor_[u]; a != kNone; a = arcs_[a].next) {
+      Arc& arc = arcs_[a];
+      if (arc.capacity <= kEpsilon || level_[arc.to] != level_[u] + 1) continue;
+      const double f = push(arc.to, t, std::min(limit, arc.capacity));
+      if (f > 0.0) {
+        arc.capacity -= f;
+        arcs_[a ^ 1u].capacity += f;
+        return f;
+      }
+    }
+    return 0.0;
+  }
+
+  std::vector<Arc> arcs_;
+  std::vector<std::uint32_t> first_;
+  std::vector<std::uint32_t> level_;
+  std::vector<std::uint32_t> cursor_;
+};
+
+}  // namespace
+
+std::vector<float> sampled_edge_betweenness(const BuildingGraph& g, const BetweennessOptions& options,
+                                            WorkStealingPool& pool) {
+  const std::size_t n = g.node_count();
+  const std::size_t m = g.edge_count();
+  std::vector<Cost> cost(m);
+  for (EdgeId e = 0; e < m; ++e) cost[e] = edge_cost(g, e);
+
+  // Partial Fisher-Yates: the first `samples` entries are a uniform sample.
+  std::vector<NodeId> sources(n);
+  std::iota(sources.begin(), sources.end(), NodeId{0});
+  const std::size_t samples = std::min(options.samples, n);
+  SplitMix64 rng(options.seed);
+  for (std::size_t i = 0; i < samples && n - i > 1; ++i) {
+    std::swap(sources[i], sources[i + rng.below(static_cast<std::uint32_t>(n - i))]);
+  }
+
+  std::vector<BrandesScratch> workers(pool.workers());
+  for (BrandesScratch& w : workers) {
+    w.dist.assign(n, kInfiniteCost);
+    w.sigma.assign(n, 0.0);
+    w.delta.assign(n, 0.0);
+    w.acc.assign(m, 0.0);
+  }
+  pool.parallel_for(samples, 4, [&](std::size_t b, std::size_t e, unsigned self) {
+    for (std::size_t i = b; i < e; ++i) brandes_from(g, cost, sources[i], workers[self]);
+  });
+
+  std::vector<float> out(m, 0.0f);
+  const double scale = samples == 0 ? 0.0 : static_cast<double>(n) / static_cast<double>(samples);
+  for (EdgeId e = 0; e < m; ++e) {
+    double sum = 0.0;
+    for (const BrandesScratch& w : workers) sum += w.acc[e];
+    out[e] = static_cast<float>(sum * scale);
+  }
+  return out;
+}
+
+ExitCut exit_min_cut(const BuildingGraph& g, std::int32_t floor) {
+  const std::size_t n = g.node_count();
+  const auto s = static_cast<std::uint32_t>(n);
+  const auto t = static_cast<std::uint32_t>(n + 1);
+  ResidualNetwork net(n + 2);
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    if (g.edge_hazard(e) >= kImpassableHazard) continue;
+    const float pps = g.edge_capacity(e);
+    net.add_arc(g.edge_source(e), g.edge_target(e), pps > 0.0f ? pps : ResidualNetwork::kUnbounded);
+  }
+  for (NodeId v = 0; v < n; ++v) {
+    if (g.node_kind(v) == NodeKind::Room && (floor == kWholeSite || g.node_floor(v) == floor)) {
+      net.add_arc(s, v, ResidualNetwork::kUnbounded);
+    }
+  }
+  for (const NodeId x : g.exits()) net.add_arc(x, t, ResidualNetwork::kUnbounded);
+
+  ExitCut cut;
+  cut.floor = floor;
+  const double flow = net.max_flow(s, t);
+  if (flow >= ResidualNetwork::kUnbounded) {
+    cut.capacity_pps = std::numeric_limits<float>::infinity();
+    return cut;
+  }
+  cut.capacity_pps = static_cast<float>(flow);
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    if (g.edge_hazard(e) >= kImpassableHazard) continue;
+    if (net.source_side(g.edge_source(e)) && !net.source_side(g.edge_target(e))) cut.arcs.push_back(e);
+  }
+  std::sort(cut.arcs.begin(), cut.arcs.end(), [&](EdgeId a, EdgeId b) {
+    return g.edge_capacity(a) != g.edge_capacity(b) ? g.edge_capacity(a) > g.edge_capacity(b) : a < b;
+  });
+  return cut;
+}
+
+CriticalityBuild build_criticality(const BuildingGraph& g, const BetweennessOptions& options,
+                                   WorkStealingPool& pool) {
+  CriticalityBuild build;
+  build.edge_betweenness = sampled_edge_betweenness(g, options, pool);
+  build.samples = std::min(options.samples, g.node_count());
+
+  std::vector<bool> has_rooms(static_cast<std::size_t>(g.floor_count()), false);
+  for (NodeId v = 0; v < g.node_count(); ++v) {
+    if (g.node_kind(v) == NodeKind::Room) has_rooms[static_cast<std::size_t>(g.node_floor(v) - g.min_floor())] = true;
+  }
+  const auto add = [&](const ExitCut& cut) {
+    build.cuts.push_back({cut.floor, cut.capacity_pps, static_cast<std::uint32_t>(build.cut_arcs.size()),
+                          static_cast<std::uint32_t>(cut.arcs.size())});
+    build.cut_arcs.insert(build.cut_arcs.end(), cut.arcs.begin(), cut.arcs.end());
+  };
+  add(exit_min_cut(g));
+  for (std::size_t f = 0; f < has_rooms.size(); ++f) {
+    if (has_rooms[f]) add(exit_min_cut(g, g.min_floor() + static_cast<std::int32_t>(f)));
+  }
+  return build;
+}
+
+std::vector<ConnectionLoad> rank_connections(const BuildingGraph& g, std::span<const float> edge_betweenness) {
+  std::vector<ConnectionLoad> out;
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    const EdgeId twin = g.edge_twin(e);
+    if (twin != kInvalidEdge && twin < e) continue;
+    out.push_back({e, edge_betweenness[e] + (twin != kInvalidEdge ? edge_betweenness[twin] : 0.0f)});
+  }
+  std::sort(out.begin(), out.end(), [](const ConnectionLoad& a, const ConnectionLoad& b) {
+    return a.betweenness != b.betweenness ? a.betweenness > b.betweenness : a.edge < b.edge;
+  });
+  return out;
+}
+
+}  // namespace evac
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "exec/work_stealing_pool.hpp"
+#include "graph/building_graph.hpp"
+
+namespace evac {
+
+struct BetweennessOptions {
+  std::size_t samples = 256;  // source nodes; at or above node_count the result is exact
+  std::uint64_t seed = 1;
+};
+
+// Approximate arc betweenness: the number of shortest walking paths between
+// ordered pairs of nodes that use each arc, estimated with Brandes' algorithm
+// run from a uniform sample of sources and scaled by node_count / samples.
+// Shortest paths are by edge_cost() on the graph as it stands, so closed arcs
+// carry nothing. Sources are split over the pool, each worker accumulating
+// into its own column; the columns are summed at the end.
+std::vector<float> sampled_edge_betweenness(const BuildingGraph& g, const BetweennessOptions& options,
+                                            WorkStealingPool& pool);
+
+inline constexpr std::int32_t kWholeSite = std::numeric_limits<std::int32_t>::min();
+
+// Minimum cut between the rooms (of one floor, or of the whole site) and the
+// exits, with each arc's door or corridor throughput as its capacity. Arcs
+// without a capacity are unbounded and closed arcs are left out. The cut
+// capacity is the highest sustained evacuation flow the building admits, so
+// occupants / capacity_pps bounds the egress time of any plan from below.
+struct ExitCut {
+  std::int32_t floor = kWholeSite;
+  float capacity_pps = 0.0f;  // +inf when every cut crosses an unbounded arc
+  std::vector<EdgeId> arcs;   // saturated arcs from the room side, widest first
+};
+
+ExitCut exit_min_cut(const BuildingGraph& g, std::int32_t floor = kWholeSite);
+
+// Per-cut record as stored in the model; arcs [first_arc, first_arc + arc_count)
+// of the cut-arc section belong to it.
+struct ExitCutSummary {
+  std::int32_t floor;
+  float capacity_pps;
+  std::uint32_t first_arc;
+  std::uint32_t arc_count;
+};
+static_assert(sizeof(ExitCutSummary) == 16);
+
+// What `main analyze` and `compile --criticality` store: arc betweenness, the
+// site cut first and then one cut per floor that has rooms.
+struct CriticalityBuild {
+  std::vector<float> edge_betweenness;
+  std::vector<ExitCutSummary> cuts;
+  std::vector<EdgeId> cut_arcs;
+  std::size_t samples = 0;
+};
+
+CriticalityBuild build_criticality(const BuildingGraph& g, const BetweennessOptions& options,
+                                   WorkStealingPool& pool);
+
+// Betweenness of every connection (both arcs), with the lower arc id of each.
+struct ConnectionLoad {
+  EdgeId edge;
+  float betweenness;
+};
+std::vector<ConnectionLoad> rank_connections(const BuildingGraph& g, std::span<const float> edge_betweenness);
+
+}  // namespace evac
@@ -0,0 +1,118 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "analysis/criticality.hpp"
+#include "app/commands.hpp"
+#include "exec/work_stealing_pool.hpp"
+#include "graph/plan_loader.hpp"
+#include "model/mapped_model.hpp"
+
+namespace evac::app {
+namespace {
+
+void print_cut(const BuildingGraph& g, const char* scope, const ExitCutSummary& cut, std::span<const EdgeId> arcs) {
+  if (std::isinf(cut.capacity_pps)) {
+    std::printf("  %-9s unbounded (some route has no capacity limit)\n", scope);
+    return;
+  }
+  std::printf("  %-9s %8.2f pps over %u arcs:", scope, cut.capacity_pps, cut.arc_count);
+  for (const EdgeId e : arcs) std::printf(" %u-%u", g.edge_source(e), g.edge_target(e));
+  std::printf("\n");
+}
+
+}  // namespace
+
+// Pre-event criticality report for building managers: the connections most
+// walking routes depend on (sampled Brandes betweenness) and the minimum cut
+// between the rooms and the exits, for the site and for each floor. The cut
+// arcs are the doors and corridors that bound how fast the building can empty.
+//
+// --out writes a model with the analysis stored beside the graph; contingency
+// tables of an input model are carried over. `plan` checks its egress time
+// against the stored site cut; `compile --criticality` stores the same
+// analysis at compile time and ranks the contingency tables by it.
+int cmd_analyze(const Args& args) {
+  BetweennessOptions options;
+  unsigned threads = 0;
+  std::size_t top = 10;
+  std::string path;
+  std::string out;
+  bool ok = true;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const std::string& a = args[i];
+    const bool has_value = i + 1 < args.size();
+    if (a == "--samples" && has_value) {
+      options.samples = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--seed" && has_value) {
+      options.seed = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--threads" && has_value) {
+      threads = static_cast<unsigned>(std::strtoul(args[++i].c_str(), nullptr, 10));
+    } else if (a == "--top" && has_value) {
+      top = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--out" && has_value) {
+      out = args[++i];
+    } else if (path.empty() && a[0] != '-') {
+      path = a;
+    } else {
+      ok = false;
+    }
+  }
+  if (!ok || path.empty()) {
+    std::fprintf(stderr,
+                 "usage: main analyze <plan> [--samples n] [--seed s] [--threads n] [--top k] [--out model.evm]\n");
+    return 2;
+  }
+
+  std::shared_ptr<const MappedModel> model;
+  if (is_model_file(path)) model = MappedModel::open(path);
+  const BuildingGraph g = model ? graph_from_model(model) : load_plan_file(path);
+  WorkStealingPool pool(threads != 0 ? threads : std::thread::hardware_concurrency());
+
+  const auto start = std::chrono::steady_clock::now();
+  const CriticalityBuild build = build_criticality(g, options, pool);
+  const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  std::printf("betweenness from %zu of %zu sources on %u threads, cuts for %zu scopes (%.1f ms)\n", build.samples,
+              g.node_count(), pool.workers(), build.cuts.size(), ms);
+  const std::vector<ConnectionLoad> ranked = rank_connections(g, build.edge_betweenness);
+  std::printf("busiest connections:\n");
+  for (std::size_t i = 0; i < ranked.size() && i < top; ++i) {
+    const EdgeId e = ranked[i].edge;
+    const float pps = g.edge_capacity(e);
+    std::printf("  %6u-%-6u %-9s %6.1f m  %5.2f pps  %12.1f paths\n", g.edge_source(e), g.edge_target(e),
+                to_string(g.edge_kind(e)), g.edge_length(e), pps, ranked[i].betweenness);
+  }
+  std::printf("exit cuts:\n");
+  for (const ExitCutSummary& cut : build.cuts) {
+    const std::span<const EdgeId> arcs(build.cut_arcs.data() + cut.first_arc, cut.arc_count);
+    const std::string scope = cut.floor == kWholeSite ? "site" : "floor " + std::to_string(cut.floor);
+    print_cut(g, scope.c_str(), cut, arcs);
+  }
+
+  if (!out.empty()) {
+    ContingencyBuild tables;
+    ModelAnalyses analyses;
+    analyses.criticality = &build;
+    if (model) {
+      const auto entries = model->section<ContingencyEntry>(SectionId::ContingencyIndex);
+      const auto next_edge = model->section<EdgeId>(SectionId::ContingencyNextEdge);
+      const auto distance = model->section<Cost>(SectionId::ContingencyDistance);
+      if (!entries.empty()) {
+        tables.entries.assign(entries.begin(), entries.end());
+        tables.next_edge.assign(next_edge.begin(), next_edge.end());
+        tables.distance.assign(distance.begin(), distance.end());
+        analyses.contingencies = &tables;
+      }
+    }
+    write_graph_model(g, out, analyses);
+    std::printf("wrote %s\n", out.c_str());
+  }
+  return 0;
+}
+
+}  // namespace evac::app
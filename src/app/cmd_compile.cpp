@@ -0,0 +1,111 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "analysis/criticality.hpp"
+#include "app/commands.hpp"
+#include "exec/work_stealing_pool.hpp"
+#include "graph/plan_loader.hpp"
+#include "model/mapped_model.hpp"
+#include "routing/contingency_tables.hpp"
+#include "routing/incremental_router.hpp"
+
+namespace evac::app {
+
+// Compiles a text floor plan into a mapped model file, then maps it back and
+// reports the cold-start path a replica takes: map, wrap, first exit field.
+// --contingencies k also stores exit fields for the k connections and nodes
+// carrying the most routes, each closed on its own (see ContingencyTables).
+// --criticality n stores sampled betweenness from n sources and the exit cuts
+// (see `main analyze`); the contingencies are then ranked by that betweenness.
+int cmd_compile(const Args& args) {
+  std::size_t contingencies = 0;
+  std::size_t samples = 0;
+  unsigned threads = 0;
+  std::vector<std::string> paths;
+  bool ok = true;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const bool has_value = i + 1 < args.size();
+    if (args[i] == "--contingencies" && has_value) {
+      contingencies = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (args[i] == "--criticality" && has_value) {
+      samples = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (args[i] == "--threads" && has_value) {
+      threads = static_cast<unsigned>(std::strtoul(args[++i].c_str(), nullptr, 10));
+    } else if (args[i][0] != '-') {
+      paths.push_back(args[i]);
+    } else {
+      ok = false;
+    }
+  }
+  if (!ok || paths.size() != 2) {
+    std::fprintf(stderr, "usage: main compile <plan> <model.evm> [--contingencies k] [--criticality n] [--threads n]\n");
+    return 2;
+  }
+  using Clock = std::chrono::steady_clock;
+  const auto ms_since = [](Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  };
+
+  auto t0 = Clock::now();
+  const BuildingGraph source = load_plan_file(paths[0]);
+  const double parse_ms = ms_since(t0);
+  ModelAnalyses analyses;
+  ContingencyBuild tables;
+  CriticalityBuild criticality;
+  double tables_ms = 0.0;
+  double criticality_ms = 0.0;
+  if (contingencies != 0 || samples != 0) {
+    WorkStealingPool pool(threads != 0 ? threads : std::thread::hardware_concurrency());
+    if (samples != 0) {
+      t0 = Clock::now();
+      criticality = build_criticality(source, {samples, 1}, pool);
+      criticality_ms = ms_since(t0);
+      analyses.criticality = &criticality;
+    }
+    if (contingencies != 0) {
+      t0 = Clock::now();
+      tables = build_contingency_tables(
+          source, rank_contingencies(source, contingencies, criticality.edge_betweenness), pool);
+      tables_ms = ms_since(t0);
+      analyses.contingencies = &tables;
+    }
+  }
+  write_graph_model(source, paths[1], analyses);
+
+  t0 = Clock::now();
+  std::shared_ptr<const MappedModel> model = MappedModel::open(paths[1]);
+  const double map_ms = ms_since(t0);
+  const std::size_t bytes = model->size_bytes();
+  const std::uint32_t bad = model->verify();
+  if (bad != 0) {
+    std::fprintf(stderr, "%s: section %u failed its checksum\n", paths[1].c_str(), bad);
+    return 1;
+  }
+  t0 = Clock::now();
+  BuildingGraph mapped = graph_from_model(std::move(model));
+  IncrementalRouter router(mapped);
+  const double ready_ms = ms_since(t0);
+
+  std::printf("%s: %zu nodes, %zu arcs, %zu bytes\n", paths[1].c_str(), mapped.node_count(),
+              mapped.edge_count(), bytes);
+  std::printf("parse %.2f ms, map %.3f ms, routing ready %.2f ms after map\n", parse_ms, map_ms, ready_ms);
+  if (contingencies != 0) {
+    std::size_t connections = 0;
+    for (const ContingencyEntry& c : tables.entries) {
+      connections += c.kind == static_cast<std::uint32_t>(ContingencyKind::Connection);
+    }
+    std::printf("contingencies: %zu tables (%zu connections, %zu nodes) built in %.1f ms\n", tables.entries.size(),
+                connections, tables.entries.size() - connections, tables_ms);
+  }
+  if (samples != 0) {
+    std::printf("criticality: %zu sources, site exit cut %.2f pps, built in %.1f ms\n", criticality.samples,
+                criticality.cuts.front().capacity_pps, criticality_ms);
+  }
+  return 0;
+}
+
+}  // namespace evac::app
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "app/commands.hpp"
+#include "crowd/agents.hpp"
+#include "district/district.hpp"
+#include "model/mapped_model.hpp"
+#include "routing/exit_field.hpp"
+#include "util/rng.hpp"
+
+namespace evac::app {
+namespace {
+
+std::size_t count_mismatches(const District& district, const BuildingGraph& world, ExitField& assembled,
+                             ExitField& reference) {
+  district.export_field(assembled);
+  solve_exit_field(world, reference);
+  std::size_t bad = 0;
+  for (std::size_t v = 0; v < reference.distance.size(); ++v) bad += assembled.distance[v] != reference.distance[v];
+  return bad;
+}
+
+}  // namespace
+
+// Runs a plan as a partitioned district: one router and crowd simulator per
+// region exchanging labels and hand-overs as messages. Every hazard update is
+// followed by exactly one exchange round, after which the regions' fields are
+// checked against a single site-wide solve.
+int cmd_district(const Args& args) {
+  PartitionParams partition;
+  std::size_t agent_count = 2000;
+  double seconds = 120.0;
+  double update_every = 10.0;
+  std::size_t flips = 4;
+  unsigned threads = 0;
+  std::uint64_t seed = 1;
+  std::string path;
+  bool ok = true;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const std::string& a = args[i];
+    const bool has_value = i + 1 < args.size();
+    if (a == "--regions" && has_value) {
+      partition.regions = static_cast<std::uint32_t>(std::max(1ul, std::strtoul(args[++i].c_str(), nullptr, 10)));
+    } else if (a == "--agents" && has_value) {
+      agent_count = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--seconds" && has_value) {
+      seconds = std::strtod(args[++i].c_str(), nullptr);
+    } else if (a == "--update-every" && has_value) {
+      update_every = std::max(0.1, std::strtod(args[++i].c_str(), nullptr));
+    } else if (a == "--flips" && has_value) {
+      flips = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--threads" && has_value) {
+      threads = static_cast<unsigned>(std::strtoul(args[++i].c_str(), nullptr, 10));
+    } else if (a == "--seed" && has_value) {
+      seed = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a[0] != '-' && path.empty()) {
+      path = a;
+    } else {
+      ok = false;
+    }
+  }
+  if (!ok || path.empty()) {
+    std::fprintf(stderr,
+                 "usage: main district <plan> [--regions k] [--agents n] [--seconds s] [--update-every s] "
+                 "[--flips n] [--threads n] [--seed n]\n");
+    return 2;
+  }
+
+  BuildingGraph world = load_building(path);
+  const auto start = std::chrono::steady_clock::now();
+  partition.seed = seed;
+  RegionPartition regions = partition_building(world, partition);
+  const double partition_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%u regions, %zu cut arcs (weight %llu), %zu boundary nodes, partitioned in %.1f ms\n",
+              regions.regions, regions.cut_arcs.size(), static_cast<unsigned long long>(regions.cut_weight),
+              regions.boundary.size(), partition_ms);
+  for (std::uint32_t r = 0; r < regions.regions; ++r) {
+    std::printf("  region %u: %zu nodes, %zu boundary, %zu cut arcs out\n", r, regions.region_nodes(r).size(),
+                regions.region_boundary(r).size(), regions.region_cut_arcs(r).size());
+  }
+
+  WorkStealingPool pool(threads != 0 ? threads : std::thread::hardware_concurrency());
+  District district(world, std::move(regions), pool);
+  ExitField assembled;
+  ExitField reference;
+  ExchangeStats exchanged = district.exchange();
+  std::size_t mismatches = count_mismatches(district, world, assembled, reference);
+  std::printf("initial exchange: %zu label messages, %zu bytes, %zu nodes differ from the site-wide solve\n",
+              exchanged.label_messages, exchanged.label_bytes, mismatches);
+
+  AgentPopulation agents;
+  spawn_agents(world, agent_count, seed, agents);
+  district.add_agents(agents);
+  const float dt = CrowdParams{}.dt;
+  const auto ticks = static_cast<std::uint64_t>(seconds / dt);
+  const auto update_ticks = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(update_every / dt));
+  SplitMix64 rng(seed ^ 0x5a5a5a5aull);
+  std::size_t updates = 0;
+  std::size_t diverged_rounds = 0;
+  std::size_t label_bytes = 0;
+  std::size_t flow_bytes = 0;
+  std::size_t handed_over = 0;
+  const auto sim_start = std::chrono::steady_clock::now();
+  for (std::uint64_t t = 1; t <= ticks && district.inside() != 0; ++t) {
+    const DistrictTick tick = district.step();
+    flow_bytes += tick.flow_bytes;
+    handed_over += tick.agents_handed_over;
+    if (t % update_ticks != 0 || world.edge_count() == 0) continue;
+    for (std::size_t f = 0; f < flips; ++f) {
+      const EdgeId e = rng.below(static_cast<std::uint32_t>(world.edge_count()));
+      const float hazard = rng.uniform() < 0.5f ? 0.0f : rng.uniform(0.2f, 1.0f);
+      world.set_edge_hazard(e, hazard);
+      district.set_edge_hazard(e, hazard);
+    }
+    exchanged = district.exchange();
+    label_bytes += exchanged.label_bytes;
+    ++updates;
+    const std::size_t bad = count_mismatches(district, world, assembled, reference);
+    mismatches += bad;
+    diverged_rounds += bad != 0;
+  }
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - sim_start).count();
+
+  std::printf("%zu hazard updates, one exchange round each: %zu rounds left a region off the site-wide field\n",
+              updates, diverged_rounds);
+  std::printf("messages: %zu label bytes, %zu flow bytes, %zu agents handed over\n", label_bytes, flow_bytes,
+              handed_over);
+  std::printf("%zu of %zu agents evacuated, %zu inside, in %.3f s on %u workers\n", district.evacuated(),
+              agents.size(), district.inside(), secs, pool.workers());
+  return mismatches == 0 ? 0 : 1;
+}
+
+}  // namespace evac::app
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app/commands.hpp"
+#include "hazard/hazard_forecaster.hpp"
+#include "model/mapped_model.hpp"
+#include "routing/incremental_router.hpp"
+
+namespace evac::app {
+
+// Fire scenario driver: a forecaster thread propagates smoke from a fire at
+// one node while this thread plays the router, folding predicted hazards into
+// the exit field and answering next-hop queries in between.
+int cmd_forecast(const Args& args) {
+  NodeId fire = kInvalidNode;
+  float seconds = 120.0f;
+  ForecastOptions options;
+  options.time_scale = 0.0f;
+  std::string path;
+  bool ok = true;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const std::string& a = args[i];
+    const bool has_value = i + 1 < args.size();
+    if (a == "--fire" && has_value) {
+      fire = static_cast<NodeId>(std::strtoul(args[++i].c_str(), nullptr, 10));
+    } else if (a == "--seconds" && has_value) {
+      seconds = std::strtof(args[++i].c_str(), nullptr);
+    } else if (a == "--horizon" && has_value) {
+      options.horizon_seconds = std::strtof(args[++i].c_str(), nullptr);
+    } else if (a == "--cadence" && has_value) {
+      options.cadence_seconds = std::max(0.5f, std::strtof(args[++i].c_str(), nullptr));
+    } else if (a == "--speedup" && has_value) {
+      options.time_scale = std::strtof(args[++i].c_str(), nullptr);
+    } else if (a[0] != '-' && path.empty()) {
+      path = a;
+    } else {
+      ok = false;
+    }
+  }
+  if (!ok || path.empty() || fire == kInvalidNode) {
+    std::fprintf(stderr,
+                 "usage: main forecast <plan> --fire <node> [--seconds s] [--horizon s] [--cadence s] "
+                 "[--speedup x]\n");
+    return 2;
+  }
+
+  BuildingGraph graph = load_building(path);
+  if (fire >= graph.node_count()) {
+    std::fprintf(stderr, "fire node %u out of range\n", fire);
+    return 2;
+  }
+  IncrementalRouter router(graph);
+  HazardBlend blend(graph.edge_count());
+  HazardForecaster forecaster(graph, SmokeParams{}, options);
+  forecaster.add_source({graph.node_floor(fire), graph.node_x(fire), graph.node_y(fire)});
+
+  const auto cycles_wanted = static_cast<std::uint64_t>(std::ceil(seconds / options.cadence_seconds));
+  std::vector<HazardUpdate> updates;
+  std::uint64_t queries = 0, routable = 0, repairs = 0, applied = 0;
+  double worst_query_us = 0.0;
+  forecaster.start();
+  while (forecaster.cycles() < cycles_wanted) {
+    updates.clear();
+    if (forecaster.poll(updates)) {
+      for (const HazardUpdate& u : updates) {
+        if (blend.set_forecast(u.edge, u.hazard)) router.set_edge_hazard(u.edge, blend.effective(u.edge));
+      }
+      const RepairStats stats = router.repair();
+      applied += stats.changed_edges;
+      ++repairs;
+    }
+    // Queries keep being served while the forecaster works.
+    const auto t0 = std::chrono::steady_clock::now();
+    for (NodeId v = 0; v < graph.node_count(); ++v) routable += router.next_hop(v) != kInvalidNode;
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    worst_query_us = std::max(worst_query_us, us / std::max<std::size_t>(1, graph.node_count()));
+    queries += graph.node_count();
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  forecaster.stop();
+
+  std::printf("%llu forecast cycles (%.0f s ahead every %.1f s), last cycle %.2f ms, %zu/%zu blocks active\n",
+              static_cast<unsigned long long>(forecaster.cycles()), options.horizon_seconds,
+              options.cadence_seconds, forecaster.last_cycle_ms(), forecaster.last_active_blocks(),
+              forecaster.total_blocks());
+  std::printf("%llu repairs, %llu arc hazard changes, %llu queries (%llu routable), worst query %.2f us\n",
+              static_cast<unsigned long long>(repairs), static_cast<unsigned long long>(applied),
+              static_cast<unsigned long long>(queries), static_cast<unsigned long long>(routable), worst_query_us);
+  for (NodeId v = 0; v < graph.node_count(); ++v) {
+    const NodeId hop = router.next_hop(v);
+    if (graph.node_kind(v) == NodeKind::Exit) {
+      std::printf("node %u: exit\n", v);
+    } else if (hop == kInvalidNode) {
+      std::printf("node %u: no safe exit\n", v);
+    } else {
+      std::printf("node %u: next %u, %.1f s to exit\n", v, hop, router.distance(v) / 10.0f);
+    }
+  }
+  return 0;
+}
+
+}  // namespace evac::app
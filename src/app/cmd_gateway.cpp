@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app/commands.hpp"
+#include "gateway/gateway_server.hpp"
+#include "ingest/ingest_pipeline.hpp"
+#include "model/mapped_model.hpp"
+#include "net/guidance_server.hpp"
+#include "routing/guidance_snapshot.hpp"
+#include "routing/incremental_router.hpp"
+#include "telemetry/trace.hpp"
+
+namespace evac::app {
+
+// Site front end: devices connect over MQTT and Modbus/TCP, their readings go
+// through the ingest pipeline, and this thread plays the router, repairing
+// and publishing guidance (served on --guidance-port) for --seconds.
+int cmd_gateway(const Args& args) {
+  GatewayOptions options;
+  options.mqtt_port = 1883;
+  options.modbus_port = 1502;
+  long guidance_port = -1;
+  double seconds = 60.0;
+  std::vector<std::string> paths;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const std::string& a = args[i];
+    const bool has_value = i + 1 < args.size();
+    if (a == "--mqtt-port" && has_value) {
+      options.mqtt_port = static_cast<int>(std::strtol(args[++i].c_str(), nullptr, 10));
+    } else if (a == "--modbus-port" && has_value) {
+      options.modbus_port = static_cast<int>(std::strtol(args[++i].c_str(), nullptr, 10));
+    } else if (a == "--io-threads" && has_value) {
+      options.io_threads = std::max<std::size_t>(1, std::strtoull(args[++i].c_str(), nullptr, 10));
+    } else if (a == "--guidance-port" && has_value) {
+      guidance_port = std::strtol(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--seconds" && has_value) {
+      seconds = std::strtod(args[++i].c_str(), nullptr);
+    } else if (a == "--bind-all") {
+      options.loopback_only = false;
+    } else if (a[0] != '-') {
+      paths.push_back(a);
+    } else {
+      paths.clear();
+      break;
+    }
+  }
+  if (paths.size() != 2 || (options.mqtt_port < 0 && options.modbus_port < 0)) {
+    std::fprintf(stderr,
+                 "usage: main gateway <plan> <sensor-map> [--mqtt-port p] [--modbus-port p] [--io-threads n] "
+                 "[--guidance-port p] [--seconds s] [--bind-all]   (port -1 disables)\n");
+    return 2;
+  }
+
+  BuildingGraph graph = load_building(paths[0]);
+  const SensorMap sensors = load_sensor_map_file(paths[1], graph);
+  IncrementalRouter router(graph);
+  IngestOptions ingest;
+  ingest.producers = options.io_threads;
+  ingest.shards = std::min<std::size_t>(options.io_threads, 4);
+  IngestPipeline pipeline(sensors, graph.edge_count(), ingest);
+  set_trace_thread_name("router");
+
+  GuidancePublisher guidance;
+  std::uint64_t version = 0;
+  guidance.publish(std::make_shared<const GuidanceSnapshot>(graph, router.distances(), router.next_edges(), ++version));
+  std::unique_ptr<GuidanceServer> feed;
+  if (guidance_port >= 0) {
+    feed = std::make_unique<GuidanceServer>(guidance, static_cast<std::uint16_t>(guidance_port));
+    std::printf("guidance feed on port %u\n", feed->port());
+  }
+  GatewayServer gateway(pipeline, sensors, options);
+  if (options.mqtt_port >= 0) std::printf("mqtt on port %u\n", gateway.mqtt_port());
+  if (options.modbus_port >= 0) std::printf("modbus on port %u\n", gateway.modbus_port());
+  std::fflush(stdout);
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+  std::uint64_t repairs = 0;
+  while (std::chrono::steady_clock::now() < deadline) {
+    const std::span<const HazardUpdate> updates = pipeline.drain();
+    if (updates.empty()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    for (const HazardUpdate& u : updates) router.set_edge_hazard(u.edge, u.hazard);
+    router.repair();
+    guidance.publish(
+        std::make_shared<const GuidanceSnapshot>(graph, router.distances(), router.next_edges(), ++version));
+    if (feed) feed->notify();
+    if (pipeline.oldest_ingress_ns() != 0) {
+      trace_record(TraceStage::SensorToSign, trace_now_ns() - pipeline.oldest_ingress_ns());
+    }
+    ++repairs;
+  }
+
+  const GatewayCounters c = gateway.counters();
+  const IngestCounters ic = pipeline.counters();
+  std::printf("%llu connections (%llu open), %llu mqtt publishes, %llu modbus writes\n",
+              static_cast<unsigned long long>(c.accepted), static_cast<unsigned long long>(c.connections),
+              static_cast<unsigned long long>(c.mqtt_publishes), static_cast<unsigned long long>(c.modbus_writes));
+  std::printf("%llu readings (%llu unknown sensor), %llu rejected, %llu protocol errors, %llu repairs\n",
+              static_cast<unsigned long long>(c.readings), static_cast<unsigned long long>(ic.unknown_sensor),
+              static_cast<unsigned long long>(c.rejected), static_cast<unsigned long long>(c.protocol_errors),
+              static_cast<unsigned long long>(repairs));
+  return 0;
+}
+
+}  // namespace evac::app
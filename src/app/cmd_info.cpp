@@ -0,0 +1,45 @@
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+#include "app/commands.hpp"
+#include "model/mapped_model.hpp"
+
+namespace evac::app {
+
+int cmd_info(const Args& args) {
+  if (args.size() != 1) {
+    std::fprintf(stderr, "usage: main info <plan>\n");
+    return 2;
+  }
+  std::shared_ptr<const MappedModel> model;
+  if (is_model_file(args[0])) model = MappedModel::open(args[0]);
+  const BuildingGraph g = model ? graph_from_model(model) : load_building(args[0]);
+
+  std::array<std::size_t, 5> by_kind{};
+  for (NodeId v = 0; v < g.node_count(); ++v) ++by_kind[static_cast<std::size_t>(g.node_kind(v))];
+
+  std::printf("nodes %zu  arcs %zu  floors %d (lowest %d)\n", g.node_count(), g.edge_count(),
+              g.floor_count(), g.min_floor());
+  for (std::size_t k = 0; k < by_kind.size(); ++k) {
+    std::printf("  %-10s %zu\n", to_string(static_cast<NodeKind>(k)), by_kind[k]);
+  }
+  if (model) {
+    const ContingencyTables tables = contingencies_from_model(model, g);
+    if (!tables.empty()) std::printf("contingency tables %zu\n", tables.size());
+    for (std::uint32_t i = 0; i < tables.size(); ++i) {
+      const ContingencyEntry& c = tables.entry(i);
+      if (c.kind == static_cast<std::uint32_t>(ContingencyKind::Connection)) {
+        std::printf("  %3u connection %u-%u, %u routes\n", i, g.edge_source(c.element), g.edge_target(c.element),
+                    c.load);
+      } else {
+        std::printf("  %3u node %u, %u routes\n", i, c.element, c.load);
+      }
+    }
+  }
+  if (g.exits().empty()) std::printf("warning: plan has no exits\n");
+  return 0;
+}
+
+}  // namespace evac::app
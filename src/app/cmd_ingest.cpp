@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app/commands.hpp"
+#include "checkpoint/checkpoint_writer.hpp"
+#include "eventlog/event_log_writer.hpp"
+#include "eventlog/log_replay.hpp"
+#include "ingest/ingest_pipeline.hpp"
+#include "ingest/occupancy_fusion.hpp"
+#include "model/mapped_model.hpp"
+#include "net/guidance_server.hpp"
+#include "routing/edge_cost_versions.hpp"
+#include "routing/guidance_snapshot.hpp"
+#include "routing/incremental_router.hpp"
+#include "signage/signage_controller.hpp"
+#include "telemetry/metrics_server.hpp"
+#include "telemetry/trace.hpp"
+#include "util/rng.hpp"
+
+namespace evac::app {
+
+// Load test for the sensor path: producer threads encode random readings for
+// the mapped sensors into gateway frames and submit them, while this thread
+// plays the router, draining, coalescing and repairing the exit field, with
+// occupancy and Wi-Fi counts fused into per-arc queueing delays. With
+// --pollers, that many threads stand in for phones polling guidance: each
+// answers batches of random origins from the latest published snapshot, and
+// every 64th batch as a fresh route request: a sweep over the latest cost
+// version the router published, read under an epoch pin.
+// Stage latencies, including sensor-to-sign, are printed at the end, served on
+// --metrics-port while the run lasts, and dumped as a Chrome trace to --trace.
+// --log records every consumed reading and routing decision for `replay`.
+// --guidance-port serves the published snapshots as a guidance feed.
+// --signs drives the mapped exit signs from every published snapshot through
+// the signage controller; one bus thread stands in for the gateways' slow
+// links, flushing each gateway at most every 20 ms.
+// --checkpoint keeps a checkpoint of hazards, fused occupancy and the exit
+// field for a standby (`restore`), captured at most every --checkpoint-ms
+// after a publish and written in the background.
+int cmd_ingest(const Args& args) {
+  std::size_t producers = 4;
+  std::size_t pollers = 0;
+  long metrics_port = -1;
+  long guidance_port = -1;
+  std::string trace_path;
+  std::string log_path;
+  std::string signs_path;
+  std::string checkpoint_path;
+  std::uint64_t checkpoint_ms = 200;
+  std::uint64_t events = 200000;
+  std::uint64_t seed = 1;
+  std::vector<std::string> paths;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const std::string& a = args[i];
+    const bool has_value = i + 1 < args.size();
+    if (a == "--producers" && has_value) {
+      producers = std::max<std::size_t>(1, std::strtoull(args[++i].c_str(), nullptr, 10));
+    } else if (a == "--pollers" && has_value) {
+      pollers = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--guidance-port" && has_value) {
+      guidance_port = std::strtol(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--metrics-port" && has_value) {
+      metrics_port = std::strtol(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--log" && has_value) {
+      log_path = args[++i];
+    } else if (a == "--trace" && has_value) {
+      trace_path = args[++i];
+    } else if (a == "--signs" && has_value) {
+      signs_path = args[++i];
+    } else if (a == "--checkpoint" && has_value) {
+      checkpoint_path = args[++i];
+    } else if (a == "--checkpoint-ms" && has_value) {
+      checkpoint_ms = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--events" && has_value) {
+      events = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--seed" && has_value) {
+      seed = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a[0] != '-') {
+      paths.push_back(a);
+    } else {
+      paths.clear();
+      break;
+    }
+  }
+  if (paths.size() != 2) {
+    std::fprintf(stderr,
+                 "usage: main ingest <plan> <sensor-map> [--producers n] [--pollers n] [--events n] [--seed n] "
+                 "[--metrics-port p] [--guidance-port p] [--trace file] [--log file] [--signs file] "
+                 "[--checkpoint file] [--checkpoint-ms n]\n");
+    return 2;
+  }
+
+  BuildingGraph graph = load_building(paths[0]);
+  const SensorMap sensors = load_sensor_map_file(paths[1], graph);
+  if (sensors.sensor_count() == 0) {
+    std::fprintf(stderr, "sensor map is empty\n");
+    return 1;
+  }
+  IncrementalRouter router(graph);
+  EpochDomain cost_readers;
+  EdgeCostVersions costs(graph, cost_readers);
+  router.publish_costs(&costs);
+  IngestOptions options;
+  options.producers = producers;
+  options.shards = std::min<std::size_t>(producers, 4);
+  IngestPipeline pipeline(sensors, graph.edge_count(), options);
+  OccupancyFusion fusion(sensors, graph);
+  std::unique_ptr<MetricsServer> metrics;
+  if (metrics_port >= 0) {
+    metrics = std::make_unique<MetricsServer>(static_cast<std::uint16_t>(metrics_port));
+    std::printf("metrics on http://127.0.0.1:%u/metrics\n", metrics->port());
+  }
+  set_trace_thread_name("router");
+  const auto start = std::chrono::steady_clock::now();
+  const auto elapsed_us = [&] {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+  };
+  std::unique_ptr<EventLogWriter> log;
+  DecisionRecorder decisions(graph.node_count());
+  GuidancePublisher guidance;
+  std::uint64_t version = 0;
+  auto snapshot = std::make_shared<const GuidanceSnapshot>(graph, router.distances(), router.next_edges(),
+                                                          costs.current(), ++version);
+  guidance.publish(snapshot);
+  std::unique_ptr<GuidanceServer> feed;
+  if (guidance_port >= 0) {
+    feed = std::make_unique<GuidanceServer>(guidance, static_cast<std::uint16_t>(guidance_port));
+    std::printf("guidance feed on 127.0.0.1:%u\n", feed->port());
+  }
+  const SignMap signs = signs_path.empty() ? SignMap() : load_sign_map_file(signs_path, graph);
+  SignOutbox sign_outbox(signs);
+  SignageController signage(graph, signs, sign_outbox);
+  signage.update(*snapshot, elapsed_us());
+  std::atomic<bool> bus_running{true};
+  std::thread bus;
+  if (signs.sign_count() != 0) {
+    bus = std::thread([&] {
+      set_trace_thread_name("sign bus");
+      std::vector<std::byte> frame;
+      for (bool more = true; more;) {
+        more = bus_running.load(std::memory_order_acquire);
+        for (std::uint32_t gw = 0; gw < signs.gateway_count(); ++gw) {
+          frame.clear();
+          sign_outbox.take(gw, frame);
+        }
+        if (more) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+    });
+  }
+  if (!log_path.empty()) {
+    log = std::make_unique<EventLogWriter>(log_path);
+    pipeline.set_event_log(log.get());
+    decisions.record(*log, elapsed_us(), 0, snapshot.get());
+  }
+
+  std::unique_ptr<CheckpointWriter> checkpoints;
+  std::vector<float> zone_people(fusion.zone_count());
+  std::uint64_t last_checkpoint_us = 0;
+  const auto checkpoint = [&](std::uint64_t now_us) {
+    for (std::uint32_t z = 0; z < zone_people.size(); ++z) zone_people[z] = fusion.zone_occupancy(z);
+    CheckpointState state;
+    state.time_us = now_us;
+    state.version = version;
+    state.edge_hazard = graph.edge_hazards();
+    state.edge_congestion = graph.edge_congestions();
+    state.zone_occupancy = zone_people;
+    state.distance = router.distances();
+    state.next_edge = router.next_edges();
+    checkpoints->submit(state);
+    last_checkpoint_us = now_us;
+  };
+  if (!checkpoint_path.empty()) {
+    checkpoints = std::make_unique<CheckpointWriter>(
+        checkpoint_path, CheckpointShape{graph.node_count(), graph.edge_count(), fusion.zone_count(), 0});
+    checkpoint(elapsed_us());
+  }
+
+  std::atomic<std::size_t> finished{0};
+  std::vector<std::thread> threads;
+  for (std::size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      const std::string name = "producer " + std::to_string(p);
+      set_trace_thread_name(name.c_str());
+      SplitMix64 rng(seed * 7919 + p);
+      std::vector<SensorEvent> batch(64);
+      std::vector<std::byte> frame;
+      const std::uint64_t share = events / producers + (p < events % producers ? 1 : 0);
+      for (std::uint64_t sent = 0; sent < share; sent += batch.size()) {
+        batch.resize(std::min<std::uint64_t>(64, share - sent));
+        const std::uint64_t now_us = elapsed_us();
+        for (SensorEvent& e : batch) {
+          const std::uint32_t s = rng.below(static_cast<std::uint32_t>(sensors.sensor_count()));
+          e.sensor_id = sensors.sensor_id(s);
+          e.kind = sensors.kind(s);
+          e.timestamp_us = now_us;
+          if (e.kind == SensorKind::Heat) e.value = rng.uniform(20.0f, 90.0f);
+          else if (is_occupancy_sensor(e.kind)) e.value = rng.uniform(0.0f, 40.0f);
+          else e.value = rng.uniform();
+        }
+        frame.clear();
+        encode_event_frame(batch, frame);
+        pipeline.submit_frame(static_cast<unsigned>(p), frame);
+      }
+      finished.fetch_add(1, std::memory_order_release);
+    });
+  }
+  std::atomic<bool> polling{true};
+  std::atomic<std::uint64_t> polled{0};
+  std::atomic<std::uint64_t> swept{0};
+  std::vector<std::thread> poll_threads;
+  for (std::size_t p = 0; p < pollers; ++p) {
+    poll_threads.emplace_back([&, p] {
+      EpochDomain::Reader reader(cost_readers);
+      Arena scratch;
+      SplitMix64 rng(seed * 104729 + p);
+      std::vector<NodeId> origins(256);
+      std::vector<GuidanceAnswer> answers(origins.size());
+      std::uint64_t answered = 0, sweeps = 0;
+      for (std::uint64_t round = 1; polling.load(std::memory_order_relaxed); ++round) {
+        for (NodeId& v : origins) v = rng.below(static_cast<std::uint32_t>(graph.node_count()));
+        if (round % 64 == 0) {
+          const auto pin = reader.pin();
+          answer_batch(graph, costs.current(), origins, answers, scratch);
+          ++sweeps;
+        } else {
+          guidance.current()->answer(origins, answers);
+        }
+        answered += origins.size();
+      }
+      polled.fetch_add(answered, std::memory_order_relaxed);
+      swept.fetch_add(sweeps, std::memory_order_relaxed);
+    });
+  }
+
+  std::uint64_t repairs = 0;
+  std::uint64_t arc_updates = 0;
+  std::uint64_t congestion_updates = 0;
+  double worst_repair_us = 0.0;
+  for (;;) {
+    const bool last = finished.load(std::memory_order_acquire) == producers;
+    const std::uint64_t drained_before = pipeline.drained_readings();
+    const std::span<const HazardUpdate> updates = pipeline.drain();
+    const auto batch = static_cast<std::uint32_t>(pipeline.drained_readings() - drained_before);
+    // One fused congestion update per drain that may publish; replay repeats
+    // it at the same logged timestamp.
+    const std::uint64_t now_us = elapsed_us();
+    fusion.add(pipeline.occupancy());
+    const std::span<const CongestionUpdate> congestion =
+        batch != 0 ? fusion.update(now_us) : std::span<const CongestionUpdate>();
+    if (!updates.empty() || !congestion.empty()) {
+      const auto t0 = std::chrono::steady_clock::now();
+      for (const HazardUpdate& u : updates) router.set_edge_hazard(u.edge, u.hazard);
+      for (const CongestionUpdate& u : congestion) router.set_edge_congestion(u.edge, u.delay_s);
+      router.repair();
+      const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+      worst_repair_us = std::max(worst_repair_us, us);
+      snapshot = std::make_shared<const GuidanceSnapshot>(graph, router.distances(), router.next_edges(),
+                                                          costs.current(), ++version);
+      guidance.publish(snapshot);
+      if (feed) feed->notify();
+      if (signs.sign_count() != 0) signage.update(*snapshot, now_us);
+      if (checkpoints && now_us - last_checkpoint_us >= checkpoint_ms * 1000) checkpoint(now_us);
+      if (pipeline.oldest_ingress_ns() != 0) {
+        trace_record(TraceStage::SensorToSign, trace_now_ns() - pipeline.oldest_ingress_ns());
+      }
+      arc_updates += updates.size();
+      congestion_updates += congestion.size();
+      ++repairs;
+    }
+    const bool published = !updates.empty() || !congestion.empty();
+    if (log && batch != 0) decisions.record(*log, now_us, batch, published ? snapshot.get() : nullptr);
+    if (last && !published && pipeline.drained_readings() == pipeline.counters().accepted) break;
+    if (!published) std::this_thread::yield();
+  }
+  for (std::thread& t : threads) t.join();
+  polling.store(false, std::memory_order_relaxed);
+  for (std::thread& t : poll_threads) t.join();
+  bus_running.store(false, std::memory_order_release);
+  if (bus.joinable()) bus.join();
+  if (checkpoints) {
+    checkpoint(elapsed_us());
+    checkpoints->flush();
+  }
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  const IngestCounters c = pipeline.counters();
+  std::printf("%llu readings in %.3f s (%.0f/s) from %zu producers, %llu backpressure spins\n",
+              static_cast<unsigned long long>(pipeline.drained_readings()), secs,
+              secs > 0.0 ? pipeline.drained_readings() / secs : 0.0, producers,
+              static_cast<unsigned long long>(c.backpressure_spins));
+  std::printf("%llu repairs, %llu coalesced arc updates, worst repair %.1f us\n",
+              static_cast<unsigned long long>(repairs), static_cast<unsigned long long>(arc_updates),
+              worst_repair_us);
+  std::printf("occupancy: %zu zones over %zu arcs, %llu congestion updates, %llu late readings dropped\n",
+              fusion.zone_count(), fusion.covered_arcs(), static_cast<unsigned long long>(congestion_updates),
+              static_cast<unsigned long long>(fusion.dropped_late()));
+  if (pollers > 0) {
+    std::printf("%llu guidance answers (%.0f/s) from %zu pollers over %llu snapshots, %llu sweeps over %llu cost "
+                "versions\n",
+                static_cast<unsigned long long>(polled.load()), secs > 0.0 ? polled.load() / secs : 0.0, pollers,
+                static_cast<unsigned long long>(version), static_cast<unsigned long long>(swept.load()),
+                static_cast<unsigned long long>(costs.current().version()));
+  }
+  if (feed) {
+    const GuidanceServerCounters fc = feed->counters();
+    std::printf("feed: %llu clients served, %llu versions, %llu full + %llu delta frames, %llu bytes\n",
+                static_cast<unsigned long long>(fc.accepted), static_cast<unsigned long long>(fc.versions),
+                static_cast<unsigned long long>(fc.full_frames), static_cast<unsigned long long>(fc.delta_frames),
+                static_cast<unsigned long long>(fc.bytes_sent));
+  }
+  if (signs.sign_count() != 0) {
+    const SignageStats& ss = signage.stats();
+    const SignOutboxCounters sc = sign_outbox.counters();
+    std::uint64_t full_bytes = 0;  // every sign's state in every snapshot
+    for (std::uint32_t gw = 0; gw < signs.gateway_count(); ++gw) {
+      full_bytes += kSignFrameHeaderSize + signs.signs_of(gw).size() * kSignCommandSize;
+    }
+    full_bytes *= ss.snapshots;
+    std::printf("signs: %zu on %zu gateways, %llu snapshots, %llu changes (%llu urgent), %llu flips held back\n",
+                signs.sign_count(), signs.gateway_count(), static_cast<unsigned long long>(ss.snapshots),
+                static_cast<unsigned long long>(ss.changes), static_cast<unsigned long long>(ss.urgent),
+                static_cast<unsigned long long>(ss.suppressed));
+    std::printf("sign bus: %llu frames, %llu commands (%llu collapsed), %llu bytes vs %llu for full tables\n",
+                static_cast<unsigned long long>(sc.frames), static_cast<unsigned long long>(sc.commands),
+                static_cast<unsigned long long>(sc.collapsed), static_cast<unsigned long long>(sc.bytes),
+                static_cast<unsigned long long>(full_bytes));
+  }
+  if (log) {
+    log->flush();
+    const EventLogCounters lc = log->counters();
+    std::printf("log: %llu records in %llu blocks, %llu commits, %.1f bytes/record, %.1fx compression%s\n",
+                static_cast<unsigned long long>(lc.records), static_cast<unsigned long long>(lc.blocks),
+                static_cast<unsigned long long>(lc.commits),
+                lc.records ? static_cast<double>(lc.file_bytes) / lc.records : 0.0,
+                lc.file_bytes ? static_cast<double>(lc.raw_bytes) / lc.file_bytes : 0.0,
+                log->failed() ? " (write FAILED)" : "");
+  }
+  if (checkpoints) {
+    const CheckpointCounters cc = checkpoints->counters();
+    std::printf("checkpoints: %llu written (%llu superseded), %llu of %llu pages dirty, %llu bytes, last %.2f ms%s\n",
+                static_cast<unsigned long long>(cc.written), static_cast<unsigned long long>(cc.superseded),
+                static_cast<unsigned long long>(cc.pages_written), static_cast<unsigned long long>(cc.pages_total),
+                static_cast<unsigned long long>(cc.bytes_written), cc.last_write_us / 1e3,
+                checkpoints->failed() ? " (write FAILED)" : "");
+  }
+  std::printf("%-15s %10s %10s %10s %10s %10s\n", "stage", "count", "p50_us", "p99_us", "p99.9_us", "max_us");
+  const auto merged = std::make_unique<HdrHistogram>();
+  for (std::size_t st = 0; st < kTraceStageCount; ++st) {
+    merged_histogram(static_cast<TraceStage>(st), *merged);
+    if (merged->count() == 0) continue;
+    std::printf("%-15s %10llu %10.1f %10.1f %10.1f %10.1f\n", to_string(static_cast<TraceStage>(st)),
+                static_cast<unsigned long long>(merged->count()), merged->percentile(50.0) / 1e3,
+                merged->percentile(99.0) / 1e3, merged->percentile(99.9) / 1e3, merged->max() / 1e3);
+  }
+  if (!trace_path.empty() && !write_chrome_trace(trace_path)) {
+    std::fprintf(stderr, "cannot write %s\n", trace_path.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace evac::app
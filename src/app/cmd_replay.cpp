@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "app/commands.hpp"
+#include "eventlog/log_replay.hpp"
+#include "ingest/sensor_map.hpp"
+#include "model/mapped_model.hpp"
+
+namespace evac::app {
+
+// Re-drives the ingest pipeline and router from an `ingest --log` recording
+// and reports whether the replayed routing decisions match the logged ones.
+int cmd_replay(const Args& args) {
+  double speed = 100.0;
+  std::vector<std::string> positional;
+  bool ok = true;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const std::string& a = args[i];
+    const bool has_value = i + 1 < args.size();
+    if (a == "--speed" && has_value) {
+      speed = std::strtod(args[++i].c_str(), nullptr);
+    } else if (a[0] != '-') {
+      positional.push_back(a);
+    } else {
+      ok = false;
+    }
+  }
+  if (!ok || positional.size() != 3 || speed < 0.0) {
+    std::fprintf(stderr, "usage: main replay <plan> <sensor-map> <log> [--speed x]  (0 = unpaced)\n");
+    return 2;
+  }
+
+  BuildingGraph graph = load_building(positional[0]);
+  const SensorMap sensors = load_sensor_map_file(positional[1], graph);
+  const ReplayStats stats = replay_event_log(positional[2], graph, sensors, speed);
+
+  std::printf("records:     %llu (%llu readings, %llu routes)%s\n", static_cast<unsigned long long>(stats.records),
+              static_cast<unsigned long long>(stats.sensor_records),
+              static_cast<unsigned long long>(stats.route_records), stats.truncated ? ", log truncated" : "");
+  std::printf("drains:      %llu (%llu published, %llu split)\n", static_cast<unsigned long long>(stats.drains),
+              static_cast<unsigned long long>(stats.publications),
+              static_cast<unsigned long long>(stats.split_drains));
+  std::printf("time:        %.3f s logged, %.3f s replayed (%.1fx)\n", stats.logged_seconds, stats.replay_seconds,
+              stats.replay_seconds > 0.0 ? stats.logged_seconds / stats.replay_seconds : 0.0);
+  std::printf("mismatches:  %llu batch, %llu divergent\n", static_cast<unsigned long long>(stats.batch_mismatches),
+              static_cast<unsigned long long>(stats.divergent_drains));
+  return stats.batch_mismatches == 0 && stats.divergent_drains == 0 ? 0 : 1;
+}
+
+}  // namespace evac::app
@@ -0,0 +1,103 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "app/commands.hpp"
+#include "checkpoint/mapped_checkpoint.hpp"
+#include "model/mapped_model.hpp"
+#include "routing/incremental_router.hpp"
+
+namespace evac::app {
+namespace {
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+}  // namespace
+
+// Standby takeover: maps a checkpoint written by `ingest --checkpoint` or
+// `simulate --checkpoint`, restores hazards, congestion and the exit field
+// from its newest committed slot and reports what was recovered and how long
+// each step took, against a cold solve of the same state. --verify also checks
+// the slot's data checksum.
+int cmd_restore(const Args& args) {
+  bool verify = false;
+  std::vector<std::string> positional;
+  bool ok = true;
+  for (const std::string& a : args) {
+    if (a == "--verify") {
+      verify = true;
+    } else if (a[0] != '-') {
+      positional.push_back(a);
+    } else {
+      ok = false;
+    }
+  }
+  if (!ok || positional.size() != 2) {
+    std::fprintf(stderr, "usage: main restore <plan> <checkpoint> [--verify]\n");
+    return 2;
+  }
+
+  BuildingGraph graph = load_building(positional[0]);
+  auto t0 = std::chrono::steady_clock::now();
+  const std::shared_ptr<const MappedCheckpoint> checkpoint = MappedCheckpoint::open(positional[1]);
+  const double open_ms = ms_since(t0);
+  t0 = std::chrono::steady_clock::now();
+  RestoredState state;
+  if (!read_latest_checkpoint(*checkpoint, state)) {
+    std::fprintf(stderr, "%s: no committed checkpoint yet\n", positional[1].c_str());
+    return 1;
+  }
+  const double read_ms = ms_since(t0);
+  if (verify) {
+    const int slot = checkpoint->latest_slot();
+    SlotHeader h;
+    if (!checkpoint->slot_header(slot, h) || h.sequence != state.slot.sequence || !checkpoint->verify(slot)) {
+      std::fprintf(stderr, "%s: checkpoint %llu fails its checksum\n", positional[1].c_str(),
+                   static_cast<unsigned long long>(state.slot.sequence));
+      return 1;
+    }
+  }
+  t0 = std::chrono::steady_clock::now();
+  apply_checkpoint(state, graph);
+  const IncrementalRouter router(graph, state.distance, state.next_edge);
+  const double warm_ms = ms_since(t0);
+  t0 = std::chrono::steady_clock::now();
+  const IncrementalRouter cold(graph);
+  const double cold_ms = ms_since(t0);
+
+  std::size_t smoked = 0;
+  std::size_t closed = 0;
+  std::size_t congested = 0;
+  for (EdgeId e = 0; e < graph.edge_count(); ++e) {
+    closed += graph.edge_hazard(e) >= kImpassableHazard;
+    smoked += graph.edge_hazard(e) > 0.0f && graph.edge_hazard(e) < kImpassableHazard;
+    congested += graph.edge_congestion(e) > 0.0f;
+  }
+  double people = 0.0;
+  for (const float z : state.zone_occupancy) people += z;
+  std::size_t inside = 0;
+  for (const std::uint8_t out : state.agents.evacuated) inside += out == 0;
+  std::size_t mismatches = 0;
+  std::size_t stale_hops = 0;
+  for (NodeId v = 0; v < graph.node_count(); ++v) {
+    mismatches += router.distance(v) != cold.distance(v);
+    stale_hops += router.next_edge(v) != state.next_edge[v];
+  }
+
+  std::printf("checkpoint %llu at t=%.3f s, guidance version %llu\n",
+              static_cast<unsigned long long>(state.slot.sequence), state.slot.time_us / 1e6,
+              static_cast<unsigned long long>(state.slot.version));
+  std::printf("hazards:   %zu arcs smoked, %zu closed, %zu with queueing delay\n", smoked, closed, congested);
+  std::printf("occupancy: %.1f people over %zu zones\n", people, state.zone_occupancy.size());
+  std::printf("agents:    %zu inside of %zu\n", inside, state.agents.size());
+  std::printf("field:     %zu next hops moved by the warm repair, %zu distances differ from a cold solve\n",
+              stale_hops, mismatches);
+  std::printf("restore:   open %.3f ms, copy %.3f ms, warm router %.3f ms (cold solve %.3f ms)\n", open_ms, read_ms,
+              warm_ms, cold_ms);
+  return mismatches == 0 ? 0 : 1;
+}
+
+}  // namespace evac::app
@@ -0,0 +1,287 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "app/commands.hpp"
+#include "graph/plan_loader.hpp"
+#include "model/mapped_model.hpp"
+#include "routing/contingency_tables.hpp"
+#include "routing/cost_policy.hpp"
+#include "routing/exit_field.hpp"
+#include "routing/guidance_snapshot.hpp"
+#include "routing/incremental_router.hpp"
+#include "routing/overlay_router.hpp"
+
+namespace evac::app {
+namespace {
+
+// Router is taken by non-const reference: OverlayRouter fills its per-floor
+// caches on query.
+template <class Router>
+void print_route(Router& router, NodeId v) {
+  const Cost d = router.distance(v);
+  if (d == kInfiniteCost) {
+    std::printf("  %6u -> %-6s  unreachable\n", v, "-");
+  } else if (router.next_hop(v) == kInvalidNode) {
+    std::printf("  %6u -> %-6s  %8.1f s\n", v, "exit", d / 10.0);
+  } else {
+    std::printf("  %6u -> %-6u  %8.1f s\n", v, router.next_hop(v), d / 10.0);
+  }
+}
+
+// One stdin line: the arcs it sets and the hazard level they get, or a
+// batch of origins to answer.
+struct RouteUpdate {
+  std::vector<EdgeId> arcs;
+  float level = 0.0f;
+  EdgeId connection = kInvalidEdge;  // "hazard": the a->b arc
+  NodeId closed = kInvalidNode;      // "close": the node
+  std::vector<NodeId> origins;       // "query"; empty for updates
+  CostModel query_model = CostModel::Smoke;
+};
+
+// False, with a message on stderr, for blank or malformed lines.
+bool parse_update(const BuildingGraph& graph, const std::string& line, RouteUpdate& out) {
+  std::istringstream fields(line);
+  std::string verb;
+  NodeId a = 0;
+  NodeId b = 0;
+  std::string model;
+  out.arcs.clear();
+  out.connection = kInvalidEdge;
+  out.closed = kInvalidNode;
+  out.origins.clear();
+  if (!(fields >> verb)) return false;
+  if (verb == "query" && fields >> model && parse_cost_model(model.c_str(), out.query_model)) {
+    bool valid = true;
+    while (fields >> a) {
+      valid &= a < graph.node_count();
+      out.origins.push_back(a);
+    }
+    if (valid && !out.origins.empty() && fields.eof()) return true;
+    out.origins.clear();
+  }
+  if (verb == "hazard" && fields >> a >> b >> out.level && a < graph.node_count() && b < graph.node_count()) {
+    const EdgeId e = graph.find_edge(a, b);
+    if (e == kInvalidEdge) {
+      std::fprintf(stderr, "no connection %u-%u\n", a, b);
+      return false;
+    }
+    out.connection = e;
+    out.arcs.push_back(e);
+    if (const EdgeId twin = graph.edge_twin(e); twin != kInvalidEdge) out.arcs.push_back(twin);
+    return true;
+  }
+  if (verb == "close" && fields >> a && a < graph.node_count()) {
+    contingency_arcs(graph, {static_cast<std::uint32_t>(ContingencyKind::Node), a, 0, 0}, out.arcs);
+    out.level = kImpassableHazard;
+    out.closed = a;
+    return true;
+  }
+  std::fprintf(stderr, "ignored: %s\n", line.c_str());
+  return false;
+}
+
+// --check: the router's distances against a full solve of the same costs.
+// Returns the number of nodes that differ.
+template <CostPolicy Policy, class Router>
+std::size_t check_route(const BuildingGraph& graph, Router& router) {
+  ExitField reference;
+  solve_exit_field<Policy>(graph, reference, scratch_arena());
+  std::size_t differ = 0;
+  for (NodeId v = 0; v < graph.node_count(); ++v) differ += router.distance(v) != reference.distance[v];
+  std::printf("check: %zu of %zu distances differ from a full solve\n", differ, graph.node_count());
+  return differ;
+}
+
+// A "query" line as one answer_batch() sweep under the requested cost model,
+// which need not be the one the router maintains (accessible routes for
+// wheelchair users next to the smoke-aware field, say). The sweep reads the
+// live arc hazards, so it runs here on the routing thread between repairs.
+// Returns the number of answers that differ from a full solve under --check.
+std::size_t run_query(const BuildingGraph& graph, const RouteUpdate& update, bool check) {
+  std::vector<GuidanceAnswer> answers(update.origins.size());
+  return with_cost_policy(update.query_model, [&](auto policy) -> std::size_t {
+    using Policy = decltype(policy);
+    const auto start = std::chrono::steady_clock::now();
+    answer_batch<Policy>(graph, update.origins, answers, scratch_arena());
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    std::printf("query: %zu origins, cost %s, %lld us\n", answers.size(), to_string(Policy::kModel),
+                static_cast<long long>(us));
+    for (const GuidanceAnswer& a : answers) {
+      if (a.distance == kInfiniteCost) {
+        std::printf("  %6u -> %-6s  unreachable\n", a.origin, "-");
+      } else {
+        std::printf("  %6u -> %-6s  %8.1f s via exit %u\n", a.origin,
+                    a.next_hop == kInvalidNode ? "exit" : std::to_string(a.next_hop).c_str(), a.distance / 10.0,
+                    a.exit);
+      }
+    }
+    if (!check) return 0;
+    ExitField reference;
+    solve_exit_field<Policy>(graph, reference, scratch_arena());
+    std::size_t differ = 0;
+    for (const GuidanceAnswer& a : answers) differ += a.distance != reference.distance[a.origin];
+    std::printf("check: %zu of %zu answers differ from a full solve\n", differ, answers.size());
+    return differ;
+  });
+}
+
+// One specialised loop per cost model; the model is chosen once, in cmd_route().
+// Contingency tables are solved with SmokeCost, so only that loop uses them.
+template <CostPolicy Policy>
+int run_route(BuildingGraph& graph, const ContingencyTables& tables, bool check) {
+  BasicIncrementalRouter<Policy> router(graph);
+  for (NodeId v = 0; v < graph.node_count(); ++v) print_route(router, v);
+  std::size_t differ = check ? check_route<Policy>(graph, router) : 0;
+  std::fflush(stdout);
+
+  std::string line;
+  RouteUpdate update;
+  while (std::getline(std::cin, line)) {
+    if (!parse_update(graph, line, update)) continue;
+    if (!update.origins.empty()) {
+      differ += run_query(graph, update, check);
+      std::fflush(stdout);
+      continue;
+    }
+    for (EdgeId e : update.arcs) router.set_edge_hazard(e, update.level);
+    std::uint32_t table = ContingencyTables::kNone;
+    if (update.closed != kInvalidNode) {
+      table = tables.match_node(update.closed);
+    } else if (update.level >= kImpassableHazard) {
+      table = tables.match_connection(update.connection);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    RepairStats stats;
+    if constexpr (std::is_same_v<Policy, SmokeCost>) {
+      if (table != ContingencyTables::kNone) {
+        std::printf("contingency table %u\n", table);
+        stats = router.repair_from(tables.distances(table), tables.next_edges(table));
+      } else {
+        stats = router.repair();
+      }
+    } else {
+      stats = router.repair();
+    }
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    std::printf("repair: %zu arcs, %zu expanded, %zu next hops changed, %lld us\n",
+                stats.changed_edges, stats.expanded_nodes, stats.changed_next_hops,
+                static_cast<long long>(us));
+    router.for_each_changed_next_hop([&](NodeId v) { print_route(router, v); });
+    if (check) differ += check_route<Policy>(graph, router);
+    std::fflush(stdout);
+  }
+  return differ == 0 ? 0 : 1;
+}
+
+// --overlay: the same protocol on the floor-overlay router, which prices arcs
+// with SmokeCost and has no contingency tables. It keeps no change list, so
+// changed next hops are found against the previous table.
+int run_overlay_route(BuildingGraph& graph, bool check) {
+  OverlayRouter router(graph);
+  std::vector<NodeId> hops(graph.node_count());
+  for (NodeId v = 0; v < graph.node_count(); ++v) {
+    hops[v] = router.next_hop(v);
+    print_route(router, v);
+  }
+  std::printf("overlay: %zu portals over %d floors\n", router.portal_count(), graph.floor_count());
+  std::size_t differ = check ? check_route<SmokeCost>(graph, router) : 0;
+  std::fflush(stdout);
+
+  std::string line;
+  RouteUpdate update;
+  while (std::getline(std::cin, line)) {
+    if (!parse_update(graph, line, update)) continue;
+    if (!update.origins.empty()) {
+      differ += run_query(graph, update, check);
+      std::fflush(stdout);
+      continue;
+    }
+    for (EdgeId e : update.arcs) router.set_edge_hazard(e, update.level);
+    const auto start = std::chrono::steady_clock::now();
+    const OverlayRepairStats stats = router.repair();
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    std::printf("repair: %zu arcs, %zu floors customised, %zu overlay nodes, %lld us\n", stats.changed_edges,
+                stats.customised_floors, stats.overlay_nodes, static_cast<long long>(us));
+    for (NodeId v = 0; v < graph.node_count(); ++v) {
+      const NodeId hop = router.next_hop(v);
+      if (hop == hops[v]) continue;
+      hops[v] = hop;
+      print_route(router, v);
+    }
+    if (check) differ += check_route<SmokeCost>(graph, router);
+    std::fflush(stdout);
+  }
+  return differ == 0 ? 0 : 1;
+}
+
+}  // namespace
+
+// Prints the initial next-hop table, then reads hazard updates from stdin:
+//
+//   hazard <a> <b> <level>    set both arcs of connection a-b (0 clear .. 1 closed)
+//   close <v>                 close every arc at node v
+//   query <cost> <v>...       route these origins under a cost model, as one batch
+//
+// Each update is repaired incrementally and the changed next hops are printed.
+// A closure the model has a contingency table for (compile --contingencies)
+// starts the repair from that table instead of the current field.
+// --cost picks the cost model (smoke, distance or accessible). --overlay
+// routes through the two-level floor-overlay router instead (smoke cost
+// only). --check solves the field from scratch after every update and
+// compares distances; the exit status is 1 if any differed.
+int cmd_route(const Args& args) {
+  CostModel model = CostModel::Smoke;
+  bool overlay = false;
+  bool check = false;
+  std::string path;
+  bool ok = true;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    if (args[i] == "--cost" && i + 1 < args.size() && parse_cost_model(args[i + 1].c_str(), model)) {
+      ++i;
+    } else if (args[i] == "--overlay") {
+      overlay = true;
+    } else if (args[i] == "--check") {
+      check = true;
+    } else if (args[i][0] != '-' && path.empty()) {
+      path = args[i];
+    } else {
+      ok = false;
+    }
+  }
+  if (!ok || path.empty()) {
+    std::fprintf(stderr, "usage: main route <plan> [--cost smoke|distance|accessible] [--overlay] [--check]  "
+                 "(hazard updates on stdin)\n");
+    return 2;
+  }
+  if (overlay && model != CostModel::Smoke) {
+    std::fprintf(stderr, "--overlay routes with the smoke cost only\n");
+    return 2;
+  }
+  ContingencyTables tables;
+  BuildingGraph graph;
+  if (is_model_file(path)) {
+    const std::shared_ptr<const MappedModel> mapped = MappedModel::open(path);
+    graph = graph_from_model(mapped);
+    tables = contingencies_from_model(mapped, graph);
+  } else {
+    graph = load_plan_file(path);
+  }
+  if (overlay) return run_overlay_route(graph, check);
+  return with_cost_policy(model, [&](auto policy) { return run_route<decltype(policy)>(graph, tables, check); });
+}
+
+}  // namespace evac::app
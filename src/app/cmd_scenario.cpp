@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app/commands.hpp"
+#include "model/mapped_model.hpp"
+#include "scenario/scenario_runner.hpp"
+
+namespace evac::app {
+namespace {
+
+// "12,13,40" -> node ids; false on anything that is not a node of g.
+bool parse_node_list(const std::string& text, const BuildingGraph& g, std::vector<NodeId>& out) {
+  out.clear();
+  std::size_t start = 0;
+  while (start <= text.size()) {
+    const std::size_t end = std::min(text.find(',', start), text.size());
+    const std::string item = text.substr(start, end - start);
+    char* rest = nullptr;
+    const unsigned long v = std::strtoul(item.c_str(), &rest, 10);
+    if (item.empty() || *rest != '\0' || v >= g.node_count()) return false;
+    out.push_back(static_cast<NodeId>(v));
+    start = end + 1;
+  }
+  return !out.empty();
+}
+
+}  // namespace
+
+// What-if comparison: each --close option closes the arcs around a set of
+// nodes (a stairwell, a corridor), and every option, plus the world as it
+// stands, is run as a Monte Carlo batch of crowd evacuations.
+int cmd_scenario(const Args& args) {
+  MonteCarloParams params;
+  unsigned threads = 0;
+  std::vector<std::string> closures;
+  std::string path;
+  bool ok = true;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const std::string& a = args[i];
+    const bool has_value = i + 1 < args.size();
+    if (a == "--close" && has_value) {
+      closures.push_back(args[++i]);
+    } else if (a == "--runs" && has_value) {
+      params.runs = std::max<std::size_t>(1, std::strtoull(args[++i].c_str(), nullptr, 10));
+    } else if (a == "--agents" && has_value) {
+      params.agents = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--seed" && has_value) {
+      params.seed = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--max-seconds" && has_value) {
+      params.max_seconds = std::strtod(args[++i].c_str(), nullptr);
+    } else if (a == "--threads" && has_value) {
+      threads = static_cast<unsigned>(std::strtoul(args[++i].c_str(), nullptr, 10));
+    } else if (a[0] != '-' && path.empty()) {
+      path = a;
+    } else {
+      ok = false;
+    }
+  }
+  if (!ok || path.empty()) {
+    std::fprintf(stderr,
+                 "usage: main scenario <plan> [--close n,n...]... [--runs k] [--agents n] [--seed n] "
+                 "[--max-seconds s] [--threads n]\n");
+    return 2;
+  }
+
+  const BuildingGraph graph = load_building(path);
+  std::vector<ScenarioOption> options;
+  options.push_back({"as-is", {}});
+  std::vector<NodeId> nodes;
+  for (const std::string& c : closures) {
+    if (!parse_node_list(c, graph, nodes)) {
+      std::fprintf(stderr, "bad node list '%s'\n", c.c_str());
+      return 2;
+    }
+    options.push_back(close_nodes_option(graph, "close " + c, nodes));
+  }
+
+  WorkStealingPool pool(threads != 0 ? threads : std::thread::hardware_concurrency());
+  ScenarioRunner runner(graph, pool);
+  const auto start = std::chrono::steady_clock::now();
+  const std::vector<OptionSummary> summaries = runner.run(options, params);
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::printf("%-20s %8s %8s %8s %8s %8s %10s %8s\n", "option", "mean_s", "p10_s", "p50_s", "p90_s", "worst_s",
+              "incomplete", "fork_kb");
+  for (const OptionSummary& s : summaries) {
+    std::printf("%-20s %8.1f %8.1f %8.1f %8.1f %8.1f %10zu %8.1f\n", s.name.c_str(), s.mean_egress, s.p10_egress,
+                s.p50_egress, s.p90_egress, s.runs.empty() ? 0.0 : s.runs.back().egress_seconds, s.incomplete,
+                s.fork_bytes / 1024.0);
+  }
+  std::printf("%zu runs of %zu agents in %.3f s on %u workers\n", summaries.size() * params.runs, params.agents,
+              secs, pool.workers());
+  return 0;
+}
+
+}  // namespace evac::app
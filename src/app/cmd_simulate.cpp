@@ -0,0 +1,247 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "app/commands.hpp"
+#include "checkpoint/checkpoint_writer.hpp"
+#include "checkpoint/mapped_checkpoint.hpp"
+#include "crowd/crowd_backend.hpp"
+#include "crowd/crowd_sim.hpp"
+#include "crowd/cuda_crowd.hpp"
+#include "crowd/hybrid_crowd.hpp"
+#include "model/mapped_model.hpp"
+#include "routing/incremental_router.hpp"
+
+namespace evac::app {
+namespace {
+
+// FNV-1a over agent positions; equal across runs iff the simulation reproduced.
+std::uint64_t state_checksum(const AgentPopulation& agents) {
+  std::uint64_t h = 0xcbf29ce484222325ull;
+  auto mix = [&](float f) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof bits);
+    for (int k = 0; k < 4; ++k) {
+      h ^= (bits >> (8 * k)) & 0xffu;
+      h *= 0x100000001b3ull;
+    }
+  };
+  for (std::size_t i = 0; i < agents.size(); ++i) {
+    mix(agents.x[i]);
+    mix(agents.y[i]);
+  }
+  return h;
+}
+
+#if EVAC_WITH_CUDA
+// Same loop on the device; the state comes back only for the checksum.
+int simulate_cuda(const BuildingGraph& graph, const IncrementalRouter& router, AgentPopulation& agents,
+                  std::uint64_t ticks, const CrowdParams& params) {
+  CudaCrowdSimulator sim(graph, params);
+  sim.set_next_edges(router.next_edges());
+  sim.upload(agents);
+  const auto start = std::chrono::steady_clock::now();
+  TickStats stats;
+  const auto report_every = static_cast<std::uint64_t>(10.0f / sim.params().dt);
+  while (stats.tick < ticks) {
+    stats = sim.step();
+    if (stats.tick % report_every == 0) {
+      std::printf("t=%7.1f s  inside %zu\n", stats.tick * sim.params().dt, stats.active);
+    }
+    if (stats.active == 0) break;
+  }
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  sim.download(agents);
+  std::printf("%llu ticks (%.1f s simulated) in %.3f s: %.1f ticks/s on cuda, %zu still inside\n",
+              static_cast<unsigned long long>(stats.tick), stats.tick * sim.params().dt, secs,
+              secs > 0.0 ? stats.tick / secs : 0.0, stats.active);
+  std::printf("checksum %016llx\n", static_cast<unsigned long long>(state_checksum(agents)));
+  return 0;
+}
+#endif
+
+// Level-of-detail run: agents only on floors with hazard or queues, flow on
+// the rest (HybridCrowd). People still inside are agents plus flow.
+int simulate_lod(const BuildingGraph& graph, const IncrementalRouter& router, const AgentPopulation& agents,
+                 std::uint64_t ticks, WorkStealingPool& pool, const CrowdParams& params) {
+  HybridParams hybrid;
+  hybrid.crowd = params;
+  HybridCrowd sim(graph, pool, hybrid);
+  sim.set_next_edges(router.next_edges());
+  sim.load(agents);
+  const double total = sim.people();
+
+  const auto start = std::chrono::steady_clock::now();
+  HybridStats stats;
+  const auto report_every = static_cast<std::uint64_t>(10.0f / params.dt);
+  while (stats.tick < ticks) {
+    stats = sim.step();
+    if (stats.tick % report_every == 0) {
+      std::printf("t=%7.1f s  inside %.1f (%zu agents, %.1f flow) on %zu active floors\n", stats.tick * params.dt,
+                  total - stats.evacuated, stats.agents, stats.flow_people, stats.active_floors);
+    }
+    if (total - stats.evacuated < 0.5) break;
+  }
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const HybridCounters& c = sim.counters();
+  std::printf("%llu ticks (%.1f s simulated) in %.3f s: %.1f ticks/s on %u workers (lod), %.1f still inside\n",
+              static_cast<unsigned long long>(stats.tick), stats.tick * params.dt, secs,
+              secs > 0.0 ? stats.tick / secs : 0.0, pool.workers(), total - stats.evacuated);
+  std::printf("%llu spawned, %llu folded, %llu activations, %llu deactivations, mass error %.2e\n",
+              static_cast<unsigned long long>(c.spawned), static_cast<unsigned long long>(c.despawned),
+              static_cast<unsigned long long>(c.activations), static_cast<unsigned long long>(c.deactivations),
+              sim.people() - total);
+  AgentPopulation inside;
+  for (int f = 0; f < graph.floor_count(); ++f) {
+    const AgentPopulation& on = sim.floor_agents(static_cast<std::int16_t>(graph.min_floor() + f));
+    for (std::size_t i = 0; i < on.size(); ++i) inside.add(on.x[i], on.y[i], on.floor[i], on.goal[i], 0.0f, 0.0f);
+  }
+  std::printf("checksum %016llx\n", static_cast<unsigned long long>(state_checksum(inside)));
+  return 0;
+}
+
+}  // namespace
+
+// --checkpoint writes the agents, hazards and exit field every
+// --checkpoint-every ticks; --resume continues from the newest checkpoint in
+// a file instead of spawning. Both run on the cpu backend without --lod.
+int cmd_simulate(const Args& args) {
+  std::size_t agent_count = 1000;
+  std::uint64_t ticks = 6000;
+  unsigned threads = 0;
+  std::uint64_t seed = 1;
+  CrowdParams params;
+  CrowdBackend backend = CrowdBackend::Cpu;
+  bool lod = false;
+  std::string checkpoint_path;
+  std::uint64_t checkpoint_every = 100;
+  std::string resume_path;
+  std::string path;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const std::string& a = args[i];
+    const bool has_value = i + 1 < args.size();
+    if (a == "--agents" && has_value) {
+      agent_count = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--ticks" && has_value) {
+      ticks = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--threads" && has_value) {
+      threads = static_cast<unsigned>(std::strtoul(args[++i].c_str(), nullptr, 10));
+    } else if (a == "--seed" && has_value) {
+      seed = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--isa" && has_value && parse_force_isa(args[i + 1].c_str(), params.isa)) {
+      ++i;
+    } else if (a == "--backend" && has_value && parse_crowd_backend(args[i + 1].c_str(), backend)) {
+      ++i;
+    } else if (a == "--lod") {
+      lod = true;
+    } else if (a == "--checkpoint" && has_value) {
+      checkpoint_path = args[++i];
+    } else if (a == "--checkpoint-every" && has_value) {
+      checkpoint_every = std::strtoull(args[++i].c_str(), nullptr, 10);
+    } else if (a == "--resume" && has_value) {
+      resume_path = args[++i];
+    } else if (path.empty() && a[0] != '-') {
+      path = a;
+    } else {
+      path.clear();
+      break;
+    }
+  }
+  if (path.empty()) {
+    std::fprintf(stderr, "usage: main simulate <plan> [--agents n] [--ticks n] [--threads n] [--seed n] "
+                 "[--isa auto|scalar|avx2|avx512] [--backend cpu|cuda] [--lod] [--checkpoint file] "
+                 "[--checkpoint-every ticks] [--resume file]\n");
+    return 2;
+  }
+  if (!crowd_backend_available(backend)) {
+    std::fprintf(stderr, "crowd backend %s is not available in this build\n", to_string(backend));
+    return 2;
+  }
+  if (lod && backend != CrowdBackend::Cpu) {
+    std::fprintf(stderr, "--lod runs on the cpu backend only\n");
+    return 2;
+  }
+  if ((!checkpoint_path.empty() || !resume_path.empty()) && (lod || backend != CrowdBackend::Cpu)) {
+    std::fprintf(stderr, "--checkpoint and --resume run on the cpu backend without --lod\n");
+    return 2;
+  }
+  if (checkpoint_every == 0) checkpoint_every = 1;
+
+  BuildingGraph graph = load_building(path);
+  std::unique_ptr<IncrementalRouter> router;
+  AgentPopulation agents;
+  std::uint64_t start_us = 0;
+  if (!resume_path.empty()) {
+    RestoredState state;
+    if (!read_latest_checkpoint(*MappedCheckpoint::open(resume_path), state)) {
+      std::fprintf(stderr, "%s: no checkpoint committed\n", resume_path.c_str());
+      return 1;
+    }
+    apply_checkpoint(state, graph);
+    router = std::make_unique<IncrementalRouter>(graph, state.distance, state.next_edge);
+    agents = std::move(state.agents);
+    start_us = state.slot.time_us;
+    std::printf("resumed checkpoint %llu at t=%.1f s with %zu agents\n",
+                static_cast<unsigned long long>(state.slot.sequence), start_us / 1e6, agents.size());
+  } else {
+    router = std::make_unique<IncrementalRouter>(graph);
+    spawn_agents(graph, agent_count, seed, agents);
+  }
+#if EVAC_WITH_CUDA
+  if (backend == CrowdBackend::Cuda) return simulate_cuda(graph, *router, agents, ticks, params);
+#endif
+
+  WorkStealingPool pool(threads != 0 ? threads : std::thread::hardware_concurrency());
+  if (lod) return simulate_lod(graph, *router, agents, ticks, pool, params);
+  CrowdSimulator sim(graph, pool, params);
+  sim.set_next_edges(router->next_edges());
+
+  std::unique_ptr<CheckpointWriter> checkpoints;
+  const auto checkpoint = [&](std::uint64_t tick) {
+    CheckpointState state;
+    state.time_us = start_us + static_cast<std::uint64_t>(tick * static_cast<double>(sim.params().dt) * 1e6);
+    state.edge_hazard = graph.edge_hazards();
+    state.edge_congestion = graph.edge_congestions();
+    state.distance = router->distances();
+    state.next_edge = router->next_edges();
+    state.agents = &agents;
+    checkpoints->submit(state);
+  };
+  if (!checkpoint_path.empty()) {
+    checkpoints = std::make_unique<CheckpointWriter>(
+        checkpoint_path, CheckpointShape{graph.node_count(), graph.edge_count(), 0, agents.size()});
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  TickStats stats;
+  const auto report_every = static_cast<std::uint64_t>(10.0f / sim.params().dt);
+  while (stats.tick < ticks) {
+    stats = sim.step(agents);
+    if (stats.tick % report_every == 0) {
+      std::printf("t=%7.1f s  inside %zu\n", stats.tick * sim.params().dt, stats.active);
+    }
+    if (checkpoints && stats.tick % checkpoint_every == 0) checkpoint(stats.tick);
+    if (stats.active == 0) break;
+  }
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (checkpoints) {
+    if (stats.tick % checkpoint_every != 0) checkpoint(stats.tick);
+    checkpoints->flush();
+    const CheckpointCounters cc = checkpoints->counters();
+    std::printf("checkpoints: %llu written (%llu superseded), %llu of %llu pages dirty, last %.2f ms%s\n",
+                static_cast<unsigned long long>(cc.written), static_cast<unsigned long long>(cc.superseded),
+                static_cast<unsigned long long>(cc.pages_written), static_cast<unsigned long long>(cc.pages_total),
+                cc.last_write_us / 1e3, checkpoints->failed() ? " (write FAILED)" : "");
+  }
+  std::printf("%llu ticks (%.1f s simulated) in %.3f s: %.1f ticks/s on %u workers (%s), %zu still inside\n",
+              static_cast<unsigned long long>(stats.tick), stats.tick * sim.params().dt, secs,
+              secs > 0.0 ? stats.tick / secs : 0.0, pool.workers(), to_string(sim.force_isa()),
+              stats.active);
+  std::printf("checksum %016llx\n", static_cast<unsigned long long>(state_checksum(agents)));
+  return 0;
+}
+
+}  // namespace evac::app
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace evac::app {
+
+using Args = std::vector<std::string>;
+
+// Each subcommand of `main` receives the arguments after its name and returns
+// the process exit code. Usage errors print to stderr and return 2.
+int cmd_info(const Args& args);
+int cmd_compile(const Args& args);
+int cmd_analyze(const Args& args);
+int cmd_route(const Args& args);
+int cmd_plan(const Args& args);
+int cmd_simulate(const Args& args);
+int cmd_ingest(const Args& args);
+int cmd_forecast(const Args& args);
+int cmd_scenario(const Args& args);
+int cmd_replay(const Args& args);
+int cmd_gateway(const Args& args);
+int cmd_district(const Args& args);
+int cmd_restore(const Args& args);
+
+}  // namespace evac::app
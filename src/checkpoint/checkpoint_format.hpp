@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace evac {
+
+// On-disk layout of a controller checkpoint (.ckpt): live state a hot
+// standby maps to take over without replaying the event log.
+//
+//   page 0          CheckpointHeader: shape and column table
+//   slot 0          SlotHeader page | columns
+//   slot 1          SlotHeader page | columns
+//
+// The two slots are written alternately, so the newest committed checkpoint
+// is never the one being overwritten. A slot's header is cleared before any
+// of its pages change and rewritten, with the new sequence number, after they
+// are all on disk; a reader takes the intact slot with the highest sequence.
+// Columns sit at the same offsets in both slots, 64-byte aligned like model
+// sections, and keep their capacity for the life of the file; the agent
+// columns are filled up to the slot's agent_count. Host byte order, with an
+// endian tag as in the model format.
+inline constexpr char kCheckpointMagic[8] = {'E', 'V', 'A', 'C', 'C', 'K', 'P', '\0'};
+inline constexpr std::uint32_t kCheckpointVersion = 1;
+inline constexpr std::uint32_t kCheckpointEndianTag = 0x01020304u;
+inline constexpr std::size_t kCheckpointPage = 4096;
+inline constexpr std::size_t kCheckpointAlignment = 64;
+
+enum class ColumnId : std::uint32_t {
+  EdgeHazard = 1,
+  EdgeCongestion = 2,  // queueing delay, s
+  ZoneOccupancy = 3,   // fused people estimate per occupancy zone
+  Distance = 4,        // exit field
+  NextEdge = 5,
+  AgentX = 6,
+  AgentY = 7,
+  AgentVx = 8,
+  AgentVy = 9,
+  AgentRadius = 10,
+  AgentSpeed = 11,
+  AgentFloor = 12,
+  AgentGoal = 13,
+  AgentEvacuated = 14,
+};
+inline constexpr std::size_t kCheckpointColumns = 14;
+
+struct ColumnEntry {
+  std::uint32_t id;
+  std::uint32_t element_size;
+  std::uint64_t offset;    // from the start of the slot's data, kCheckpointAlignment-aligned
+  std::uint64_t capacity;  // elements
+};
+
+struct CheckpointHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t endian_tag;
+  std::uint64_t file_size;
+  std::uint64_t node_count;
+  std::uint64_t edge_count;
+  std::uint64_t zone_count;
+  std::uint64_t agent_capacity;
+  std::uint64_t slot_bytes;  // header page plus data, a whole number of pages
+  std::uint64_t data_bytes;  // column bytes per slot
+  std::uint32_t column_count;
+  std::uint32_t page_size;
+  ColumnEntry columns[kCheckpointColumns];
+};
+
+struct SlotHeader {
+  std::uint64_t sequence;  // 0 while the slot is being rewritten
+  std::uint64_t time_us;   // controller clock at capture
+  std::uint64_t version;   // guidance snapshot version the field belongs to
+  std::uint64_t agent_count;
+  std::uint64_t data_checksum;    // FNV-1a over the slot's data_bytes, checked on demand
+  std::uint64_t header_checksum;  // FNV-1a over the fields above
+};
+
+static_assert(sizeof(ColumnEntry) == 24);
+static_assert(sizeof(CheckpointHeader) == 80 + kCheckpointColumns * sizeof(ColumnEntry));
+static_assert(sizeof(CheckpointHeader) <= kCheckpointPage);
+static_assert(sizeof(SlotHeader) == 48);
+
+inline std::uint64_t slot_offset(const CheckpointHeader& h, int slot) {
+  return h.page_size + static_cast<std::uint64_t>(slot) * h.slot_bytes;
+}
+
+}  // namespace evac
@@ -0,0 +1,255 @@
+#include "checkpoint/checkpoint_writer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include "model/model_format.hpp"
+#include "telemetry/trace.hpp"
+
+namespace evac {
+namespace {
+
+std::uint64_t align_up(std::uint64_t v, std::uint64_t to) { return (v + to - 1) / to * to; }
+
+bool pwrite_all(int fd, const std::byte* data, std::size_t bytes, std::uint64_t offset) {
+  while (bytes != 0) {
+    const ssize_t n = ::pwrite(fd, data, bytes, static_cast<off_t>(offset));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    bytes -= static_cast<std::size_t>(n);
+    offset += static_cast<std::uint64_t>(n);
+  }
+  return true;
+}
+
+const ColumnEntry& column(const CheckpointHeader& h, ColumnId id) {
+  return h.columns[static_cast<std::size_t>(id) - 1];
+}
+
+}  // namespace
+
+CheckpointHeader make_checkpoint_header(const CheckpointShape& shape) {
+  struct Column {
+    ColumnId id;
+    std::uint32_t element_size;
+    std::size_t capacity;
+  };
+  const std::size_t n = shape.node_count;
+  const std::size_t m = shape.edge_count;
+  const std::size_t a = shape.agent_capacity;
+  const Column columns[kCheckpointColumns] = {
+      {ColumnId::EdgeHazard, sizeof(float), m},
+      {ColumnId::EdgeCongestion, sizeof(float), m},
+      {ColumnId::ZoneOccupancy, sizeof(float), shape.zone_count},
+      {ColumnId::Distance, sizeof(Cost), n},
+      {ColumnId::NextEdge, sizeof(EdgeId), n},
+      {ColumnId::AgentX, sizeof(float), a},
+      {ColumnId::AgentY, sizeof(float), a},
+      {ColumnId::AgentVx, sizeof(float), a},
+      {ColumnId::AgentVy, sizeof(float), a},
+      {ColumnId::AgentRadius, sizeof(float), a},
+      {ColumnId::AgentSpeed, sizeof(float), a},
+      {ColumnId::AgentFloor, sizeof(std::int16_t), a},
+      {ColumnId::AgentGoal, sizeof(NodeId), a},
+      {ColumnId::AgentEvacuated, sizeof(std::uint8_t), a},
+  };
+
+  CheckpointHeader h{};
+  std::memcpy(h.magic, kCheckpointMagic, sizeof(h.magic));
+  h.version = kCheckpointVersion;
+  h.endian_tag = kCheckpointEndianTag;
+  h.node_count = n;
+  h.edge_count = m;
+  h.zone_count = shape.zone_count;
+  h.agent_capacity = a;
+  h.column_count = static_cast<std::uint32_t>(kCheckpointColumns);
+  h.page_size = static_cast<std::uint32_t>(kCheckpointPage);
+  std::uint64_t offset = 0;
+  for (std::size_t i = 0; i < kCheckpointColumns; ++i) {
+    h.columns[i] = {static_cast<std::uint32_t>(columns[i].id), columns[i].element_size, offset, columns[i].capacity};
+    offset = align_up(offset + std::uint64_t(columns[i].element_size) * columns[i].capacity, kCheckpointAlignment);
+  }
+  h.data_bytes = align_up(offset, kCheckpointPage);
+  h.slot_bytes = kCheckpointPage + h.data_bytes;
+  h.file_size = kCheckpointPage + 2 * h.slot_bytes;
+  return h;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& path, const CheckpointShape& shape, CheckpointOptions options)
+    : header_(make_checkpoint_header(shape)), options_(options) {
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) throw std::runtime_error(path + ": " + std::strerror(errno));
+  // Both slots start zeroed, so neither holds a committed checkpoint yet.
+  std::vector<std::byte> page(kCheckpointPage);
+  std::memcpy(page.data(), &header_, sizeof header_);
+  if (::ftruncate(fd_, static_cast<off_t>(header_.file_size)) != 0 ||
+      !pwrite_all(fd_, page.data(), page.size(), 0) || (options_.sync && ::fdatasync(fd_) != 0)) {
+    const std::string what = std::strerror(errno);
+    ::close(fd_);
+    throw std::runtime_error(path + ": " + what);
+  }
+  for (Capture* c : {&staging_, &pending_, &writing_}) c->data.assign(header_.data_bytes, std::byte{0});
+  for (std::vector<std::byte>& s : shadow_) s.assign(header_.data_bytes, std::byte{0});
+  thread_ = std::thread([this] { run(); });
+}
+
+CheckpointWriter::~CheckpointWriter() {
+  flush();
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wake_cv_.notify_one();
+  thread_.join();
+  ::close(fd_);
+}
+
+void CheckpointWriter::submit(const CheckpointState& state) {
+  const std::size_t agents = state.agents ? state.agents->size() : 0;
+  const auto fits = [](std::size_t size, std::uint64_t capacity) { return size == 0 || size == capacity; };
+  if (!fits(state.edge_hazard.size(), header_.edge_count) || !fits(state.edge_congestion.size(), header_.edge_count) ||
+      !fits(state.zone_occupancy.size(), header_.zone_count) || !fits(state.distance.size(), header_.node_count) ||
+      !fits(state.next_edge.size(), header_.node_count) || agents > header_.agent_capacity) {
+    throw std::invalid_argument("checkpoint state does not fit the file's shape");
+  }
+
+  // Only the filled part of an agent column is copied; the tail keeps
+  // whatever it held, which the slot header's agent_count excludes.
+  std::byte* data = staging_.data.data();
+  const auto put = [&](ColumnId id, const void* src, std::size_t count) {
+    const ColumnEntry& c = column(header_, id);
+    if (src && count != 0) {
+      std::memcpy(data + c.offset, src, count * c.element_size);
+    } else if (static_cast<std::uint32_t>(id) < static_cast<std::uint32_t>(ColumnId::AgentX)) {
+      std::memset(data + c.offset, 0, c.capacity * c.element_size);
+    }
+  };
+  put(ColumnId::EdgeHazard, state.edge_hazard.data(), state.edge_hazard.size());
+  put(ColumnId::EdgeCongestion, state.edge_congestion.data(), state.edge_congestion.size());
+  put(ColumnId::ZoneOccupancy, state.zone_occupancy.data(), state.zone_occupancy.size());
+  put(ColumnId::Distance, state.distance.data(), state.distance.size());
+  put(ColumnId::NextEdge, state.next_edge.data(), state.next_edge.size());
+  if (agents != 0) {
+    const AgentPopulation& p = *state.agents;
+    put(ColumnId::AgentX, p.x.data(), agents);
+    put(ColumnId::AgentY, p.y.data(), agents);
+    put(ColumnId::AgentVx, p.vx.data(), agents);
+    put(ColumnId::AgentVy, p.vy.data(), agents);
+    put(ColumnId::AgentRadius, p.radius.data(), agents);
+    put(ColumnId::AgentSpeed, p.desired_speed.data(), agents);
+    put(ColumnId::AgentFloor, p.floor.data(), agents);
+    put(ColumnId::AgentGoal, p.goal.data(), agents);
+    put(ColumnId::AgentEvacuated, p.evacuated.data(), agents);
+  }
+  staging_.slot = {};
+  staging_.slot.sequence = ++sequence_;
+  staging_.slot.time_us = state.time_us;
+  staging_.slot.version = state.version;
+  staging_.slot.agent_count = agents;
+
+  {
+    std::lock_guard lock(mutex_);
+    std::swap(staging_, pending_);
+    if (has_pending_) ++counters_.superseded;
+    has_pending_ = true;
+    ++counters_.submitted;
+  }
+  wake_cv_.notify_one();
+}
+
+void CheckpointWriter::flush() {
+  std::unique_lock lock(mutex_);
+  const std::uint64_t target = sequence_;
+  committed_cv_.wait(lock, [&] { return failed() || committed_ >= target; });
+}
+
+CheckpointCounters CheckpointWriter::counters() const {
+  std::lock_guard lock(mutex_);
+  return counters_;
+}
+
+// Clear the header, rewrite the dirty pages, then commit the header; with
+// sync, each step is on disk before the next starts, so a crash at any point
+// leaves this slot invalid and the other one intact.
+bool CheckpointWriter::write_slot(const Capture& capture) {
+  // The other slot from the last write, not sequence parity: captures that
+  // were superseded leave gaps in the sequence.
+  const int slot = 1 - last_slot_;
+  const std::uint64_t base = slot_offset(header_, slot);
+  std::vector<std::byte>& shadow = shadow_[slot];
+  std::byte cleared[sizeof(SlotHeader)] = {};
+  if (!pwrite_all(fd_, cleared, sizeof cleared, base)) return false;
+  if (options_.sync && ::fdatasync(fd_) != 0) return false;
+
+  const std::size_t pages = header_.data_bytes / kCheckpointPage;
+  std::uint64_t dirty = 0;
+  for (std::size_t p = 0; p < pages;) {
+    const auto differs = [&](std::size_t q) {
+      return std::memcmp(capture.data.data() + q * kCheckpointPage, shadow.data() + q * kCheckpointPage,
+                         kCheckpointPage) != 0;
+    };
+    if (!differs(p)) {
+      ++p;
+      continue;
+    }
+    std::size_t end = p + 1;
+    while (end < pages && differs(end)) ++end;
+    const std::size_t at = p * kCheckpointPage;
+    const std::size_t bytes = (end - p) * kCheckpointPage;
+    if (!pwrite_all(fd_, capture.data.data() + at, bytes, base + kCheckpointPage + at)) return false;
+    std::memcpy(shadow.data() + at, capture.data.data() + at, bytes);
+    dirty += end - p;
+    p = end;
+  }
+  if (options_.sync && ::fdatasync(fd_) != 0) return false;
+
+  SlotHeader header = capture.slot;
+  header.data_checksum = fnv1a(capture.data.data(), capture.data.size());
+  header.header_checksum = fnv1a(&header, offsetof(SlotHeader, header_checksum));
+  if (!pwrite_all(fd_, reinterpret_cast<const std::byte*>(&header), sizeof header, base)) return false;
+  if (options_.sync && ::fdatasync(fd_) != 0) return false;
+
+  last_slot_ = slot;
+  std::lock_guard lock(mutex_);
+  counters_.pages_written += dirty;
+  counters_.pages_total += pages;
+  counters_.bytes_written += dirty * kCheckpointPage + 2 * sizeof header;
+  return true;
+}
+
+void CheckpointWriter::run() {
+  set_trace_thread_name("checkpoint");
+  for (;;) {
+    {
+      std::unique_lock lock(mutex_);
+      wake_cv_.wait(lock, [&] { return has_pending_ || stopping_; });
+      if (!has_pending_) return;
+      std::swap(pending_, writing_);
+      has_pending_ = false;
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    const bool ok = write_slot(writing_);
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    {
+      std::lock_guard lock(mutex_);
+      if (!ok) {
+        failed_.store(true, std::memory_order_release);
+      } else {
+        committed_ = writing_.slot.sequence;
+        ++counters_.written;
+        counters_.last_write_us = us;
+      }
+    }
+    committed_cv_.notify_all();
+    if (!ok) return;
+  }
+}
+
+}  // namespace evac
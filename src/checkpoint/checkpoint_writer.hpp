@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "checkpoint/checkpoint_format.hpp"
+#include "crowd/agents.hpp"
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+
+namespace evac {
+
+// Sizes a checkpoint file is laid out for; fixed for the life of the file.
+struct CheckpointShape {
+  std::size_t node_count = 0;
+  std::size_t edge_count = 0;
+  std::size_t zone_count = 0;
+  std::size_t agent_capacity = 0;
+};
+
+// Header and column table for a shape; the reader checks a file's header
+// against the one its own shape fields produce.
+CheckpointHeader make_checkpoint_header(const CheckpointShape& shape);
+
+// One capture of the controller's live state. Empty spans are stored as
+// zeros; non-empty ones must match the shape.
+struct CheckpointState {
+  std::uint64_t time_us = 0;
+  std::uint64_t version = 0;
+  std::span<const float> edge_hazard;
+  std::span<const float> edge_congestion;
+  std::span<const float> zone_occupancy;
+  std::span<const Cost> distance;
+  std::span<const EdgeId> next_edge;
+  const AgentPopulation* agents = nullptr;  // at most agent_capacity
+};
+
+struct CheckpointOptions {
+  bool sync = true;  // fdatasync around every slot commit
+};
+
+struct CheckpointCounters {
+  std::uint64_t submitted = 0;
+  std::uint64_t written = 0;
+  std::uint64_t superseded = 0;     // replaced by a newer capture before the writer got to them
+  std::uint64_t pages_written = 0;  // dirty data pages
+  std::uint64_t pages_total = 0;    // data pages of the written checkpoints
+  std::uint64_t bytes_written = 0;
+  double last_write_us = 0.0;
+};
+
+// Periodic checkpoints written by a background thread, so the controller
+// pays only for copying its columns (submit()). Each checkpoint goes to the
+// slot not holding the newest one, and only the data pages that differ from
+// what that slot already holds are rewritten: hazards, the exit field and
+// the agents' static columns change in few pages between checkpoints.
+// Captures that arrive while a write is in progress replace each other; only
+// the newest is written.
+//
+// Throws std::runtime_error if the file cannot be created; I/O errors later
+// on stop the writer thread and show up as failed().
+class CheckpointWriter {
+ public:
+  CheckpointWriter(const std::string& path, const CheckpointShape& shape, CheckpointOptions options = {});
+  ~CheckpointWriter();  // writes the last capture
+  CheckpointWriter(const CheckpointWriter&) = delete;
+  CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+  // Owner thread only. Throws std::invalid_argument if the state does not
+  // fit the shape.
+  void submit(const CheckpointState& state);
+  // Returns once every capture submitted before it is committed or superseded.
+  void flush();
+
+  const CheckpointHeader& header() const { return header_; }
+  bool failed() const { return failed_.load(std::memory_order_acquire); }
+  CheckpointCounters counters() const;
+
+ private:
+  struct Capture {
+    std::vector<std::byte> data;
+    SlotHeader slot{};
+  };
+
+  void run();
+  bool write_slot(const Capture& capture);
+
+  CheckpointHeader header_{};
+  CheckpointOptions options_;
+  int fd_ = -1;
+  Capture staging_;  // owner thread
+  Capture pending_;  // guarded by mutex_
+  Capture writing_;  // writer thread
+  std::vector<std::byte> shadow_[2];  // writer thread; what each slot holds on disk
+  int last_slot_ = 1;                 // writer thread
+  std::uint64_t sequence_ = 0;        // owner thread
+  std::uint64_t committed_ = 0;       // guarded by mutex_; newest sequence written or superseded
+  bool has_pending_ = false;
+  bool stopping_ = false;
+  std::atomic<bool> failed_{false};
+  mutable std::mutex mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable committed_cv_;
+  CheckpointCounters counters_;  // guarded by mutex_
+  std::thread thread_;
+};
+
+}  // namespace evac
@@ -0,0 +1,165 @@
+#include "checkpoint/mapped_checkpoint.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "checkpoint/checkpoint_writer.hpp"
+#include "model/model_format.hpp"
+
+namespace evac {
+namespace {
+
+[[noreturn]] void fail(const std::string& path, const std::string& what) {
+  throw std::runtime_error(path + ": " + what);
+}
+
+// Header fields after the shape are derived from it; a file whose table
+// differs from the one its shape produces was written by something else.
+bool same_layout(const CheckpointHeader& a, const CheckpointHeader& b) {
+  return a.file_size == b.file_size && a.slot_bytes == b.slot_bytes && a.data_bytes == b.data_bytes &&
+         a.column_count == b.column_count && a.page_size == b.page_size &&
+         std::memcmp(a.columns, b.columns, sizeof a.columns) == 0;
+}
+
+template <class T>
+void copy_column(const CheckpointHeader& h, const std::byte* data, ColumnId id, std::size_t count, T* out) {
+  const ColumnEntry& c = h.columns[static_cast<std::size_t>(id) - 1];
+  if (count != 0) std::memcpy(out, data + c.offset, count * sizeof(T));
+}
+
+}  // namespace
+
+std::shared_ptr<const MappedCheckpoint> MappedCheckpoint::open(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) fail(path, "cannot open checkpoint file");
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    fail(path, "cannot stat checkpoint file");
+  }
+  const auto size = static_cast<std::size_t>(st.st_size);
+  if (size < kCheckpointPage) {
+    ::close(fd);
+    fail(path, "truncated checkpoint header");
+  }
+  void* base = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);  // the mapping keeps the file referenced
+  if (base == MAP_FAILED) fail(path, "mmap failed");
+  // The whole newest slot is read right after open.
+  ::madvise(base, size, MADV_WILLNEED);
+  std::shared_ptr<const MappedCheckpoint> checkpoint(new MappedCheckpoint(path, base, size));
+
+  const CheckpointHeader& h = checkpoint->header();
+  if (std::memcmp(h.magic, kCheckpointMagic, sizeof(h.magic)) != 0) fail(path, "not a checkpoint file");
+  if (h.endian_tag != kCheckpointEndianTag) fail(path, "checkpoint written on the other byte order");
+  if (h.version != kCheckpointVersion) {
+    fail(path, "checkpoint version " + std::to_string(h.version) + ", expected " +
+                   std::to_string(kCheckpointVersion));
+  }
+  const CheckpointHeader want = make_checkpoint_header(
+      {static_cast<std::size_t>(h.node_count), static_cast<std::size_t>(h.edge_count),
+       static_cast<std::size_t>(h.zone_count), static_cast<std::size_t>(h.agent_capacity)});
+  if (!same_layout(h, want)) fail(path, "column layout does not match the checkpoint's shape");
+  if (h.file_size != size) fail(path, "file size does not match header (truncated copy?)");
+  return checkpoint;
+}
+
+MappedCheckpoint::~MappedCheckpoint() {
+  if (base_) ::munmap(base_, size_);
+}
+
+bool MappedCheckpoint::slot_header(int slot, SlotHeader& out) const {
+  const auto* at = static_cast<const std::byte*>(base_) + slot_offset(header(), slot);
+  std::memcpy(&out, at, sizeof out);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return out.sequence != 0 && out.agent_count <= header().agent_capacity &&
+         out.header_checksum == fnv1a(&out, offsetof(SlotHeader, header_checksum));
+}
+
+int MappedCheckpoint::latest_slot() const {
+  int best = -1;
+  std::uint64_t sequence = 0;
+  for (int s = 0; s < 2; ++s) {
+    SlotHeader h;
+    if (slot_header(s, h) && h.sequence > sequence) {
+      best = s;
+      sequence = h.sequence;
+    }
+  }
+  return best;
+}
+
+const std::byte* MappedCheckpoint::slot_data(int slot) const {
+  return static_cast<const std::byte*>(base_) + slot_offset(header(), slot) + header().page_size;
+}
+
+bool MappedCheckpoint::verify(int slot) const {
+  SlotHeader h;
+  return slot_header(slot, h) && fnv1a(slot_data(slot), header().data_bytes) == h.data_checksum;
+}
+
+bool read_latest_checkpoint(const MappedCheckpoint& checkpoint, RestoredState& out) {
+  const CheckpointHeader& h = checkpoint.header();
+  for (;;) {
+    const int slot = checkpoint.latest_slot();
+    if (slot < 0) return false;
+    SlotHeader before;
+    if (!checkpoint.slot_header(slot, before)) continue;  // cleared since latest_slot() looked
+
+    const std::byte* data = checkpoint.slot_data(slot);
+    const auto n = static_cast<std::size_t>(h.node_count);
+    const auto m = static_cast<std::size_t>(h.edge_count);
+    const auto a = static_cast<std::size_t>(before.agent_count);
+    out.edge_hazard.resize(m);
+    out.edge_congestion.resize(m);
+    out.zone_occupancy.resize(static_cast<std::size_t>(h.zone_count));
+    out.distance.resize(n);
+    out.next_edge.resize(n);
+    out.agents.resize(a);
+    copy_column(h, data, ColumnId::EdgeHazard, m, out.edge_hazard.data());
+    copy_column(h, data, ColumnId::EdgeCongestion, m, out.edge_congestion.data());
+    copy_column(h, data, ColumnId::ZoneOccupancy, out.zone_occupancy.size(), out.zone_occupancy.data());
+    copy_column(h, data, ColumnId::Distance, n, out.distance.data());
+    copy_column(h, data, ColumnId::NextEdge, n, out.next_edge.data());
+    copy_column(h, data, ColumnId::AgentX, a, out.agents.x.data());
+    copy_column(h, data, ColumnId::AgentY, a, out.agents.y.data());
+    copy_column(h, data, ColumnId::AgentVx, a, out.agents.vx.data());
+    copy_column(h, data, ColumnId::AgentVy, a, out.agents.vy.data());
+    copy_column(h, data, ColumnId::AgentRadius, a, out.agents.radius.data());
+    copy_column(h, data, ColumnId::AgentSpeed, a, out.agents.desired_speed.data());
+    copy_column(h, data, ColumnId::AgentFloor, a, out.agents.floor.data());
+    copy_column(h, data, ColumnId::AgentGoal, a, out.agents.goal.data());
+    copy_column(h, data, ColumnId::AgentEvacuated, a, out.agents.evacuated.data());
+
+    // The writer clears a slot's header before touching its pages, so an
+    // unchanged header means the copy saw none of a later write.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    SlotHeader after;
+    if (checkpoint.slot_header(slot, after) && std::memcmp(&before, &after, sizeof before) == 0) {
+      out.slot = before;
+      return true;
+    }
+  }
+}
+
+void apply_checkpoint(const RestoredState& state, BuildingGraph& g) {
+  if (state.edge_hazard.size() != g.edge_count() || state.distance.size() != g.node_count()) {
+    throw std::runtime_error("checkpoint is for a building of another shape");
+  }
+  for (NodeId v : state.agents.goal) {
+    if (v >= g.node_count()) throw std::runtime_error("checkpoint agent heads for a node the building lacks");
+  }
+  std::copy(state.edge_hazard.begin(), state.edge_hazard.end(), g.edge_hazards().begin());
+  for (EdgeId e = 0; e < g.edge_count(); ++e) g.set_edge_congestion(e, state.edge_congestion[e]);
+}
+
+}  // namespace evac
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "checkpoint/checkpoint_format.hpp"
+#include "crowd/agents.hpp"
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+
+namespace evac {
+
+// Read-only shared mapping of a checkpoint file, for a standby taking over
+// from the controller that writes it. Opening validates the header against
+// the layout its shape implies and touches nothing else; the primary may keep
+// writing while the file is mapped.
+class MappedCheckpoint {
+ public:
+  // Throws std::runtime_error naming the file on any structural problem.
+  static std::shared_ptr<const MappedCheckpoint> open(const std::string& path);
+  ~MappedCheckpoint();
+  MappedCheckpoint(const MappedCheckpoint&) = delete;
+  MappedCheckpoint& operator=(const MappedCheckpoint&) = delete;
+
+  const CheckpointHeader& header() const { return *static_cast<const CheckpointHeader*>(base_); }
+  const std::string& path() const { return path_; }
+
+  // Copy of a slot's header if it is committed and intact.
+  bool slot_header(int slot, SlotHeader& out) const;
+  // Committed slot with the highest sequence, or -1 before the first commit.
+  int latest_slot() const;
+  // Column bytes of a slot in place.
+  const std::byte* slot_data(int slot) const;
+  // Recomputes the slot's data checksum; false if the data is torn or damaged.
+  bool verify(int slot) const;
+
+ private:
+  MappedCheckpoint(std::string path, void* base, std::size_t size) : path_(std::move(path)), base_(base), size_(size) {}
+
+  std::string path_;
+  void* base_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Live state as of one checkpoint, copied out of the mapping.
+struct RestoredState {
+  SlotHeader slot{};
+  std::vector<float> edge_hazard;
+  std::vector<float> edge_congestion;
+  std::vector<float> zone_occupancy;
+  std::vector<Cost> distance;
+  std::vector<EdgeId> next_edge;
+  AgentPopulation agents;
+};
+
+// Copies out the newest committed checkpoint. The slot header is read again
+// afterwards and the copy retried if the writer committed over it meanwhile,
+// so the result is always one consistent capture. False if no checkpoint has
+// been committed yet.
+bool read_latest_checkpoint(const MappedCheckpoint& checkpoint, RestoredState& out);
+
+// Writes the restored hazards and congestion delays into the graph; an
+// IncrementalRouter built on it from the restored field then needs no solve.
+// Throws std::runtime_error if the checkpoint is for another building.
+void apply_checkpoint(const RestoredState& state, BuildingGraph& g);
+
+}  // namespace evac
@@ -0,0 +1,58 @@
+#include "crowd/agents.hpp"
+
+#include <algorithm>
+
+#include "util/rng.hpp"
+
+namespace evac {
+
+void AgentPopulation::resize(std::size_t n) {
+  x.resize(n);
+  y.resize(n);
+  vx.resize(n);
+  vy.resize(n);
+  radius.resize(n);
+  desired_speed.resize(n);
+  floor.resize(n);
+  goal.resize(n);
+  evacuated.resize(n);
+}
+
+void AgentPopulation::add(float px, float py, std::int16_t on_floor, NodeId start, float r,
+                          float speed) {
+  x.push_back(px);
+  y.push_back(py);
+  vx.push_back(0.0f);
+  vy.push_back(0.0f);
+  radius.push_back(r);
+  desired_speed.push_back(speed);
+  floor.push_back(on_floor);
+  goal.push_back(start);
+  evacuated.push_back(0);
+}
+
+void spawn_agents(const BuildingGraph& g, std::size_t count, std::uint64_t seed,
+                  AgentPopulation& out) {
+  std::vector<NodeId> rooms;
+  std::vector<std::uint64_t> cumulative;
+  std::uint64_t total = 0;
+  for (NodeId v = 0; v < g.node_count(); ++v) {
+    if (g.node_kind(v) != NodeKind::Room) continue;
+    total += g.node_capacity(v) != 0 ? g.node_capacity(v) : 10;
+    rooms.push_back(v);
+    cumulative.push_back(total);
+  }
+  if (rooms.empty()) return;
+
+  SplitMix64 rng(seed);
+  for (std::size_t i = 0; i < count; ++i) {
+    const std::uint64_t pick = rng.next() % total;
+    const auto it = std::upper_bound(cumulative.begin(), cumulative.end(), pick);
+    const NodeId room = rooms[static_cast<std::size_t>(it - cumulative.begin())];
+    const float px = g.node_x(room) + rng.uniform(-2.0f, 2.0f);
+    const float py = g.node_y(room) + rng.uniform(-2.0f, 2.0f);
+    out.add(px, py, g.node_floor(room), room, rng.uniform(0.22f, 0.28f), rng.uniform(1.0f, 1.45f));
+  }
+}
+
+}  // namespace evac
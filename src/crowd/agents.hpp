@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "util/aligned_buffer.hpp"
+
+namespace evac {
+
+// Pedestrians in struct-of-arrays layout, indexed by agent id. Positions are
+// floor-local metres in the same frame as BuildingGraph node coordinates. The
+// float columns are 64-byte aligned for the SIMD force kernels.
+struct AgentPopulation {
+  aligned_vector<float> x;
+  aligned_vector<float> y;
+  aligned_vector<float> vx;
+  aligned_vector<float> vy;
+  aligned_vector<float> radius;
+  aligned_vector<float> desired_speed;
+  std::vector<std::int16_t> floor;
+  std::vector<NodeId> goal;  // node the agent is currently walking to
+  std::vector<std::uint8_t> evacuated;
+
+  std::size_t size() const { return x.size(); }
+  void resize(std::size_t n);
+  void add(float px, float py, std::int16_t on_floor, NodeId start, float r, float speed);
+};
+
+// Places `count` agents in rooms, weighted by room capacity (rooms without a
+// capacity weigh 10), jittered around the room node. Deterministic in `seed`.
+void spawn_agents(const BuildingGraph& g, std::size_t count, std::uint64_t seed,
+                  AgentPopulation& out);
+
+}  // namespace evac
@@ -0,0 +1,39 @@
+#include "crowd/crowd_backend.hpp"
+
+#include <cstring>
+#include <initializer_list>
+
+#if EVAC_WITH_CUDA
+#include "crowd/cuda_crowd.hpp"
+#endif
+
+namespace evac {
+
+const char* to_string(CrowdBackend backend) {
+  switch (backend) {
+    case CrowdBackend::Cpu: return "cpu";
+    case CrowdBackend::Cuda: return "cuda";
+  }
+  return "?";
+}
+
+bool parse_crowd_backend(const char* name, CrowdBackend& out) {
+  for (CrowdBackend backend : {CrowdBackend::Cpu, CrowdBackend::Cuda}) {
+    if (std::strcmp(name, to_string(backend)) == 0) {
+      out = backend;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool crowd_backend_available(CrowdBackend backend) {
+  if (backend == CrowdBackend::Cpu) return true;
+#if EVAC_WITH_CUDA
+  return cuda_device_count() > 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace evac
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace evac {
+
+// Where the crowd step runs. Cuda is only available in builds configured with
+// EVAC_WITH_CUDA (crowd/cuda_crowd.cu compiled by nvcc) and on a machine with
+// a CUDA device; embedded controllers use the CPU path.
+enum class CrowdBackend { Cpu, Cuda };
+
+const char* to_string(CrowdBackend backend);
+// Parses "cpu", "cuda"; returns false on anything else.
+bool parse_crowd_backend(const char* name, CrowdBackend& out);
+
+// Compiled in and at least one device visible.
+bool crowd_backend_available(CrowdBackend backend);
+
+}  // namespace evac
@@ -0,0 +1,148 @@
+#include "crowd/crowd_sim.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace evac {
+
+CrowdSimulator::CrowdSimulator(const BuildingGraph& graph, WorkStealingPool& pool, CrowdParams params)
+    : CrowdSimulator(graph, pool, params, grid_layout_for(graph, params.cell_size)) {}
+
+CrowdSimulator::CrowdSimulator(const BuildingGraph& graph, WorkStealingPool& pool, CrowdParams params,
+                               const CellGridLayout& layout)
+    : graph_(graph), pool_(pool), params_(params), grid_(layout) {
+  params_.interaction_radius = std::min(params_.interaction_radius, params_.cell_size);
+  kernel_ = select_repulsion_kernel(params_.isa, &isa_);
+  arenas_.resize(pool_.workers());
+}
+
+void CrowdSimulator::step_cell(const AgentPopulation& cur, std::uint32_t cell, unsigned worker) {
+  const float dt = params_.dt;
+
+  // Every agent of the cell shares the same 3x3 neighbourhood: copy its three
+  // contiguous runs of cell-ordered columns into padded aligned scratch, so the
+  // kernel streams them and the summation order is fixed.
+  Arena& arena = arenas_[worker];
+  const ArenaScope scope(arena);
+  std::size_t count = 0;
+  grid_.for_each_run(cell, [&](std::uint32_t b, std::uint32_t e) { count += e - b; });
+  const std::size_t padded = padded_neighbour_count(count);
+  const std::span<float> nx = arena.allocate_array<float>(padded, kSimdAlignment);
+  const std::span<float> ny = arena.allocate_array<float>(padded, kSimdAlignment);
+  const std::span<float> nr = arena.allocate_array<float>(padded, kSimdAlignment);
+  std::size_t fill = 0;
+  grid_.for_each_run(cell, [&](std::uint32_t b, std::uint32_t e) {
+    std::copy(grid_.sorted_x() + b, grid_.sorted_x() + e, nx.begin() + fill);
+    std::copy(grid_.sorted_y() + b, grid_.sorted_y() + e, ny.begin() + fill);
+    std::copy(grid_.sorted_r() + b, grid_.sorted_r() + e, nr.begin() + fill);
+    fill += e - b;
+  });
+  std::fill(nx.begin() + fill, nx.end(), kNeighbourSentinel);
+  std::fill(ny.begin() + fill, ny.end(), kNeighbourSentinel);
+  std::fill(nr.begin() + fill, nr.end(), 0.0f);
+  const NeighbourBlock block{nx.data(), ny.data(), nr.data(), padded};
+  RepulsionParams repulsion;
+  repulsion.strength = params_.repulsion_strength;
+  repulsion.inv_range = 1.0f / params_.repulsion_range;
+  repulsion.cutoff2 = params_.interaction_radius * params_.interaction_radius;
+
+  const std::span<const std::uint32_t> sorted = grid_.sorted_agents();
+  for (std::uint32_t k = grid_.cell_begin(cell); k < grid_.cell_end(cell); ++k) {
+    const std::uint32_t i = sorted[k];
+    const float xi = cur.x[i];
+    const float yi = cur.y[i];
+    NodeId goal = cur.goal[i];
+    std::int16_t floor = cur.floor[i];
+    bool out = false;
+
+    // Waypoint bookkeeping: on arrival, switch floor and take the next hop.
+    float gx = graph_.node_x(goal) - xi;
+    float gy = graph_.node_y(goal) - yi;
+    if (gx * gx + gy * gy < params_.arrival_radius * params_.arrival_radius) {
+      floor = graph_.node_floor(goal);
+      if (graph_.node_kind(goal) == NodeKind::Exit) {
+        out = true;
+      } else if (!next_edge_.empty() && next_edge_[goal] != kInvalidEdge) {
+        goal = graph_.edge_target(next_edge_[goal]);
+        gx = graph_.node_x(goal) - xi;
+        gy = graph_.node_y(goal) - yi;
+      }
+    }
+
+    float ax = 0.0f;
+    float ay = 0.0f;
+    kernel_(xi, yi, cur.radius[i], block, repulsion, ax, ay);
+    const float glen = std::sqrt(gx * gx + gy * gy);
+    if (glen > 1e-4f) {
+      const float v0 = cur.desired_speed[i];
+      ax += (v0 * gx / glen - cur.vx[i]) / params_.relaxation_time;
+      ay += (v0 * gy / glen - cur.vy[i]) / params_.relaxation_time;
+    }
+
+    float vx = cur.vx[i] + ax * dt;
+    float vy = cur.vy[i] + ay * dt;
+    const float vmax = 1.3f * cur.desired_speed[i];
+    const float speed2 = vx * vx + vy * vy;
+    if (speed2 > vmax * vmax) {
+      const float s = vmax / std::sqrt(speed2);
+      vx *= s;
+      vy *= s;
+    }
+    next_.x[i] = xi + vx * dt;
+    next_.y[i] = yi + vy * dt;
+    next_.vx[i] = vx;
+    next_.vy[i] = vy;
+    next_.goal[i] = goal;
+    next_.floor[i] = floor;
+    next_.evacuated[i] = out ? 1 : 0;
+  }
+}
+
+TickStats CrowdSimulator::step(AgentPopulation& agents) {
+  const std::size_t n = agents.size();
+  grid_.rebuild(agents, pool_);
+  next_.resize(n);
+  const std::span<const std::uint32_t> cells = grid_.agent_cells();
+  // Evacuated agents are not indexed; carry their state over unchanged.
+  for (std::size_t i = 0; i < n; ++i) {
+    if (cells[i] != CellGrid::kNoCell) continue;
+    next_.x[i] = agents.x[i];
+    next_.y[i] = agents.y[i];
+    next_.vx[i] = 0.0f;
+    next_.vy[i] = 0.0f;
+    next_.goal[i] = agents.goal[i];
+    next_.floor[i] = agents.floor[i];
+    next_.evacuated[i] = 1;
+  }
+
+  pool_.parallel_for(grid_.cell_count(), params_.tile_cells, [&](std::size_t b, std::size_t e, unsigned worker) {
+    for (std::size_t c = b; c < e; ++c) {
+      if (grid_.cell_population(static_cast<std::uint32_t>(c)) != 0) {
+        step_cell(agents, static_cast<std::uint32_t>(c), worker);
+      }
+    }
+  });
+
+  std::swap(agents.x, next_.x);
+  std::swap(agents.y, next_.y);
+  std::swap(agents.vx, next_.vx);
+  std::swap(agents.vy, next_.vy);
+  std::swap(agents.goal, next_.goal);
+  std::swap(agents.floor, next_.floor);
+  std::swap(agents.evacuated, next_.evacuated);
+  for (Arena& a : arenas_) a.reset();
+
+  TickStats stats;
+  stats.tick = ++tick_;
+  for (std::size_t i = 0; i < n; ++i) {
+    if (!agents.evacuated[i]) {
+      ++stats.active;
+    } else if (cells[i] != CellGrid::kNoCell) {
+      ++stats.newly_evacuated;
+    }
+  }
+  return stats;
+}
+
+}  // namespace evac
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "crowd/agents.hpp"
+#include "crowd/force_kernel.hpp"
+#include "exec/work_stealing_pool.hpp"
+#include "graph/building_graph.hpp"
+#include "spatial/cell_grid.hpp"
+#include "util/arena.hpp"
+
+namespace evac {
+
+struct CrowdParams {
+  float dt = 0.1f;                  // seconds per tick
+  float cell_size = 2.0f;           // metres; bounds the interaction radius
+  std::uint32_t tile_cells = 64;    // cells per scheduling tile
+  float interaction_radius = 2.0f;  // neighbours farther than this are ignored
+  float relaxation_time = 0.5f;     // seconds to reach the desired velocity
+  float repulsion_strength = 2.0f;  // m/s^2 at contact
+  float repulsion_range = 0.3f;     // m, exponential fall-off
+  float arrival_radius = 0.6f;      // m, distance at which a waypoint counts as reached
+  ForceIsa isa = ForceIsa::Auto;    // repulsion kernel; all choices give identical results
+};
+
+struct TickStats {
+  std::uint64_t tick = 0;
+  std::size_t active = 0;          // agents still inside after this tick
+  std::size_t newly_evacuated = 0;
+};
+
+// Social-force pedestrian model stepped in spatial tiles on a work-stealing
+// pool. Agents steer towards their current waypoint node and take the next hop
+// from the routing field when they reach it. Neighbours come from a cell list
+// rebuilt at the start of every tick; a tile is a run of consecutive cells.
+//
+// A tick is a Jacobi update: every tile reads only the previous tick's state
+// and writes only the next-state slots of the agents it owns, so agents at tile
+// borders see the same neighbours whichever worker runs which tile, and the
+// result is identical for any thread count or steal order.
+class CrowdSimulator {
+ public:
+  CrowdSimulator(const BuildingGraph& graph, WorkStealingPool& pool, CrowdParams params = {});
+  // Simulates on a grid other than the whole building's (see grid_layout_for()).
+  CrowdSimulator(const BuildingGraph& graph, WorkStealingPool& pool, CrowdParams params, const CellGridLayout& layout);
+
+  // Next-hop arcs from the router (IncrementalRouter::next_edges()); the span
+  // must stay valid while step() runs.
+  void set_next_edges(std::span<const EdgeId> next_edge) { next_edge_ = next_edge; }
+
+  TickStats step(AgentPopulation& agents);
+
+  const CrowdParams& params() const { return params_; }
+  ForceIsa force_isa() const { return isa_; }
+  // Index from the most recent tick; also serves density queries.
+  const CellGrid& grid() const { return grid_; }
+
+ private:
+  void step_cell(const AgentPopulation& cur, std::uint32_t cell, unsigned worker);
+
+  const BuildingGraph& graph_;
+  WorkStealingPool& pool_;
+  CrowdParams params_;
+  std::span<const EdgeId> next_edge_;
+  RepulsionKernel kernel_ = nullptr;
+  ForceIsa isa_ = ForceIsa::Scalar;
+
+  CellGrid grid_;
+  std::vector<Arena> arenas_;  // per worker, reset at the end of every tick
+  AgentPopulation next_;
+  std::uint64_t tick_ = 0;
+};
+
+}  // namespace evac
@@ -0,0 +1,480 @@
+// Built only with EVAC_WITH_CUDA, by nvcc with --fmad=false -std=c++20: the
+// step kernel must perform exactly the IEEE operations of the scalar CPU path
+// (crowd_sim.cpp, repulsion_scalar() in force_kernel.cpp) in the same order.
+
+#include "crowd/cuda_crowd.hpp"
+
+#include <cub/device/device_scan.cuh>
+#include <cuda_runtime.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "crowd/force_kernel.hpp"
+#include "spatial/cell_grid.hpp"
+
+namespace evac {
+namespace {
+
+constexpr unsigned kThreads = 256;
+constexpr std::uint32_t kNoCell = CellGrid::kNoCell;
+
+// Must match force_kernel.cpp.
+constexpr float kExpLo = -87.0f;
+constexpr float kExpHi = 88.0f;
+constexpr float kLog2e = 1.44269504088896341f;
+constexpr float kLn2Hi = 0.693359375f;
+constexpr float kLn2Lo = -2.12194440e-4f;
+constexpr float kP0 = 1.9875691500e-4f;
+constexpr float kP1 = 1.3981999507e-3f;
+constexpr float kP2 = 8.3334519073e-3f;
+constexpr float kP3 = 4.1665795894e-2f;
+constexpr float kP4 = 1.6666665459e-1f;
+constexpr float kP5 = 5.0000001201e-1f;
+constexpr float kMinDistance2 = 1e-12f;
+
+void check(cudaError_t status, const char* what) {
+  if (status != cudaSuccess) {
+    throw std::runtime_error(std::string("cuda: ") + what + ": " + cudaGetErrorString(status));
+  }
+}
+
+unsigned blocks_for(std::size_t n) { return static_cast<unsigned>((n + kThreads - 1) / kThreads); }
+
+// Owning device buffer; grows, never shrinks.
+template <class T>
+class DeviceArray {
+ public:
+  DeviceArray() = default;
+  ~DeviceArray() { cudaFree(data_); }
+  DeviceArray(const DeviceArray&) = delete;
+  DeviceArray& operator=(const DeviceArray&) = delete;
+
+  void reserve(std::size_t n) {
+    if (n <= capacity_) return;
+    cudaFree(data_);
+    data_ = nullptr;
+    check(cudaMalloc(&data_, n * sizeof(T)), "cudaMalloc");
+    capacity_ = n;
+  }
+  void upload(const T* src, std::size_t n) {
+    reserve(n);
+    if (n != 0) check(cudaMemcpy(data_, src, n * sizeof(T), cudaMemcpyHostToDevice), "upload");
+  }
+  void download(T* dst, std::size_t n) const {
+    if (n != 0) check(cudaMemcpy(dst, data_, n * sizeof(T), cudaMemcpyDeviceToHost), "download");
+  }
+  T* get() const { return data_; }
+
+ private:
+  T* data_ = nullptr;
+  std::size_t capacity_ = 0;
+};
+
+// One generation of the mutable agent columns.
+struct StateColumns {
+  float* x;
+  float* y;
+  float* vx;
+  float* vy;
+  std::int16_t* floor;
+  NodeId* goal;
+  std::uint8_t* evacuated;
+};
+
+struct StaticColumns {
+  const float* radius;
+  const float* desired_speed;
+  const float* node_x;
+  const float* node_y;
+  const std::int16_t* node_floor;
+  const NodeKind* node_kind;
+  const NodeId* edge_target;
+  const EdgeId* next_edge;  // null until set_next_edges()
+};
+
+struct GridColumns {
+  CellGridLayout layout;
+  std::uint32_t* agent_cell;
+  std::uint32_t* counts;   // cell_count + 1; scanned into offsets
+  std::uint32_t* offsets;  // cell_count + 1
+  std::uint32_t* cursor;   // scatter cursors
+  std::uint32_t* sorted;
+  float* sorted_x;
+  float* sorted_y;
+  float* sorted_r;
+};
+
+struct StepParams {
+  float dt;
+  float arrival_radius;
+  float relaxation_time;
+  RepulsionParams repulsion;
+};
+
+struct DeviceStats {
+  unsigned long long active;
+  unsigned long long newly_evacuated;
+};
+
+__device__ std::uint32_t clamp_axis(float v, float cell_size, std::uint32_t cells) {
+  const float c = floorf(v / cell_size);
+  if (!(c > 0.0f)) return 0u;
+  const auto i = static_cast<std::uint32_t>(c);
+  return i < cells - 1 ? i : cells - 1;
+}
+
+__device__ std::uint32_t cell_of(const CellGridLayout& l, float x, float y, std::int16_t floor) {
+  const std::uint32_t col = clamp_axis(x - l.origin_x, l.cell_size, l.cols);
+  const std::uint32_t row = clamp_axis(y - l.origin_y, l.cell_size, l.rows);
+  int f = floor - l.min_floor;
+  f = f < 0 ? 0 : (f > int(l.floors) - 1 ? int(l.floors) - 1 : f);
+  return (static_cast<std::uint32_t>(f) * l.rows + row) * l.cols + col;
+}
+
+__device__ float exp_approx(float x) {
+  x = fminf(fmaxf(x, kExpLo), kExpHi);
+  const float k = floorf(x * kLog2e + 0.5f);
+  float r = x - k * kLn2Hi;
+  r = r - k * kLn2Lo;
+  float p = kP0;
+  p = p * r + kP1;
+  p = p * r + kP2;
+  p = p * r + kP3;
+  p = p * r + kP4;
+  p = p * r + kP5;
+  p = p * (r * r) + r + 1.0f;
+  const float scale = __uint_as_float(static_cast<std::uint32_t>(static_cast<std::int32_t>(k) + 127) << 23);
+  return p * scale;
+}
+
+__device__ float fold16(const float* a) {
+  float s8[8];
+  for (int l = 0; l < 8; ++l) s8[l] = a[l] + a[l + 8];
+  float s4[4];
+  for (int l = 0; l < 4; ++l) s4[l] = s8[l] + s8[l + 4];
+  const float s2_0 = s4[0] + s4[2];
+  const float s2_1 = s4[1] + s4[3];
+  return s2_0 + s2_1;
+}
+
+__global__ void key_and_count(std::size_t n, StateColumns cur, GridColumns grid) {
+  const std::size_t i = blockIdx.x * std::size_t{blockDim.x} + threadIdx.x;
+  if (i >= n) return;
+  if (cur.evacuated[i]) {
+    grid.agent_cell[i] = kNoCell;
+    return;
+  }
+  const std::uint32_t c = cell_of(grid.layout, cur.x[i], cur.y[i], cur.floor[i]);
+  grid.agent_cell[i] = c;
+  atomicAdd(&grid.counts[c], 1u);
+}
+
+__global__ void scatter(std::size_t n, GridColumns grid) {
+  const std::size_t i = blockIdx.x * std::size_t{blockDim.x} + threadIdx.x;
+  if (i >= n) return;
+  const std::uint32_t c = grid.agent_cell[i];
+  if (c == kNoCell) return;
+  grid.sorted[atomicAdd(&grid.cursor[c], 1u)] = static_cast<std::uint32_t>(i);
+}
+
+// Ascending ids per cell, as CellGrid::rebuild() leaves them, then the
+// kernel columns in cell order.
+__global__ void sort_and_gather(std::size_t cells, const float* x, const float* y, const float* radius,
+                                GridColumns grid) {
+  const std::size_t c = blockIdx.x * std::size_t{blockDim.x} + threadIdx.x;
+  if (c >= cells) return;
+  std::uint32_t* first = grid.sorted + grid.offsets[c];
+  std::uint32_t* last = grid.sorted + grid.offsets[c + 1];
+  for (std::uint32_t* p = first + 1; p < last; ++p) {
+    const std::uint32_t v = *p;
+    std::uint32_t* q = p;
+    for (; q > first && q[-1] > v; --q) *q = q[-1];
+    *q = v;
+  }
+  for (std::uint32_t k = grid.offsets[c]; k < grid.offsets[c + 1]; ++k) {
+    const std::uint32_t i = grid.sorted[k];
+    grid.sorted_x[k] = x[i];
+    grid.sorted_y[k] = y[i];
+    grid.sorted_r[k] = radius[i];
+  }
+}
+
+// One thread per indexed agent; mirrors CrowdSimulator::step_cell(). The
+// neighbour list is the 3x3 neighbourhood's runs back to back, padded with
+// sentinels to a lane multiple, and neighbour k goes to lane k % 16.
+__global__ void step_agents(std::size_t n, StateColumns cur, StateColumns next, StaticColumns fixed,
+                            GridColumns grid, StepParams p) {
+  const std::size_t k = blockIdx.x * std::size_t{blockDim.x} + threadIdx.x;
+  const std::uint32_t cells = grid.layout.cols * grid.layout.rows * grid.layout.floors;
+  if (k >= n || k >= grid.offsets[cells]) return;
+  const std::uint32_t i = grid.sorted[k];
+  const std::uint32_t cell = grid.agent_cell[i];
+  const float xi = cur.x[i];
+  const float yi = cur.y[i];
+  NodeId goal = cur.goal[i];
+  std::int16_t floor = cur.floor[i];
+  bool out = false;
+
+  float gx = fixed.node_x[goal] - xi;
+  float gy = fixed.node_y[goal] - yi;
+  if (gx * gx + gy * gy < p.arrival_radius * p.arrival_radius) {
+    floor = fixed.node_floor[goal];
+    if (fixed.node_kind[goal] == NodeKind::Exit) {
+      out = true;
+    } else if (fixed.next_edge && fixed.next_edge[goal] != kInvalidEdge) {
+      goal = fixed.edge_target[fixed.next_edge[goal]];
+      gx = fixed.node_x[goal] - xi;
+      gy = fixed.node_y[goal] - yi;
+    }
+  }
+
+  float lane_x[kForceLanes] = {};
+  float lane_y[kForceLanes] = {};
+  const float ri = fixed.radius[i];
+  std::uint32_t lane = 0;
+  const auto accumulate = [&](float nx, float ny, float nr) {
+    const float ex = xi - nx;
+    const float ey = yi - ny;
+    const float d2 = ex * ex + ey * ey;
+    const bool active = d2 < p.repulsion.cutoff2 && d2 >= kMinDistance2;
+    const float d = sqrtf(d2);
+    const float f = p.repulsion.strength * exp_approx((ri + nr - d) * p.repulsion.inv_range);
+    const float t = f / d;
+    lane_x[lane] = lane_x[lane] + (active ? t * ex : 0.0f);
+    lane_y[lane] = lane_y[lane] + (active ? t * ey : 0.0f);
+    lane = (lane + 1) % kForceLanes;
+  };
+  const std::uint32_t cols = grid.layout.cols;
+  const std::uint32_t rows = grid.layout.rows;
+  const std::uint32_t col = cell % cols;
+  const std::uint32_t row = (cell / cols) % rows;
+  const std::uint32_t row_base = cell - col;
+  const std::uint32_t first_col = col == 0 ? 0 : col - 1;
+  const std::uint32_t last_col = col + 1 == cols ? col : col + 1;
+  for (int dr = -1; dr <= 1; ++dr) {
+    if ((row == 0 && dr < 0) || (row + 1 == rows && dr > 0)) continue;
+    const std::uint32_t base = row_base + static_cast<std::uint32_t>(dr * int(cols));
+    const std::uint32_t begin = grid.offsets[base + first_col];
+    const std::uint32_t end = grid.offsets[base + last_col + 1];
+    for (std::uint32_t j = begin; j < end; ++j) accumulate(grid.sorted_x[j], grid.sorted_y[j], grid.sorted_r[j]);
+  }
+  while (lane != 0) accumulate(kNeighbourSentinel, kNeighbourSentinel, 0.0f);
+  float ax = fold16(lane_x);
+  float ay = fold16(lane_y);
+
+  const float glen = sqrtf(gx * gx + gy * gy);
+  if (glen > 1e-4f) {
+    const float v0 = fixed.desired_speed[i];
+    ax += (v0 * gx / glen - cur.vx[i]) / p.relaxation_time;
+    ay += (v0 * gy / glen - cur.vy[i]) / p.relaxation_time;
+  }
+  float vx = cur.vx[i] + ax * p.dt;
+  float vy = cur.vy[i] + ay * p.dt;
+  const float vmax = 1.3f * fixed.desired_speed[i];
+  const float speed2 = vx * vx + vy * vy;
+  if (speed2 > vmax * vmax) {
+    const float s = vmax / sqrtf(speed2);
+    vx *= s;
+    vy *= s;
+  }
+  next.x[i] = xi + vx * p.dt;
+  next.y[i] = yi + vy * p.dt;
+  next.vx[i] = vx;
+  next.vy[i] = vy;
+  next.goal[i] = goal;
+  next.floor[i] = floor;
+  next.evacuated[i] = out ? 1 : 0;
+}
+
+// Evacuated agents are not indexed; carry their state over, then count.
+__global__ void carry_and_count(std::size_t n, StateColumns cur, StateColumns next, GridColumns grid,
+                                DeviceStats* stats) {
+  const std::size_t i = blockIdx.x * std::size_t{blockDim.x} + threadIdx.x;
+  if (i >= n) return;
+  if (grid.agent_cell[i] == kNoCell) {
+    next.x[i] = cur.x[i];
+    next.y[i] = cur.y[i];
+    next.vx[i] = 0.0f;
+    next.vy[i] = 0.0f;
+    next.goal[i] = cur.goal[i];
+    next.floor[i] = cur.floor[i];
+    next.evacuated[i] = 1;
+    return;
+  }
+  if (!next.evacuated[i]) {
+    atomicAdd(&stats->active, 1ull);
+  } else {
+    atomicAdd(&stats->newly_evacuated, 1ull);
+  }
+}
+
+}  // namespace
+
+int cuda_device_count() {
+  int count = 0;
+  return cudaGetDeviceCount(&count) == cudaSuccess ? count : 0;
+}
+
+struct CudaCrowdSimulator::Device {
+  struct State {
+    DeviceArray<float> x, y, vx, vy;
+    DeviceArray<std::int16_t> floor;
+    DeviceArray<NodeId> goal;
+    DeviceArray<std::uint8_t> evacuated;
+
+    void reserve(std::size_t n) {
+      x.reserve(n);
+      y.reserve(n);
+      vx.reserve(n);
+      vy.reserve(n);
+      floor.reserve(n);
+      goal.reserve(n);
+      evacuated.reserve(n);
+    }
+    StateColumns columns() const {
+      return {x.get(), y.get(), vx.get(), vy.get(), floor.get(), goal.get(), evacuated.get()};
+    }
+  };
+
+  CellGridLayout layout;
+  State state[2];
+  int current = 0;
+  DeviceArray<float> radius, desired_speed;
+  DeviceArray<float> node_x, node_y;
+  DeviceArray<std::int16_t> node_floor;
+  DeviceArray<NodeKind> node_kind;
+  DeviceArray<NodeId> edge_target;
+  DeviceArray<EdgeId> next_edge;
+  bool has_next_edge = false;
+  DeviceArray<std::uint32_t> agent_cell, counts, offsets, cursor, sorted;
+  DeviceArray<float> sorted_x, sorted_y, sorted_r;
+  DeviceArray<std::uint8_t> scan_temp;
+  std::size_t scan_temp_bytes = 0;
+  DeviceArray<DeviceStats> stats;
+
+  GridColumns grid_columns() const {
+    return {layout,    agent_cell.get(), counts.get(),   offsets.get(),  cursor.get(),
+            sorted.get(), sorted_x.get(), sorted_y.get(), sorted_r.get()};
+  }
+  StaticColumns static_columns() const {
+    return {radius.get(), desired_speed.get(), node_x.get(),      node_y.get(),
+            node_floor.get(), node_kind.get(), edge_target.get(), has_next_edge ? next_edge.get() : nullptr};
+  }
+};
+
+CudaCrowdSimulator::CudaCrowdSimulator(const BuildingGraph& graph, CrowdParams params)
+    : params_(params), device_(std::make_unique<Device>()) {
+  if (cuda_device_count() == 0) throw std::runtime_error("cuda: no device available");
+  params_.interaction_radius = std::min(params_.interaction_radius, params_.cell_size);
+  Device& d = *device_;
+  d.layout = grid_layout_for(graph, params_.cell_size);
+  const GraphColumns g = graph.columns();
+  d.node_x.upload(g.node_x.data(), g.node_x.size());
+  d.node_y.upload(g.node_y.data(), g.node_y.size());
+  d.node_floor.upload(g.node_floor.data(), g.node_floor.size());
+  d.node_kind.upload(g.node_kind.data(), g.node_kind.size());
+  d.edge_target.upload(g.edge_target.data(), g.edge_target.size());
+
+  const std::size_t cells = d.layout.cell_count();
+  d.counts.reserve(cells + 1);
+  d.offsets.reserve(cells + 1);
+  d.cursor.reserve(cells);
+  check(cub::DeviceScan::ExclusiveSum(nullptr, d.scan_temp_bytes, d.counts.get(), d.offsets.get(),
+                                      static_cast<int>(cells + 1)),
+        "scan sizing");
+  d.scan_temp.reserve(d.scan_temp_bytes);
+  d.stats.reserve(1);
+}
+
+CudaCrowdSimulator::~CudaCrowdSimulator() = default;
+
+void CudaCrowdSimulator::set_next_edges(std::span<const EdgeId> next_edge) {
+  device_->next_edge.upload(next_edge.data(), next_edge.size());
+  device_->has_next_edge = !next_edge.empty();
+}
+
+void CudaCrowdSimulator::upload(const AgentPopulation& agents) {
+  Device& d = *device_;
+  const std::size_t n = agents.size();
+  agent_count_ = n;
+  d.current = 0;
+  Device::State& s = d.state[0];
+  s.x.upload(agents.x.data(), n);
+  s.y.upload(agents.y.data(), n);
+  s.vx.upload(agents.vx.data(), n);
+  s.vy.upload(agents.vy.data(), n);
+  s.floor.upload(agents.floor.data(), n);
+  s.goal.upload(agents.goal.data(), n);
+  s.evacuated.upload(agents.evacuated.data(), n);
+  d.state[1].reserve(n);
+  d.radius.upload(agents.radius.data(), n);
+  d.desired_speed.upload(agents.desired_speed.data(), n);
+  d.agent_cell.reserve(n);
+  d.sorted.reserve(n);
+  d.sorted_x.reserve(n);
+  d.sorted_y.reserve(n);
+  d.sorted_r.reserve(n);
+}
+
+TickStats CudaCrowdSimulator::step() {
+  Device& d = *device_;
+  const std::size_t n = agent_count_;
+  const std::size_t cells = d.layout.cell_count();
+  const StateColumns cur = d.state[d.current].columns();
+  const StateColumns next = d.state[1 - d.current].columns();
+  const GridColumns grid = d.grid_columns();
+  TickStats stats;
+  stats.tick = ++tick_;
+  if (n == 0) return stats;
+
+  check(cudaMemset(grid.counts, 0, (cells + 1) * sizeof(std::uint32_t)), "clear counts");
+  key_and_count<<<blocks_for(n), kThreads>>>(n, cur, grid);
+  check(cub::DeviceScan::ExclusiveSum(d.scan_temp.get(), d.scan_temp_bytes, grid.counts, grid.offsets,
+                                      static_cast<int>(cells + 1)),
+        "scan");
+  check(cudaMemcpy(grid.cursor, grid.offsets, cells * sizeof(std::uint32_t), cudaMemcpyDeviceToDevice),
+        "cursors");
+  scatter<<<blocks_for(n), kThreads>>>(n, grid);
+  sort_and_gather<<<blocks_for(cells), kThreads>>>(cells, cur.x, cur.y, d.radius.get(), grid);
+
+  StepParams p;
+  p.dt = params_.dt;
+  p.arrival_radius = params_.arrival_radius;
+  p.relaxation_time = params_.relaxation_time;
+  p.repulsion.strength = params_.repulsion_strength;
+  p.repulsion.inv_range = 1.0f / params_.repulsion_range;
+  p.repulsion.cutoff2 = params_.interaction_radius * params_.interaction_radius;
+  step_agents<<<blocks_for(n), kThreads>>>(n, cur, next, d.static_columns(), grid, p);
+
+  check(cudaMemset(d.stats.get(), 0, sizeof(DeviceStats)), "clear stats");
+  carry_and_count<<<blocks_for(n), kThreads>>>(n, cur, next, grid, d.stats.get());
+  check(cudaGetLastError(), "step kernels");
+  DeviceStats counted{};
+  d.stats.download(&counted, 1);
+  d.current = 1 - d.current;
+  stats.active = static_cast<std::size_t>(counted.active);
+  stats.newly_evacuated = static_cast<std::size_t>(counted.newly_evacuated);
+  return stats;
+}
+
+void CudaCrowdSimulator::download(AgentPopulation& agents) const {
+  const Device& d = *device_;
+  const std::size_t n = agent_count_;
+  agents.resize(n);
+  const Device::State& s = d.state[d.current];
+  s.x.download(agents.x.data(), n);
+  s.y.download(agents.y.data(), n);
+  s.vx.download(agents.vx.data(), n);
+  s.vy.download(agents.vy.data(), n);
+  s.floor.download(agents.floor.data(), n);
+  s.goal.download(agents.goal.data(), n);
+  s.evacuated.download(agents.evacuated.data(), n);
+  d.radius.download(agents.radius.data(), n);
+  d.desired_speed.download(agents.desired_speed.data(), n);
+}
+
+}  // namespace evac
@@ -0,0 +1,62 @@
+#pragma once
+
+// CUDA crowd backend; only present in builds with EVAC_WITH_CUDA, where
+// crowd/cuda_crowd.cu is compiled by nvcc with --fmad=false. This header is
+// plain C++ so host translation units can include it.
+
+#if EVAC_WITH_CUDA
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include "crowd/agents.hpp"
+#include "crowd/crowd_sim.hpp"
+#include "graph/building_graph.hpp"
+
+namespace evac {
+
+int cuda_device_count();
+
+// Device-resident twin of CrowdSimulator for stadium-scale what-if runs. The
+// agents live on the device in the same SoA columns as AgentPopulation, and a
+// tick runs the same stages as the CPU path: key and count agents per cell,
+// scan, scatter, per-cell sort by id, gather the kernel columns, then one
+// thread per indexed agent does the waypoint update and the fixed-order
+// 16-lane repulsion sum. With FMA contraction off on both sides every
+// operation matches the scalar CPU kernel, so download() after N ticks gives
+// the same state checksum as N CPU ticks, which is how the two paths are
+// cross-checked.
+//
+// Only the tick statistics cross the bus per tick; upload() and download()
+// move the whole population.
+class CudaCrowdSimulator {
+ public:
+  // Throws std::runtime_error when no device is available.
+  CudaCrowdSimulator(const BuildingGraph& graph, CrowdParams params = {});
+  ~CudaCrowdSimulator();
+  CudaCrowdSimulator(const CudaCrowdSimulator&) = delete;
+  CudaCrowdSimulator& operator=(const CudaCrowdSimulator&) = delete;
+
+  // Copies the router's next-hop arcs to the device; call again after a repair.
+  void set_next_edges(std::span<const EdgeId> next_edge);
+
+  void upload(const AgentPopulation& agents);
+  TickStats step();
+  void download(AgentPopulation& agents) const;
+
+  const CrowdParams& params() const { return params_; }
+  std::size_t size() const { return agent_count_; }
+
+ private:
+  struct Device;
+
+  CrowdParams params_;
+  std::size_t agent_count_ = 0;
+  std::uint64_t tick_ = 0;
+  std::unique_ptr<Device> device_;
+};
+
+}  // namespace evac
+
+#endif  // EVAC_WITH_CUDA
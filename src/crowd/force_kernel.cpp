@@ -0,0 +1,274 @@
+#include "crowd/force_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EVAC_X86_KERNELS 1
+#endif
+
+// Every implementation must perform the same IEEE operations in the same
+// order; a fused multiply-add in one of them would break bit-equality.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+// GCC 12 flags the _mm512_undefined_*() placeholders inside its own intrinsics.
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace evac {
+namespace {
+
+constexpr float kExpLo = -87.0f;
+constexpr float kExpHi = 88.0f;
+constexpr float kLog2e = 1.44269504088896341f;
+constexpr float kLn2Hi = 0.693359375f;
+constexpr float kLn2Lo = -2.12194440e-4f;
+constexpr float kP0 = 1.9875691500e-4f;
+constexpr float kP1 = 1.3981999507e-3f;
+constexpr float kP2 = 8.3334519073e-3f;
+constexpr float kP3 = 4.1665795894e-2f;
+constexpr float kP4 = 1.6666665459e-1f;
+constexpr float kP5 = 5.0000001201e-1f;
+constexpr float kMinDistance2 = 1e-12f;
+
+// Cephes-style expf: range reduction by ln 2, degree-5 polynomial, exponent
+// injection. Written as plain mul/add so the vector versions can mirror it.
+inline float exp_approx(float x) {
+  x = std::min(std::max(x, kExpLo), kExpHi);
+  const float k = std::floor(x * kLog2e + 0.5f);
+  float r = x - k * kLn2Hi;
+  r = r - k * kLn2Lo;
+  float p = kP0;
+  p = p * r + kP1;
+  p = p * r + kP2;
+  p = p * r + kP3;
+  p = p * r + kP4;
+  p = p * r + kP5;
+  p = p * (r * r) + r + 1.0f;
+  const std::uint32_t bits = static_cast<std::uint32_t>(static_cast<std::int32_t>(k) + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof scale);
+  return p * scale;
+}
+
+inline float fold16(const float* a) {
+  float s8[8];
+  for (int l = 0; l < 8; ++l) s8[l] = a[l] + a[l + 8];
+  float s4[4];
+  for (int l = 0; l < 4; ++l) s4[l] = s8[l] + s8[l + 4];
+  const float s2_0 = s4[0] + s4[2];
+  const float s2_1 = s4[1] + s4[3];
+  return s2_0 + s2_1;
+}
+
+}  // namespace
+
+const char* to_string(ForceIsa isa) {
+  switch (isa) {
+    case ForceIsa::Auto: return "auto";
+    case ForceIsa::Scalar: return "scalar";
+    case ForceIsa::Avx2: return "avx2";
+    case ForceIsa::Avx512: return "avx512";
+  }
+  return "?";
+}
+
+bool parse_force_isa(const char* name, ForceIsa& out) {
+  for (ForceIsa isa : {ForceIsa::Auto, ForceIsa::Scalar, ForceIsa::Avx2, ForceIsa::Avx512}) {
+    if (std::strcmp(name, to_string(isa)) == 0) {
+      out = isa;
+      return true;
+    }
+  }
+  return false;
+}
+
+void repulsion_scalar(float xi, float yi, float ri, const NeighbourBlock& nb, const RepulsionParams& p,
+                      float& fx, float& fy) {
+  float ax[kForceLanes] = {};
+  float ay[kForceLanes] = {};
+  for (std::size_t base = 0; base < nb.count; base += kForceLanes) {
+    for (std::size_t l = 0; l < kForceLanes; ++l) {
+      const std::size_t j = base + l;
+      const float ex = xi - nb.x[j];
+      const float ey = yi - nb.y[j];
+      const float d2 = ex * ex + ey * ey;
+      const bool active = d2 < p.cutoff2 && d2 >= kMinDistance2;
+      const float d = std::sqrt(d2);
+      const float f = p.strength * exp_approx((ri + nb.r[j] - d) * p.inv_range);
+      const float t = f / d;
+      ax[l] = ax[l] + (active ? t * ex : 0.0f);
+      ay[l] = ay[l] + (active ? t * ey : 0.0f);
+    }
+  }
+  fx = fold16(ax);
+  fy = fold16(ay);
+}
+
+#if EVAC_X86_KERNELS
+
+namespace {
+
+__attribute__((target("avx2"))) inline __m256 exp_avx2(__m256 x) {
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(kExpLo)), _mm256_set1_ps(kExpHi));
+  const __m256 k = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(kLog2e)), _mm256_set1_ps(0.5f)));
+  __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(kLn2Hi)));
+  r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(kLn2Lo)));
+  __m256 p = _mm256_set1_ps(kP0);
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kP1));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kP2));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kP3));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kP4));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kP5));
+  p = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p, _mm256_mul_ps(r, r)), r), _mm256_set1_ps(1.0f));
+  const __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(p, _mm256_castsi256_ps(bits));
+}
+
+struct Avx2Lanes {
+  __m256 x, y;
+};
+
+__attribute__((target("avx2"))) inline Avx2Lanes lane_force_avx2(__m256 xi, __m256 yi, __m256 ri,
+                                                                  const float* xj, const float* yj,
+                                                                  const float* rj, const RepulsionParams& p) {
+  const __m256 ex = _mm256_sub_ps(xi, _mm256_load_ps(xj));
+  const __m256 ey = _mm256_sub_ps(yi, _mm256_load_ps(yj));
+  const __m256 d2 = _mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey));
+  const __m256 active = _mm256_and_ps(_mm256_cmp_ps(d2, _mm256_set1_ps(p.cutoff2), _CMP_LT_OQ),
+                                      _mm256_cmp_ps(d2, _mm256_set1_ps(kMinDistance2), _CMP_GE_OQ));
+  const __m256 d = _mm256_sqrt_ps(d2);
+  const __m256 arg = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(ri, _mm256_load_ps(rj)), d),
+                                   _mm256_set1_ps(p.inv_range));
+  const __m256 f = _mm256_mul_ps(_mm256_set1_ps(p.strength), exp_avx2(arg));
+  const __m256 t = _mm256_div_ps(f, d);
+  return {_mm256_and_ps(active, _mm256_mul_ps(t, ex)), _mm256_and_ps(active, _mm256_mul_ps(t, ey))};
+}
+
+// Lanes 0-7 in `lo`, 8-15 in `hi`; same tree as fold16().
+__attribute__((target("avx2"))) inline float fold16_avx2(__m256 lo, __m256 hi) {
+  const __m256 s8 = _mm256_add_ps(lo, hi);
+  const __m128 s4 = _mm_add_ps(_mm256_castps256_ps128(s8), _mm256_extractf128_ps(s8, 1));
+  const __m128 s2 = _mm_add_ps(s4, _mm_movehl_ps(s4, s4));
+  return _mm_cvtss_f32(_mm_add_ss(s2, _mm_shuffle_ps(s2, s2, 1)));
+}
+
+}  // namespace
+
+__attribute__((target("avx2"))) void repulsion_avx2(float xi, float yi, float ri, const NeighbourBlock& nb,
+                                                     const RepulsionParams& p, float& fx, float& fy) {
+  const __m256 vxi = _mm256_set1_ps(xi);
+  const __m256 vyi = _mm256_set1_ps(yi);
+  const __m256 vri = _mm256_set1_ps(ri);
+  __m256 ax_lo = _mm256_setzero_ps(), ax_hi = _mm256_setzero_ps();
+  __m256 ay_lo = _mm256_setzero_ps(), ay_hi = _mm256_setzero_ps();
+  for (std::size_t base = 0; base < nb.count; base += kForceLanes) {
+    const Avx2Lanes lo = lane_force_avx2(vxi, vyi, vri, nb.x + base, nb.y + base, nb.r + base, p);
+    const Avx2Lanes hi = lane_force_avx2(vxi, vyi, vri, nb.x + base + 8, nb.y + base + 8, nb.r + base + 8, p);
+    ax_lo = _mm256_add_ps(ax_lo, lo.x);
+    ay_lo = _mm256_add_ps(ay_lo, lo.y);
+    ax_hi = _mm256_add_ps(ax_hi, hi.x);
+    ay_hi = _mm256_add_ps(ay_hi, hi.y);
+  }
+  fx = fold16_avx2(ax_lo, ax_hi);
+  fy = fold16_avx2(ay_lo, ay_hi);
+}
+
+namespace {
+
+__attribute__((target("avx512f"))) inline __m512 exp_avx512(__m512 x) {
+  x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(kExpLo)), _mm512_set1_ps(kExpHi));
+  const __m512 k = _mm512_roundscale_ps(_mm512_add_ps(_mm512_mul_ps(x, _mm512_set1_ps(kLog2e)), _mm512_set1_ps(0.5f)),
+                                        _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  __m512 r = _mm512_sub_ps(x, _mm512_mul_ps(k, _mm512_set1_ps(kLn2Hi)));
+  r = _mm512_sub_ps(r, _mm512_mul_ps(k, _mm512_set1_ps(kLn2Lo)));
+  __m512 p = _mm512_set1_ps(kP0);
+  p = _mm512_add_ps(_mm512_mul_ps(p, r), _mm512_set1_ps(kP1));
+  p = _mm512_add_ps(_mm512_mul_ps(p, r), _mm512_set1_ps(kP2));
+  p = _mm512_add_ps(_mm512_mul_ps(p, r), _mm512_set1_ps(kP3));
+  p = _mm512_add_ps(_mm512_mul_ps(p, r), _mm512_set1_ps(kP4));
+  p = _mm512_add_ps(_mm512_mul_ps(p, r), _mm512_set1_ps(kP5));
+  p = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(p, _mm512_mul_ps(r, r)), r), _mm512_set1_ps(1.0f));
+  const __m512i bits = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(k), _mm512_set1_epi32(127)), 23);
+  return _mm512_mul_ps(p, _mm512_castsi512_ps(bits));
+}
+
+__attribute__((target("avx512f"))) inline float fold16_avx512(__m512 a) {
+  const __m256 hi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1));
+  const __m256 s8 = _mm256_add_ps(_mm512_castps512_ps256(a), hi);
+  const __m128 s4 = _mm_add_ps(_mm256_castps256_ps128(s8), _mm256_extractf128_ps(s8, 1));
+  const __m128 s2 = _mm_add_ps(s4, _mm_movehl_ps(s4, s4));
+  return _mm_cvtss_f32(_mm_add_ss(s2, _mm_shuffle_ps(s2, s2, 1)));
+}
+
+}  // namespace
+
+__attribute__((target("avx512f"))) void repulsion_avx512(float xi, float yi, float ri, const NeighbourBlock& nb,
+                                                          const RepulsionParams& p, float& fx, float& fy) {
+  const __m512 vxi = _mm512_set1_ps(xi);
+  const __m512 vyi = _mm512_set1_ps(yi);
+  const __m512 vri = _mm512_set1_ps(ri);
+  const __m512 cutoff2 = _mm512_set1_ps(p.cutoff2);
+  const __m512 min_d2 = _mm512_set1_ps(kMinDistance2);
+  const __m512 inv_range = _mm512_set1_ps(p.inv_range);
+  const __m512 strength = _mm512_set1_ps(p.strength);
+  __m512 ax = _mm512_setzero_ps();
+  __m512 ay = _mm512_setzero_ps();
+  for (std::size_t base = 0; base < nb.count; base += kForceLanes) {
+    const __m512 ex = _mm512_sub_ps(vxi, _mm512_load_ps(nb.x + base));
+    const __m512 ey = _mm512_sub_ps(vyi, _mm512_load_ps(nb.y + base));
+    const __m512 d2 = _mm512_add_ps(_mm512_mul_ps(ex, ex), _mm512_mul_ps(ey, ey));
+    const __mmask16 active = _mm512_cmp_ps_mask(d2, cutoff2, _CMP_LT_OQ) & _mm512_cmp_ps_mask(d2, min_d2, _CMP_GE_OQ);
+    const __m512 d = _mm512_sqrt_ps(d2);
+    const __m512 arg = _mm512_mul_ps(_mm512_sub_ps(_mm512_add_ps(vri, _mm512_load_ps(nb.r + base)), d), inv_range);
+    const __m512 t = _mm512_div_ps(_mm512_mul_ps(strength, exp_avx512(arg)), d);
+    ax = _mm512_add_ps(ax, _mm512_maskz_mul_ps(active, t, ex));
+    ay = _mm512_add_ps(ay, _mm512_maskz_mul_ps(active, t, ey));
+  }
+  fx = fold16_avx512(ax);
+  fy = fold16_avx512(ay);
+}
+
+RepulsionKernel select_repulsion_kernel(ForceIsa requested, ForceIsa* chosen) {
+  ForceIsa isa = ForceIsa::Scalar;
+  const bool want512 = requested == ForceIsa::Auto || requested == ForceIsa::Avx512;
+  const bool want256 = want512 || requested == ForceIsa::Avx2;
+  if (want512 && __builtin_cpu_supports("avx512f")) {
+    isa = ForceIsa::Avx512;
+  } else if (want256 && __builtin_cpu_supports("avx2")) {
+    isa = ForceIsa::Avx2;
+  }
+  if (chosen) *chosen = isa;
+  switch (isa) {
+    case ForceIsa::Avx512: return repulsion_avx512;
+    case ForceIsa::Avx2: return repulsion_avx2;
+    default: return repulsion_scalar;
+  }
+}
+
+#else  // !EVAC_X86_KERNELS
+
+void repulsion_avx2(float xi, float yi, float ri, const NeighbourBlock& nb, const RepulsionParams& p,
+                    float& fx, float& fy) {
+  repulsion_scalar(xi, yi, ri, nb, p, fx, fy);
+}
+
+void repulsion_avx512(float xi, float yi, float ri, const NeighbourBlock& nb, const RepulsionParams& p,
+                      float& fx, float& fy) {
+  repulsion_scalar(xi, yi, ri, nb, p, fx, fy);
+}
+
+RepulsionKernel select_repulsion_kernel(ForceIsa, ForceIsa* chosen) {
+  if (chosen) *chosen = ForceIsa::Scalar;
+  return repulsion_scalar;
+}
+
+#endif  // EVAC_X86_KERNELS
+
+}  // namespace evac
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+
+namespace evac {
+
+// Canonical lane count of the repulsion reduction. Every implementation keeps
+// 16 partial sums (neighbour k goes to lane k % 16) and folds them with the
+// same pairwise tree, so scalar, AVX2 (two 8-wide registers) and AVX-512 (one
+// 16-wide register) produce bit-identical forces.
+inline constexpr std::size_t kForceLanes = 16;
+
+enum class ForceIsa { Auto, Scalar, Avx2, Avx512 };
+
+const char* to_string(ForceIsa isa);
+// Parses "auto", "scalar", "avx2", "avx512"; returns false on anything else.
+bool parse_force_isa(const char* name, ForceIsa& out);
+
+struct RepulsionParams {
+  float strength = 2.0f;   // m/s^2 at contact
+  float inv_range = 1.0f / 0.3f;
+  float cutoff2 = 4.0f;    // squared interaction radius
+};
+
+// Neighbour candidates for one agent as SoA columns of `count` entries, where
+// `count` is a multiple of kForceLanes and the arrays are 64-byte aligned. Pad
+// slots must hold a far-away sentinel (pad_neighbours() does this); the agent
+// itself may appear and is skipped because its distance is zero.
+struct NeighbourBlock {
+  const float* x;
+  const float* y;
+  const float* r;
+  std::size_t count;
+};
+
+inline constexpr float kNeighbourSentinel = 1e30f;
+
+// Rounds `count` up to a lane multiple; callers fill [count, padded) with the sentinel.
+inline std::size_t padded_neighbour_count(std::size_t count) {
+  return (count + kForceLanes - 1) / kForceLanes * kForceLanes;
+}
+
+using RepulsionKernel = void (*)(float xi, float yi, float ri, const NeighbourBlock& nb,
+                                 const RepulsionParams& p, float& fx, float& fy);
+
+void repulsion_scalar(float xi, float yi, float ri, const NeighbourBlock& nb,
+                      const RepulsionParams& p, float& fx, float& fy);
+void repulsion_avx2(float xi, float yi, float ri, const NeighbourBlock& nb,
+                    const RepulsionParams& p, float& fx, float& fy);
+void repulsion_avx512(float xi, float yi, float ri, const NeighbourBlock& nb,
+                      const RepulsionParams& p, float& fx, float& fy);
+
+// Best kernel the CPU supports, capped at `requested`. Unsupported requests fall
+// back to the next narrower implementation; the effective ISA is reported.
+RepulsionKernel select_repulsion_kernel(ForceIsa requested, ForceIsa* chosen = nullptr);
+
+}  // namespace evac
@@ -0,0 +1,324 @@
+#include "crowd/hybrid_crowd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "routing/cost.hpp"
+#include "spatial/cell_grid.hpp"
+
+namespace evac {
+namespace {
+
+void append_agent(const AgentPopulation& from, std::size_t i, AgentPopulation& to) {
+  to.add(from.x[i], from.y[i], from.floor[i], from.goal[i], from.radius[i], from.desired_speed[i]);
+  to.vx.back() = from.vx[i];
+  to.vy.back() = from.vy[i];
+}
+
+}  // namespace
+
+HybridCrowd::HybridCrowd(const BuildingGraph& graph, WorkStealingPool& pool, HybridParams params)
+    : graph_(graph),
+      params_(params),
+      pool_(pool),
+      step_seconds_(static_cast<double>(params.crowd.dt) * std::max<std::uint32_t>(params.macro_every, 1)),
+      rng_(params.seed) {
+  params_.macro_every = std::max<std::uint32_t>(params_.macro_every, 1);
+  params_.jam_factor = std::max(params_.jam_factor, 1.5f);
+  const std::size_t m = graph_.edge_count();
+  cell_offset_.resize(m + 1);
+  capacity_.resize(m);
+  std::uint32_t cells = 0;
+  for (EdgeId e = 0; e < m; ++e) {
+    cell_offset_[e] = cells;
+    const double cell_m = walking_speed_mps(graph_.edge_kind(e)) * step_seconds_;
+    cells += static_cast<std::uint32_t>(std::max(1.0, std::round(graph_.edge_length(e) / cell_m)));
+    const float pps = graph_.edge_capacity(e);
+    capacity_[e] = (pps > 0.0f ? pps : params_.default_capacity_pps) * step_seconds_;
+  }
+  cell_offset_[m] = cells;
+  cells_.assign(cells, 0.0);
+  outflow_.assign(cells, 0.0);
+  inflow_.assign(m, 0.0);
+  entry_.assign(m, 0.0);
+  queue_.assign(graph_.node_count(), 0.0);
+  credit_.assign(graph_.node_count(), 0.0);
+  active_.assign(static_cast<std::size_t>(graph_.floor_count()), 0);
+  calm_.assign(active_.size(), 0.0);
+  micro_.resize(active_.size());
+  agents_.resize(active_.size());
+}
+
+void HybridCrowd::set_next_edges(std::span<const EdgeId> next_edge) {
+  next_edge_ = next_edge;
+  for (const auto& sim : micro_) {
+    if (sim) sim->set_next_edges(next_edge);
+  }
+}
+
+void HybridCrowd::load(const AgentPopulation& agents) {
+  for (EdgeId e = 0; e < graph_.edge_count(); ++e) {
+    const std::size_t f = floor_index(graph_.node_floor(graph_.edge_source(e)));
+    if (graph_.edge_hazard(e) >= params_.activate_hazard && !active_[f]) activate(f);
+  }
+  for (std::size_t i = 0; i < agents.size(); ++i) {
+    if (agents.evacuated[i]) {
+      evacuated_ += 1.0;
+    } else if (active_[floor_index(agents.floor[i])] && node_active(agents.goal[i])) {
+      append_agent(agents, i, agents_[floor_index(agents.floor[i])]);
+    } else {
+      arrive(agents.goal[i], 1.0);
+    }
+  }
+  loaded_ += static_cast<double>(agents.size());
+}
+
+std::size_t HybridCrowd::agent_count() const {
+  std::size_t n = 0;
+  for (const AgentPopulation& a : agents_) n += a.size();
+  return n;
+}
+
+double HybridCrowd::people() const {
+  double total = evacuated_ + static_cast<double>(agent_count());
+  for (const double n : cells_) total += n;
+  for (const double n : entry_) total += n;
+  for (const double n : queue_) total += n;
+  for (const double n : credit_) total += n;
+  return total;
+}
+
+void HybridCrowd::arrive(NodeId v, double people) {
+  if (graph_.node_kind(v) == NodeKind::Exit) {
+    evacuated_ += people;
+  } else if (node_active(v)) {
+    credit_[v] += people;
+  } else {
+    queue_[v] += people;
+  }
+}
+
+void HybridCrowd::spawn(NodeId goal, float x, float y, std::int16_t floor) {
+  const float jitter = graph_.node_kind(goal) == NodeKind::Room ? 2.0f : 0.5f;
+  agents_[floor_index(floor)].add(x + rng_.uniform(-jitter, jitter), y + rng_.uniform(-jitter, jitter), floor, goal,
+              rng_.uniform(0.22f, 0.28f), rng_.uniform(1.0f, 1.45f));
+  ++counters_.spawned;
+}
+
+void HybridCrowd::spawn_credit(NodeId v) {
+  for (; credit_[v] >= 1.0; credit_[v] -= 1.0) spawn(v, graph_.node_x(v), graph_.node_y(v), graph_.node_floor(v));
+}
+
+// Folds an agent into the arc towards its waypoint, preferring the one its
+// routing field would have taken; an agent with no such arc joins the
+// waypoint itself.
+void HybridCrowd::fold(const AgentPopulation& agents, std::size_t i) {
+  const NodeId goal = agents.goal[i];
+  EdgeId via = kInvalidEdge;
+  for (const EdgeId e : graph_.in_edges(goal)) {
+    const NodeId u = graph_.edge_source(e);
+    if (graph_.node_floor(u) != agents.floor[i]) continue;
+    if (via == kInvalidEdge || (!next_edge_.empty() && next_edge_[u] == e)) via = e;
+  }
+  if (via != kInvalidEdge && flow_arc(via)) {
+    entry_[via] += 1.0;
+  } else {
+    arrive(goal, 1.0);
+  }
+  ++counters_.despawned;
+}
+
+// Drops evacuated agents of a floor, folds those that left the active floors
+// and hands those that reached another active floor to its population.
+void HybridCrowd::compact(std::size_t floor) {
+  AgentPopulation& agents = agents_[floor];
+  std::size_t keep = 0;
+  for (std::size_t i = 0; i < agents.size(); ++i) {
+    if (agents.evacuated[i]) {
+      evacuated_ += 1.0;
+      continue;
+    }
+    const std::size_t on = floor_index(agents.floor[i]);
+    if (!active_[on] || !node_active(agents.goal[i])) {
+      fold(agents, i);
+      continue;
+    }
+    if (on != floor) {
+      append_agent(agents, i, agents_[on]);
+      continue;
+    }
+    if (keep != i) {
+      agents.x[keep] = agents.x[i];
+      agents.y[keep] = agents.y[i];
+      agents.vx[keep] = agents.vx[i];
+      agents.vy[keep] = agents.vy[i];
+      agents.radius[keep] = agents.radius[i];
+      agents.desired_speed[keep] = agents.desired_speed[i];
+      agents.floor[keep] = agents.floor[i];
+      agents.goal[keep] = agents.goal[i];
+      agents.evacuated[keep] = 0;
+    }
+    ++keep;
+  }
+  agents.resize(keep);
+}
+
+// One Godunov step over every arc with an end on a flow floor. All flows are
+// computed from the state at the start of the step and applied afterwards, so
+// the arc order does not matter.
+void HybridCrowd::flow_step() {
+  const double slope = 1.0 / (params_.jam_factor - 1.0);
+  const auto sending = [](double n, double q) { return std::min(n, q); };
+  const auto receiving = [&](double n, double q) {
+    return std::max(0.0, std::min(q, (params_.jam_factor * q - n) * slope));
+  };
+  const std::size_t m = graph_.edge_count();
+  const auto released = [&](EdgeId e) {
+    const NodeId u = graph_.edge_source(e);
+    const bool from_queue = !node_active(u) && !next_edge_.empty() && next_edge_[u] == e;
+    return entry_[e] + (from_queue ? queue_[u] : 0.0);
+  };
+
+  for (EdgeId e = 0; e < m; ++e) {
+    if (!flow_arc(e)) continue;
+    const float hazard = graph_.edge_hazard(e);
+    const double q = hazard >= kImpassableHazard ? 0.0 : capacity_[e] * (1.0 - std::max(hazard, 0.0f));
+    const std::uint32_t b = cell_offset_[e];
+    const std::uint32_t end = cell_offset_[e + 1];
+    for (std::uint32_t c = b; c + 1 < end; ++c) {
+      outflow_[c] = std::min(sending(cells_[c], q), receiving(cells_[c + 1], q));
+    }
+    outflow_[end - 1] = sending(cells_[end - 1], q);
+    inflow_[e] = std::min(released(e), receiving(cells_[b], q));
+  }
+
+  for (EdgeId e = 0; e < m; ++e) {
+    if (!flow_arc(e)) continue;
+    const std::uint32_t b = cell_offset_[e];
+    const std::uint32_t end = cell_offset_[e + 1];
+    double in = inflow_[e];
+    const double from_entry = std::min(in, entry_[e]);
+    entry_[e] -= from_entry;
+    queue_[graph_.edge_source(e)] -= in - from_entry;
+    for (std::uint32_t c = b; c < end; ++c) {
+      cells_[c] += in - outflow_[c];
+      in = outflow_[c];
+    }
+    if (in > 0.0) arrive(graph_.edge_target(e), in);
+  }
+  ++counters_.flow_steps;
+}
+
+void HybridCrowd::activate(std::size_t floor) {
+  active_[floor] = 1;
+  calm_[floor] = 0.0;
+  ++counters_.activations;
+  if (!micro_[floor]) {
+    std::vector<NodeId> nodes;
+    for (NodeId v = 0; v < graph_.node_count(); ++v) {
+      if (floor_index(graph_.node_floor(v)) == floor) nodes.push_back(v);
+    }
+    micro_[floor] = std::make_unique<CrowdSimulator>(graph_, pool_, params_.crowd,
+                                                     grid_layout_for(graph_, nodes, params_.crowd.cell_size));
+    micro_[floor]->set_next_edges(next_edge_);
+  }
+  const auto on_floor = [&](NodeId v) { return floor_index(graph_.node_floor(v)) == floor; };
+  for (EdgeId e = 0; e < graph_.edge_count(); ++e) {
+    const NodeId u = graph_.edge_source(e);
+    const NodeId v = graph_.edge_target(e);
+    if ((!on_floor(u) && !on_floor(v)) || flow_arc(e)) continue;
+    // Every whole person along the arc becomes an agent where the flow has
+    // got to; the remainder waits at the target.
+    const std::uint32_t b = cell_offset_[e];
+    const std::uint32_t k = cell_offset_[e + 1] - b;
+    double carry = entry_[e];
+    entry_[e] = 0.0;
+    for (std::uint32_t c = 0; c <= k; ++c) {
+      const float t = static_cast<float>(c) / static_cast<float>(k);
+      for (; carry >= 1.0; carry -= 1.0) {
+        spawn(v, graph_.node_x(u) + t * (graph_.node_x(v) - graph_.node_x(u)),
+              graph_.node_y(u) + t * (graph_.node_y(v) - graph_.node_y(u)), graph_.node_floor(u));
+      }
+      if (c < k) {
+        carry += cells_[b + c];
+        cells_[b + c] = 0.0;
+      }
+    }
+    arrive(v, carry);
+  }
+  for (NodeId v = 0; v < graph_.node_count(); ++v) {
+    if (!on_floor(v)) continue;
+    credit_[v] += queue_[v];
+    queue_[v] = 0.0;
+  }
+}
+
+void HybridCrowd::deactivate(std::size_t floor) {
+  active_[floor] = 0;
+  ++counters_.deactivations;
+  for (NodeId v = 0; v < graph_.node_count(); ++v) {
+    if (floor_index(graph_.node_floor(v)) != floor) continue;
+    queue_[v] += credit_[v];
+    credit_[v] = 0.0;
+  }
+  compact(floor);
+}
+
+// A floor is hot while an arc on it carries hazard, or people back up on it:
+// in node queues or congested cells while it is flow, in agents or people
+// waiting to leave it by flow arcs while it is active.
+void HybridCrowd::update_floors() {
+  std::vector<double> backlog(active_.size(), 0.0);
+  std::vector<std::uint8_t> hot(active_.size(), 0);
+  for (EdgeId e = 0; e < graph_.edge_count(); ++e) {
+    const std::size_t f = floor_index(graph_.node_floor(graph_.edge_source(e)));
+    if (graph_.edge_hazard(e) >= params_.activate_hazard) hot[f] = 1;
+    backlog[f] += entry_[e];
+    if (active_[f]) continue;
+    const double q = capacity_[e];
+    for (std::uint32_t c = cell_offset_[e]; c < cell_offset_[e + 1]; ++c) {
+      if (cells_[c] > q) backlog[f] += cells_[c];
+    }
+  }
+  for (NodeId v = 0; v < graph_.node_count(); ++v) {
+    const std::size_t f = floor_index(graph_.node_floor(v));
+    if (graph_.node_kind(v) != NodeKind::Room && queue_[v] > params_.queue_people) hot[f] = 1;
+  }
+  for (std::size_t f = 0; f < active_.size(); ++f) {
+    backlog[f] += static_cast<double>(agents_[f].size());
+    if (hot[f] || backlog[f] > params_.queue_people) {
+      calm_[f] = 0.0;
+      if (!active_[f]) activate(f);
+    } else if (active_[f]) {
+      calm_[f] += step_seconds_;
+      if (calm_[f] >= params_.calm_seconds) deactivate(f);
+    }
+  }
+}
+
+HybridStats HybridCrowd::step() {
+  if (tick_ % params_.macro_every == 0) {
+    flow_step();
+    update_floors();
+    for (NodeId v = 0; v < graph_.node_count(); ++v) {
+      if (credit_[v] >= 1.0 && node_active(v)) spawn_credit(v);
+    }
+  }
+  for (std::size_t f = 0; f < active_.size(); ++f) {
+    if (agents_[f].size() != 0) micro_[f]->step(agents_[f]);
+  }
+  for (std::size_t f = 0; f < active_.size(); ++f) {
+    if (agents_[f].size() != 0) compact(f);
+  }
+  ++tick_;
+
+  HybridStats stats;
+  stats.tick = tick_;
+  stats.agents = agent_count();
+  stats.evacuated = evacuated_;
+  stats.flow_people = loaded_ - evacuated_ - static_cast<double>(stats.agents);
+  stats.active_floors = static_cast<std::size_t>(std::count(active_.begin(), active_.end(), std::uint8_t{1}));
+  return stats;
+}
+
+}  // namespace evac
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "crowd/agents.hpp"
+#include "crowd/crowd_sim.hpp"
+#include "exec/work_stealing_pool.hpp"
+#include "graph/building_graph.hpp"
+#include "util/rng.hpp"
+
+namespace evac {
+
+struct HybridParams {
+  CrowdParams crowd;                   // microscopic model on active floors
+  std::uint32_t macro_every = 10;      // crowd ticks per flow step
+  float default_capacity_pps = 1.3f;   // arcs the plan gives no capacity
+  float jam_factor = 3.0f;             // cell storage in step capacities; backward wave at v / (jam_factor - 1)
+  float activate_hazard = 0.05f;       // hazard on any arc of a floor makes it active
+  float queue_people = 25.0f;          // a queue this long (or a floor this full, once active) marks a bottleneck
+  float calm_seconds = 30.0f;          // an active floor returns to flow after this long without either
+  std::uint64_t seed = 1;              // jitter of agents spawned from flow
+};
+
+struct HybridStats {
+  std::uint64_t tick = 0;
+  std::size_t agents = 0;           // microscopic agents inside
+  double flow_people = 0.0;         // people carried by the flow model
+  double evacuated = 0.0;
+  std::size_t active_floors = 0;
+};
+
+struct HybridCounters {
+  std::uint64_t spawned = 0;      // agents created from flow at active-floor boundaries
+  std::uint64_t despawned = 0;    // agents folded back into flow
+  std::uint64_t activations = 0;
+  std::uint64_t deactivations = 0;
+  std::uint64_t flow_steps = 0;
+};
+
+// Level-of-detail crowd: the social-force model (CrowdSimulator) runs only on
+// active floors, those with hazard on them or a queue forming, and everything
+// else moves as a cell-transmission flow (the Godunov scheme for the LWR
+// model) on the building graph.
+//
+// In the flow model each arc is cut into cells one free-flow step long and
+// carries a triangular fundamental diagram: a cell sends min(n, Q) and
+// receives min(Q, (N - n) / (jam_factor - 1)), with Q the arc's capacity per
+// step and N = jam_factor * Q its storage, so queues back up along corridors
+// and stair flights; hazard scales Q by (1 - hazard). Nodes are point queues that release onto the node's
+// next-hop arc, so flow follows the same routing field as the agents. One
+// flow step covers `macro_every` crowd ticks.
+//
+// People cross between the models at active-floor boundaries. Flow leaving an
+// arc into an active node, or a floor being activated, turns into agents at
+// the node (or along the arc, cell by cell); an agent whose next waypoint is
+// on a flow floor, or whose floor is deactivated, is folded into the arc it
+// is walking. Fractions of a person wait at their node until a whole agent
+// can be spawned, so the head count, flow people plus agents plus evacuated,
+// is conserved to rounding (see people()).
+//
+// Each active floor has its own CrowdSimulator on a grid of that floor only,
+// so a tick costs in proportion to the active floors, not to the building;
+// agents reaching a landing of another active floor move to its simulator.
+//
+// Hazards are read from the graph, which the router owns; set_next_edges()
+// must be called again after every repair, as for CrowdSimulator.
+class HybridCrowd {
+ public:
+  HybridCrowd(const BuildingGraph& graph, WorkStealingPool& pool, HybridParams params = {});
+
+  void set_next_edges(std::span<const EdgeId> next_edge);
+  // Starts from a spawned population: agents on floors that are active now
+  // stay agents, the rest arrive at their waypoint node as flow would: an
+  // exit counts them out and an active node turns them into agents there.
+  void load(const AgentPopulation& agents);
+
+  HybridStats step();
+
+  // Agents on one floor; empty unless the floor is active.
+  const AgentPopulation& floor_agents(std::int16_t floor) const { return agents_[floor_index(floor)]; }
+  std::size_t agent_count() const;
+  bool floor_active(std::int16_t floor) const { return active_[floor_index(floor)] != 0; }
+  const HybridCounters& counters() const { return counters_; }
+  // Flow people, agents and evacuated together; constant over a run.
+  double people() const;
+
+ private:
+  std::size_t floor_index(std::int16_t floor) const {
+    return static_cast<std::size_t>(floor - graph_.min_floor());
+  }
+  bool node_active(NodeId v) const { return active_[floor_index(graph_.node_floor(v))] != 0; }
+  bool flow_arc(EdgeId e) const {
+    return !node_active(graph_.edge_source(e)) || !node_active(graph_.edge_target(e));
+  }
+
+  void flow_step();
+  void update_floors();
+  void activate(std::size_t floor);
+  void deactivate(std::size_t floor);
+  void arrive(NodeId v, double people);
+  void spawn(NodeId goal, float x, float y, std::int16_t floor);
+  void spawn_credit(NodeId v);
+  void fold(const AgentPopulation& agents, std::size_t i);
+  void compact(std::size_t floor);
+
+  const BuildingGraph& graph_;
+  HybridParams params_;
+  WorkStealingPool& pool_;
+  double step_seconds_ = 1.0;
+  std::span<const EdgeId> next_edge_;
+  std::vector<std::unique_ptr<CrowdSimulator>> micro_;  // per floor, built on first activation
+  std::vector<AgentPopulation> agents_;                 // per floor
+  SplitMix64 rng_;
+
+  // Flow state. Cells of arc e are [cell_offset_[e], cell_offset_[e + 1]).
+  std::vector<std::uint32_t> cell_offset_;
+  std::vector<double> cells_;
+  std::vector<double> outflow_;       // per cell, scratch of one flow step
+  std::vector<double> inflow_;        // per arc, into the first cell; scratch of one flow step
+  std::vector<double> capacity_;      // per arc, people per flow step
+  std::vector<double> entry_;         // per arc, folded agents waiting to enter the first cell
+  std::vector<double> queue_;         // per node
+  std::vector<double> credit_;        // per active node, flow waiting to become agents
+  double evacuated_ = 0.0;
+  double loaded_ = 0.0;              // people() should stay at this
+
+  std::vector<std::uint8_t> active_;  // per floor
+  std::vector<double> calm_;          // per floor, seconds since it was last hot
+  std::uint64_t tick_ = 0;
+  HybridCounters counters_;
+};
+
+}  // namespace evac
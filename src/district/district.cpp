@@ -0,0 +1,125 @@
+#include "district/district.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace evac {
+
+District::District(const BuildingGraph& model, RegionPartition partition, WorkStealingPool& pool, CrowdParams crowd)
+    : model_(model), partition_(std::move(partition)), pool_(pool) {
+  const std::uint32_t k = partition_.regions;
+  nodes_.reserve(k);
+  for (std::uint32_t r = 0; r < k; ++r) nodes_.push_back(std::make_unique<RegionNode>(model_, partition_, r, crowd));
+  labels_.resize(k);
+  outbox_.assign(k, std::vector<std::vector<std::byte>>(k));
+}
+
+void District::set_edge_hazard(EdgeId e, float hazard) {
+  nodes_[partition_.region_of[model_.edge_source(e)]]->set_edge_hazard(e, hazard);
+}
+
+ExchangeStats District::exchange() {
+  const std::uint32_t k = partition_.regions;
+  std::vector<std::uint8_t> sent(k, 0);
+  pool_.parallel_for(k, 1, [&](std::size_t b, std::size_t e, unsigned) {
+    for (std::size_t r = b; r < e; ++r) {
+      labels_[r].clear();
+      sent[r] = nodes_[r]->publish_labels(labels_[r]) ? 1 : 0;
+    }
+  });
+  ExchangeStats stats;
+  for (std::uint32_t r = 0; r < k; ++r) {
+    stats.label_messages += sent[r];
+    stats.label_bytes += labels_[r].size();
+  }
+
+  std::vector<std::uint8_t> rebuilt(k, 0);
+  std::vector<RegionStatus> status(k, RegionStatus::Ok);
+  pool_.parallel_for(k, 1, [&](std::size_t b, std::size_t e, unsigned) {
+    for (std::size_t r = b; r < e; ++r) {
+      for (std::uint32_t from = 0; from < k; ++from) {
+        if (from == r || labels_[from].empty()) continue;
+        const RegionStatus s = nodes_[r]->receive(labels_[from]);
+        if (s != RegionStatus::Ok) status[r] = s;
+      }
+      rebuilt[r] = nodes_[r]->solve() ? 1 : 0;
+    }
+  });
+  for (std::uint32_t r = 0; r < k; ++r) {
+    if (status[r] != RegionStatus::Ok) {
+      throw std::runtime_error("district: region " + std::to_string(r) + " rejected labels: " + to_string(status[r]));
+    }
+    stats.fields_rebuilt += rebuilt[r];
+  }
+  return stats;
+}
+
+void District::add_agents(const AgentPopulation& agents) {
+  for (std::size_t i = 0; i < agents.size(); ++i) {
+    AgentPopulation& to = nodes_[partition_.region_of[agents.goal[i]]]->agents();
+    to.add(agents.x[i], agents.y[i], agents.floor[i], agents.goal[i], agents.radius[i], agents.desired_speed[i]);
+  }
+}
+
+DistrictTick District::step() {
+  const std::uint32_t k = partition_.regions;
+  std::vector<TickStats> ticks(k);
+  pool_.parallel_for(k, 1, [&](std::size_t b, std::size_t e, unsigned) {
+    for (std::size_t r = b; r < e; ++r) {
+      for (auto& box : outbox_[r]) box.clear();
+      ticks[r] = nodes_[r]->step(outbox_[r]);
+    }
+  });
+
+  DistrictTick tick;
+  std::vector<RegionStatus> status(k, RegionStatus::Ok);
+  pool_.parallel_for(k, 1, [&](std::size_t b, std::size_t e, unsigned) {
+    for (std::size_t r = b; r < e; ++r) {
+      for (std::uint32_t from = 0; from < k; ++from) {
+        if (outbox_[from][r].empty()) continue;
+        const RegionStatus s = nodes_[r]->receive(outbox_[from][r]);
+        if (s != RegionStatus::Ok) status[r] = s;
+      }
+    }
+  });
+  for (std::uint32_t r = 0; r < k; ++r) {
+    if (status[r] != RegionStatus::Ok) {
+      throw std::runtime_error("district: region " + std::to_string(r) + " rejected a flow: " + to_string(status[r]));
+    }
+    tick.crowd.tick = ticks[r].tick;
+    tick.crowd.newly_evacuated += ticks[r].newly_evacuated;
+    for (const auto& box : outbox_[r]) {
+      if (box.empty()) continue;
+      tick.flow_bytes += box.size();
+      tick.agents_handed_over += (box.size() - sizeof(RegionHeader)) / sizeof(FlowAgent);
+    }
+  }
+  tick.crowd.active = inside();
+  return tick;
+}
+
+std::size_t District::evacuated() const {
+  std::size_t total = 0;
+  for (const auto& node : nodes_) total += node->evacuated();
+  return total;
+}
+
+std::size_t District::inside() const {
+  std::size_t total = 0;
+  for (const auto& node : nodes_) total += node->agents().size();
+  return total;
+}
+
+void District::export_field(ExitField& out) const {
+  const std::size_t n = model_.node_count();
+  out.distance.resize(n);
+  out.next_edge.resize(n);
+  for (NodeId v = 0; v < n; ++v) {
+    const RegionNode& owner = *nodes_[partition_.region_of[v]];
+    out.distance[v] = owner.distance(v);
+    out.next_edge[v] = owner.next_edge(v);
+  }
+}
+
+}  // namespace evac
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "crowd/crowd_sim.hpp"
+#include "district/region_node.hpp"
+#include "district/region_partition.hpp"
+#include "exec/work_stealing_pool.hpp"
+#include "graph/building_graph.hpp"
+#include "routing/exit_field.hpp"
+
+namespace evac {
+
+struct ExchangeStats {
+  std::size_t label_messages = 0;   // regions whose labels changed
+  std::size_t label_bytes = 0;      // per receiver
+  std::size_t fields_rebuilt = 0;
+};
+
+struct DistrictTick {
+  TickStats crowd;                  // summed over regions
+  std::size_t agents_handed_over = 0;
+  std::size_t flow_bytes = 0;
+};
+
+// A partitioned site run in one process: one RegionNode per region, stepped
+// in parallel on a pool, with every message crossing between nodes as the
+// bytes a network transport would carry. A deployment puts each node on its
+// own machine and the mailboxes on the wire; nothing else changes.
+//
+// Hazard updates go to the region owning the arc. exchange() is one round:
+// regions with changed labels broadcast them, every node receives all of them
+// in region order and re-solves, after which routing has converged.
+class District {
+ public:
+  District(const BuildingGraph& model, RegionPartition partition, WorkStealingPool& pool, CrowdParams crowd = {});
+  District(const District&) = delete;
+  District& operator=(const District&) = delete;
+
+  const RegionPartition& partition() const { return partition_; }
+  std::uint32_t regions() const { return partition_.regions; }
+  RegionNode& node(std::uint32_t r) { return *nodes_[r]; }
+
+  void set_edge_hazard(EdgeId e, float hazard);
+  ExchangeStats exchange();
+
+  // Hands each agent to the region of its start node.
+  void add_agents(const AgentPopulation& agents);
+  // Steps every region one tick, then delivers the hand-overs. Agents are
+  // owned by their waypoint region, and a region's population order depends
+  // only on message order, so runs are identical for any pool size.
+  DistrictTick step();
+  std::size_t evacuated() const;
+  std::size_t inside() const;
+
+  // Assembles the site-wide field from the owning regions.
+  void export_field(ExitField& out) const;
+
+ private:
+  const BuildingGraph& model_;
+  RegionPartition partition_;
+  WorkStealingPool& pool_;
+  std::vector<std::unique_ptr<RegionNode>> nodes_;
+  std::vector<std::vector<std::byte>> labels_;               // per sender
+  std::vector<std::vector<std::vector<std::byte>>> outbox_;  // [sender][receiver]
+};
+
+}  // namespace evac
@@ -0,0 +1,93 @@
+#include "district/region_messages.hpp"
+
+#include <bit>
+
+namespace evac {
+
+static_assert(std::endian::native == std::endian::little, "district messages are little-endian");
+
+namespace {
+
+template <class T>
+void append(std::vector<std::byte>& out, const T& value) {
+  const auto* p = reinterpret_cast<const std::byte*>(&value);
+  out.insert(out.end(), p, p + sizeof value);
+}
+
+template <class T>
+void append_array(std::vector<std::byte>& out, std::span<const T> values) {
+  const auto bytes = std::as_bytes(values);
+  out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+RegionHeader make_header(RegionMessageKind kind, std::uint32_t region, std::uint64_t epoch) {
+  RegionHeader h{};
+  h.magic = kRegionMagic;
+  h.format = kRegionFormat;
+  h.kind = static_cast<std::uint16_t>(kind);
+  h.region = region;
+  h.epoch = epoch;
+  return h;
+}
+
+}  // namespace
+
+void encode_labels_message(std::uint32_t region, std::uint64_t epoch, std::span<const Cost> exit,
+                           std::span<const Cost> table, std::span<const Cost> cut, std::vector<std::byte>& out) {
+  RegionHeader h = make_header(RegionMessageKind::Labels, region, epoch);
+  h.entries = static_cast<std::uint32_t>(exit.size());
+  h.cut_arcs = static_cast<std::uint32_t>(cut.size());
+  h.payload_bytes = static_cast<std::uint32_t>((exit.size() + table.size() + cut.size()) * sizeof(Cost));
+  out.reserve(out.size() + sizeof h + h.payload_bytes);
+  append(out, h);
+  append_array(out, exit);
+  append_array(out, table);
+  append_array(out, cut);
+}
+
+void encode_flow_message(std::uint32_t region, std::uint64_t tick, std::span<const FlowAgent> agents,
+                         std::vector<std::byte>& out) {
+  RegionHeader h = make_header(RegionMessageKind::Flow, region, tick);
+  h.entries = static_cast<std::uint32_t>(agents.size());
+  h.payload_bytes = static_cast<std::uint32_t>(agents.size() * sizeof(FlowAgent));
+  out.reserve(out.size() + sizeof h + h.payload_bytes);
+  append(out, h);
+  append_array(out, agents);
+}
+
+const char* to_string(RegionStatus status) {
+  switch (status) {
+    case RegionStatus::Ok: return "ok";
+    case RegionStatus::Incomplete: return "incomplete";
+    case RegionStatus::BadMagic: return "bad magic";
+    case RegionStatus::BadVersion: return "bad version";
+    case RegionStatus::BadSize: return "bad size";
+  }
+  return "?";
+}
+
+RegionStatus RegionMessageView::parse(std::span<const std::byte> in, RegionMessageView& out,
+                                      std::size_t& message_bytes) {
+  if (in.size() < sizeof(RegionHeader)) return RegionStatus::Incomplete;
+  RegionHeader h;
+  std::memcpy(&h, in.data(), sizeof h);
+  if (h.magic != kRegionMagic) return RegionStatus::BadMagic;
+  if (h.format != kRegionFormat) return RegionStatus::BadVersion;
+  std::uint64_t expected = 0;
+  if (h.kind == static_cast<std::uint16_t>(RegionMessageKind::Labels)) {
+    expected = (std::uint64_t{h.entries} * (1 + std::uint64_t{h.entries}) + h.cut_arcs) * sizeof(Cost);
+  } else if (h.kind == static_cast<std::uint16_t>(RegionMessageKind::Flow)) {
+    if (h.cut_arcs != 0) return RegionStatus::BadSize;
+    expected = std::uint64_t{h.entries} * sizeof(FlowAgent);
+  } else {
+    return RegionStatus::BadVersion;
+  }
+  if (h.payload_bytes != expected) return RegionStatus::BadSize;
+  if (in.size() - sizeof h < h.payload_bytes) return RegionStatus::Incomplete;
+  out.header_ = h;
+  out.payload_ = in.data() + sizeof h;
+  message_bytes = sizeof h + h.payload_bytes;
+  return RegionStatus::Ok;
+}
+
+}  // namespace evac
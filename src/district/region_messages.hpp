@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+
+namespace evac {
+
+// Messages between the nodes of a district. Like the guidance feed, each is
+// a fixed header followed by flat little-endian arrays, read in place.
+//
+//   Labels: RegionHeader | Cost exit[b] | Cost table[b * b] | Cost cut[c]
+//   Flow:   RegionHeader | FlowAgent[a]
+//
+// Labels carry a region's distance labels: for each of its b boundary nodes
+// the in-region distance to an exit, the in-region boundary-to-boundary
+// table (row = from) and the cost of each of the c cut arcs it owns, in
+// RegionPartition order. With every region's labels a node can solve the
+// whole site's boundary overlay on its own. Flow hands over agents whose
+// next waypoint lies in the receiving region. Sizes are multiples of 4.
+inline constexpr std::uint32_t kRegionMagic = 0x44525645;  // "EVRD"
+inline constexpr std::uint16_t kRegionFormat = 1;
+
+enum class RegionMessageKind : std::uint16_t { Labels = 1, Flow = 2 };
+
+struct RegionHeader {
+  std::uint32_t magic;
+  std::uint16_t format;         // kRegionFormat
+  std::uint16_t kind;           // RegionMessageKind
+  std::uint32_t region;         // sender
+  std::uint32_t entries;        // Labels: boundary nodes; Flow: agents
+  std::uint32_t cut_arcs;       // Labels only
+  std::uint32_t payload_bytes;  // after the header
+  std::uint64_t epoch;          // Labels: sender's label version; Flow: sender's tick
+};
+static_assert(sizeof(RegionHeader) == 32);
+
+struct FlowAgent {
+  float x;
+  float y;
+  float vx;
+  float vy;
+  float radius;
+  float desired_speed;
+  NodeId goal;
+  std::int16_t floor;
+  std::uint16_t reserved;
+};
+static_assert(sizeof(FlowAgent) == 32);
+
+// Appends one message to `out`; table is row-major, exit.size() squared.
+void encode_labels_message(std::uint32_t region, std::uint64_t epoch, std::span<const Cost> exit,
+                           std::span<const Cost> table, std::span<const Cost> cut, std::vector<std::byte>& out);
+void encode_flow_message(std::uint32_t region, std::uint64_t tick, std::span<const FlowAgent> agents,
+                         std::vector<std::byte>& out);
+
+enum class RegionStatus { Ok, Incomplete, BadMagic, BadVersion, BadSize };
+
+const char* to_string(RegionStatus status);
+
+// One message inside a receive buffer; the accessors read straight from it.
+class RegionMessageView {
+ public:
+  // Ok with `message_bytes` set once `in` starts with a whole message.
+  static RegionStatus parse(std::span<const std::byte> in, RegionMessageView& out, std::size_t& message_bytes);
+
+  const RegionHeader& header() const { return header_; }
+  RegionMessageKind kind() const { return static_cast<RegionMessageKind>(header_.kind); }
+
+  // Labels.
+  Cost exit_cost(std::size_t i) const { return load<Cost>(i * 4); }
+  Cost table(std::size_t from, std::size_t to) const {
+    return load<Cost>((header_.entries + from * header_.entries + to) * 4);
+  }
+  Cost cut_cost(std::size_t i) const {
+    return load<Cost>((header_.entries + std::size_t{header_.entries} * header_.entries + i) * 4);
+  }
+
+  // Flow.
+  FlowAgent agent(std::size_t i) const { return load<FlowAgent>(i * sizeof(FlowAgent)); }
+
+ private:
+  template <class T>
+  T load(std::size_t offset) const {
+    T v;
+    std::memcpy(&v, payload_ + offset, sizeof v);
+    return v;
+  }
+
+  RegionHeader header_{};
+  const std::byte* payload_ = nullptr;
+};
+
+}  // namespace evac
@@ -0,0 +1,342 @@
+#include "district/region_node.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "spatial/cell_grid.hpp"
+#include "telemetry/trace.hpp"
+
+namespace evac {
+
+RegionNode::RegionNode(const BuildingGraph& model, const RegionPartition& partition, std::uint32_t region,
+                       CrowdParams crowd)
+    : graph_(model), part_(partition), region_(region),
+      sim_(graph_, pool_, crowd, grid_layout_for(graph_, partition.region_nodes(region), crowd.cell_size)) {
+  const std::size_t n = graph_.node_count();
+  const std::size_t m = graph_.edge_count();
+  edge_cost_.resize(m);
+  for (EdgeId e = 0; e < m; ++e) edge_cost_[e] = edge_cost(graph_, e);
+
+  table_offset_.assign(part_.regions + 1, 0);
+  for (std::uint32_t r = 0; r < part_.regions; ++r) {
+    const std::size_t p = part_.region_boundary(r).size();
+    table_offset_[r + 1] = table_offset_[r] + p * p;
+  }
+  table_.assign(table_offset_.back(), kInfiniteCost);
+  exit_cost_.assign(part_.boundary.size(), kInfiniteCost);
+  overlay_.assign(part_.boundary.size(), kInfiniteCost);
+  cut_cost_.assign(part_.cut_arcs.size(), kInfiniteCost);
+  for (const EdgeId e : part_.region_cut_arcs(region_)) cut_cost_[part_.cut_index[e]] = edge_cost_[e];
+  label_epoch_.assign(part_.regions, 0);
+  cross_.assign(part_.region_boundary(region_).size(), kInfiniteCost);
+  cross_via_.assign(cross_.size(), kInvalidEdge);
+  dist_.assign(n, kInfiniteCost);
+  next_.assign(n, kInvalidEdge);
+  leaving_.resize(part_.regions);
+  sim_.set_next_edges(next_);
+}
+
+void RegionNode::set_edge_hazard(EdgeId e, float hazard) {
+  graph_.set_edge_hazard(e, hazard);
+  pending_edges_.push_back(e);
+}
+
+void RegionNode::region_search(std::span<const Seed> seeds, bool boundary_only) {
+  for (const NodeId v : part_.region_nodes(region_)) {
+    dist_[v] = kInfiniteCost;
+    next_[v] = kInvalidEdge;
+  }
+  ArenaScope scope(scratch_);
+  using Entry = std::pair<Cost, NodeId>;
+  arena_vector<Entry> queue{ArenaAllocator<Entry>(scratch_)};
+  queue.reserve(part_.region_nodes(region_).size() + seeds.size());
+  const auto push = [&](Cost d, NodeId v) {
+    queue.push_back({d, v});
+    std::push_heap(queue.begin(), queue.end(), std::greater<>());
+  };
+  std::size_t boundary_left = part_.region_boundary(region_).size();
+  for (const Seed& s : seeds) {
+    if (s.dist >= dist_[s.node]) continue;
+    dist_[s.node] = s.dist;
+    next_[s.node] = s.via;
+    push(s.dist, s.node);
+  }
+  while (!queue.empty()) {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+    const auto [d, v] = queue.back();
+    queue.pop_back();
+    if (d != dist_[v]) continue;
+    if (boundary_only && part_.boundary_index[v] != kNoRegionSlot && --boundary_left == 0) break;
+    for (const EdgeId e : graph_.in_edges(v)) {
+      const NodeId u = graph_.edge_source(e);
+      if (!owns(u)) continue;
+      const Cost candidate = saturating_add(d, edge_cost_[e]);
+      if (candidate < dist_[u]) {
+        dist_[u] = candidate;
+        next_[u] = e;
+        push(candidate, u);
+      }
+    }
+  }
+}
+
+// Same cell customisation as OverlayRouter::customise(), over the region.
+void RegionNode::customise() {
+  const std::span<const NodeId> boundary = part_.region_boundary(region_);
+  const std::size_t p = boundary.size();
+  Cost* table = table_.data() + table_offset_[region_];
+  field_valid_ = false;
+  ++counters_.customisations;
+
+  Seed seed{};
+  for (std::size_t j = 0; j < p; ++j) {
+    seed = {boundary[j], 0, kInvalidEdge};
+    region_search({&seed, 1}, true);
+    for (std::size_t i = 0; i < p; ++i) table[i * p + j] = dist_[boundary[i]];
+  }
+
+  ArenaScope scope(scratch_);
+  arena_vector<Seed> exits{ArenaAllocator<Seed>(scratch_)};
+  for (const NodeId x : graph_.exits()) {
+    if (owns(x)) exits.push_back({x, 0, kInvalidEdge});
+  }
+  region_search(exits, true);
+  const std::uint32_t first = part_.boundary_offsets[region_];
+  for (std::size_t i = 0; i < p; ++i) exit_cost_[first + i] = dist_[boundary[i]];
+}
+
+bool RegionNode::publish_labels(std::vector<std::byte>& out) {
+  EVAC_TRACE_SPAN(TraceStage::Route);
+  std::sort(pending_edges_.begin(), pending_edges_.end());
+  pending_edges_.erase(std::unique(pending_edges_.begin(), pending_edges_.end()), pending_edges_.end());
+  bool recustomise = false;
+  for (const EdgeId e : pending_edges_) {
+    const Cost c = edge_cost(graph_, e);
+    if (c == edge_cost_[e]) continue;
+    edge_cost_[e] = c;
+    const std::uint32_t cut = part_.cut_index[e];
+    if (cut != kNoRegionSlot) {
+      cut_cost_[cut] = c;
+      labels_dirty_ = true;
+    } else {
+      recustomise = true;
+    }
+  }
+  pending_edges_.clear();
+
+  if (recustomise) {
+    // An interior change that moves no boundary label still reroutes the
+    // interior, but peers need not hear about it.
+    const std::uint32_t first = part_.boundary_offsets[region_];
+    const std::uint32_t last = part_.boundary_offsets[region_ + 1];
+    const std::vector<Cost> old_table(table_.begin() + table_offset_[region_],
+                                      table_.begin() + table_offset_[region_ + 1]);
+    const std::vector<Cost> old_exit(exit_cost_.begin() + first, exit_cost_.begin() + last);
+    customise();
+    if (!std::equal(old_table.begin(), old_table.end(), table_.begin() + table_offset_[region_]) ||
+        !std::equal(old_exit.begin(), old_exit.end(), exit_cost_.begin() + first)) {
+      labels_dirty_ = true;
+    }
+  } else if (epoch_ == 0) {
+    customise();
+  }
+  if (!labels_dirty_) return false;
+
+  labels_dirty_ = false;
+  overlay_dirty_ = true;
+  label_epoch_[region_] = ++epoch_;
+  const std::uint32_t first = part_.boundary_offsets[region_];
+  const std::uint32_t p = part_.boundary_offsets[region_ + 1] - first;
+  const std::span<const Cost> exit(exit_cost_.data() + first, p);
+  const std::span<const Cost> table(table_.data() + table_offset_[region_], std::size_t{p} * p);
+  const std::span<const Cost> cut(cut_cost_.data() + part_.cut_offsets[region_],
+                                  part_.cut_offsets[region_ + 1] - part_.cut_offsets[region_]);
+  encode_labels_message(region_, epoch_, exit, table, cut, out);
+  return true;
+}
+
+bool RegionNode::apply_labels(const RegionMessageView& message) {
+  const RegionHeader& h = message.header();
+  const std::uint32_t r = h.region;
+  if (r >= part_.regions || r == region_) return false;
+  const std::uint32_t first = part_.boundary_offsets[r];
+  const std::size_t p = part_.boundary_offsets[r + 1] - first;
+  const std::uint32_t cut_first = part_.cut_offsets[r];
+  const std::size_t c = part_.cut_offsets[r + 1] - cut_first;
+  if (h.entries != p || h.cut_arcs != c) return false;
+  ++counters_.labels_received;
+  if (h.epoch <= label_epoch_[r]) return true;  // stale or repeated
+  label_epoch_[r] = h.epoch;
+  Cost* table = table_.data() + table_offset_[r];
+  for (std::size_t i = 0; i < p; ++i) {
+    exit_cost_[first + i] = message.exit_cost(i);
+    for (std::size_t j = 0; j < p; ++j) table[i * p + j] = message.table(i, j);
+  }
+  for (std::size_t i = 0; i < c; ++i) cut_cost_[cut_first + i] = message.cut_cost(i);
+  overlay_dirty_ = true;
+  return true;
+}
+
+void RegionNode::adopt_flow(const RegionMessageView& message) {
+  for (std::size_t i = 0; i < message.header().entries; ++i) {
+    const FlowAgent a = message.agent(i);
+    agents_.add(a.x, a.y, a.floor, a.goal, a.radius, a.desired_speed);
+    agents_.vx.back() = a.vx;
+    agents_.vy.back() = a.vy;
+  }
+  counters_.agents_received += message.header().entries;
+}
+
+RegionStatus RegionNode::receive(std::span<const std::byte> in) {
+  std::size_t pos = 0;
+  while (pos < in.size()) {
+    RegionMessageView message;
+    std::size_t bytes = 0;
+    const RegionStatus status = RegionMessageView::parse(in.subspan(pos), message, bytes);
+    if (status != RegionStatus::Ok) return status;
+    if (message.kind() == RegionMessageKind::Labels) {
+      if (!apply_labels(message)) return RegionStatus::BadSize;
+    } else {
+      for (std::size_t i = 0; i < message.header().entries; ++i) {
+        const NodeId goal = message.agent(i).goal;
+        if (goal >= graph_.node_count() || !owns(goal)) return RegionStatus::BadSize;
+      }
+      adopt_flow(message);
+    }
+    pos += bytes;
+  }
+  return RegionStatus::Ok;
+}
+
+// OverlayRouter::solve_overlay() over every region's boundary nodes; cut
+// arcs take the place of inter-floor arcs.
+void RegionNode::solve_overlay() {
+  const std::size_t k = part_.boundary.size();
+  ArenaScope scope(scratch_);
+  using Entry = std::pair<Cost, std::uint32_t>;
+  arena_vector<Entry> queue{ArenaAllocator<Entry>(scratch_)};
+  queue.reserve(k);
+  const auto push = [&](Cost d, std::uint32_t q) {
+    queue.push_back({d, q});
+    std::push_heap(queue.begin(), queue.end(), std::greater<>());
+  };
+  for (std::uint32_t q = 0; q < k; ++q) {
+    overlay_[q] = exit_cost_[q];
+    if (overlay_[q] != kInfiniteCost) push(overlay_[q], q);
+  }
+  while (!queue.empty()) {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+    const auto [d, q] = queue.back();
+    queue.pop_back();
+    if (d != overlay_[q]) continue;
+    const NodeId v = part_.boundary[q];
+    const std::uint32_t r = part_.region_of[v];
+    const std::uint32_t first = part_.boundary_offsets[r];
+    const std::size_t p = part_.boundary_offsets[r + 1] - first;
+    const Cost* table = table_.data() + table_offset_[r];
+    const std::size_t j = q - first;
+    for (std::size_t i = 0; i < p; ++i) {
+      const Cost candidate = saturating_add(table[i * p + j], d);
+      if (candidate < overlay_[first + i]) {
+        overlay_[first + i] = candidate;
+        push(candidate, static_cast<std::uint32_t>(first + i));
+      }
+    }
+    for (const EdgeId e : graph_.in_edges(v)) {
+      const std::uint32_t cut = part_.cut_index[e];
+      if (cut == kNoRegionSlot) continue;
+      const std::uint32_t u = part_.boundary_index[graph_.edge_source(e)];
+      const Cost candidate = saturating_add(cut_cost_[cut], d);
+      if (candidate < overlay_[u]) {
+        overlay_[u] = candidate;
+        push(candidate, u);
+      }
+    }
+  }
+  ++counters_.overlay_solves;
+}
+
+void RegionNode::rebuild_field() {
+  const std::span<const NodeId> boundary = part_.region_boundary(region_);
+  ArenaScope scope(scratch_);
+  arena_vector<Seed> seeds{ArenaAllocator<Seed>(scratch_)};
+  for (const NodeId x : graph_.exits()) {
+    if (owns(x)) seeds.push_back({x, 0, kInvalidEdge});
+  }
+  for (std::size_t i = 0; i < boundary.size(); ++i) {
+    if (cross_[i] != kInfiniteCost) seeds.push_back({boundary[i], cross_[i], cross_via_[i]});
+  }
+  region_search(seeds, false);
+  field_valid_ = true;
+  ++counters_.field_rebuilds;
+}
+
+bool RegionNode::solve() {
+  EVAC_TRACE_SPAN(TraceStage::Route);
+  if (overlay_dirty_) {
+    solve_overlay();
+    overlay_dirty_ = false;
+    const std::span<const NodeId> boundary = part_.region_boundary(region_);
+    for (std::size_t i = 0; i < boundary.size(); ++i) {
+      Cost best = kInfiniteCost;
+      EdgeId via = kInvalidEdge;
+      for (const EdgeId e : graph_.out_edges(boundary[i])) {
+        const std::uint32_t cut = part_.cut_index[e];
+        if (cut == kNoRegionSlot) continue;
+        const Cost c = saturating_add(cut_cost_[cut], overlay_[part_.boundary_index[graph_.edge_target(e)]]);
+        if (c < best) {
+          best = c;
+          via = e;
+        }
+      }
+      if (best != cross_[i] || via != cross_via_[i]) field_valid_ = false;
+      cross_[i] = best;
+      cross_via_[i] = via;
+    }
+  }
+  if (field_valid_) return false;
+  rebuild_field();
+  return true;
+}
+
+TickStats RegionNode::step(std::span<std::vector<std::byte>> outbox) {
+  TickStats stats = sim_.step(agents_);
+  std::size_t keep = 0;
+  for (std::size_t i = 0; i < agents_.size(); ++i) {
+    if (agents_.evacuated[i]) {
+      ++evacuated_;
+      continue;
+    }
+    const NodeId goal = agents_.goal[i];
+    if (!owns(goal)) {
+      leaving_[part_.region_of[goal]].push_back({agents_.x[i], agents_.y[i], agents_.vx[i], agents_.vy[i],
+                                                 agents_.radius[i], agents_.desired_speed[i], goal,
+                                                 agents_.floor[i], 0});
+      continue;
+    }
+    if (keep != i) {
+      agents_.x[keep] = agents_.x[i];
+      agents_.y[keep] = agents_.y[i];
+      agents_.vx[keep] = agents_.vx[i];
+      agents_.vy[keep] = agents_.vy[i];
+      agents_.radius[keep] = agents_.radius[i];
+      agents_.desired_speed[keep] = agents_.desired_speed[i];
+      agents_.floor[keep] = agents_.floor[i];
+      agents_.goal[keep] = goal;
+      agents_.evacuated[keep] = 0;
+    }
+    ++keep;
+  }
+  agents_.resize(keep);
+  for (std::uint32_t r = 0; r < part_.regions; ++r) {
+    if (leaving_[r].empty()) continue;
+    encode_flow_message(region_, stats.tick, leaving_[r], outbox[r]);
+    counters_.agents_sent += leaving_[r].size();
+    leaving_[r].clear();
+  }
+  stats.active = keep;
+  return stats;
+}
+
+}  // namespace evac
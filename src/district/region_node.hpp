@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "crowd/agents.hpp"
+#include "crowd/crowd_sim.hpp"
+#include "district/region_messages.hpp"
+#include "district/region_partition.hpp"
+#include "exec/work_stealing_pool.hpp"
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+#include "util/arena.hpp"
+
+namespace evac {
+
+struct RegionNodeCounters {
+  std::uint64_t customisations = 0;   // label tables rebuilt
+  std::uint64_t overlay_solves = 0;
+  std::uint64_t field_rebuilds = 0;   // region-local searches after a boundary change
+  std::uint64_t labels_received = 0;
+  std::uint64_t agents_sent = 0;
+  std::uint64_t agents_received = 0;
+};
+
+// One region of a partitioned site: what a single machine runs. It routes
+// only its own nodes and simulates only the agents walking towards them,
+// and it learns about the rest of the site purely from peers' messages.
+//
+// Routing generalises OverlayRouter from floors to regions. A region's
+// labels (its boundary-to-boundary table, its boundary nodes' distances to
+// its own exits and the costs of its outgoing cut arcs) are rebuilt when a
+// hazard lands on one of its arcs and broadcast. Every node keeps the latest
+// labels of every region and solves the boundary overlay itself, then
+// re-derives its own field from its exits and its boundary continuations.
+// Because the overlay is exact given all labels, one exchange round after a
+// hazard update leaves every region's distances equal to a site-wide
+// solve_exit_field(); there is no iteration between neighbours.
+//
+// Agents belong to the region of their current waypoint. After each tick the
+// ones whose next waypoint lies elsewhere are handed over in Flow messages.
+// Repulsion between agents on opposite sides of a region border is not
+// modelled; the seams fall on stair flights, where few agents meet.
+//
+// Not thread-safe; a district steps its nodes in parallel, each on one thread.
+class RegionNode {
+ public:
+  RegionNode(const BuildingGraph& model, const RegionPartition& partition, std::uint32_t region,
+             CrowdParams crowd = {});
+  RegionNode(const RegionNode&) = delete;
+  RegionNode& operator=(const RegionNode&) = delete;
+
+  std::uint32_t region() const { return region_; }
+  const BuildingGraph& graph() const { return graph_; }
+  const RegionNodeCounters& counters() const { return counters_; }
+
+  // Hazard on an arc this region owns (its source lies in the region).
+  void set_edge_hazard(EdgeId e, float hazard);
+  // Applies pending hazards. When they changed the region's labels (and on
+  // the first call), re-customises, appends a Labels message and returns true.
+  bool publish_labels(std::vector<std::byte>& out);
+  // Applies every whole message in `in`: peers' labels and agents handed
+  // over. A message that does not fit the partition is BadSize.
+  RegionStatus receive(std::span<const std::byte> in);
+  // Re-solves the overlay from the labels held and rebuilds the region's
+  // field if a boundary continuation moved. Returns whether the field changed.
+  bool solve();
+
+  // Valid for nodes of this region.
+  Cost distance(NodeId v) const { return dist_[v]; }
+  EdgeId next_edge(NodeId v) const { return next_[v]; }
+
+  AgentPopulation& agents() { return agents_; }
+  const AgentPopulation& agents() const { return agents_; }
+  std::size_t evacuated() const { return evacuated_; }
+  // One crowd tick, then hands agents bound for other regions to outbox[r]
+  // as Flow messages. Evacuated agents are counted and dropped.
+  TickStats step(std::span<std::vector<std::byte>> outbox);
+
+ private:
+  struct Seed {
+    NodeId node;
+    Cost dist;
+    EdgeId via;
+  };
+
+  bool owns(NodeId v) const { return part_.region_of[v] == region_; }
+  bool apply_labels(const RegionMessageView& message);
+  void adopt_flow(const RegionMessageView& message);
+  void region_search(std::span<const Seed> seeds, bool boundary_only);
+  void customise();
+  void solve_overlay();
+  void rebuild_field();
+
+  BuildingGraph graph_;
+  const RegionPartition& part_;
+  std::uint32_t region_;
+  RegionNodeCounters counters_;
+  std::vector<Cost> edge_cost_;
+  std::vector<EdgeId> pending_edges_;
+  bool labels_dirty_ = true;
+  std::uint64_t epoch_ = 0;
+
+  // Labels of every region; table_offset_[r] locates region r's table.
+  std::vector<std::size_t> table_offset_;
+  std::vector<Cost> table_;
+  std::vector<Cost> exit_cost_;       // per boundary node
+  std::vector<Cost> cut_cost_;        // per cut arc
+  std::vector<std::uint64_t> label_epoch_;
+  bool overlay_dirty_ = true;
+  std::vector<Cost> overlay_;         // per boundary node, site-wide exit distance
+  std::vector<Cost> cross_;           // per own boundary node, best continuation over a cut arc
+  std::vector<EdgeId> cross_via_;
+  bool field_valid_ = false;
+
+  std::vector<Cost> dist_;            // per node; current for the region's nodes
+  std::vector<EdgeId> next_;
+  Arena scratch_;
+
+  WorkStealingPool pool_{1};
+  CrowdSimulator sim_;
+  AgentPopulation agents_;
+  std::size_t evacuated_ = 0;
+  std::vector<std::vector<FlowAgent>> leaving_;  // per destination region
+};
+
+}  // namespace evac
@@ -0,0 +1,349 @@
+#include "district/region_partition.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "util/rng.hpp"
+
+namespace evac {
+namespace {
+
+constexpr std::uint32_t kNone = 0xffffffffu;
+
+// Undirected weighted graph in CSR form; parallel arcs are merged and their
+// weights summed, so a twin pair weighs twice its kind.
+struct WeightedGraph {
+  std::vector<std::uint32_t> offsets{0};
+  std::vector<std::uint32_t> adj;
+  std::vector<std::uint32_t> weight;
+  std::vector<std::uint32_t> vertex_weight;
+  std::uint64_t total_weight = 0;
+
+  std::size_t size() const { return vertex_weight.size(); }
+};
+
+// Appends rows one at a time, merging repeated neighbours through a slot map.
+class RowBuilder {
+ public:
+  RowBuilder(WeightedGraph& out, std::size_t n) : out_(out), slot_(n, kNone) {}
+
+  void add(std::uint32_t self, std::uint32_t v, std::uint32_t w) {
+    if (v == self) return;
+    if (slot_[v] == kNone) {
+      slot_[v] = static_cast<std::uint32_t>(out_.adj.size());
+      out_.adj.push_back(v);
+      out_.weight.push_back(w);
+    } else {
+      out_.weight[slot_[v]] += w;
+    }
+  }
+
+  void finish_row(std::uint32_t vertex_weight) {
+    for (std::size_t i = out_.offsets.back(); i < out_.adj.size(); ++i) slot_[out_.adj[i]] = kNone;
+    out_.offsets.push_back(static_cast<std::uint32_t>(out_.adj.size()));
+    out_.vertex_weight.push_back(vertex_weight);
+    out_.total_weight += vertex_weight;
+  }
+
+ private:
+  WeightedGraph& out_;
+  std::vector<std::uint32_t> slot_;
+};
+
+WeightedGraph from_building(const BuildingGraph& g) {
+  WeightedGraph out;
+  const std::size_t n = g.node_count();
+  out.offsets.reserve(n + 1);
+  out.adj.reserve(2 * g.edge_count());
+  out.weight.reserve(2 * g.edge_count());
+  RowBuilder rows(out, n);
+  for (NodeId u = 0; u < n; ++u) {
+    for (const EdgeId e : g.out_edges(u)) rows.add(u, g.edge_target(e), cut_weight(g.edge_kind(e)));
+    for (const EdgeId e : g.in_edges(u)) rows.add(u, g.edge_source(e), cut_weight(g.edge_kind(e)));
+    rows.finish_row(1);
+  }
+  return out;
+}
+
+// Heavy-edge matching in a seeded random order: each unmatched vertex pairs
+// with the unmatched neighbour it shares the heaviest edge with, unless the
+// pair would outweigh `max_vertex_weight`. cmap receives the coarse id of
+// every fine vertex.
+WeightedGraph coarsen(const WeightedGraph& fine, SplitMix64& rng, std::uint32_t max_vertex_weight,
+                      std::vector<std::uint32_t>& cmap) {
+  const std::size_t n = fine.size();
+  std::vector<std::uint32_t> order(n);
+  for (std::uint32_t v = 0; v < n; ++v) order[v] = v;
+  for (std::size_t i = n; i > 1; --i) std::swap(order[i - 1], order[rng.below(static_cast<std::uint32_t>(i))]);
+
+  std::vector<std::uint32_t> match(n, kNone);
+  for (const std::uint32_t u : order) {
+    if (match[u] != kNone) continue;
+    std::uint32_t best = u;
+    std::uint32_t best_weight = 0;
+    for (std::uint32_t i = fine.offsets[u]; i < fine.offsets[u + 1]; ++i) {
+      const std::uint32_t v = fine.adj[i];
+      if (match[v] != kNone || fine.vertex_weight[u] + fine.vertex_weight[v] > max_vertex_weight) continue;
+      if (fine.weight[i] > best_weight) {
+        best = v;
+        best_weight = fine.weight[i];
+      }
+    }
+    match[u] = best;
+    match[best] = u;
+  }
+
+  cmap.assign(n, kNone);
+  std::vector<std::uint32_t> members;  // two per coarse vertex, repeated for singletons
+  members.reserve(2 * n);
+  for (std::uint32_t u = 0; u < n; ++u) {
+    if (cmap[u] != kNone) continue;
+    cmap[u] = cmap[match[u]] = static_cast<std::uint32_t>(members.size() / 2);
+    members.push_back(u);
+    members.push_back(match[u]);
+  }
+
+  WeightedGraph coarse;
+  const std::size_t cn = members.size() / 2;
+  coarse.offsets.reserve(cn + 1);
+  RowBuilder rows(coarse, cn);
+  for (std::uint32_t c = 0; c < cn; ++c) {
+    const std::uint32_t a = members[2 * c];
+    const std::uint32_t b = members[2 * c + 1];
+    for (const std::uint32_t u : {a, b}) {
+      for (std::uint32_t i = fine.offsets[u]; i < fine.offsets[u + 1]; ++i) {
+        rows.add(c, cmap[fine.adj[i]], fine.weight[i]);
+      }
+      if (a == b) break;
+    }
+    rows.finish_row(fine.vertex_weight[a] + (a == b ? 0 : fine.vertex_weight[b]));
+  }
+  return coarse;
+}
+
+// Unassigned vertex farthest (in hops, among unassigned vertices) from the
+// lowest unassigned one: growing from the rim of what is left keeps the
+// remainder in one piece.
+std::uint32_t peripheral_seed(const WeightedGraph& g, const std::vector<std::uint32_t>& part) {
+  std::uint32_t start = kNone;
+  for (std::uint32_t v = 0; v < g.size() && start == kNone; ++v) {
+    if (part[v] == kNone) start = v;
+  }
+  if (start == kNone) return kNone;
+  std::vector<std::uint8_t> seen(g.size(), 0);
+  std::queue<std::uint32_t> frontier;
+  frontier.push(start);
+  seen[start] = 1;
+  std::uint32_t last = start;
+  while (!frontier.empty()) {
+    last = frontier.front();
+    frontier.pop();
+    for (std::uint32_t i = g.offsets[last]; i < g.offsets[last + 1]; ++i) {
+      const std::uint32_t v = g.adj[i];
+      if (seen[v] || part[v] != kNone) continue;
+      seen[v] = 1;
+      frontier.push(v);
+    }
+  }
+  return last;
+}
+
+// Greedy graph growing: regions are grown one after another from a
+// peripheral seed, always absorbing the frontier vertex most strongly tied to
+// the region, until each holds its share; the last region takes the rest.
+std::vector<std::uint32_t> grow_regions(const WeightedGraph& g, std::uint32_t k) {
+  std::vector<std::uint32_t> part(g.size(), kNone);
+  std::vector<std::uint64_t> tie(g.size(), 0);
+  const std::uint64_t target = g.total_weight / k;
+  using Entry = std::pair<std::uint64_t, std::uint32_t>;
+  for (std::uint32_t r = 0; r + 1 < k; ++r) {
+    std::priority_queue<Entry> frontier;
+    std::fill(tie.begin(), tie.end(), 0);
+    std::uint64_t weight = 0;
+    while (weight < target) {
+      if (frontier.empty()) {
+        const std::uint32_t seed = peripheral_seed(g, part);
+        if (seed == kNone) break;
+        frontier.push({0, seed});
+      }
+      const auto [t, v] = frontier.top();
+      frontier.pop();
+      if (part[v] != kNone || t != tie[v]) continue;
+      part[v] = r;
+      weight += g.vertex_weight[v];
+      for (std::uint32_t i = g.offsets[v]; i < g.offsets[v + 1]; ++i) {
+        const std::uint32_t u = g.adj[i];
+        if (part[u] != kNone) continue;
+        tie[u] += g.weight[i];
+        frontier.push({tie[u], u});
+      }
+    }
+  }
+  for (std::uint32_t& p : part) {
+    if (p == kNone) p = k - 1;
+  }
+  return part;
+}
+
+// Greedy boundary refinement. A vertex moves to the neighbouring region with
+// the largest gain (edge weight it would stop cutting), provided the target
+// stays within max_weight; zero-gain moves are taken only towards a lighter
+// region, and an overweight region sheds vertices even at a loss.
+void refine(const WeightedGraph& g, std::vector<std::uint32_t>& part, std::uint32_t k, std::uint64_t max_weight,
+            std::uint32_t passes) {
+  std::vector<std::uint64_t> region_weight(k, 0);
+  for (std::uint32_t v = 0; v < g.size(); ++v) region_weight[part[v]] += g.vertex_weight[v];
+  std::vector<std::pair<std::uint32_t, std::int64_t>> ties;
+  for (std::uint32_t pass = 0; pass < passes; ++pass) {
+    std::size_t moved = 0;
+    for (std::uint32_t v = 0; v < g.size(); ++v) {
+      const std::uint32_t a = part[v];
+      std::int64_t internal = 0;
+      ties.clear();
+      for (std::uint32_t i = g.offsets[v]; i < g.offsets[v + 1]; ++i) {
+        const std::uint32_t b = part[g.adj[i]];
+        if (b == a) {
+          internal += g.weight[i];
+          continue;
+        }
+        auto it = std::find_if(ties.begin(), ties.end(), [b](const auto& t) { return t.first == b; });
+        if (it == ties.end()) {
+          ties.push_back({b, g.weight[i]});
+        } else {
+          it->second += g.weight[i];
+        }
+      }
+      const std::uint64_t w = g.vertex_weight[v];
+      if (ties.empty() || region_weight[a] == w) continue;
+      const bool overweight = region_weight[a] > max_weight;
+      std::uint32_t best = kNone;
+      std::int64_t best_gain = 0;
+      for (const auto& [b, t] : ties) {
+        if (region_weight[b] + w > max_weight) continue;
+        const std::int64_t gain = t - internal;
+        const bool lighter = region_weight[b] + w < region_weight[a];
+        if (gain < 0 && !overweight) continue;
+        if (gain == 0 && !lighter && !overweight) continue;
+        if (best == kNone || gain > best_gain || (gain == best_gain && region_weight[b] < region_weight[best])) {
+          best = b;
+          best_gain = gain;
+        }
+      }
+      if (best == kNone) continue;
+      part[v] = best;
+      region_weight[a] -= w;
+      region_weight[best] += w;
+      ++moved;
+    }
+    if (moved == 0) break;
+  }
+}
+
+}  // namespace
+
+std::uint32_t cut_weight(EdgeKind kind) {
+  switch (kind) {
+    case EdgeKind::Stairs:
+    case EdgeKind::Elevator: return 1;
+    case EdgeKind::Ramp:
+    case EdgeKind::Door: return 4;
+    case EdgeKind::Corridor: break;
+  }
+  return 8;
+}
+
+RegionPartition partition_building(const BuildingGraph& g, const PartitionParams& params) {
+  const std::size_t n = g.node_count();
+  const auto k = static_cast<std::uint32_t>(std::clamp<std::size_t>(params.regions, 1, std::max<std::size_t>(1, n)));
+  if (k == 1 || n == 0) return make_region_partition(g, std::vector<std::uint32_t>(n, 0), k);
+
+  std::vector<WeightedGraph> levels;
+  std::vector<std::vector<std::uint32_t>> maps;
+  levels.push_back(from_building(g));
+  SplitMix64 rng(params.seed);
+  const std::uint64_t share = (levels[0].total_weight + k - 1) / k;
+  const std::uint32_t per_region = std::max<std::uint32_t>(params.coarsen_to, 1);
+  const std::size_t floor_size = std::size_t{k} * per_region;
+  // A coarse vertex may carry 1.5x the mean weight at the coarsest level.
+  const auto max_vertex_weight = static_cast<std::uint32_t>(std::max<std::uint64_t>(2, share * 3 / (2 * per_region)));
+  while (levels.back().size() > floor_size) {
+    std::vector<std::uint32_t> cmap;
+    WeightedGraph coarse = coarsen(levels.back(), rng, max_vertex_weight, cmap);
+    if (coarse.size() * 20 > levels.back().size() * 19) break;  // matching has stalled
+    maps.push_back(std::move(cmap));
+    levels.push_back(std::move(coarse));
+  }
+
+  const auto limit = static_cast<std::uint64_t>(std::ceil((1.0 + params.imbalance) * static_cast<double>(share)));
+  std::vector<std::uint32_t> part = grow_regions(levels.back(), k);
+  for (std::size_t level = levels.size(); level-- > 0;) {
+    if (level + 1 < levels.size()) {
+      std::vector<std::uint32_t> finer(levels[level].size());
+      for (std::size_t v = 0; v < finer.size(); ++v) finer[v] = part[maps[level][v]];
+      part = std::move(finer);
+    }
+    // Coarse vertices are lumpy, so the limit only tightens to its final value at the finest level.
+    const std::uint64_t slack = level == 0 ? 0 : max_vertex_weight;
+    refine(levels[level], part, k, limit + slack, params.refine_passes);
+  }
+  return make_region_partition(g, std::move(part), k);
+}
+
+RegionPartition make_region_partition(const BuildingGraph& g, std::vector<std::uint32_t> region_of,
+                                      std::uint32_t regions) {
+  const std::size_t n = g.node_count();
+  const std::size_t m = g.edge_count();
+  if (region_of.size() != n) throw std::invalid_argument("region partition: one region per node expected");
+  for (const std::uint32_t r : region_of) {
+    if (r >= regions) throw std::invalid_argument("region partition: region " + std::to_string(r) + " out of range");
+  }
+
+  RegionPartition p;
+  p.regions = regions;
+  p.region_of = std::move(region_of);
+  p.node_offsets.assign(regions + 1, 0);
+  for (NodeId v = 0; v < n; ++v) ++p.node_offsets[p.region_of[v] + 1];
+  for (std::uint32_t r = 0; r < regions; ++r) p.node_offsets[r + 1] += p.node_offsets[r];
+  p.nodes.resize(n);
+  std::vector<std::uint32_t> slot(p.node_offsets.begin(), p.node_offsets.end() - 1);
+  for (NodeId v = 0; v < n; ++v) p.nodes[slot[p.region_of[v]]++] = v;
+
+  std::vector<std::uint8_t> on_boundary(n, 0);
+  p.cut_index.assign(m, kNoRegionSlot);
+  p.cut_offsets.assign(regions + 1, 0);
+  for (EdgeId e = 0; e < m; ++e) {
+    const NodeId u = g.edge_source(e);
+    const NodeId v = g.edge_target(e);
+    if (p.region_of[u] == p.region_of[v]) continue;
+    on_boundary[u] = on_boundary[v] = 1;
+    ++p.cut_offsets[p.region_of[u] + 1];
+    p.cut_weight += cut_weight(g.edge_kind(e));
+  }
+  for (std::uint32_t r = 0; r < regions; ++r) p.cut_offsets[r + 1] += p.cut_offsets[r];
+  p.cut_arcs.resize(p.cut_offsets[regions]);
+  slot.assign(p.cut_offsets.begin(), p.cut_offsets.end() - 1);
+  for (EdgeId e = 0; e < m; ++e) {
+    const std::uint32_t r = p.region_of[g.edge_source(e)];
+    if (r == p.region_of[g.edge_target(e)]) continue;
+    p.cut_index[e] = slot[r];
+    p.cut_arcs[slot[r]++] = e;
+  }
+
+  p.boundary_index.assign(n, kNoRegionSlot);
+  p.boundary_offsets.assign(regions + 1, 0);
+  for (std::uint32_t r = 0; r < regions; ++r) {
+    for (const NodeId v : p.region_nodes(r)) {
+      if (!on_boundary[v]) continue;
+      p.boundary_index[v] = static_cast<std::uint32_t>(p.boundary.size());
+      p.boundary.push_back(v);
+    }
+    p.boundary_offsets[r + 1] = static_cast<std::uint32_t>(p.boundary.size());
+  }
+  return p;
+}
+
+}  // namespace evac
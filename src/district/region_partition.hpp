@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+
+namespace evac {
+
+struct PartitionParams {
+  std::uint32_t regions = 4;
+  float imbalance = 0.05f;           // a region may hold (1 + imbalance) * nodes / regions
+  std::uint32_t coarsen_to = 40;     // coarsening stops below regions * coarsen_to vertices
+  std::uint32_t refine_passes = 8;   // per level
+  std::uint64_t seed = 1;            // matching order; same seed, same partition
+};
+
+// Price of separating the two ends of an arc. Stair and elevator flights are
+// the seams between floors and between the towers of a site, and only a
+// handful of people cross each per tick, so they are cheap to cut; a corridor
+// spine is not.
+std::uint32_t cut_weight(EdgeKind kind);
+
+inline constexpr std::uint32_t kNoRegionSlot = 0xffffffffu;
+
+// Assignment of every node to one of `regions` regions, with the indexes the
+// district runtime needs. Boundary nodes are the ends of cut arcs; a cut arc
+// belongs to the region of its source, which owns its hazard and its cost.
+struct RegionPartition {
+  std::uint32_t regions = 0;
+  std::vector<std::uint32_t> region_of;         // per node
+
+  std::vector<std::uint32_t> node_offsets;      // regions + 1
+  std::vector<NodeId> nodes;                    // grouped by region, ascending within
+  std::vector<std::uint32_t> boundary_offsets;  // regions + 1
+  std::vector<NodeId> boundary;                 // grouped by region, ascending within
+  std::vector<std::uint32_t> boundary_index;    // per node, slot in `boundary` or kNoRegionSlot
+  std::vector<std::uint32_t> cut_offsets;       // regions + 1, grouped by source region
+  std::vector<EdgeId> cut_arcs;
+  std::vector<std::uint32_t> cut_index;         // per arc, slot in `cut_arcs` or kNoRegionSlot
+  std::uint64_t cut_weight = 0;                 // summed over cut arcs
+
+  std::span<const NodeId> region_nodes(std::uint32_t r) const {
+    return {nodes.data() + node_offsets[r], node_offsets[r + 1] - node_offsets[r]};
+  }
+  std::span<const NodeId> region_boundary(std::uint32_t r) const {
+    return {boundary.data() + boundary_offsets[r], boundary_offsets[r + 1] - boundary_offsets[r]};
+  }
+  std::span<const EdgeId> region_cut_arcs(std::uint32_t r) const {
+    return {cut_arcs.data() + cut_offsets[r], cut_offsets[r + 1] - cut_offsets[r]};
+  }
+};
+
+// Balanced k-way partition minimising cut_weight(), in the multilevel style
+// of METIS: heavy-edge matching coarsens the graph to a few dozen vertices
+// per region, greedy graph growing partitions the coarsest graph, and each
+// level on the way back is refined by moving boundary vertices to the
+// neighbouring region they are most connected to, within the balance limit.
+// Regions need not be connected.
+RegionPartition partition_building(const BuildingGraph& g, const PartitionParams& params);
+
+// Builds the indexes for a given assignment, e.g. one region per building of
+// a site. Throws std::invalid_argument if region_of does not fit g.
+RegionPartition make_region_partition(const BuildingGraph& g, std::vector<std::uint32_t> region_of,
+                                      std::uint32_t regions);
+
+}  // namespace evac
@@ -0,0 +1,111 @@
+#include "eventlog/block_codec.hpp"
+
+#include <cstring>
+
+namespace evac {
+namespace {
+
+constexpr std::size_t kMinMatch = 4;
+constexpr std::size_t kMaxOffset = 65535;
+constexpr unsigned kHashBits = 12;
+
+std::uint32_t read32(const std::uint8_t* p) {
+  std::uint32_t v;
+  std::memcpy(&v, p, sizeof v);
+  return v;
+}
+
+std::uint32_t hash4(std::uint32_t v) { return (v * 2654435761u) >> (32 - kHashBits); }
+
+void put_length(std::size_t len, std::vector<std::uint8_t>& out) {
+  for (; len >= 255; len -= 255) out.push_back(255);
+  out.push_back(static_cast<std::uint8_t>(len));
+}
+
+void emit(const std::uint8_t* literals, std::size_t literal_len, std::size_t offset, std::size_t match_len,
+          std::vector<std::uint8_t>& out) {
+  const std::size_t ml = match_len == 0 ? 0 : match_len - kMinMatch;
+  out.push_back(static_cast<std::uint8_t>((literal_len < 15 ? literal_len : 15) << 4 | (ml < 15 ? ml : 15)));
+  if (literal_len >= 15) put_length(literal_len - 15, out);
+  out.insert(out.end(), literals, literals + literal_len);
+  if (match_len == 0) return;
+  out.push_back(static_cast<std::uint8_t>(offset));
+  out.push_back(static_cast<std::uint8_t>(offset >> 8));
+  if (ml >= 15) put_length(ml - 15, out);
+}
+
+bool get_length(const std::uint8_t*& p, const std::uint8_t* end, std::size_t& len) {
+  for (;;) {
+    if (p == end) return false;
+    const std::uint8_t b = *p++;
+    len += b;
+    if (b != 255) return true;
+  }
+}
+
+}  // namespace
+
+void lz_compress(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out) {
+  const std::uint8_t* base = in.data();
+  const std::size_t n = in.size();
+  std::uint32_t table[1u << kHashBits] = {};  // position + 1, 0 = empty
+  std::size_t anchor = 0;
+  std::size_t i = 0;
+  while (i + kMinMatch <= n) {
+    const std::uint32_t v = read32(base + i);
+    std::uint32_t& slot = table[hash4(v)];
+    const std::size_t candidate = slot;
+    slot = static_cast<std::uint32_t>(i + 1);
+    if (candidate == 0 || i - (candidate - 1) > kMaxOffset || read32(base + candidate - 1) != v) {
+      ++i;
+      continue;
+    }
+    const std::size_t from = candidate - 1;
+    std::size_t len = kMinMatch;
+    while (i + len < n && base[from + len] == base[i + len]) ++len;
+    emit(base + anchor, i - anchor, i - from, len, out);
+    i += len;
+    anchor = i;
+  }
+  emit(base + anchor, n - anchor, 0, 0, out);
+}
+
+namespace {
+
+bool decode(std::span<const std::uint8_t> in, std::size_t raw_size, std::uint8_t* dst) {
+  std::size_t written = 0;
+  const std::uint8_t* p = in.data();
+  const std::uint8_t* end = p + in.size();
+  while (p != end) {
+    const std::uint8_t token = *p++;
+    std::size_t literal_len = token >> 4;
+    if (literal_len == 15 && !get_length(p, end, literal_len)) return false;
+    if (literal_len > static_cast<std::size_t>(end - p) || literal_len > raw_size - written) return false;
+    std::memcpy(dst + written, p, literal_len);
+    p += literal_len;
+    written += literal_len;
+    if (p == end) break;  // last sequence
+    if (end - p < 2) return false;
+    const std::size_t offset = p[0] | std::size_t{p[1]} << 8;
+    p += 2;
+    std::size_t match_len = token & 15;
+    if (match_len == 15 && !get_length(p, end, match_len)) return false;
+    match_len += kMinMatch;
+    if (offset == 0 || offset > written || match_len > raw_size - written) return false;
+    // Byte by byte: the match may overlap its own output.
+    for (std::size_t k = 0; k < match_len; ++k, ++written) dst[written] = dst[written - offset];
+  }
+  return written == raw_size;
+}
+
+}  // namespace
+
+bool lz_decompress(std::span<const std::uint8_t> in, std::size_t raw_size, std::vector<std::uint8_t>& out) {
+  const std::size_t start = out.size();
+  out.resize(start + raw_size);
+  if (decode(in, raw_size, out.data() + start)) return true;
+  out.resize(start);
+  return false;
+}
+
+}  // namespace evac
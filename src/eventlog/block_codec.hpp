@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace evac {
+
+// Byte-oriented LZ77 block codec in the LZ4 mould (greedy hash-chain-free
+// matching, 64 KiB window, no entropy stage): fast enough for a background
+// log thread on an embedded controller, and log blocks are repetitive
+// enough (the same sensor ids, kinds and close readings over and over) for it
+// to pay off. No external dependency.
+//
+// A block is a series of sequences: token (literal length << 4 | match
+// length - 4, 15 = continued in 255-byte steps), literals, little-endian u16
+// offset, match continuation. The last sequence has literals only.
+
+// Appends the compressed form of `in` to `out`.
+void lz_compress(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out);
+// Decodes `in` into exactly `raw_size` bytes appended to `out`; false if the
+// input is malformed or does not produce raw_size bytes (out is then unchanged).
+bool lz_decompress(std::span<const std::uint8_t> in, std::size_t raw_size, std::vector<std::uint8_t>& out);
+
+}  // namespace evac
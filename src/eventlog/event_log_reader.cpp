@@ -0,0 +1,72 @@
+#include "eventlog/event_log_reader.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "eventlog/block_codec.hpp"
+#include "model/model_format.hpp"
+
+namespace evac {
+
+EventLogReader::EventLogReader(const std::string& path) : path_(path) {
+  file_ = std::fopen(path.c_str(), "rb");
+  if (!file_) throw std::runtime_error(path + ": cannot open");
+  LogFileHeader header{};
+  if (std::fread(&header, sizeof header, 1, file_) != 1 ||
+      std::memcmp(header.magic, kLogMagic, sizeof header.magic) != 0) {
+    std::fclose(file_);
+    throw std::runtime_error(path + ": not an event log");
+  }
+  if (header.version != kLogVersion || header.endian_tag != kLogEndianTag) {
+    std::fclose(file_);
+    throw std::runtime_error(path + ": unsupported event log version or byte order");
+  }
+}
+
+EventLogReader::~EventLogReader() { std::fclose(file_); }
+
+bool EventLogReader::load_block() {
+  LogBlockHeader header{};
+  const std::size_t got = std::fread(&header, 1, sizeof header, file_);
+  if (got == 0) return false;  // clean end
+  if (got != sizeof header || header.magic != kLogBlockMagic) {
+    truncated_ = true;
+    return false;
+  }
+  stored_.resize(header.stored_size);
+  if (std::fread(stored_.data(), 1, stored_.size(), file_) != stored_.size() ||
+      fnv1a(stored_.data(), stored_.size()) != header.checksum) {
+    truncated_ = true;
+    return false;
+  }
+  raw_.clear();
+  if (header.flags & kLogBlockCompressed) {
+    if (!lz_decompress(stored_, header.raw_size, raw_)) {
+      truncated_ = true;
+      return false;
+    }
+  } else {
+    raw_.swap(stored_);
+  }
+  pos_ = 0;
+  remaining_ = header.record_count;
+  previous_us_ = header.first_timestamp_us;
+  ++blocks_;
+  return true;
+}
+
+bool EventLogReader::next(LogRecord& out) {
+  while (remaining_ == 0) {
+    if (truncated_ || !load_block()) return false;
+  }
+  if (!decode_log_record(raw_, pos_, previous_us_, out)) {
+    truncated_ = true;
+    remaining_ = 0;
+    return false;
+  }
+  previous_us_ = out.timestamp_us;
+  --remaining_;
+  return true;
+}
+
+}  // namespace evac
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "eventlog/log_format.hpp"
+
+namespace evac {
+
+// Sequential reader for logs written by EventLogWriter. Throws
+// std::runtime_error ("path: what") when the file is missing or its header is
+// not an event log. A torn or corrupt block ends the stream early and sets
+// truncated(); every block before it is still delivered.
+class EventLogReader {
+ public:
+  explicit EventLogReader(const std::string& path);
+  ~EventLogReader();
+  EventLogReader(const EventLogReader&) = delete;
+  EventLogReader& operator=(const EventLogReader&) = delete;
+
+  bool next(LogRecord& out);
+
+  bool truncated() const { return truncated_; }
+  std::uint64_t blocks_read() const { return blocks_; }
+
+ private:
+  bool load_block();
+
+  std::string path_;
+  std::FILE* file_ = nullptr;
+  std::vector<std::uint8_t> stored_;
+  std::vector<std::uint8_t> raw_;
+  std::size_t pos_ = 0;
+  std::uint32_t remaining_ = 0;
+  std::uint64_t previous_us_ = 0;
+  std::uint64_t blocks_ = 0;
+  bool truncated_ = false;
+};
+
+}  // namespace evac
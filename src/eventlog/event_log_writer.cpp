@@ -0,0 +1,192 @@
+#include "eventlog/event_log_writer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "eventlog/block_codec.hpp"
+#include "model/model_format.hpp"
+#include "telemetry/trace.hpp"
+
+namespace evac {
+namespace {
+
+bool write_all(int fd, const std::uint8_t* data, std::size_t bytes) {
+  while (bytes != 0) {
+    const ssize_t n = ::write(fd, data, bytes);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    bytes -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+template <class T>
+void append_bytes(std::vector<std::uint8_t>& out, const T& value) {
+  const auto* p = reinterpret_cast<const std::uint8_t*>(&value);
+  out.insert(out.end(), p, p + sizeof value);
+}
+
+}  // namespace
+
+EventLogWriter::EventLogWriter(const std::string& path, EventLogOptions options)
+    : options_(options), ring_(std::make_unique<MpscRing<LogRecord>>(options.ring_capacity)) {
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) throw std::runtime_error(path + ": " + std::strerror(errno));
+  LogFileHeader header{};
+  std::memcpy(header.magic, kLogMagic, sizeof header.magic);
+  header.version = kLogVersion;
+  header.endian_tag = kLogEndianTag;
+  if (!write_all(fd_, reinterpret_cast<const std::uint8_t*>(&header), sizeof header)) {
+    const std::string what = std::strerror(errno);
+    ::close(fd_);
+    throw std::runtime_error(path + ": " + what);
+  }
+  file_bytes_.store(sizeof header, std::memory_order_relaxed);
+  raw_.reserve(options_.block_bytes + 64);
+  thread_ = std::thread([this] { run(); });
+}
+
+EventLogWriter::~EventLogWriter() {
+  flush();
+  {
+    std::lock_guard lock(mutex_);
+    stopping_.store(true, std::memory_order_release);
+  }
+  wake_cv_.notify_one();
+  thread_.join();
+  ::close(fd_);
+}
+
+void EventLogWriter::append(const LogRecord& record) {
+  while (!ring_->try_push(record)) {
+    if (failed()) return;
+    spins_.fetch_add(1, std::memory_order_relaxed);
+    std::this_thread::yield();
+  }
+  appended_.fetch_add(1, std::memory_order_release);
+}
+
+void EventLogWriter::flush() {
+  const std::uint64_t target = appended_.load(std::memory_order_acquire);
+  std::unique_lock lock(mutex_);
+  flush_requested_ = true;
+  wake_cv_.notify_one();
+  committed_cv_.wait(lock, [&] { return failed() || committed_.load(std::memory_order_acquire) >= target; });
+}
+
+EventLogCounters EventLogWriter::counters() const {
+  EventLogCounters c;
+  c.records = committed_.load(std::memory_order_relaxed);
+  c.blocks = blocks_.load(std::memory_order_relaxed);
+  c.commits = commits_.load(std::memory_order_relaxed);
+  c.raw_bytes = raw_bytes_.load(std::memory_order_relaxed);
+  c.file_bytes = file_bytes_.load(std::memory_order_relaxed);
+  c.backpressure_spins = spins_.load(std::memory_order_relaxed);
+  return c;
+}
+
+void EventLogWriter::seal_block() {
+  if (block_records_ == 0) return;
+  const std::size_t at = group_.size();
+  group_.resize(at + sizeof(LogBlockHeader));
+  lz_compress(raw_, group_);
+  LogBlockHeader header{};
+  header.magic = kLogBlockMagic;
+  header.flags = kLogBlockCompressed;
+  header.stored_size = static_cast<std::uint32_t>(group_.size() - at - sizeof header);
+  if (header.stored_size >= raw_.size()) {
+    // Incompressible: store raw.
+    group_.resize(at + sizeof header);
+    group_.insert(group_.end(), raw_.begin(), raw_.end());
+    header.flags = 0;
+    header.stored_size = static_cast<std::uint32_t>(raw_.size());
+  }
+  header.raw_size = static_cast<std::uint32_t>(raw_.size());
+  header.record_count = block_records_;
+  header.first_timestamp_us = block_first_us_;
+  header.checksum = fnv1a(group_.data() + at + sizeof header, header.stored_size);
+  std::memcpy(group_.data() + at, &header, sizeof header);
+  raw_bytes_.fetch_add(raw_.size(), std::memory_order_relaxed);
+  blocks_.fetch_add(1, std::memory_order_relaxed);
+  raw_.clear();
+  block_records_ = 0;
+}
+
+bool EventLogWriter::commit() {
+  seal_block();
+  if (!group_.empty()) {
+    if (!write_all(fd_, group_.data(), group_.size())) return false;
+    if (options_.sync && ::fdatasync(fd_) != 0) return false;
+    file_bytes_.fetch_add(group_.size(), std::memory_order_relaxed);
+    commits_.fetch_add(1, std::memory_order_relaxed);
+    group_.clear();
+  }
+  {
+    std::lock_guard lock(mutex_);
+    committed_.store(consumed_, std::memory_order_release);
+  }
+  committed_cv_.notify_all();
+  return true;
+}
+
+void EventLogWriter::run() {
+  set_trace_thread_name("event log");
+  using Clock = std::chrono::steady_clock;
+  auto group_started = Clock::now();
+  bool pending = false;
+  for (;;) {
+    const std::size_t n = ring_->drain(4096, [&](const LogRecord& r) {
+      if (block_records_ == 0) {
+        block_first_us_ = r.timestamp_us;
+        previous_us_ = r.timestamp_us;
+      }
+      encode_log_record(r, previous_us_, raw_);
+      previous_us_ = r.timestamp_us;
+      ++block_records_;
+      if (raw_.size() >= options_.block_bytes) seal_block();
+    });
+    consumed_ += n;
+    if (n != 0 && !pending) {
+      pending = true;
+      group_started = Clock::now();
+    }
+
+    const bool due = pending && Clock::now() - group_started >= options_.commit_interval;
+    bool flush_now;
+    bool stop;
+    {
+      std::unique_lock lock(mutex_);
+      flush_now = flush_requested_;
+      stop = stopping_.load(std::memory_order_acquire);
+      if (n == 0 && !flush_now && !stop && !due) {
+        // Idle: nap until the group is due or a flush request arrives.
+        wake_cv_.wait_for(lock, pending ? options_.commit_interval / 4 : options_.commit_interval);
+        continue;
+      }
+    }
+    if (flush_now || due || (stop && n == 0)) {
+      // A flush must also cover records still in flight in the ring.
+      if (flush_now && consumed_ < appended_.load(std::memory_order_acquire)) continue;
+      if (!commit()) {
+        failed_.store(true, std::memory_order_release);
+        committed_cv_.notify_all();
+        return;
+      }
+      pending = false;
+      {
+        std::lock_guard lock(mutex_);
+        if (committed_.load(std::memory_order_relaxed) >= appended_.load(std::memory_order_acquire)) {
+          flush_requested_ = false;
+        }
+      }
+      if (stop && consumed_ == appended_.load(std::memory_order_acquire)) return;
+    }
+  }
+}
+
+}  // namespace evac
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "eventlog/log_format.hpp"
+#include "ingest/mpsc_ring.hpp"
+
+namespace evac {
+
+struct EventLogOptions {
+  std::size_t block_bytes = 64 * 1024;  // raw bytes per block before compression
+  std::chrono::milliseconds commit_interval{20};
+  bool sync = true;                     // fdatasync once per commit group
+  std::size_t ring_capacity = 1 << 15;
+};
+
+struct EventLogCounters {
+  std::uint64_t records = 0;
+  std::uint64_t blocks = 0;
+  std::uint64_t commits = 0;      // write + sync groups
+  std::uint64_t raw_bytes = 0;    // encoded records before compression
+  std::uint64_t file_bytes = 0;
+  std::uint64_t backpressure_spins = 0;
+};
+
+// Append-only event log written by a background thread. Any thread appends
+// fixed-size records into a lock-free MPSC ring; the log thread encodes them
+// into blocks, compresses each full block, and commits in groups: everything
+// that arrived during one commit interval goes out in a single write() and a
+// single fdatasync(), however many records and blocks that is. flush() waits
+// until every record appended before it is durable.
+//
+// Throws std::runtime_error if the file cannot be created; I/O errors later
+// on stop the log thread and show up as failed().
+class EventLogWriter {
+ public:
+  EventLogWriter(const std::string& path, EventLogOptions options = {});
+  ~EventLogWriter();  // flushes
+  EventLogWriter(const EventLogWriter&) = delete;
+  EventLogWriter& operator=(const EventLogWriter&) = delete;
+
+  // Any thread; yields while the ring is full.
+  void append(const LogRecord& record);
+  void flush();
+
+  bool failed() const { return failed_.load(std::memory_order_acquire); }
+  EventLogCounters counters() const;
+
+ private:
+  void run();
+  void seal_block();
+  bool commit();
+
+  EventLogOptions options_;
+  int fd_ = -1;
+  std::unique_ptr<MpscRing<LogRecord>> ring_;
+  std::atomic<std::uint64_t> appended_{0};
+  std::atomic<std::uint64_t> committed_{0};
+  std::atomic<std::uint64_t> spins_{0};
+  std::atomic<bool> stopping_{false};
+  std::atomic<bool> failed_{false};
+  std::mutex mutex_;
+  std::condition_variable committed_cv_;
+  std::condition_variable wake_cv_;
+  bool flush_requested_ = false;
+
+  // Log thread state.
+  std::vector<std::uint8_t> raw_;
+  std::vector<std::uint8_t> group_;
+  std::uint32_t block_records_ = 0;
+  std::uint64_t block_first_us_ = 0;
+  std::uint64_t previous_us_ = 0;
+  std::uint64_t consumed_ = 0;
+  std::atomic<std::uint64_t> blocks_{0};
+  std::atomic<std::uint64_t> commits_{0};
+  std::atomic<std::uint64_t> raw_bytes_{0};
+  std::atomic<std::uint64_t> file_bytes_{0};
+  std::thread thread_;
+};
+
+}  // namespace evac
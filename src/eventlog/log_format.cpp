@@ -0,0 +1,93 @@
+#include "eventlog/log_format.hpp"
+
+#include <cstring>
+
+namespace evac {
+namespace {
+
+void put_varint(std::uint64_t v, std::vector<std::uint8_t>& out) {
+  while (v >= 0x80) {
+    out.push_back(static_cast<std::uint8_t>(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<std::uint8_t>(v));
+}
+
+bool get_varint(std::span<const std::uint8_t> in, std::size_t& pos, std::uint64_t& v) {
+  v = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (pos >= in.size()) return false;
+    const std::uint8_t b = in[pos++];
+    v |= std::uint64_t{b & 0x7fu} << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+bool get_varint32(std::span<const std::uint8_t> in, std::size_t& pos, std::uint32_t& v) {
+  std::uint64_t wide;
+  if (!get_varint(in, pos, wide) || wide > 0xffffffffu) return false;
+  v = static_cast<std::uint32_t>(wide);
+  return true;
+}
+
+std::uint64_t zigzag(std::int64_t v) {
+  return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+std::int64_t unzigzag(std::uint64_t v) { return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1); }
+
+}  // namespace
+
+void encode_log_record(const LogRecord& r, std::uint64_t previous_us, std::vector<std::uint8_t>& out) {
+  out.push_back(static_cast<std::uint8_t>(static_cast<std::uint8_t>(r.type) | r.kind << 4));
+  put_varint(zigzag(static_cast<std::int64_t>(r.timestamp_us - previous_us)), out);
+  switch (r.type) {
+    case LogRecordType::Sensor: {
+      put_varint(r.a, out);
+      std::uint8_t bytes[4];
+      std::memcpy(bytes, &r.value, sizeof bytes);
+      out.insert(out.end(), bytes, bytes + 4);
+      break;
+    }
+    case LogRecordType::Repair:
+      put_varint(r.a, out);
+      put_varint(r.b, out);
+      break;
+    case LogRecordType::Route:
+      put_varint(r.a, out);
+      put_varint(std::uint32_t(r.b + 1), out);
+      put_varint(std::uint32_t(r.c + 1), out);
+      break;
+  }
+}
+
+bool decode_log_record(std::span<const std::uint8_t> in, std::size_t& pos, std::uint64_t previous_us,
+                       LogRecord& out) {
+  if (pos >= in.size()) return false;
+  const std::uint8_t head = in[pos++];
+  out = LogRecord{};
+  out.type = static_cast<LogRecordType>(head & 0x0f);
+  out.kind = static_cast<std::uint8_t>(head >> 4);
+  std::uint64_t delta;
+  if (!get_varint(in, pos, delta)) return false;
+  out.timestamp_us = previous_us + static_cast<std::uint64_t>(unzigzag(delta));
+  switch (out.type) {
+    case LogRecordType::Sensor:
+      if (!get_varint32(in, pos, out.a) || in.size() - pos < 4) return false;
+      std::memcpy(&out.value, in.data() + pos, sizeof out.value);
+      pos += 4;
+      return true;
+    case LogRecordType::Repair:
+      return get_varint32(in, pos, out.a) && get_varint32(in, pos, out.b);
+    case LogRecordType::Route:
+      if (!get_varint32(in, pos, out.a) || !get_varint32(in, pos, out.b) || !get_varint32(in, pos, out.c)) {
+        return false;
+      }
+      out.b -= 1;
+      out.c -= 1;
+      return true;
+  }
+  return false;
+}
+
+}  // namespace evac
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace evac {
+
+// On-disk layout of event logs (.evl). A log is a file header followed by
+// self-contained blocks: each block header carries the block's first
+// timestamp and a checksum, and record timestamps inside a block are deltas
+// from the previous record, so any block decodes on its own and a torn tail
+// after a crash costs at most the block being written.
+//
+// Record encoding, before block compression:
+//   u8      type | sensor kind << 4
+//   varint  zigzag timestamp delta, microseconds
+//   Sensor: varint sensor id, f32 value
+//   Repair: varint guidance version, varint readings in the batch
+//   Route:  varint node, varint next hop + 1, varint distance + 1
+// (+1 maps kInvalidNode / kInfiniteCost to 0.)
+
+inline constexpr char kLogMagic[8] = {'E', 'V', 'A', 'C', 'L', 'O', 'G', '\0'};
+inline constexpr std::uint32_t kLogVersion = 1;
+inline constexpr std::uint32_t kLogEndianTag = 0x01020304;
+inline constexpr std::uint32_t kLogBlockMagic = 0x424c5645;  // "EVLB"
+inline constexpr std::uint32_t kLogBlockCompressed = 1;
+
+struct LogFileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t endian_tag;
+  std::uint64_t reserved;
+};
+static_assert(sizeof(LogFileHeader) == 24);
+
+struct LogBlockHeader {
+  std::uint32_t magic;
+  std::uint32_t flags;
+  std::uint32_t raw_size;
+  std::uint32_t stored_size;
+  std::uint32_t record_count;
+  std::uint32_t reserved;
+  std::uint64_t first_timestamp_us;
+  std::uint64_t checksum;  // fnv1a of the stored bytes
+};
+static_assert(sizeof(LogBlockHeader) == 40);
+
+enum class LogRecordType : std::uint8_t {
+  Sensor = 1,  // an accepted reading, in the order the router consumed it
+  Repair = 2,  // router drained a batch and published guidance
+  Route = 3,   // a node's next hop changed in that publication
+};
+
+struct LogRecord {
+  LogRecordType type = LogRecordType::Sensor;
+  std::uint8_t kind = 0;  // SensorKind for Sensor records
+  std::uint64_t timestamp_us = 0;
+  std::uint32_t a = 0;    // sensor id | version | node
+  std::uint32_t b = 0;    // readings | next hop
+  std::uint32_t c = 0;    // distance (Route)
+  float value = 0.0f;     // reading (Sensor)
+};
+
+void encode_log_record(const LogRecord& r, std::uint64_t previous_us, std::vector<std::uint8_t>& out);
+// Decodes one record at `pos`, advancing it; false on truncated or unknown input.
+bool decode_log_record(std::span<const std::uint8_t> in, std::size_t& pos, std::uint64_t previous_us,
+                       LogRecord& out);
+
+}  // namespace evac
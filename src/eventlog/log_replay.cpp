@@ -0,0 +1,134 @@
+#include "eventlog/log_replay.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "eventlog/event_log_reader.hpp"
+#include "ingest/ingest_pipeline.hpp"
+#include "ingest/occupancy_fusion.hpp"
+#include "routing/incremental_router.hpp"
+
+namespace evac {
+
+void DecisionRecorder::record(EventLogWriter& log, std::uint64_t timestamp_us, std::uint32_t readings,
+                              const GuidanceSnapshot* published) {
+  LogRecord marker;
+  marker.type = LogRecordType::Repair;
+  marker.timestamp_us = timestamp_us;
+  marker.a = published ? static_cast<std::uint32_t>(published->version()) : 0;
+  marker.b = readings;
+  log.append(marker);
+  if (!published) return;
+  const std::span<const NodeId> hops = published->next_hops();
+  const std::span<const Cost> dist = published->distances();
+  for (NodeId v = 0; v < hops.size() && v < next_hop_.size(); ++v) {
+    if (seeded_ && hops[v] == next_hop_[v]) continue;
+    next_hop_[v] = hops[v];
+    LogRecord route;
+    route.type = LogRecordType::Route;
+    route.timestamp_us = timestamp_us;
+    route.a = v;
+    route.b = hops[v];
+    route.c = dist[v];
+    log.append(route);
+  }
+  seeded_ = true;
+}
+
+ReplayStats replay_event_log(const std::string& path, BuildingGraph& graph, const SensorMap& sensors,
+                             double speed) {
+  using Clock = std::chrono::steady_clock;
+  EventLogReader reader(path);
+  IngestOptions options;
+  options.ring_capacity = 1 << 16;
+  IngestPipeline pipeline(sensors, graph.edge_count(), options);
+  OccupancyFusion fusion(sensors, graph);
+  IncrementalRouter router(graph);
+  const std::size_t n = graph.node_count();
+  std::vector<NodeId> expected(n, kInvalidNode);
+  std::vector<NodeId> actual(n, kInvalidNode);
+  const auto capture = [&] {
+    for (NodeId v = 0; v < n; ++v) {
+      const EdgeId e = router.next_edges()[v];
+      actual[v] = e == kInvalidEdge ? kInvalidNode : graph.edge_target(e);
+    }
+  };
+  capture();
+
+  ReplayStats stats;
+  std::uint64_t pending = 0;
+  std::uint64_t drained_before = 0;
+  bool seen_marker = false;
+  std::uint64_t first_us = 0;
+  std::uint64_t last_us = 0;
+  const auto start = Clock::now();
+  // A split drain only stages its hazards: the recording repaired once per
+  // batch, and repairing twice may break cost ties differently.
+  // Congestion is fused once per marker, at the marker's timestamp.
+  bool staged = false;
+  const auto drain = [&](bool repair, std::uint64_t now_us) {
+    const std::span<const HazardUpdate> updates = pipeline.drain();
+    for (const HazardUpdate& u : updates) router.set_edge_hazard(u.edge, u.hazard);
+    fusion.add(pipeline.occupancy());
+    staged = staged || !updates.empty();
+    pending = 0;
+    if (!repair) return;
+    for (const CongestionUpdate& u : fusion.update(now_us)) {
+      router.set_edge_congestion(u.edge, u.delay_s);
+      staged = true;
+    }
+    if (!staged) return;
+    router.repair();
+    capture();
+    staged = false;
+    ++stats.publications;
+  };
+
+  LogRecord rec;
+  while (reader.next(rec)) {
+    if (stats.records++ == 0) first_us = rec.timestamp_us;
+    last_us = std::max(last_us, rec.timestamp_us);
+    if (speed > 0.0 && rec.timestamp_us > first_us) {
+      const std::chrono::duration<double, std::micro> offset(static_cast<double>(rec.timestamp_us - first_us) / speed);
+      const auto due = start + std::chrono::duration_cast<Clock::duration>(offset);
+      if (Clock::now() < due) std::this_thread::sleep_until(due);
+    }
+    switch (rec.type) {
+      case LogRecordType::Sensor: {
+        if (pending + 1 >= options.ring_capacity) {
+          drain(false, rec.timestamp_us);
+          ++stats.split_drains;
+        }
+        SensorEvent event;
+        event.timestamp_us = rec.timestamp_us;
+        event.sensor_id = rec.a;
+        event.kind = static_cast<SensorKind>(rec.kind);
+        event.value = rec.value;
+        pipeline.submit(0, event);
+        ++pending;
+        ++stats.sensor_records;
+        break;
+      }
+      case LogRecordType::Repair:
+        if (seen_marker && expected != actual) ++stats.divergent_drains;
+        seen_marker = true;
+        drain(true, rec.timestamp_us);
+        ++stats.drains;
+        if (pipeline.drained_readings() - drained_before != rec.b) ++stats.batch_mismatches;
+        drained_before = pipeline.drained_readings();
+        break;
+      case LogRecordType::Route:
+        if (rec.a < n) expected[rec.a] = rec.b;
+        ++stats.route_records;
+        break;
+    }
+  }
+  if (seen_marker && expected != actual) ++stats.divergent_drains;
+  stats.truncated = reader.truncated();
+  stats.logged_seconds = static_cast<double>(last_us - first_us) / 1e6;
+  stats.replay_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return stats;
+}
+
+}  // namespace evac
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "eventlog/event_log_writer.hpp"
+#include "graph/building_graph.hpp"
+#include "ingest/sensor_map.hpp"
+#include "routing/guidance_snapshot.hpp"
+
+namespace evac {
+
+// Routing-thread side of recording: after every non-empty drain, a Repair
+// record with the batch size, and, when guidance was published, a Route
+// record for each node whose next hop changed since the last publication
+// (every node, the first time).
+class DecisionRecorder {
+ public:
+  explicit DecisionRecorder(std::size_t node_count) : next_hop_(node_count, kInvalidNode), seeded_(false) {}
+
+  // `published` is null when the drain changed no arc and nothing was published.
+  void record(EventLogWriter& log, std::uint64_t timestamp_us, std::uint32_t readings,
+              const GuidanceSnapshot* published);
+
+ private:
+  std::vector<NodeId> next_hop_;
+  bool seeded_;
+};
+
+struct ReplayStats {
+  std::uint64_t records = 0;
+  std::uint64_t sensor_records = 0;
+  std::uint64_t route_records = 0;
+  std::uint64_t drains = 0;
+  std::uint64_t publications = 0;
+  std::uint64_t split_drains = 0;        // batches too big for the ring, drained early
+  std::uint64_t batch_mismatches = 0;    // drains whose size differed from the log
+  std::uint64_t divergent_drains = 0;    // replayed next hops differed from the logged ones
+  double logged_seconds = 0.0;           // span of the log's timestamps
+  double replay_seconds = 0.0;
+  bool truncated = false;
+};
+
+// Re-drives the ingest pipeline and router from a log: readings are
+// submitted in logged order, the pipeline is drained at each Repair record,
+// and the next hops the router then publishes are checked against the
+// logged Route records. `speed` scales the pacing (100 = a hundred times
+// faster than the incident ran; 0 = as fast as possible). `graph` must be the
+// plan the log was recorded on, with the hazards it started from.
+ReplayStats replay_event_log(const std::string& path, BuildingGraph& graph, const SensorMap& sensors,
+                             double speed);
+
+}  // namespace evac
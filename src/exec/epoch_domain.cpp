@@ -0,0 +1,40 @@
+#include "exec/epoch_domain.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace evac {
+
+EpochDomain::Reader::Reader(EpochDomain& domain) : domain_(domain), slot_(domain.slots_.size()) {
+  for (std::size_t i = 0; i < domain_.slots_.size(); ++i) {
+    bool expected = false;
+    if (domain_.slots_[i].taken.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+      slot_ = i;
+      return;
+    }
+  }
+  throw std::runtime_error("epoch domain: more than " + std::to_string(kMaxReaders) + " readers");
+}
+
+EpochDomain::Reader::~Reader() {
+  domain_.slots_[slot_].epoch.store(kIdle, std::memory_order_release);
+  domain_.slots_[slot_].taken.store(false, std::memory_order_release);
+}
+
+std::uint64_t EpochDomain::oldest_pinned() const {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::uint64_t oldest = kIdle;
+  for (const Slot& s : slots_) {
+    const std::uint64_t e = s.epoch.load(std::memory_order_seq_cst);
+    if (e < oldest) oldest = e;
+  }
+  return oldest;
+}
+
+std::size_t EpochDomain::reader_count() const {
+  std::size_t n = 0;
+  for (const Slot& s : slots_) n += s.taken.load(std::memory_order_relaxed) ? 1 : 0;
+  return n;
+}
+
+}  // namespace evac
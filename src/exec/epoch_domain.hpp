@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace evac {
+
+// Epoch-based reclamation for one writer and many readers. A reader pins the
+// current global epoch for the duration of a read; the writer publishes a new
+// version by swapping a pointer, closes the epoch with advance(), and may free
+// the old version once every pinned reader is past that epoch. Readers only
+// ever store to their own slot, and the writer never waits: anything still
+// pinned is simply reclaimed on a later pass.
+//
+// Each reader thread registers once (a Reader owns a slot); pins do not nest.
+class EpochDomain {
+ public:
+  static constexpr std::size_t kMaxReaders = 256;
+  static constexpr std::uint64_t kIdle = std::numeric_limits<std::uint64_t>::max();
+
+  EpochDomain() : slots_(kMaxReaders) {}
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+
+  class Guard {
+   public:
+    explicit Guard(std::atomic<std::uint64_t>& slot) : slot_(&slot) {}
+    ~Guard() {
+      if (slot_) slot_->store(kIdle, std::memory_order_release);
+    }
+    Guard(Guard&& o) noexcept : slot_(o.slot_) { o.slot_ = nullptr; }
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+    Guard& operator=(Guard&&) = delete;
+
+   private:
+    std::atomic<std::uint64_t>* slot_;
+  };
+
+  // A registered reader; throws std::runtime_error when all slots are taken.
+  class Reader {
+   public:
+    explicit Reader(EpochDomain& domain);
+    ~Reader();
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    // Shared pointers loaded after this returns stay valid until the guard
+    // goes out of scope.
+    Guard pin() {
+      std::atomic<std::uint64_t>& epoch = domain_.slots_[slot_].epoch;
+      epoch.store(domain_.epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      return Guard(epoch);
+    }
+
+   private:
+    EpochDomain& domain_;
+    std::size_t slot_;
+  };
+
+  std::uint64_t epoch() const { return epoch_.load(std::memory_order_acquire); }
+
+  // Writer, after swapping a published pointer: closes the current epoch and
+  // returns it. Objects unlinked before the call are safe to free once
+  // reclaimable(returned epoch).
+  std::uint64_t advance() { return epoch_.fetch_add(1, std::memory_order_seq_cst); }
+
+  // Oldest epoch any reader is pinned at, or kIdle when none is.
+  std::uint64_t oldest_pinned() const;
+  bool reclaimable(std::uint64_t retired_epoch) const { return oldest_pinned() > retired_epoch; }
+
+  std::size_t reader_count() const;
+
+ private:
+  struct alignas(64) Slot {
+    std::atomic<std::uint64_t> epoch{kIdle};
+    std::atomic<bool> taken{false};
+  };
+
+  std::atomic<std::uint64_t> epoch_{1};
+  std::vector<Slot> slots_;
+};
+
+}  // namespace evac
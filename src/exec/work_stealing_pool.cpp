@@ -0,0 +1,123 @@
+#include "exec/work_stealing_pool.hpp"
+
+#include <algorithm>
+
+namespace evac {
+namespace {
+
+constexpr std::uint64_t pack(std::uint32_t begin, std::uint32_t end) {
+  return (std::uint64_t{begin} << 32) | end;
+}
+constexpr std::uint32_t range_begin(std::uint64_t r) { return static_cast<std::uint32_t>(r >> 32); }
+constexpr std::uint32_t range_end(std::uint64_t r) { return static_cast<std::uint32_t>(r); }
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned workers) : slots_(std::max(1u, workers)) {
+  threads_.reserve(slots_.size() - 1);
+  for (unsigned w = 1; w < slots_.size(); ++w) threads_.emplace_back([this, w] { worker_loop(w); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& t : threads_) t.join();
+}
+
+void WorkStealingPool::run(std::size_t n, std::size_t grain, Thunk thunk, void* ctx) {
+  if (n == 0) return;
+  const std::size_t chunks = (n + grain - 1) / grain;
+  if (slots_.size() == 1 || chunks == 1) {
+    for (std::size_t b = 0; b < n; b += grain) thunk(ctx, b, std::min(n, b + grain), 0);
+    return;
+  }
+
+  thunk_ = thunk;
+  ctx_ = ctx;
+  n_ = n;
+  grain_ = grain;
+  chunks_left_.store(chunks, std::memory_order_relaxed);
+  const std::size_t w = slots_.size();
+  for (std::size_t i = 0; i < w; ++i) {
+    const auto b = static_cast<std::uint32_t>(chunks * i / w);
+    const auto e = static_cast<std::uint32_t>(chunks * (i + 1) / w);
+    slots_[i].range.store(pack(b, e), std::memory_order_relaxed);
+  }
+  busy_.store(static_cast<unsigned>(w), std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  drain(0);
+  busy_.fetch_sub(1, std::memory_order_acq_rel);
+  // Wait for stragglers to leave drain() so the job context can go out of scope.
+  while (busy_.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+}
+
+void WorkStealingPool::worker_loop(unsigned self) {
+  std::uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+      if (stopping_) return;
+      seen = generation_;
+    }
+    drain(self);
+    busy_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+void WorkStealingPool::drain(unsigned self) {
+  std::uint32_t chunk = 0;
+  while (chunks_left_.load(std::memory_order_acquire) != 0) {
+    if (!take_own(self, chunk) && !steal(self, chunk)) {
+      std::this_thread::yield();
+      continue;
+    }
+    const std::size_t b = std::size_t{chunk} * grain_;
+    thunk_(ctx_, b, std::min(n_, b + grain_), self);
+    chunks_left_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+bool WorkStealingPool::take_own(unsigned self, std::uint32_t& chunk) {
+  std::atomic<std::uint64_t>& slot = slots_[self].range;
+  std::uint64_t r = slot.load(std::memory_order_acquire);
+  while (range_begin(r) < range_end(r)) {
+    if (slot.compare_exchange_weak(r, pack(range_begin(r) + 1, range_end(r)),
+                                   std::memory_order_acq_rel)) {
+      chunk = range_begin(r);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkStealingPool::steal(unsigned self, std::uint32_t& chunk) {
+  const auto w = static_cast<unsigned>(slots_.size());
+  for (unsigned k = 1; k < w; ++k) {
+    std::atomic<std::uint64_t>& victim = slots_[(self + k) % w].range;
+    std::uint64_t r = victim.load(std::memory_order_acquire);
+    while (range_begin(r) < range_end(r)) {
+      const std::uint32_t b = range_begin(r);
+      const std::uint32_t e = range_end(r);
+      const std::uint32_t mid = b + (e - b) / 2;  // victim keeps [b, mid)
+      if (victim.compare_exchange_weak(r, pack(b, mid), std::memory_order_acq_rel)) {
+        // Our own slot is empty, and other thieves skip empty slots, so a plain
+        // store is enough to publish the stolen remainder.
+        chunk = mid;
+        slots_[self].range.store(pack(mid + 1, e), std::memory_order_release);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace evac
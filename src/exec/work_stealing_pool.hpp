@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace evac {
+
+// Fixed-size pool running data-parallel loops with range stealing. A loop over
+// [0, n) is cut into chunks of `grain` items and the chunk range is dealt out
+// evenly, one contiguous sub-range per worker. A worker takes chunks from the
+// front of its own range; when it runs dry it steals the back half of a
+// victim's range with a single CAS on the packed (begin, end) pair, so
+// imbalanced tiles (a crowded stair landing next to empty offices) even out
+// without a shared queue.
+//
+// The calling thread takes part as worker 0; `workers() == 1` runs inline.
+// parallel_for() calls must not be nested and must come from one thread.
+class WorkStealingPool {
+ public:
+  explicit WorkStealingPool(unsigned workers = std::thread::hardware_concurrency());
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  unsigned workers() const { return static_cast<unsigned>(slots_.size()); }
+
+  // body(begin, end, worker) with end - begin <= grain; blocks until all done.
+  template <class Fn>
+  void parallel_for(std::size_t n, std::size_t grain, Fn&& body) {
+    auto thunk = [](void* ctx, std::size_t b, std::size_t e, unsigned w) {
+      (*static_cast<std::remove_reference_t<Fn>*>(ctx))(b, e, w);
+    };
+    run(n, grain == 0 ? 1 : grain, thunk, &body);
+  }
+
+ private:
+  using Thunk = void (*)(void*, std::size_t, std::size_t, unsigned);
+
+  struct alignas(64) Slot {
+    std::atomic<std::uint64_t> range{0};  // begin chunk in high 32 bits, end in low
+  };
+
+  void run(std::size_t n, std::size_t grain, Thunk thunk, void* ctx);
+  void worker_loop(unsigned self);
+  void drain(unsigned self);
+  bool take_own(unsigned self, std::uint32_t& chunk);
+  bool steal(unsigned self, std::uint32_t& chunk);
+
+  std::vector<Slot> slots_;
+  std::vector<std::thread> threads_;
+
+  // Current job; written by run() before the generation bump publishes it.
+  Thunk thunk_ = nullptr;
+  void* ctx_ = nullptr;
+  std::size_t n_ = 0;
+  std::size_t grain_ = 1;
+  std::atomic<std::size_t> chunks_left_{0};
+  std::atomic<unsigned> busy_{0};
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::uint64_t generation_ = 0;
+  bool stopping_ = false;
+};
+
+}  // namespace evac
@@ -0,0 +1,276 @@
+#include "gateway/gateway_server.hpp"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "gateway/modbus.hpp"
+#include "telemetry/trace.hpp"
+
+namespace evac {
+namespace {
+
+constexpr std::size_t kInitialBuffer = 512;
+constexpr std::size_t kMaxMqttPacket = 64 * 1024;
+constexpr std::size_t kModbusBuffer = 512;  // a few pipelined ADUs of at most 260 bytes
+constexpr std::string_view kSensorTopic = "evac/sensor/";
+constexpr std::string_view kFrameTopic = "evac/frame";
+
+std::uint64_t wall_clock_us() {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
+          .count());
+}
+
+void tune(int fd) {
+  const int yes = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof yes);
+  ::setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &yes, sizeof yes);
+}
+
+// Moves the unparsed tail of `in` to the front.
+void compact(std::vector<std::byte>& in, std::size_t& have, std::size_t consumed) {
+  if (consumed == 0) return;
+  std::memmove(in.data(), in.data() + consumed, have - consumed);
+  have -= consumed;
+}
+
+}  // namespace
+
+GatewayServer::GatewayServer(IngestPipeline& pipeline, const SensorMap& sensors, GatewayOptions options)
+    : pipeline_(pipeline), sensors_(sensors), options_(options) {
+  options_.io_threads = std::max<std::size_t>(1, options_.io_threads);
+  if (options_.first_producer + options_.io_threads > pipeline_.producers()) {
+    throw std::invalid_argument("gateway loops need more producers than the ingest pipeline has");
+  }
+  const bool reuse = options_.io_threads > 1;
+  for (std::size_t i = 0; i < options_.io_threads; ++i) {
+    auto shard = std::make_unique<Shard>();
+    shard->producer = options_.first_producer + static_cast<unsigned>(i);
+    // Later shards join the port the first one got.
+    if (options_.mqtt_port >= 0) {
+      const auto port = static_cast<std::uint16_t>(i == 0 ? options_.mqtt_port : mqtt_port_);
+      shard->mqtt = std::make_unique<AsyncListener>(shard->loop, port, options_.loopback_only, reuse);
+      mqtt_port_ = shard->mqtt->port();
+    }
+    if (options_.modbus_port >= 0) {
+      const auto port = static_cast<std::uint16_t>(i == 0 ? options_.modbus_port : modbus_port_);
+      shard->modbus = std::make_unique<AsyncListener>(shard->loop, port, options_.loopback_only, reuse);
+      modbus_port_ = shard->modbus->port();
+    }
+    shards_.push_back(std::move(shard));
+  }
+  for (std::size_t i = 0; i < shards_.size(); ++i) {
+    Shard& shard = *shards_[i];
+    if (shard.mqtt) accept_loop(shard, *shard.mqtt, true);
+    if (shard.modbus) accept_loop(shard, *shard.modbus, false);
+    shard.thread = std::thread([&shard, i] {
+      const std::string name = "gateway-" + std::to_string(i);
+      set_trace_thread_name(name.c_str());
+      shard.loop.run();
+    });
+  }
+}
+
+GatewayServer::~GatewayServer() {
+  for (auto& shard : shards_) shard->loop.stop();
+  for (auto& shard : shards_) shard->thread.join();
+}
+
+GatewayCounters GatewayServer::counters() const {
+  GatewayCounters total;
+  for (const auto& s : shards_) {
+    total.connections += s->connections.load(std::memory_order_relaxed);
+    total.accepted += s->accepted.load(std::memory_order_relaxed);
+    total.mqtt_publishes += s->mqtt_publishes.load(std::memory_order_relaxed);
+    total.modbus_writes += s->modbus_writes.load(std::memory_order_relaxed);
+    total.readings += s->readings.load(std::memory_order_relaxed);
+    total.rejected += s->rejected.load(std::memory_order_relaxed);
+    total.protocol_errors += s->protocol_errors.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+Task GatewayServer::accept_loop(Shard& shard, AsyncListener& listener, bool mqtt) {
+  for (;;) {
+    const int fd = co_await listener.accept();
+    if (fd < 0) co_return;
+    tune(fd);
+    shard.accepted.fetch_add(1, std::memory_order_relaxed);
+    shard.connections.fetch_add(1, std::memory_order_relaxed);
+    if (mqtt) {
+      mqtt_session(shard, AsyncSocket(shard.loop, fd));
+    } else {
+      modbus_session(shard, AsyncSocket(shard.loop, fd));
+    }
+  }
+}
+
+Task GatewayServer::mqtt_session(Shard& shard, AsyncSocket socket) {
+  std::vector<std::byte> in(kInitialBuffer);
+  std::vector<std::byte> out;
+  std::size_t have = 0;
+  bool connected = false;
+  for (;;) {
+    if (have == in.size()) {
+      if (in.size() >= kMaxMqttPacket) {
+        shard.protocol_errors.fetch_add(1, std::memory_order_relaxed);
+        break;
+      }
+      in.resize(in.size() * 2);
+    }
+    const ssize_t n = co_await socket.read_some(std::span(in).subspan(have));
+    if (n <= 0) break;
+    have += static_cast<std::size_t>(n);
+
+    out.clear();
+    std::size_t pos = 0;
+    bool open = true;
+    while (open) {
+      MqttPacket packet;
+      std::size_t bytes = 0;
+      const MqttStatus status = parse_mqtt_packet(std::span(in.data() + pos, have - pos), packet, bytes);
+      if (status == MqttStatus::Incomplete) break;
+      if (status == MqttStatus::Malformed) {
+        shard.protocol_errors.fetch_add(1, std::memory_order_relaxed);
+        open = false;
+        break;
+      }
+      open = on_mqtt_packet(shard, packet, connected, out);
+      pos += bytes;
+    }
+    compact(in, have, pos);
+    if (!out.empty() && co_await socket.write_all(out) < 0) break;
+    if (!open) break;
+  }
+  shard.connections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool GatewayServer::on_mqtt_packet(Shard& shard, const MqttPacket& packet, bool& connected,
+                                   std::vector<std::byte>& out) {
+  if (!connected && packet.type != MqttType::Connect) {
+    shard.protocol_errors.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  std::uint16_t id = 0;
+  switch (packet.type) {
+    case MqttType::Connect:
+      connected = true;
+      encode_mqtt_connack(out);
+      return true;
+    case MqttType::Publish: {
+      MqttPublish publish;
+      if (!parse_mqtt_publish(packet, publish)) {
+        shard.protocol_errors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      on_mqtt_publish(shard, publish);
+      if (publish.qos == 1) encode_mqtt_ack(MqttType::Puback, publish.packet_id, out);
+      if (publish.qos == 2) encode_mqtt_ack(MqttType::Pubrec, publish.packet_id, out);
+      return true;
+    }
+    case MqttType::Pubrel:
+      if (parse_mqtt_packet_id(packet, id)) encode_mqtt_ack(MqttType::Pubcomp, id, out);
+      return true;
+    case MqttType::Subscribe:
+      if (parse_mqtt_packet_id(packet, id)) encode_mqtt_suback_failures(id, count_mqtt_subscriptions(packet), out);
+      return true;
+    case MqttType::Pingreq:
+      encode_mqtt_pingresp(out);
+      return true;
+    case MqttType::Disconnect:
+      return false;
+    default:
+      return true;
+  }
+}
+
+// QoS 2 publishes are delivered on PUBLISH rather than on PUBREL; a
+// duplicate only re-asserts the same reading.
+void GatewayServer::on_mqtt_publish(Shard& shard, const MqttPublish& publish) {
+  shard.mqtt_publishes.fetch_add(1, std::memory_order_relaxed);
+  if (publish.topic == kFrameTopic) {
+    if (pipeline_.submit_frame(shard.producer, publish.payload) != DecodeStatus::Ok) {
+      shard.rejected.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    shard.readings.fetch_add(detail::load_le<std::uint32_t>(publish.payload.data() + 4), std::memory_order_relaxed);
+    return;
+  }
+  if (!publish.topic.starts_with(kSensorTopic)) {
+    shard.rejected.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const std::string_view id_text = publish.topic.substr(kSensorTopic.size());
+  const auto* text = reinterpret_cast<const char*>(publish.payload.data());
+  SensorEvent event;
+  const auto id = std::from_chars(id_text.data(), id_text.data() + id_text.size(), event.sensor_id);
+  const auto value = std::from_chars(text, text + publish.payload.size(), event.value);
+  if (id.ec != std::errc() || id.ptr != id_text.data() + id_text.size() || value.ec != std::errc()) {
+    shard.rejected.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  event.timestamp_us = wall_clock_us();
+  pipeline_.submit(shard.producer, event);
+  shard.readings.fetch_add(1, std::memory_order_relaxed);
+}
+
+Task GatewayServer::modbus_session(Shard& shard, AsyncSocket socket) {
+  std::vector<std::byte> in(kModbusBuffer);
+  std::vector<std::byte> out;
+  std::size_t have = 0;
+  bool open = true;
+  while (open) {
+    const ssize_t n = co_await socket.read_some(std::span(in).subspan(have));
+    if (n <= 0) break;
+    have += static_cast<std::size_t>(n);
+
+    out.clear();
+    std::size_t pos = 0;
+    for (;;) {
+      ModbusRequest request;
+      std::size_t bytes = 0;
+      const ModbusStatus status = parse_modbus_adu(std::span(in.data() + pos, have - pos), request, bytes);
+      if (status == ModbusStatus::Incomplete) break;
+      if (status == ModbusStatus::Malformed) {
+        shard.protocol_errors.fetch_add(1, std::memory_order_relaxed);
+        open = false;
+        break;
+      }
+      pos += bytes;
+      ModbusRegisterWrite write;
+      std::uint8_t code = parse_modbus_write_registers(request, write);
+      const std::size_t first = (std::size_t{request.unit} * 65536 + write.start) / 2;
+      if (code == 0 && first + write.count / 2 > sensors_.sensor_count()) code = kModbusIllegalAddress;
+      if (code != 0) {
+        shard.rejected.fetch_add(1, std::memory_order_relaxed);
+        encode_modbus_exception(request, code, out);
+        continue;
+      }
+      const std::uint64_t now_us = wall_clock_us();
+      for (std::size_t i = 0; i < write.count / 2u; ++i) {
+        SensorEvent event;
+        event.timestamp_us = now_us;
+        event.sensor_id = sensors_.sensor_id(static_cast<std::uint32_t>(first + i));
+        event.value = modbus_register_float(write, i);
+        pipeline_.submit(shard.producer, event);
+      }
+      shard.modbus_writes.fetch_add(1, std::memory_order_relaxed);
+      shard.readings.fetch_add(write.count / 2u, std::memory_order_relaxed);
+      encode_modbus_write_response(request, write, out);
+    }
+    compact(in, have, pos);
+    if (!out.empty() && co_await socket.write_all(out) < 0) break;
+  }
+  shard.connections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+}  // namespace evac
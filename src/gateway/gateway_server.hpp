@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gateway/mqtt.hpp"
+#include "ingest/ingest_pipeline.hpp"
+#include "ingest/sensor_map.hpp"
+#include "net/event_loop.hpp"
+
+namespace evac {
+
+struct GatewayOptions {
+  int mqtt_port = -1;            // -1 off, 0 any free port
+  int modbus_port = -1;
+  std::size_t io_threads = 1;
+  unsigned first_producer = 0;   // loop i submits as producer first_producer + i
+  bool loopback_only = true;
+};
+
+struct GatewayCounters {
+  std::uint64_t connections = 0;   // open now
+  std::uint64_t accepted = 0;
+  std::uint64_t mqtt_publishes = 0;
+  std::uint64_t modbus_writes = 0;
+  std::uint64_t readings = 0;      // handed to the pipeline
+  std::uint64_t rejected = 0;      // unknown topics, bad payloads, Modbus exceptions
+  std::uint64_t protocol_errors = 0;  // connections dropped for malformed traffic
+};
+
+// Device-facing front of the ingest pipeline. Each I/O thread runs one
+// EventLoop with its own listeners on the shared ports (SO_REUSEPORT), and
+// every connection is a coroutine parked on its socket, so twenty thousand
+// mostly idle devices cost twenty thousand small frames rather than threads.
+// Parsed readings go straight into the pipeline's lock-free rings with the
+// loop's own producer slot; the pipeline needs first_producer + io_threads
+// producers, or the constructor throws std::invalid_argument.
+//
+// MQTT and Modbus/TCP are spoken as described in gateway/mqtt.hpp and
+// gateway/modbus.hpp. Sockets get SO_KEEPALIVE, so dead peers are reaped by
+// the kernel rather than by per-connection timers.
+class GatewayServer {
+ public:
+  // Throws std::runtime_error if a listener cannot be bound.
+  GatewayServer(IngestPipeline& pipeline, const SensorMap& sensors, GatewayOptions options);
+  ~GatewayServer();
+  GatewayServer(const GatewayServer&) = delete;
+  GatewayServer& operator=(const GatewayServer&) = delete;
+
+  std::uint16_t mqtt_port() const { return mqtt_port_; }
+  std::uint16_t modbus_port() const { return modbus_port_; }
+  GatewayCounters counters() const;
+
+ private:
+  struct Shard {
+    EventLoop loop;
+    std::unique_ptr<AsyncListener> mqtt;
+    std::unique_ptr<AsyncListener> modbus;
+    unsigned producer = 0;
+    std::atomic<std::uint64_t> connections{0};
+    std::atomic<std::uint64_t> accepted{0};
+    std::atomic<std::uint64_t> mqtt_publishes{0};
+    std::atomic<std::uint64_t> modbus_writes{0};
+    std::atomic<std::uint64_t> readings{0};
+    std::atomic<std::uint64_t> rejected{0};
+    std::atomic<std::uint64_t> protocol_errors{0};
+    std::thread thread;
+  };
+
+  Task accept_loop(Shard& shard, AsyncListener& listener, bool mqtt);
+  Task mqtt_session(Shard& shard, AsyncSocket socket);
+  Task modbus_session(Shard& shard, AsyncSocket socket);
+  // False when the session must end.
+  bool on_mqtt_packet(Shard& shard, const MqttPacket& packet, bool& connected, std::vector<std::byte>& out);
+  void on_mqtt_publish(Shard& shard, const MqttPublish& publish);
+
+  IngestPipeline& pipeline_;
+  const SensorMap& sensors_;
+  GatewayOptions options_;
+  std::uint16_t mqtt_port_ = 0;
+  std::uint16_t modbus_port_ = 0;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace evac
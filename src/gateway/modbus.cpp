@@ -0,0 +1,95 @@
+#include "gateway/modbus.hpp"
+
+#include <bit>
+
+namespace evac {
+namespace {
+
+constexpr std::size_t kMbapBytes = 7;  // transaction, protocol, length, unit
+constexpr std::size_t kMaxPduBytes = 253;
+
+std::uint8_t byte_at(std::span<const std::byte> in, std::size_t i) { return std::to_integer<std::uint8_t>(in[i]); }
+
+std::uint16_t load_be16(std::span<const std::byte> in, std::size_t i) {
+  return static_cast<std::uint16_t>(byte_at(in, i) << 8 | byte_at(in, i + 1));
+}
+
+void put(std::vector<std::byte>& out, std::uint8_t b) { out.push_back(static_cast<std::byte>(b)); }
+
+void put_be16(std::vector<std::byte>& out, std::uint16_t v) {
+  put(out, static_cast<std::uint8_t>(v >> 8));
+  put(out, static_cast<std::uint8_t>(v));
+}
+
+void put_mbap(std::vector<std::byte>& out, std::uint16_t transaction, std::uint8_t unit, std::size_t pdu_bytes) {
+  put_be16(out, transaction);
+  put_be16(out, 0);  // protocol: Modbus
+  put_be16(out, static_cast<std::uint16_t>(pdu_bytes + 1));
+  put(out, unit);
+}
+
+}  // namespace
+
+ModbusStatus parse_modbus_adu(std::span<const std::byte> in, ModbusRequest& out, std::size_t& adu_bytes) {
+  if (in.size() < kMbapBytes + 1) return ModbusStatus::Incomplete;
+  const std::size_t length = load_be16(in, 4);  // unit + PDU
+  if (load_be16(in, 2) != 0 || length < 2 || length - 1 > kMaxPduBytes) return ModbusStatus::Malformed;
+  if (in.size() < 6 + length) return ModbusStatus::Incomplete;
+  out.transaction = load_be16(in, 0);
+  out.unit = byte_at(in, 6);
+  out.function = byte_at(in, 7);
+  out.data = in.subspan(kMbapBytes + 1, length - 2);
+  adu_bytes = 6 + length;
+  return ModbusStatus::Ok;
+}
+
+std::uint8_t parse_modbus_write_registers(const ModbusRequest& request, ModbusRegisterWrite& out) {
+  if (request.function != kModbusWriteMultipleRegisters) return kModbusIllegalFunction;
+  const std::span<const std::byte> d = request.data;
+  if (d.size() < 5) return kModbusIllegalValue;
+  out.start = load_be16(d, 0);
+  out.count = load_be16(d, 2);
+  const std::size_t bytes = byte_at(d, 4);
+  if (out.count == 0 || out.count > kModbusMaxWriteRegisters || bytes != 2u * out.count || d.size() != 5 + bytes) {
+    return kModbusIllegalValue;
+  }
+  if (out.start % 2 != 0 || out.count % 2 != 0) return kModbusIllegalAddress;
+  out.values = d.subspan(5, bytes);
+  return 0;
+}
+
+float modbus_register_float(const ModbusRegisterWrite& write, std::size_t i) {
+  const std::uint32_t bits = std::uint32_t{load_be16(write.values, 4 * i)} << 16 | load_be16(write.values, 4 * i + 2);
+  return std::bit_cast<float>(bits);
+}
+
+void encode_modbus_write_registers(std::uint16_t transaction, std::uint8_t unit, std::uint16_t start,
+                                   std::span<const float> values, std::vector<std::byte>& out) {
+  const std::size_t registers = 2 * values.size();
+  put_mbap(out, transaction, unit, 6 + 2 * registers);
+  put(out, kModbusWriteMultipleRegisters);
+  put_be16(out, start);
+  put_be16(out, static_cast<std::uint16_t>(registers));
+  put(out, static_cast<std::uint8_t>(2 * registers));
+  for (const float v : values) {
+    const auto bits = std::bit_cast<std::uint32_t>(v);
+    put_be16(out, static_cast<std::uint16_t>(bits >> 16));
+    put_be16(out, static_cast<std::uint16_t>(bits));
+  }
+}
+
+void encode_modbus_write_response(const ModbusRequest& request, const ModbusRegisterWrite& write,
+                                  std::vector<std::byte>& out) {
+  put_mbap(out, request.transaction, request.unit, 5);
+  put(out, request.function);
+  put_be16(out, write.start);
+  put_be16(out, write.count);
+}
+
+void encode_modbus_exception(const ModbusRequest& request, std::uint8_t code, std::vector<std::byte>& out) {
+  put_mbap(out, request.transaction, request.unit, 2);
+  put(out, static_cast<std::uint8_t>(request.function | 0x80));
+  put(out, code);
+}
+
+}  // namespace evac
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace evac {
+
+// Modbus/TCP server side for gateways that push readings by writing
+// holding registers (function 16, Write Multiple Registers). Each sensor
+// owns two registers holding its reading as a big-endian float32, high word
+// first, in sensor map order: register r of unit u belongs to the sensor
+// with dense index (u * 65536 + r) / 2. A write must cover whole sensors.
+// Every other function is answered with exception 1 (illegal function).
+inline constexpr std::uint8_t kModbusWriteMultipleRegisters = 16;
+inline constexpr std::uint8_t kModbusIllegalFunction = 1;
+inline constexpr std::uint8_t kModbusIllegalAddress = 2;
+inline constexpr std::uint8_t kModbusIllegalValue = 3;
+inline constexpr std::size_t kModbusMaxWriteRegisters = 123;
+
+enum class ModbusStatus { Ok, Incomplete, Malformed };
+
+struct ModbusRequest {
+  std::uint16_t transaction = 0;
+  std::uint8_t unit = 0;
+  std::uint8_t function = 0;
+  std::span<const std::byte> data;  // PDU after the function code
+};
+
+// Frames one ADU (MBAP header + PDU) at the start of `in`.
+ModbusStatus parse_modbus_adu(std::span<const std::byte> in, ModbusRequest& out, std::size_t& adu_bytes);
+
+struct ModbusRegisterWrite {
+  std::uint16_t start = 0;
+  std::uint16_t count = 0;
+  std::span<const std::byte> values;  // count big-endian registers
+};
+
+// Zero on success, else the exception code to answer with.
+std::uint8_t parse_modbus_write_registers(const ModbusRequest& request, ModbusRegisterWrite& out);
+// The float32 held by registers 2i and 2i + 1 of a write.
+float modbus_register_float(const ModbusRegisterWrite& write, std::size_t i);
+
+void encode_modbus_write_registers(std::uint16_t transaction, std::uint8_t unit, std::uint16_t start,
+                                   std::span<const float> values, std::vector<std::byte>& out);
+void encode_modbus_write_response(const ModbusRequest& request, const ModbusRegisterWrite& write,
+                                  std::vector<std::byte>& out);
+void encode_modbus_exception(const ModbusRequest& request, std::uint8_t code, std::vector<std::byte>& out);
+
+}  // namespace evac
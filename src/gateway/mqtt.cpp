@@ -0,0 +1,128 @@
+#include "gateway/mqtt.hpp"
+
+namespace evac {
+namespace {
+
+constexpr std::size_t kMaxRemainingLength = 268435455;  // four length bytes
+
+std::uint8_t byte_at(std::span<const std::byte> in, std::size_t i) { return std::to_integer<std::uint8_t>(in[i]); }
+
+std::uint16_t load_be16(std::span<const std::byte> in, std::size_t i) {
+  return static_cast<std::uint16_t>(byte_at(in, i) << 8 | byte_at(in, i + 1));
+}
+
+void put(std::vector<std::byte>& out, std::uint8_t b) { out.push_back(static_cast<std::byte>(b)); }
+
+void put_be16(std::vector<std::byte>& out, std::uint16_t v) {
+  put(out, static_cast<std::uint8_t>(v >> 8));
+  put(out, static_cast<std::uint8_t>(v));
+}
+
+void put_string(std::vector<std::byte>& out, std::string_view s) {
+  put_be16(out, static_cast<std::uint16_t>(s.size()));
+  for (const char c : s) put(out, static_cast<std::uint8_t>(c));
+}
+
+void put_fixed_header(std::vector<std::byte>& out, MqttType type, std::uint8_t flags, std::size_t remaining) {
+  put(out, static_cast<std::uint8_t>(static_cast<std::uint8_t>(type) << 4 | flags));
+  do {
+    std::uint8_t digit = remaining % 128;
+    remaining /= 128;
+    if (remaining > 0) digit |= 0x80;
+    put(out, digit);
+  } while (remaining > 0);
+}
+
+}  // namespace
+
+MqttStatus parse_mqtt_packet(std::span<const std::byte> in, MqttPacket& out, std::size_t& packet_bytes) {
+  if (in.size() < 2) return MqttStatus::Incomplete;
+  std::size_t remaining = 0;
+  std::size_t pos = 1;
+  for (std::size_t shift = 0;; shift += 7) {
+    if (pos == in.size()) return MqttStatus::Incomplete;
+    if (pos > 4) return MqttStatus::Malformed;
+    const std::uint8_t digit = byte_at(in, pos++);
+    remaining |= static_cast<std::size_t>(digit & 0x7f) << shift;
+    if (!(digit & 0x80)) break;
+  }
+  if (remaining > kMaxRemainingLength) return MqttStatus::Malformed;
+  const std::uint8_t type = byte_at(in, 0) >> 4;
+  if (type == 0 || type == 15) return MqttStatus::Malformed;
+  if (in.size() - pos < remaining) return MqttStatus::Incomplete;
+  out.type = static_cast<MqttType>(type);
+  out.flags = byte_at(in, 0) & 0x0f;
+  out.body = in.subspan(pos, remaining);
+  packet_bytes = pos + remaining;
+  return MqttStatus::Ok;
+}
+
+bool parse_mqtt_publish(const MqttPacket& packet, MqttPublish& out) {
+  const std::span<const std::byte> b = packet.body;
+  if (packet.type != MqttType::Publish || b.size() < 2) return false;
+  const std::size_t topic_len = load_be16(b, 0);
+  out.qos = (packet.flags >> 1) & 3;
+  const std::size_t header = 2 + topic_len + (out.qos > 0 ? 2 : 0);
+  if (out.qos == 3 || b.size() < header) return false;
+  out.topic = {reinterpret_cast<const char*>(b.data() + 2), topic_len};
+  out.packet_id = out.qos > 0 ? load_be16(b, 2 + topic_len) : 0;
+  out.payload = b.subspan(header);
+  return true;
+}
+
+bool parse_mqtt_packet_id(const MqttPacket& packet, std::uint16_t& id) {
+  if (packet.body.size() < 2) return false;
+  id = load_be16(packet.body, 0);
+  return true;
+}
+
+std::size_t count_mqtt_subscriptions(const MqttPacket& packet) {
+  const std::span<const std::byte> b = packet.body;
+  std::size_t count = 0;
+  // Each filter is a length-prefixed string followed by a requested QoS.
+  for (std::size_t pos = 2; pos + 2 <= b.size();) {
+    pos += 2 + load_be16(b, pos) + 1;
+    if (pos > b.size()) break;
+    ++count;
+  }
+  return count;
+}
+
+void encode_mqtt_connect(std::string_view client_id, std::uint16_t keepalive_s, std::vector<std::byte>& out) {
+  put_fixed_header(out, MqttType::Connect, 0, 10 + 2 + client_id.size());
+  put_string(out, "MQTT");
+  put(out, 4);     // protocol level 3.1.1
+  put(out, 0x02);  // clean session
+  put_be16(out, keepalive_s);
+  put_string(out, client_id);
+}
+
+void encode_mqtt_connack(std::vector<std::byte>& out) {
+  put_fixed_header(out, MqttType::Connack, 0, 2);
+  put(out, 0);  // no session present
+  put(out, 0);  // accepted
+}
+
+void encode_mqtt_publish(std::string_view topic, std::span<const std::byte> payload, std::uint8_t qos,
+                         std::uint16_t packet_id, std::vector<std::byte>& out) {
+  put_fixed_header(out, MqttType::Publish, static_cast<std::uint8_t>(qos << 1),
+                   2 + topic.size() + (qos > 0 ? 2 : 0) + payload.size());
+  put_string(out, topic);
+  if (qos > 0) put_be16(out, packet_id);
+  out.insert(out.end(), payload.begin(), payload.end());
+}
+
+void encode_mqtt_ack(MqttType type, std::uint16_t packet_id, std::vector<std::byte>& out) {
+  put_fixed_header(out, type, type == MqttType::Pubrel ? 0x02 : 0, 2);
+  put_be16(out, packet_id);
+}
+
+void encode_mqtt_suback_failures(std::uint16_t packet_id, std::size_t topics, std::vector<std::byte>& out) {
+  put_fixed_header(out, MqttType::Suback, 0, 2 + topics);
+  put_be16(out, packet_id);
+  for (std::size_t i = 0; i < topics; ++i) put(out, 0x80);
+}
+
+void encode_mqtt_pingresp(std::vector<std::byte>& out) { put_fixed_header(out, MqttType::Pingresp, 0, 0); }
+
+}  // namespace evac
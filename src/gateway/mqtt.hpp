@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace evac {
+
+// The slice of MQTT 3.1.1 a sensor gateway needs from the ingest side:
+// devices CONNECT, PUBLISH readings at QoS 0, 1 or 2, PINGREQ and
+// DISCONNECT. We are never a publisher, so SUBSCRIBE is answered with
+// failure codes. Topics:
+//
+//   evac/sensor/<id>   payload: the reading as decimal text, e.g. "0.35"
+//   evac/frame         payload: a binary gateway frame (ingest/sensor_event.hpp)
+enum class MqttType : std::uint8_t {
+  Connect = 1,
+  Connack = 2,
+  Publish = 3,
+  Puback = 4,
+  Pubrec = 5,
+  Pubrel = 6,
+  Pubcomp = 7,
+  Subscribe = 8,
+  Suback = 9,
+  Pingreq = 12,
+  Pingresp = 13,
+  Disconnect = 14,
+};
+
+enum class MqttStatus { Ok, Incomplete, Malformed };
+
+struct MqttPacket {
+  MqttType type = MqttType::Connect;
+  std::uint8_t flags = 0;
+  std::span<const std::byte> body;  // variable header and payload
+};
+
+// Frames one control packet at the start of `in`.
+MqttStatus parse_mqtt_packet(std::span<const std::byte> in, MqttPacket& out, std::size_t& packet_bytes);
+
+struct MqttPublish {
+  std::string_view topic;
+  std::uint8_t qos = 0;
+  std::uint16_t packet_id = 0;  // QoS 1 and 2 only
+  std::span<const std::byte> payload;
+};
+
+bool parse_mqtt_publish(const MqttPacket& packet, MqttPublish& out);
+// The 16-bit packet id that starts PUBREL and SUBSCRIBE bodies.
+bool parse_mqtt_packet_id(const MqttPacket& packet, std::uint16_t& id);
+// Number of topic filters in a SUBSCRIBE body, for the SUBACK.
+std::size_t count_mqtt_subscriptions(const MqttPacket& packet);
+
+// Encoders append one whole packet to `out`.
+void encode_mqtt_connect(std::string_view client_id, std::uint16_t keepalive_s, std::vector<std::byte>& out);
+void encode_mqtt_connack(std::vector<std::byte>& out);
+void encode_mqtt_publish(std::string_view topic, std::span<const std::byte> payload, std::uint8_t qos,
+                         std::uint16_t packet_id, std::vector<std::byte>& out);
+// PUBACK, PUBREC, PUBREL and PUBCOMP: a type and a packet id.
+void encode_mqtt_ack(MqttType type, std::uint16_t packet_id, std::vector<std::byte>& out);
+void encode_mqtt_suback_failures(std::uint16_t packet_id, std::size_t topics, std::vector<std::byte>& out);
+void encode_mqtt_pingresp(std::vector<std::byte>& out);
+
+}  // namespace evac
@@ -0,0 +1,217 @@
+#include "graph/building_graph.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace evac {
+namespace {
+
+// Heap storage behind a built graph.
+struct OwnedColumns {
+  std::vector<EdgeId> row_offsets;
+  std::vector<NodeId> edge_source;
+  std::vector<NodeId> edge_target;
+  std::vector<EdgeId> edge_twin;
+  std::vector<EdgeId> in_offsets;
+  std::vector<EdgeId> in_edges;
+  std::vector<EdgeKind> edge_kind;
+  std::vector<float> edge_length;
+  std::vector<float> edge_capacity;
+  std::vector<NodeKind> node_kind;
+  std::vector<std::int16_t> node_floor;
+  std::vector<float> node_x;
+  std::vector<float> node_y;
+  std::vector<std::uint32_t> node_capacity;
+  std::vector<NodeId> exits;
+};
+
+}  // namespace
+
+const char* to_string(NodeKind kind) {
+  switch (kind) {
+    case NodeKind::Room: return "room";
+    case NodeKind::Corridor: return "corridor";
+    case NodeKind::Stairwell: return "stairwell";
+    case NodeKind::Elevator: return "elevator";
+    case NodeKind::Exit: return "exit";
+  }
+  return "?";
+}
+
+const char* to_string(EdgeKind kind) {
+  switch (kind) {
+    case EdgeKind::Corridor: return "corridor";
+    case EdgeKind::Door: return "door";
+    case EdgeKind::Stairs: return "stairs";
+    case EdgeKind::Elevator: return "elevator";
+    case EdgeKind::Ramp: return "ramp";
+  }
+  return "?";
+}
+
+BuildingGraph BuildingGraph::adopt(const GraphColumns& c, std::span<const float> hazards,
+                                   std::shared_ptr<const void> storage) {
+  BuildingGraph g;
+  g.storage_ = std::move(storage);
+  g.row_offsets_ = c.row_offsets;
+  g.edge_source_ = c.edge_source;
+  g.edge_target_ = c.edge_target;
+  g.edge_twin_ = c.edge_twin;
+  g.in_offsets_ = c.in_offsets;
+  g.in_edges_ = c.in_edges;
+  g.edge_kind_ = c.edge_kind;
+  g.edge_length_ = c.edge_length;
+  g.edge_capacity_ = c.edge_capacity;
+  g.edge_hazard_.assign(hazards.begin(), hazards.end());
+  g.edge_hazard_.resize(c.edge_target.size(), 0.0f);
+  g.edge_congestion_.assign(c.edge_target.size(), 0.0f);
+  g.node_kind_ = c.node_kind;
+  g.node_floor_ = c.node_floor;
+  g.node_x_ = c.node_x;
+  g.node_y_ = c.node_y;
+  g.node_capacity_ = c.node_capacity;
+  g.exits_ = c.exits;
+  g.floor_count_ = c.floor_count;
+  g.min_floor_ = c.min_floor;
+  return g;
+}
+
+GraphColumns BuildingGraph::columns() const {
+  return {row_offsets_, edge_source_, edge_target_, edge_twin_, in_offsets_, in_edges_,
+          edge_kind_, edge_length_, edge_capacity_, node_kind_, node_floor_, node_x_,
+          node_y_, node_capacity_, exits_, floor_count_, min_floor_};
+}
+
+EdgeId BuildingGraph::find_edge(NodeId from, NodeId to) const {
+  for (EdgeId e : out_edges(from)) {
+    if (edge_target_[e] == to) return e;
+  }
+  return kInvalidEdge;
+}
+
+void GraphBuilder::reserve(std::size_t nodes, std::size_t connections) {
+  nodes_.reserve(nodes);
+  arcs_.reserve(2 * connections);
+  twins_.reserve(2 * connections);
+}
+
+NodeId GraphBuilder::add_node(const NodeSpec& spec) {
+  nodes_.push_back(spec);
+  return static_cast<NodeId>(nodes_.size() - 1);
+}
+
+void GraphBuilder::add_connection(NodeId a, NodeId b, EdgeKind kind, float length_m,
+                                  float capacity_pps) {
+  const auto first = static_cast<EdgeId>(arcs_.size());
+  arcs_.push_back({a, b, kind, length_m, capacity_pps});
+  arcs_.push_back({b, a, kind, length_m, capacity_pps});
+  twins_.push_back(first + 1);
+  twins_.push_back(first);
+}
+
+void GraphBuilder::add_arc(const EdgeSpec& spec) {
+  arcs_.push_back(spec);
+  twins_.push_back(kInvalidEdge);
+}
+
+BuildingGraph GraphBuilder::build() && {
+  const std::size_t n = nodes_.size();
+  const std::size_t m = arcs_.size();
+  if (m >= kInvalidEdge || n >= kInvalidNode) {
+    throw std::invalid_argument("building graph too large for 32-bit ids");
+  }
+  for (std::size_t i = 0; i < m; ++i) {
+    const EdgeSpec& a = arcs_[i];
+    if (a.from >= n || a.to >= n) {
+      throw std::invalid_argument("arc " + std::to_string(i) + " references unknown node");
+    }
+    if (!(a.length_m >= 0.0f) || !(a.capacity_pps >= 0.0f)) {
+      throw std::invalid_argument("arc " + std::to_string(i) + " has negative length or capacity");
+    }
+  }
+
+  auto owned = std::make_shared<OwnedColumns>();
+  OwnedColumns& c = *owned;
+
+  // Forward CSR: counting sort of arcs by source. Stable, so parallel arcs keep
+  // their insertion order and the layout is reproducible.
+  c.row_offsets.assign(n + 1, 0);
+  for (const EdgeSpec& a : arcs_) ++c.row_offsets[a.from + 1];
+  for (std::size_t v = 0; v < n; ++v) c.row_offsets[v + 1] += c.row_offsets[v];
+
+  std::vector<EdgeId> slot(c.row_offsets.begin(), c.row_offsets.end() - 1);
+  std::vector<EdgeId> position(m);  // arc index -> edge id
+  for (std::size_t i = 0; i < m; ++i) position[i] = slot[arcs_[i].from]++;
+
+  c.edge_source.resize(m);
+  c.edge_target.resize(m);
+  c.edge_twin.resize(m);
+  c.edge_kind.resize(m);
+  c.edge_length.resize(m);
+  c.edge_capacity.resize(m);
+  for (std::size_t i = 0; i < m; ++i) {
+    const EdgeId e = position[i];
+    const EdgeSpec& a = arcs_[i];
+    c.edge_source[e] = a.from;
+    c.edge_target[e] = a.to;
+    c.edge_twin[e] = twins_[i] == kInvalidEdge ? kInvalidEdge : position[twins_[i]];
+    c.edge_kind[e] = a.kind;
+    c.edge_length[e] = a.length_m;
+    c.edge_capacity[e] = a.capacity_pps;
+  }
+
+  // Reverse CSR: counting sort of forward edge ids by target.
+  c.in_offsets.assign(n + 1, 0);
+  for (std::size_t e = 0; e < m; ++e) ++c.in_offsets[c.edge_target[e] + 1];
+  for (std::size_t v = 0; v < n; ++v) c.in_offsets[v + 1] += c.in_offsets[v];
+  slot.assign(c.in_offsets.begin(), c.in_offsets.end() - 1);
+  c.in_edges.resize(m);
+  for (std::size_t e = 0; e < m; ++e) c.in_edges[slot[c.edge_target[e]]++] = static_cast<EdgeId>(e);
+
+  c.node_kind.resize(n);
+  c.node_floor.resize(n);
+  c.node_x.resize(n);
+  c.node_y.resize(n);
+  c.node_capacity.resize(n);
+  std::int16_t lo = 0;
+  std::int16_t hi = -1;
+  for (std::size_t v = 0; v < n; ++v) {
+    const NodeSpec& s = nodes_[v];
+    c.node_kind[v] = s.kind;
+    c.node_floor[v] = s.floor;
+    c.node_x[v] = s.x;
+    c.node_y[v] = s.y;
+    c.node_capacity[v] = s.capacity;
+    if (s.kind == NodeKind::Exit) c.exits.push_back(static_cast<NodeId>(v));
+    if (v == 0 || s.floor < lo) lo = s.floor;
+    if (v == 0 || s.floor > hi) hi = s.floor;
+  }
+  GraphColumns columns;
+  columns.row_offsets = c.row_offsets;
+  columns.edge_source = c.edge_source;
+  columns.edge_target = c.edge_target;
+  columns.edge_twin = c.edge_twin;
+  columns.in_offsets = c.in_offsets;
+  columns.in_edges = c.in_edges;
+  columns.edge_kind = c.edge_kind;
+  columns.edge_length = c.edge_length;
+  columns.edge_capacity = c.edge_capacity;
+  columns.node_kind = c.node_kind;
+  columns.node_floor = c.node_floor;
+  columns.node_x = c.node_x;
+  columns.node_y = c.node_y;
+  columns.node_capacity = c.node_capacity;
+  columns.exits = c.exits;
+  columns.floor_count = n == 0 ? 0 : hi - lo + 1;
+  columns.min_floor = lo;
+  BuildingGraph g = BuildingGraph::adopt(columns, {}, std::move(owned));
+
+  nodes_.clear();
+  arcs_.clear();
+  twins_.clear();
+  return g;
+}
+
+}  // namespace evac
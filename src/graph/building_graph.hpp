@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace evac {
+
+using NodeId = std::uint32_t;
+using EdgeId = std::uint32_t;
+
+inline constexpr NodeId kInvalidNode = std::numeric_limits<NodeId>::max();
+inline constexpr EdgeId kInvalidEdge = std::numeric_limits<EdgeId>::max();
+
+enum class NodeKind : std::uint8_t { Room, Corridor, Stairwell, Elevator, Exit };
+enum class EdgeKind : std::uint8_t { Corridor, Door, Stairs, Elevator, Ramp };
+
+const char* to_string(NodeKind kind);
+const char* to_string(EdgeKind kind);
+
+struct NodeSpec {
+  NodeKind kind = NodeKind::Room;
+  std::int16_t floor = 0;
+  float x = 0.0f;  // metres, floor-local coordinates
+  float y = 0.0f;
+  std::uint32_t capacity = 0;  // max simultaneous occupants, 0 = unbounded
+};
+
+struct EdgeSpec {
+  NodeId from = kInvalidNode;
+  NodeId to = kInvalidNode;
+  EdgeKind kind = EdgeKind::Corridor;
+  float length_m = 0.0f;
+  float capacity_pps = 0.0f;  // throughput in persons per second, 0 = unconstrained
+};
+
+// Half-open range of edge ids; out-edges of a node are contiguous in CSR order.
+struct EdgeRange {
+  EdgeId first = 0;
+  EdgeId last = 0;
+
+  struct iterator {
+    EdgeId e;
+    EdgeId operator*() const { return e; }
+    iterator& operator++() {
+      ++e;
+      return *this;
+    }
+    bool operator!=(const iterator& o) const { return e != o.e; }
+  };
+  iterator begin() const { return {first}; }
+  iterator end() const { return {last}; }
+  std::size_t size() const { return last - first; }
+  bool empty() const { return first == last; }
+};
+
+// Read-only columns of a graph as views into storage owned elsewhere: the
+// builder's heap arrays or a memory-mapped model file (see model/).
+struct GraphColumns {
+  std::span<const EdgeId> row_offsets;  // node_count + 1
+  std::span<const NodeId> edge_source;
+  std::span<const NodeId> edge_target;
+  std::span<const EdgeId> edge_twin;
+  std::span<const EdgeId> in_offsets;   // node_count + 1
+  std::span<const EdgeId> in_edges;
+  std::span<const EdgeKind> edge_kind;
+  std::span<const float> edge_length;
+  std::span<const float> edge_capacity;
+  std::span<const NodeKind> node_kind;
+  std::span<const std::int16_t> node_floor;
+  std::span<const float> node_x;
+  std::span<const float> node_y;
+  std::span<const std::uint32_t> node_capacity;
+  std::span<const NodeId> exits;
+  int floor_count = 0;
+  std::int16_t min_floor = 0;
+};
+
+// Building topology as a directed CSR graph. Every walkable connection is stored
+// as two arcs (one per direction) so each arc can carry its own hazard and so
+// contraflow can close one direction only. Node and edge attributes live in
+// parallel arrays indexed by NodeId / EdgeId: a relaxation touches the offsets,
+// the target and the one or two attribute arrays it needs and nothing else.
+//
+// Topology is immutable after build(); hazard and congestion are the only
+// mutable fields and are owned by whichever thread owns the graph (the routing
+// thread). The immutable columns are shared: copies of a graph (and every
+// process mapping the same model file) point at one set of arrays, while each
+// copy has its own hazards and congestion.
+class BuildingGraph {
+ public:
+  BuildingGraph() = default;
+
+  // Wraps existing columns without copying them. `storage` keeps the memory
+  // behind the spans alive; `hazards` seeds the private hazard column.
+  static BuildingGraph adopt(const GraphColumns& columns, std::span<const float> hazards,
+                             std::shared_ptr<const void> storage);
+  GraphColumns columns() const;
+
+  std::size_t node_count() const { return node_kind_.size(); }
+  std::size_t edge_count() const { return edge_target_.size(); }
+
+  EdgeRange out_edges(NodeId u) const { return {row_offsets_[u], row_offsets_[u + 1]}; }
+  // Incoming arcs of v as forward edge ids, for reverse (exit-rooted) searches.
+  std::span<const EdgeId> in_edges(NodeId v) const {
+    return {in_edges_.data() + in_offsets_[v], in_offsets_[v + 1] - in_offsets_[v]};
+  }
+
+  NodeId edge_source(EdgeId e) const { return edge_source_[e]; }
+  NodeId edge_target(EdgeId e) const { return edge_target_[e]; }
+  // Opposite-direction arc of the same connection, or kInvalidEdge for one-way arcs.
+  EdgeId edge_twin(EdgeId e) const { return edge_twin_[e]; }
+  EdgeKind edge_kind(EdgeId e) const { return edge_kind_[e]; }
+  float edge_length(EdgeId e) const { return edge_length_[e]; }
+  float edge_capacity(EdgeId e) const { return edge_capacity_[e]; }
+  // 0 = clear, 1 = impassable.
+  float edge_hazard(EdgeId e) const { return edge_hazard_[e]; }
+  void set_edge_hazard(EdgeId e, float hazard) { edge_hazard_[e] = hazard; }
+  // Expected queueing delay in front of the arc in seconds, from live
+  // occupancy; 0 when nobody is waiting. Never persisted in a model.
+  float edge_congestion(EdgeId e) const { return edge_congestion_[e]; }
+  void set_edge_congestion(EdgeId e, float delay_s) { edge_congestion_[e] = delay_s; }
+  // Linear scan over the source's out-edges; out-degree in floor plans is small.
+  EdgeId find_edge(NodeId from, NodeId to) const;
+
+  NodeKind node_kind(NodeId v) const { return node_kind_[v]; }
+  std::int16_t node_floor(NodeId v) const { return node_floor_[v]; }
+  float node_x(NodeId v) const { return node_x_[v]; }
+  float node_y(NodeId v) const { return node_y_[v]; }
+  std::uint32_t node_capacity(NodeId v) const { return node_capacity_[v]; }
+
+  std::span<const NodeId> exits() const { return exits_; }
+  int floor_count() const { return floor_count_; }
+  std::int16_t min_floor() const { return min_floor_; }
+
+  // Raw column views for kernels that sweep whole arrays.
+  std::span<const EdgeId> row_offsets() const { return row_offsets_; }
+  std::span<const NodeId> edge_targets() const { return edge_target_; }
+  std::span<const float> edge_lengths() const { return edge_length_; }
+  std::span<const float> edge_capacities() const { return edge_capacity_; }
+  std::span<const float> edge_hazards() const { return edge_hazard_; }
+  std::span<float> edge_hazards() { return edge_hazard_; }
+  std::span<const float> edge_congestions() const { return edge_congestion_; }
+
+ private:
+  std::shared_ptr<const void> storage_;
+
+  // CSR forward adjacency.
+  std::span<const EdgeId> row_offsets_;  // node_count + 1
+  std::span<const NodeId> edge_source_;
+  std::span<const NodeId> edge_target_;
+  std::span<const EdgeId> edge_twin_;
+  // CSR reverse adjacency, storing forward edge ids so attributes are shared.
+  std::span<const EdgeId> in_offsets_;  // node_count + 1
+  std::span<const EdgeId> in_edges_;
+
+  // Edge attributes (struct of arrays).
+  std::span<const EdgeKind> edge_kind_;
+  std::span<const float> edge_length_;
+  std::span<const float> edge_capacity_;
+  std::vector<float> edge_hazard_;
+  std::vector<float> edge_congestion_;
+
+  // Node attributes (struct of arrays).
+  std::span<const NodeKind> node_kind_;
+  std::span<const std::int16_t> node_floor_;
+  std::span<const float> node_x_;
+  std::span<const float> node_y_;
+  std::span<const std::uint32_t> node_capacity_;
+
+  std::span<const NodeId> exits_;
+  int floor_count_ = 0;
+  std::int16_t min_floor_ = 0;
+};
+
+// Collects nodes and connections in any order and produces the CSR layout with
+// two counting sorts (by source, then by target for the reverse index).
+class GraphBuilder {
+ public:
+  void reserve(std::size_t nodes, std::size_t connections);
+
+  NodeId add_node(const NodeSpec& spec);
+  // Walkable in both directions: adds two twin arcs.
+  void add_connection(NodeId a, NodeId b, EdgeKind kind, float length_m, float capacity_pps);
+  // One-way arc (e.g. a turnstile or a down-only escalator).
+  void add_arc(const EdgeSpec& spec);
+
+  std::size_t node_count() const { return nodes_.size(); }
+  std::size_t arc_count() const { return arcs_.size(); }
+
+  // Throws std::invalid_argument on dangling node ids or negative lengths.
+  BuildingGraph build() &&;
+
+ private:
+  std::vector<NodeSpec> nodes_;
+  std::vector<EdgeSpec> arcs_;
+  std::vector<EdgeId> twins_;  // per arc, index of the twin arc in arcs_
+};
+
+}  // namespace evac
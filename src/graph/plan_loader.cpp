@@ -0,0 +1,84 @@
+#include "graph/plan_loader.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace evac {
+namespace {
+
+[[noreturn]] void fail(const std::string& source, std::size_t line, const std::string& what) {
+  throw std::runtime_error(source + ":" + std::to_string(line) + ": " + what);
+}
+
+bool parse_node_kind(const std::string& s, NodeKind& out) {
+  for (NodeKind k : {NodeKind::Room, NodeKind::Corridor, NodeKind::Stairwell, NodeKind::Elevator,
+                     NodeKind::Exit}) {
+    if (s == to_string(k)) {
+      out = k;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parse_edge_kind(const std::string& s, EdgeKind& out) {
+  for (EdgeKind k : {EdgeKind::Corridor, EdgeKind::Door, EdgeKind::Stairs, EdgeKind::Elevator,
+                     EdgeKind::Ramp}) {
+    if (s == to_string(k)) {
+      out = k;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+BuildingGraph load_plan_text(std::istream& in, const std::string& source_name) {
+  GraphBuilder builder;
+  std::string line;
+  std::size_t line_no = 0;
+  while (std::getline(in, line)) {
+    ++line_no;
+    if (auto hash = line.find('#'); hash != std::string::npos) line.resize(hash);
+    std::istringstream fields(line);
+    std::string record;
+    if (!(fields >> record)) continue;
+
+    if (record == "node") {
+      std::string kind;
+      NodeSpec spec;
+      if (!(fields >> kind >> spec.floor >> spec.x >> spec.y)) fail(source_name, line_no, "malformed node");
+      if (!parse_node_kind(kind, spec.kind)) fail(source_name, line_no, "unknown node kind '" + kind + "'");
+      fields >> spec.capacity;
+      builder.add_node(spec);
+    } else if (record == "edge" || record == "arc") {
+      std::string kind;
+      EdgeSpec spec;
+      if (!(fields >> spec.from >> spec.to >> kind >> spec.length_m >> spec.capacity_pps)) {
+        fail(source_name, line_no, "malformed " + record);
+      }
+      if (!parse_edge_kind(kind, spec.kind)) fail(source_name, line_no, "unknown edge kind '" + kind + "'");
+      if (spec.from >= builder.node_count() || spec.to >= builder.node_count()) {
+        fail(source_name, line_no, record + " references a node that is not declared yet");
+      }
+      if (record == "edge") {
+        builder.add_connection(spec.from, spec.to, spec.kind, spec.length_m, spec.capacity_pps);
+      } else {
+        builder.add_arc(spec);
+      }
+    } else {
+      fail(source_name, line_no, "unknown record '" + record + "'");
+    }
+  }
+  return std::move(builder).build();
+}
+
+BuildingGraph load_plan_file(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot open plan file " + path);
+  return load_plan_text(in, path);
+}
+
+}  // namespace evac
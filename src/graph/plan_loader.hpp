@@ -0,0 +1,22 @@
+#pragma once
+
+#include <istream>
+#include <string>
+
+#include "graph/building_graph.hpp"
+
+namespace evac {
+
+// Line-oriented floor-plan text format, one record per line, '#' comments:
+//
+//   node <kind> <floor> <x> <y> [capacity]
+//   edge <a> <b> <kind> <length_m> <capacity_pps>        (bidirectional)
+//   arc  <a> <b> <kind> <length_m> <capacity_pps>        (one-way)
+//
+// Node ids are implicit: the n-th node record is id n-1. Kinds are the
+// to_string() names of NodeKind / EdgeKind. Errors throw std::runtime_error
+// naming the offending line.
+BuildingGraph load_plan_text(std::istream& in, const std::string& source_name = "<stream>");
+BuildingGraph load_plan_file(const std::string& path);
+
+}  // namespace evac
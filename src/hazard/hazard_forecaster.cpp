@@ -0,0 +1,144 @@
+#include "hazard/hazard_forecaster.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "ingest/sensor_map.hpp"
+#include "telemetry/trace.hpp"
+
+namespace evac {
+namespace {
+
+float hazard_of(float smoke, float heat_rise) {
+  constexpr float kAmbient = 20.0f;
+  return std::max(hazard_from_reading(SensorKind::Smoke, smoke),
+                  hazard_from_reading(SensorKind::Heat, kAmbient + heat_rise));
+}
+
+}  // namespace
+
+HazardForecaster::HazardForecaster(const BuildingGraph& g, SmokeParams params, ForecastOptions options)
+    : graph_(g), options_(options), live_(g, params), scratch_(live_) {
+  const std::size_t m = g.edge_count();
+  samples_.reserve(m * kSamplesPerEdge);
+  for (EdgeId e = 0; e < m; ++e) {
+    const NodeId u = g.edge_source(e);
+    const NodeId v = g.edge_target(e);
+    // Cross-floor arcs sample the midpoint on the lower floor, where the
+    // stairwell door is reached first.
+    const std::int16_t mid_floor = std::min(g.node_floor(u), g.node_floor(v));
+    samples_.push_back({g.node_floor(u), g.node_x(u), g.node_y(u)});
+    samples_.push_back({mid_floor, 0.5f * (g.node_x(u) + g.node_x(v)), 0.5f * (g.node_y(u) + g.node_y(v))});
+    samples_.push_back({g.node_floor(v), g.node_x(v), g.node_y(v)});
+  }
+  published_.assign(m, 0.0f);
+  latest_.assign(m, 0.0f);
+  dirty_.assign(m, 0);
+  cycle_hazard_.assign(m, 0.0f);
+}
+
+HazardForecaster::~HazardForecaster() { stop(); }
+
+void HazardForecaster::start() {
+  if (running_.exchange(true)) return;
+  thread_ = std::thread([this] { worker(); });
+}
+
+void HazardForecaster::stop() {
+  if (!running_.exchange(false)) return;
+  thread_.join();
+}
+
+void HazardForecaster::add_source(const SmokeSource& source) {
+  std::lock_guard lock(inbox_mutex_);
+  pending_sources_.push_back(source);
+}
+
+void HazardForecaster::observe_smoke(EdgeId e, float level) {
+  std::lock_guard lock(inbox_mutex_);
+  pending_observations_.emplace_back(e, level);
+}
+
+float HazardForecaster::predicted_hazard(const SmokeModel& model, EdgeId e) const {
+  float worst = 0.0f;
+  for (std::size_t k = 0; k < kSamplesPerEdge; ++k) {
+    const Sample& s = samples_[e * kSamplesPerEdge + k];
+    worst = std::max(worst, hazard_of(model.smoke_at(s.floor, s.x, s.y), model.heat_at(s.floor, s.x, s.y)));
+  }
+  return worst;
+}
+
+void HazardForecaster::run_cycle() {
+  EVAC_TRACE_SPAN(TraceStage::Hazard);
+  const auto t0 = std::chrono::steady_clock::now();
+  {
+    std::lock_guard lock(inbox_mutex_);
+    for (const SmokeSource& s : pending_sources_) live_.add_source(s);
+    for (const auto& [e, level] : pending_observations_) {
+      const NodeId u = graph_.edge_source(e);
+      const NodeId v = graph_.edge_target(e);
+      live_.observe_smoke(graph_.node_floor(u), 0.5f * (graph_.node_x(u) + graph_.node_x(v)),
+                          0.5f * (graph_.node_y(u) + graph_.node_y(v)), level);
+    }
+    pending_sources_.clear();
+    pending_observations_.clear();
+  }
+
+  live_.advance(options_.cadence_seconds);
+  for (EdgeId e = 0; e < cycle_hazard_.size(); ++e) cycle_hazard_[e] = predicted_hazard(live_, e);
+  scratch_ = live_;
+  scratch_.advance(options_.horizon_seconds);
+  for (EdgeId e = 0; e < cycle_hazard_.size(); ++e) {
+    cycle_hazard_[e] = std::max(cycle_hazard_[e], predicted_hazard(scratch_, e));
+  }
+
+  // Publishing only walks the arcs; the model work above is done unlocked.
+  {
+    std::lock_guard lock(outbox_mutex_);
+    for (EdgeId e = 0; e < cycle_hazard_.size(); ++e) {
+      const float h = cycle_hazard_[e];
+      latest_[e] = h;
+      const bool moved = std::fabs(h - published_[e]) >= options_.min_change ||
+                         (h != published_[e] && (h == 0.0f || h == 1.0f));
+      if (moved && !dirty_[e]) {
+        dirty_[e] = 1;
+        dirty_edges_.push_back(e);
+      }
+    }
+  }
+  active_blocks_.store(live_.active_blocks(), std::memory_order_relaxed);
+  cycle_ms_.store(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count(),
+                  std::memory_order_relaxed);
+  cycles_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool HazardForecaster::poll(std::vector<HazardUpdate>& out) {
+  std::unique_lock lock(outbox_mutex_, std::try_to_lock);
+  if (!lock.owns_lock() || dirty_edges_.empty()) return false;
+  for (const EdgeId e : dirty_edges_) {
+    dirty_[e] = 0;
+    if (latest_[e] == published_[e]) continue;
+    published_[e] = latest_[e];
+    out.push_back({e, latest_[e]});
+  }
+  dirty_edges_.clear();
+  return true;
+}
+
+void HazardForecaster::worker() {
+  using Clock = std::chrono::steady_clock;
+  auto next = Clock::now();
+  while (running_.load(std::memory_order_acquire)) {
+    run_cycle();
+    if (options_.time_scale <= 0.0f) continue;
+    next += std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options_.cadence_seconds / options_.time_scale));
+    // Sleep in short slices so stop() stays responsive at slow time scales.
+    while (running_.load(std::memory_order_acquire) && Clock::now() < next) {
+      std::this_thread::sleep_for(std::min<Clock::duration>(next - Clock::now(), std::chrono::milliseconds(20)));
+    }
+  }
+}
+
+}  // namespace evac
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "hazard/smoke_model.hpp"
+#include "ingest/ingest_pipeline.hpp"
+
+namespace evac {
+
+struct ForecastOptions {
+  float horizon_seconds = 60.0f;  // how far ahead predicted hazards look
+  float cadence_seconds = 5.0f;   // model time between published forecasts
+  // Model seconds per wall-clock second; 0 runs cycles back to back (replay, tests).
+  float time_scale = 1.0f;
+  float min_change = 0.02f;       // smaller hazard moves are not republished
+};
+
+// Predicted smoke and heat hazard per arc, kept fresh on a background thread.
+// Every cycle the worker advances the live SmokeModel by one cadence, folds in
+// sources and observations queued since the last cycle, then runs a copy of
+// the model `horizon_seconds` ahead. An arc's predicted hazard is the worst of
+// now and the horizon, sampled at both endpoints and the midpoint.
+//
+// The routing thread never waits on the worker: poll() uses try_lock and
+// simply comes back empty if a forecast is being published at that moment.
+// Changes are coalesced per arc until polled, so a slow consumer only ever
+// sees the latest value.
+class HazardForecaster {
+ public:
+  HazardForecaster(const BuildingGraph& g, SmokeParams params = {}, ForecastOptions options = {});
+  ~HazardForecaster();
+  HazardForecaster(const HazardForecaster&) = delete;
+  HazardForecaster& operator=(const HazardForecaster&) = delete;
+
+  void start();
+  void stop();
+
+  // Any thread; applied at the start of the next cycle.
+  void add_source(const SmokeSource& source);
+  void observe_smoke(EdgeId e, float level);
+
+  // Routing thread. Appends arcs whose predicted hazard changed since the last
+  // poll; returns false when nothing was taken.
+  bool poll(std::vector<HazardUpdate>& out);
+
+  // Runs one cycle on the calling thread (only while stopped).
+  void run_cycle();
+
+  std::uint64_t cycles() const { return cycles_.load(std::memory_order_relaxed); }
+  std::size_t last_active_blocks() const { return active_blocks_.load(std::memory_order_relaxed); }
+  std::size_t total_blocks() const { return live_.total_blocks(); }
+  double last_cycle_ms() const { return cycle_ms_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Sample {
+    std::int16_t floor;
+    float x;
+    float y;
+  };
+  static constexpr std::size_t kSamplesPerEdge = 3;
+
+  float predicted_hazard(const SmokeModel& model, EdgeId e) const;
+  void worker();
+
+  const BuildingGraph& graph_;
+  ForecastOptions options_;
+  SmokeModel live_;
+  SmokeModel scratch_;  // forecast copy, reused between cycles
+  std::vector<Sample> samples_;  // kSamplesPerEdge per arc
+
+  std::mutex inbox_mutex_;
+  std::vector<SmokeSource> pending_sources_;
+  std::vector<std::pair<EdgeId, float>> pending_observations_;
+
+  std::mutex outbox_mutex_;
+  std::vector<float> published_;      // per arc, last value handed to the router
+  std::vector<float> latest_;         // per arc, newest forecast (outbox side)
+  std::vector<std::uint8_t> dirty_;
+  std::vector<EdgeId> dirty_edges_;
+  std::vector<float> cycle_hazard_;   // worker side
+
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  std::atomic<std::uint64_t> cycles_{0};
+  std::atomic<std::size_t> active_blocks_{0};
+  std::atomic<double> cycle_ms_{0.0};
+};
+
+// Router-side fold of the two hazard sources for an arc: measured (sensors)
+// and predicted (forecaster). The effective hazard is the worse of the two,
+// and only changes of the effective value need to reach the router.
+class HazardBlend {
+ public:
+  explicit HazardBlend(std::size_t edge_count) : sensor_(edge_count, 0.0f), forecast_(edge_count, 0.0f) {}
+
+  float effective(EdgeId e) const { return sensor_[e] > forecast_[e] ? sensor_[e] : forecast_[e]; }
+
+  // Both return true when the effective hazard of the arc moved.
+  bool set_sensor(EdgeId e, float hazard) { return update(sensor_, e, hazard); }
+  bool set_forecast(EdgeId e, float hazard) { return update(forecast_, e, hazard); }
+
+ private:
+  bool update(std::vector<float>& column, EdgeId e, float hazard) {
+    const float before = effective(e);
+    column[e] = hazard;
+    return effective(e) != before;
+  }
+
+  std::vector<float> sensor_;
+  std::vector<float> forecast_;
+};
+
+}  // namespace evac
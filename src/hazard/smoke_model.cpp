@@ -0,0 +1,266 @@
+#include "hazard/smoke_model.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace evac {
+namespace {
+
+// Keeps a one-block margin of open space around the node bounding box so
+// smoke can spill out of the outermost rooms before reaching the halo.
+constexpr float kMarginCells = 4.0f;
+// Flashover-level gas temperature; burning cells do not heat beyond it.
+constexpr float kMaxHeatRise = 600.0f;
+
+// Coefficients of c' = cc*c + cw*W + ce*E + cs*S + cn*N for diffusion plus
+// first-order upwind drift plus decay. Stability needs cc >= 0.
+void stencil_coefficients(float diffusivity, float decay, float vx, float vy, float h, float dt,
+                          float out[5]) {
+  const float d = diffusivity * dt / (h * h);
+  const float aw = std::max(vx, 0.0f) * dt / h;   // drift +x pulls from the west
+  const float ae = std::max(-vx, 0.0f) * dt / h;
+  const float as = std::max(vy, 0.0f) * dt / h;
+  const float an = std::max(-vy, 0.0f) * dt / h;
+  out[1] = d + aw;
+  out[2] = d + ae;
+  out[3] = d + as;
+  out[4] = d + an;
+  out[0] = 1.0f - 4.0f * d - aw - ae - as - an - decay * dt;
+}
+
+float stable_dt(const SmokeParams& p) {
+  // Explicit scheme: 4*D*dt/h^2 + (|vx| + |vy|)*dt/h <= 1, with some headroom.
+  const float h = p.cell_size;
+  const float d = std::max(p.smoke_diffusivity, p.heat_diffusivity);
+  const float rate = 4.0f * d / (h * h) + (std::fabs(p.drift_x) + std::fabs(p.drift_y)) / h +
+                     std::max(p.smoke_decay, p.heat_decay);
+  const float limit = rate > 0.0f ? 0.9f / rate : p.dt;
+  return std::min(p.dt, limit);
+}
+
+}  // namespace
+
+SmokeModel::SmokeModel(const BuildingGraph& g, SmokeParams params) : params_(params) {
+  params_.dt = stable_dt(params_);
+  const float h = params_.cell_size;
+
+  float lo_x = 0.0f, hi_x = 0.0f, lo_y = 0.0f, hi_y = 0.0f;
+  for (NodeId v = 0; v < g.node_count(); ++v) {
+    const float x = g.node_x(v);
+    const float y = g.node_y(v);
+    if (v == 0 || x < lo_x) lo_x = x;
+    if (v == 0 || x > hi_x) hi_x = x;
+    if (v == 0 || y < lo_y) lo_y = y;
+    if (v == 0 || y > hi_y) hi_y = y;
+  }
+  origin_x_ = lo_x - kMarginCells * h;
+  origin_y_ = lo_y - kMarginCells * h;
+  const auto cells_for = [&](float extent) {
+    const auto n = static_cast<std::uint32_t>(std::ceil(extent / h + 2.0f * kMarginCells));
+    return (std::max<std::uint32_t>(n, 1) + kBlock - 1) / kBlock * kBlock;
+  };
+  cols_ = cells_for(hi_x - lo_x);
+  rows_ = cells_for(hi_y - lo_y);
+  floors_ = std::max<std::uint32_t>(1, g.floor_count());
+  min_floor_ = g.min_floor();
+  stride_ = cols_ + 2;
+  layer_cells_ = static_cast<std::size_t>(rows_ + 2) * stride_;
+  blocks_x_ = cols_ / kBlock;
+  blocks_y_ = rows_ / kBlock;
+
+  const std::size_t cells = layer_cells_ * floors_;
+  smoke_.assign(cells, 0.0f);
+  heat_.assign(cells, 0.0f);
+  smoke_next_.assign(cells, 0.0f);
+  heat_next_.assign(cells, 0.0f);
+  block_active_.assign(static_cast<std::size_t>(blocks_x_) * blocks_y_ * floors_, 0);
+  block_hot_.assign(block_active_.size(), 0);
+
+  stencil_coefficients(params_.smoke_diffusivity, params_.smoke_decay, params_.drift_x,
+                       params_.drift_y, h, params_.dt, smoke_c_);
+  stencil_coefficients(params_.heat_diffusivity, params_.heat_decay, params_.drift_x,
+                       params_.drift_y, h, params_.dt, heat_c_);
+
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    const EdgeKind kind = g.edge_kind(e);
+    if (kind != EdgeKind::Stairs && kind != EdgeKind::Elevator) continue;
+    const NodeId u = g.edge_source(e);
+    const NodeId v = g.edge_target(e);
+    if (g.node_floor(v) != g.node_floor(u) + 1) continue;
+    shafts_.emplace_back(index_of(g.node_floor(u), g.node_x(u), g.node_y(u)),
+                         index_of(g.node_floor(v), g.node_x(v), g.node_y(v)));
+  }
+  std::sort(shafts_.begin(), shafts_.end());
+  shafts_.erase(std::unique(shafts_.begin(), shafts_.end()), shafts_.end());
+}
+
+std::size_t SmokeModel::index_of(std::int16_t floor, float x, float y) const {
+  const auto clamp_axis = [&](float v, std::uint32_t cells) {
+    const float c = std::floor(v / params_.cell_size);
+    if (!(c > 0.0f)) return 0u;
+    return std::min(cells - 1, static_cast<std::uint32_t>(c));
+  };
+  const std::uint32_t col = clamp_axis(x - origin_x_, cols_);
+  const std::uint32_t row = clamp_axis(y - origin_y_, rows_);
+  const auto f = static_cast<std::size_t>(std::clamp<int>(floor - min_floor_, 0, int(floors_) - 1));
+  return f * layer_cells_ + static_cast<std::size_t>(row + 1) * stride_ + (col + 1);
+}
+
+std::size_t SmokeModel::block_of_index(std::size_t cell) const {
+  const std::size_t f = cell / layer_cells_;
+  const std::size_t in_layer = cell % layer_cells_;
+  const std::size_t row = in_layer / stride_ - 1;
+  const std::size_t col = in_layer % stride_ - 1;
+  return (f * blocks_y_ + row / kBlock) * blocks_x_ + col / kBlock;
+}
+
+void SmokeModel::mark_active(std::size_t cell) { block_hot_[block_of_index(cell)] = 1; }
+
+void SmokeModel::add_source(const SmokeSource& source) {
+  const float h = params_.cell_size;
+  const auto reach = static_cast<int>(std::ceil(source.radius / h));
+  const float r2 = source.radius * source.radius;
+  std::vector<std::size_t> cells;
+  for (int dy = -reach; dy <= reach; ++dy) {
+    for (int dx = -reach; dx <= reach; ++dx) {
+      if ((dx * dx + dy * dy) * h * h > r2 && (dx != 0 || dy != 0)) continue;
+      cells.push_back(index_of(source.floor, source.x + dx * h, source.y + dy * h));
+    }
+  }
+  // Cells clamped onto the grid edge may repeat; each burns once.
+  std::sort(cells.begin(), cells.end());
+  cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+  for (const std::size_t cell : cells) {
+    burning_.push_back({cell, source.smoke_rate, source.heat_rate});
+    mark_active(cell);
+  }
+}
+
+void SmokeModel::observe_smoke(std::int16_t floor, float x, float y, float level) {
+  const std::size_t cell = index_of(floor, x, y);
+  if (level <= smoke_[cell]) return;
+  smoke_[cell] = level;
+  if (level > params_.activity_threshold) mark_active(cell);
+}
+
+std::size_t SmokeModel::active_blocks() const {
+  return static_cast<std::size_t>(std::count(block_hot_.begin(), block_hot_.end(), 1));
+}
+
+// One block of the stencil, row by row. Rows are contiguous and the halo means
+// no neighbour is ever out of bounds, so the inner loop has no branches.
+void SmokeModel::update_block(std::uint32_t floor, std::uint32_t by, std::uint32_t bx) {
+  const std::size_t layer = floor * layer_cells_;
+  const float sc = smoke_c_[0], sw = smoke_c_[1], se = smoke_c_[2], ss = smoke_c_[3], sn = smoke_c_[4];
+  const float hc = heat_c_[0], hw = heat_c_[1], he = heat_c_[2], hs = heat_c_[3], hn = heat_c_[4];
+  for (std::uint32_t r = 0; r < kBlock; ++r) {
+    const std::size_t row = layer + static_cast<std::size_t>(by * kBlock + r + 1) * stride_ + bx * kBlock + 1;
+    const float* __restrict s = smoke_.data() + row;
+    const float* __restrict s_west = s - 1;
+    const float* __restrict s_east = s + 1;
+    const float* __restrict s_south = s - stride_;
+    const float* __restrict s_north = s + stride_;
+    const float* __restrict t = heat_.data() + row;
+    const float* __restrict t_west = t - 1;
+    const float* __restrict t_east = t + 1;
+    const float* __restrict t_south = t - stride_;
+    const float* __restrict t_north = t + stride_;
+    float* __restrict so = smoke_next_.data() + row;
+    float* __restrict to = heat_next_.data() + row;
+    for (std::uint32_t i = 0; i < kBlock; ++i) {
+      so[i] = sc * s[i] + sw * s_west[i] + se * s_east[i] + ss * s_south[i] + sn * s_north[i];
+      to[i] = hc * t[i] + hw * t_west[i] + he * t_east[i] + hs * t_south[i] + hn * t_north[i];
+    }
+  }
+}
+
+// Active set for the coming step: every block that held anything after the
+// previous one, dilated by one block so fronts can move into fresh space.
+void SmokeModel::refresh_activity() {
+  std::fill(block_active_.begin(), block_active_.end(), 0);
+  for (std::uint32_t f = 0; f < floors_; ++f) {
+    for (std::uint32_t by = 0; by < blocks_y_; ++by) {
+      for (std::uint32_t bx = 0; bx < blocks_x_; ++bx) {
+        if (!block_hot_[(f * blocks_y_ + by) * blocks_x_ + bx]) continue;
+        const std::uint32_t y0 = by == 0 ? 0 : by - 1;
+        const std::uint32_t y1 = std::min(by + 1, blocks_y_ - 1);
+        const std::uint32_t x0 = bx == 0 ? 0 : bx - 1;
+        const std::uint32_t x1 = std::min(bx + 1, blocks_x_ - 1);
+        for (std::uint32_t y = y0; y <= y1; ++y) {
+          for (std::uint32_t x = x0; x <= x1; ++x) block_active_[(f * blocks_y_ + y) * blocks_x_ + x] = 1;
+        }
+      }
+    }
+  }
+}
+
+void SmokeModel::step() {
+  refresh_activity();
+  for (std::uint32_t f = 0; f < floors_; ++f) {
+    for (std::uint32_t by = 0; by < blocks_y_; ++by) {
+      for (std::uint32_t bx = 0; bx < blocks_x_; ++bx) {
+        if (block_active_[(f * blocks_y_ + by) * blocks_x_ + bx]) update_block(f, by, bx);
+      }
+    }
+  }
+
+  // Inactive blocks hold zeros in both buffers, so swapping only needs the
+  // active interiors to have been written.
+  smoke_.swap(smoke_next_);
+  heat_.swap(heat_next_);
+
+  const float dt = params_.dt;
+  for (const BurningCell& b : burning_) {
+    smoke_[b.cell] = std::min(1.0f, smoke_[b.cell] + b.smoke_rate * dt);
+    heat_[b.cell] = std::min(kMaxHeatRise, heat_[b.cell] + b.heat_rate * dt);
+  }
+  // Buoyant transport up the shafts, using the post-stencil values.
+  const float rise = std::min(1.0f, params_.shaft_rise * dt);
+  for (const auto& [lower, upper] : shafts_) {
+    const float moved_smoke = smoke_[lower] * rise;
+    const float moved_heat = heat_[lower] * rise;
+    smoke_[lower] -= moved_smoke;
+    smoke_[upper] = std::min(1.0f, smoke_[upper] + moved_smoke);
+    heat_[lower] -= moved_heat;
+    heat_[upper] += moved_heat;
+    if (moved_smoke > 0.0f || moved_heat > 0.0f) mark_active(upper);
+  }
+
+  // Per-block peak decides next step's activity. Blocks that faded out are
+  // zeroed in both buffers so they can be skipped from now on.
+  const float threshold = params_.activity_threshold;
+  for (std::uint32_t f = 0; f < floors_; ++f) {
+    for (std::uint32_t by = 0; by < blocks_y_; ++by) {
+      for (std::uint32_t bx = 0; bx < blocks_x_; ++bx) {
+        const std::size_t b = (f * blocks_y_ + by) * blocks_x_ + bx;
+        if (!block_active_[b] && !block_hot_[b]) continue;
+        float peak = 0.0f;
+        for (std::uint32_t r = 0; r < kBlock; ++r) {
+          const std::size_t row =
+              f * layer_cells_ + static_cast<std::size_t>(by * kBlock + r + 1) * stride_ + bx * kBlock + 1;
+          const float* s = smoke_.data() + row;
+          const float* t = heat_.data() + row;
+          for (std::uint32_t i = 0; i < kBlock; ++i) peak = std::max(peak, std::max(s[i], t[i] * 0.01f));
+        }
+        block_hot_[b] = peak > threshold;
+        if (block_hot_[b]) continue;
+        for (std::uint32_t r = 0; r < kBlock; ++r) {
+          const std::size_t row =
+              f * layer_cells_ + static_cast<std::size_t>(by * kBlock + r + 1) * stride_ + bx * kBlock + 1;
+          std::fill_n(smoke_.data() + row, kBlock, 0.0f);
+          std::fill_n(heat_.data() + row, kBlock, 0.0f);
+          std::fill_n(smoke_next_.data() + row, kBlock, 0.0f);
+          std::fill_n(heat_next_.data() + row, kBlock, 0.0f);
+        }
+      }
+    }
+  }
+  for (const BurningCell& b : burning_) mark_active(b.cell);
+}
+
+void SmokeModel::advance(float seconds) {
+  const auto steps = static_cast<std::uint32_t>(std::ceil(seconds / params_.dt - 1e-4f));
+  for (std::uint32_t i = 0; i < steps; ++i) step();
+}
+
+}  // namespace evac
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "util/aligned_buffer.hpp"
+
+namespace evac {
+
+struct SmokeParams {
+  float cell_size = 1.0f;       // metres
+  float dt = 0.25f;             // seconds per step (clamped for stability)
+  float smoke_diffusivity = 0.5f;   // m^2/s, ceiling-jet mixing along corridors
+  float heat_diffusivity = 0.2f;
+  float smoke_decay = 0.002f;   // 1/s, extraction and deposition
+  float heat_decay = 0.01f;     // 1/s, losses to walls
+  float drift_x = 0.0f;         // m/s, ventilation-driven drift (same on all floors)
+  float drift_y = 0.0f;
+  float shaft_rise = 0.05f;     // 1/s, fraction of shaft smoke moving one floor up
+  float activity_threshold = 1e-3f;
+};
+
+struct SmokeSource {
+  std::int16_t floor = 0;
+  float x = 0.0f;
+  float y = 0.0f;
+  float radius = 2.0f;       // metres; every cell within it is a burning cell
+  float smoke_rate = 0.2f;   // concentration units per second, per burning cell
+  float heat_rate = 10.0f;   // degC per second, per burning cell
+};
+
+// Smoke concentration (0..1, 1 = zero visibility) and temperature rise over a
+// coarse 2.5D grid: one 2D layer per floor, coupled vertically only through
+// stair and elevator shafts. Each step is one explicit 5-point stencil with
+// diffusion, upwind ventilation drift and decay folded into fixed
+// coefficients, so the inner loop is branch-free and auto-vectorises.
+//
+// The grid is cut into 16x16 blocks and only "active" blocks are updated:
+// blocks holding smoke or heat above the threshold, plus their neighbours, so
+// quiet floors of a tall building cost nothing. Every layer carries a one-cell
+// zero halo, which makes the building envelope an open (outflow) boundary.
+class SmokeModel {
+ public:
+  static constexpr std::uint32_t kBlock = 16;
+
+  SmokeModel(const BuildingGraph& g, SmokeParams params = {});
+
+  const SmokeParams& params() const { return params_; }
+  float dt() const { return params_.dt; }
+
+  void add_source(const SmokeSource& source);
+  void clear_sources() { burning_.clear(); }
+  // Nudges the cell at (x, y) up to an observed concentration (sensor assimilation).
+  void observe_smoke(std::int16_t floor, float x, float y, float level);
+
+  void step();
+  void advance(float seconds);
+
+  float smoke_at(std::int16_t floor, float x, float y) const { return smoke_[index_of(floor, x, y)]; }
+  // Temperature rise above ambient, degC.
+  float heat_at(std::int16_t floor, float x, float y) const { return heat_[index_of(floor, x, y)]; }
+
+  std::size_t active_blocks() const;
+  std::size_t total_blocks() const { return block_active_.size(); }
+
+ private:
+  std::size_t index_of(std::int16_t floor, float x, float y) const;
+  std::size_t block_of_index(std::size_t cell) const;
+  void mark_active(std::size_t cell);
+  void update_block(std::uint32_t floor, std::uint32_t by, std::uint32_t bx);
+  void refresh_activity();
+
+  SmokeParams params_;
+  float origin_x_ = 0.0f;
+  float origin_y_ = 0.0f;
+  std::uint32_t cols_ = 0;  // interior cells per row
+  std::uint32_t rows_ = 0;
+  std::uint32_t floors_ = 1;
+  std::int16_t min_floor_ = 0;
+  std::uint32_t stride_ = 0;       // cols_ + 2
+  std::size_t layer_cells_ = 0;    // (rows_ + 2) * stride_
+  std::uint32_t blocks_x_ = 0;
+  std::uint32_t blocks_y_ = 0;
+
+  // Stencil coefficients: centre, west, east, south, north.
+  float smoke_c_[5] = {};
+  float heat_c_[5] = {};
+
+  aligned_vector<float> smoke_, heat_;
+  aligned_vector<float> smoke_next_, heat_next_;
+  std::vector<std::uint8_t> block_active_;  // updated this step
+  std::vector<std::uint8_t> block_hot_;     // above threshold after the step
+  struct BurningCell {
+    std::size_t cell;
+    float smoke_rate;
+    float heat_rate;
+  };
+  std::vector<BurningCell> burning_;
+  // Shaft cell pairs (lower floor cell, upper floor cell).
+  std::vector<std::pair<std::size_t, std::size_t>> shafts_;
+};
+
+}  // namespace evac
@@ -0,0 +1,122 @@
+#include "ingest/ingest_pipeline.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#include "telemetry/trace.hpp"
+
+namespace evac {
+
+IngestPipeline::IngestPipeline(const SensorMap& sensors, std::size_t edge_count, IngestOptions options)
+    : sensors_(sensors), options_(options) {
+  options_.producers = std::max<std::size_t>(1, options_.producers);
+  options_.shards = std::clamp<std::size_t>(options_.shards, 1, options_.producers);
+  for (std::size_t s = 0; s < options_.shards; ++s) {
+    rings_.push_back(std::make_unique<MpscRing<Reading>>(options_.ring_capacity));
+  }
+  counters_ = std::make_unique<ProducerCounters[]>(options_.producers);
+  sensor_hazard_.assign(sensors_.sensor_count(), 0.0f);
+  published_hazard_.assign(edge_count, 0.0f);
+  dirty_stamp_.assign(edge_count, 0);
+}
+
+void IngestPipeline::push(unsigned producer, const Reading& r) {
+  MpscRing<Reading>& ring = *rings_[producer % rings_.size()];
+  while (!ring.try_push(r)) {
+    counters_[producer].backpressure_spins.fetch_add(1, std::memory_order_relaxed);
+    std::this_thread::yield();
+  }
+  counters_[producer].accepted.fetch_add(1, std::memory_order_relaxed);
+}
+
+void IngestPipeline::submit(unsigned producer, const SensorEvent& event) {
+  assert(producer < options_.producers);
+  submit_at(producer, event, trace_now_ns());
+}
+
+void IngestPipeline::submit_at(unsigned producer, const SensorEvent& event, std::uint64_t ingress_ns) {
+  const std::uint32_t index = sensors_.index_of(event.sensor_id);
+  if (index == SensorMap::kUnknown) {
+    counters_[producer].unknown_sensor.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  push(producer, {index, event.value, event.timestamp_us, ingress_ns});
+}
+
+DecodeStatus IngestPipeline::submit_frame(unsigned producer, std::span<const std::byte> frame) {
+  assert(producer < options_.producers);
+  EVAC_TRACE_SPAN(TraceStage::Ingest);
+  const std::uint64_t ingress_ns = trace_now_ns();
+  const DecodeStatus status =
+      decode_event_frame(frame, [&](const SensorEvent& e) { submit_at(producer, e, ingress_ns); });
+  if (status != DecodeStatus::Ok) counters_[producer].decode_errors.fetch_add(1, std::memory_order_relaxed);
+  return status;
+}
+
+std::span<const HazardUpdate> IngestPipeline::drain(std::size_t max_readings) {
+  EVAC_TRACE_SPAN(TraceStage::Coalesce);
+  updates_.clear();
+  occupancy_.clear();
+  dirty_.clear();
+  if (++epoch_ == 0) {
+    std::fill(dirty_stamp_.begin(), dirty_stamp_.end(), 0);
+    epoch_ = 1;
+  }
+
+  // Pass 1: fold the burst into latest-per-sensor and collect touched arcs.
+  std::size_t budget = max_readings;
+  std::uint64_t oldest = 0;
+  for (auto& ring : rings_) {
+    const std::size_t n = ring->drain(budget, [&](const Reading& r) {
+      if (oldest == 0 || r.ingress_ns < oldest) oldest = r.ingress_ns;
+      const SensorKind kind = sensors_.kind(r.sensor);
+      if (log_) {
+        LogRecord rec;
+        rec.type = LogRecordType::Sensor;
+        rec.kind = static_cast<std::uint8_t>(kind);
+        rec.timestamp_us = r.timestamp_us;
+        rec.a = sensors_.sensor_id(r.sensor);
+        rec.value = r.value;
+        log_->append(rec);
+      }
+      if (is_occupancy_sensor(kind)) {
+        occupancy_.push_back({r.sensor, r.value, r.timestamp_us});
+        return;
+      }
+      sensor_hazard_[r.sensor] = hazard_from_reading(kind, r.value);
+      for (EdgeId e : sensors_.edges_of(r.sensor)) {
+        if (dirty_stamp_[e] == epoch_) continue;
+        dirty_stamp_[e] = epoch_;
+        dirty_.push_back(e);
+      }
+    });
+    budget -= n;
+    drained_ += n;
+  }
+
+  oldest_ingress_ns_ = oldest;
+
+  // Pass 2: one recomputation per touched arc, however many readings hit it.
+  for (EdgeId e : dirty_) {
+    float hazard = 0.0f;
+    for (std::uint32_t s : sensors_.sensors_of(e)) hazard = std::max(hazard, sensor_hazard_[s]);
+    if (hazard == published_hazard_[e]) continue;
+    published_hazard_[e] = hazard;
+    updates_.push_back({e, hazard});
+  }
+  return updates_;
+}
+
+IngestCounters IngestPipeline::counters() const {
+  IngestCounters total;
+  for (std::size_t p = 0; p < options_.producers; ++p) {
+    total.accepted += counters_[p].accepted.load(std::memory_order_relaxed);
+    total.unknown_sensor += counters_[p].unknown_sensor.load(std::memory_order_relaxed);
+    total.decode_errors += counters_[p].decode_errors.load(std::memory_order_relaxed);
+    total.backpressure_spins += counters_[p].backpressure_spins.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+}  // namespace evac
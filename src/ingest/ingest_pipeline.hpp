@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "eventlog/event_log_writer.hpp"
+#include "graph/building_graph.hpp"
+#include "ingest/mpsc_ring.hpp"
+#include "ingest/sensor_event.hpp"
+#include "ingest/sensor_map.hpp"
+
+namespace evac {
+
+struct IngestOptions {
+  std::size_t producers = 1;         // I/O threads calling submit*()
+  std::size_t shards = 1;            // MPSC rings; producer p feeds shard p % shards
+  std::size_t ring_capacity = 1 << 16;
+};
+
+struct HazardUpdate {
+  EdgeId edge = kInvalidEdge;
+  float hazard = 0.0f;
+};
+
+struct OccupancyReading {
+  std::uint32_t sensor = 0;  // dense SensorMap index
+  float count = 0.0f;         // heads for a camera, devices for Wi-Fi
+  std::uint64_t timestamp_us = 0;
+};
+
+struct IngestCounters {
+  std::uint64_t accepted = 0;
+  std::uint64_t unknown_sensor = 0;
+  std::uint64_t decode_errors = 0;
+  std::uint64_t backpressure_spins = 0;  // times a producer found its ring full
+};
+
+// Sensor ingestion between the gateway I/O threads and the routing thread.
+// I/O threads decode frames and resolve sensor ids to dense indices, then hand
+// readings over through bounded lock-free MPSC rings. The routing thread, the
+// only consumer, drains the rings between repairs and coalesces the burst per
+// arc: each sensor keeps only its latest reading, an arc's hazard is the worst
+// of its sensors, and only arcs whose hazard actually moved are reported.
+//
+// A full ring applies backpressure to the producer (it yields and retries);
+// readings are never dropped once decoded.
+class IngestPipeline {
+ public:
+  IngestPipeline(const SensorMap& sensors, std::size_t edge_count, IngestOptions options = {});
+
+  // I/O thread side. `producer` is the caller's own index and must be below
+  // producers(); each one has its own counters.
+  DecodeStatus submit_frame(unsigned producer, std::span<const std::byte> frame);
+  void submit(unsigned producer, const SensorEvent& event);
+
+  // Routing thread side. Drains up to `max_readings` and returns the coalesced
+  // hazard changes; the span is valid until the next drain().
+  std::span<const HazardUpdate> drain(std::size_t max_readings = std::numeric_limits<std::size_t>::max());
+  // Occupancy and Wi-Fi readings seen by the last drain(), in arrival order.
+  std::span<const OccupancyReading> occupancy() const { return occupancy_; }
+  // trace_now_ns() at which the oldest reading of the last drain() was
+  // submitted, or 0 if it drained nothing; the start of sensor-to-sign latency.
+  std::uint64_t oldest_ingress_ns() const { return oldest_ingress_ns_; }
+  std::uint64_t drained_readings() const { return drained_; }
+
+  IngestCounters counters() const;
+  std::size_t producers() const { return options_.producers; }
+
+  // Records every drained reading, in consumption order, as a Sensor record;
+  // replaying them in that order reproduces the coalesced hazards exactly.
+  // Routing thread only; null turns logging off.
+  void set_event_log(EventLogWriter* log) { log_ = log; }
+
+ private:
+  struct Reading {
+    std::uint32_t sensor;
+    float value;
+    std::uint64_t timestamp_us;
+    std::uint64_t ingress_ns;
+  };
+  struct alignas(64) ProducerCounters {
+    std::atomic<std::uint64_t> accepted{0};
+    std::atomic<std::uint64_t> unknown_sensor{0};
+    std::atomic<std::uint64_t> decode_errors{0};
+    std::atomic<std::uint64_t> backpressure_spins{0};
+  };
+
+  void push(unsigned producer, const Reading& r);
+  void submit_at(unsigned producer, const SensorEvent& event, std::uint64_t ingress_ns);
+
+  const SensorMap& sensors_;
+  IngestOptions options_;
+  std::vector<std::unique_ptr<MpscRing<Reading>>> rings_;
+  std::unique_ptr<ProducerCounters[]> counters_;
+
+  // Consumer-owned coalescing state.
+  std::vector<float> sensor_hazard_;     // latest hazard per sensor
+  std::vector<float> published_hazard_;  // per arc, last value reported
+  std::vector<std::uint32_t> dirty_stamp_;
+  std::vector<EdgeId> dirty_;
+  std::vector<HazardUpdate> updates_;
+  std::vector<OccupancyReading> occupancy_;
+  std::uint32_t epoch_ = 0;
+  std::uint64_t drained_ = 0;
+  std::uint64_t oldest_ingress_ns_ = 0;
+  EventLogWriter* log_ = nullptr;
+};
+
+}  // namespace evac
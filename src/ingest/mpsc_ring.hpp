@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+namespace evac {
+
+// Bounded lock-free multi-producer / single-consumer ring (Vyukov's bounded
+// queue with the consumer side reduced to plain loads). Each slot carries a
+// sequence number: producers claim a position with one CAS on the tail and
+// publish by bumping the slot sequence; the consumer owns the head outright.
+// Capacity is rounded up to a power of two.
+template <class T>
+class MpscRing {
+  static_assert(std::is_trivially_copyable_v<T>, "ring elements are copied by value");
+
+ public:
+  explicit MpscRing(std::size_t capacity) {
+    std::size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    if (cap > (std::size_t{1} << 31)) throw std::invalid_argument("MpscRing capacity too large");
+    mask_ = cap - 1;
+    slots_ = std::make_unique<Slot[]>(cap);
+    for (std::size_t i = 0; i < cap; ++i) slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  MpscRing(const MpscRing&) = delete;
+  MpscRing& operator=(const MpscRing&) = delete;
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  // Any thread. Returns false when the ring is full.
+  bool try_push(const T& value) {
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& slot = slots_[pos & mask_];
+      const std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          slot.value = value;
+          slot.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Consumer thread only.
+  bool try_pop(T& out) {
+    Slot& slot = slots_[head_ & mask_];
+    if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) return false;
+    out = slot.value;
+    slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+    ++head_;
+    return true;
+  }
+
+  // Consumer thread only. Pops up to `max` elements into fn(const T&).
+  template <class Fn>
+  std::size_t drain(std::size_t max, Fn&& fn) {
+    std::size_t popped = 0;
+    T value;
+    while (popped < max && try_pop(value)) {
+      fn(value);
+      ++popped;
+    }
+    return popped;
+  }
+
+ private:
+  struct alignas(64) Slot {
+    std::atomic<std::size_t> sequence{0};
+    T value{};
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  std::size_t mask_ = 0;
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  alignas(64) std::size_t head_ = 0;
+};
+
+}  // namespace evac
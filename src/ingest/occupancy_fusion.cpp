@@ -0,0 +1,112 @@
+#include "ingest/occupancy_fusion.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace evac {
+
+OccupancyFusion::OccupancyFusion(const SensorMap& sensors, const BuildingGraph& g, OccupancyParams params)
+    : params_(params) {
+  params_.bin_us = std::max<std::uint64_t>(1, params_.bin_us);
+  zone_of_.assign(sensors.sensor_count(), kNoZone);
+  for (std::uint32_t s = 0; s < sensors.sensor_count(); ++s) {
+    const SensorKind kind = sensors.kind(s);
+    if (!is_occupancy_sensor(kind)) continue;
+    zone_of_[s] = static_cast<std::uint32_t>(zone_sensor_.size());
+    zone_sensor_.push_back(s);
+    const bool wifi = kind == SensorKind::Wifi;
+    trust_.push_back(wifi ? params_.wifi_trust : params_.camera_trust);
+    scale_.push_back(wifi ? params_.people_per_device : 1.0f);
+  }
+  const std::size_t zones = zone_sensor_.size();
+  slot_people_.assign(kBins * zones, 0.0f);
+  slot_weight_.assign(kBins * zones, 0.0f);
+  people_.assign(zones, 0.0f);
+  weight_.assign(zones, 0.0f);
+
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    const std::size_t before = arc_zones_.size();
+    for (std::uint32_t s : sensors.sensors_of(e)) {
+      if (zone_of_[s] != kNoZone) arc_zones_.push_back(zone_of_[s]);
+    }
+    if (arc_zones_.size() == before) continue;
+    arcs_.push_back(e);
+    arc_zone_offsets_.push_back(static_cast<std::uint32_t>(arc_zones_.size()));
+    arc_flow_pps_.push_back(g.edge_capacity(e) > 0.0f ? g.edge_capacity(e) : params_.default_flow_pps);
+  }
+  published_.assign(arcs_.size(), 0.0f);
+}
+
+void OccupancyFusion::advance_to(std::uint64_t bin) {
+  const std::size_t zones = zone_sensor_.size();
+  const std::uint64_t turn = std::min<std::uint64_t>(bin - head_bin_, kBins);
+  for (std::uint64_t k = 1; k <= turn; ++k) {
+    const std::size_t row = static_cast<std::size_t>((head_bin_ + k) % kBins) * zones;
+    std::fill_n(slot_people_.begin() + static_cast<std::ptrdiff_t>(row), zones, 0.0f);
+    std::fill_n(slot_weight_.begin() + static_cast<std::ptrdiff_t>(row), zones, 0.0f);
+  }
+  head_bin_ = bin;
+}
+
+void OccupancyFusion::add(const OccupancyReading& reading) {
+  const std::uint32_t z = reading.sensor < zone_of_.size() ? zone_of_[reading.sensor] : kNoZone;
+  if (z == kNoZone) return;
+  const std::uint64_t bin = reading.timestamp_us / params_.bin_us;
+  if (!started_) {
+    head_bin_ = bin;
+    started_ = true;
+  }
+  if (bin > head_bin_) {
+    advance_to(bin);
+  } else if (head_bin_ - bin >= kBins) {
+    ++dropped_late_;
+    return;
+  }
+  const std::size_t cell = static_cast<std::size_t>(bin % kBins) * zone_sensor_.size() + z;
+  slot_people_[cell] += trust_[z] * scale_[z] * std::max(0.0f, reading.count);
+  slot_weight_[cell] += trust_[z];
+}
+
+std::span<const CongestionUpdate> OccupancyFusion::update(std::uint64_t now_us) {
+  updates_.clear();
+  if (!started_) return updates_;
+  const std::uint64_t now_bin = now_us / params_.bin_us;
+  if (now_bin > head_bin_) advance_to(now_bin);
+
+  // Decayed window sums, one sweep over all zones per slot, newest first.
+  const std::size_t zones = zone_sensor_.size();
+  const float bin_s = static_cast<float>(params_.bin_us) / 1e6f;
+  const float decay = params_.half_life_s > 0.0f ? std::exp2(-bin_s / params_.half_life_s) : 0.0f;
+  std::fill(people_.begin(), people_.end(), 0.0f);
+  std::fill(weight_.begin(), weight_.end(), 0.0f);
+  float w = 1.0f;
+  for (std::size_t age = 0; age < kBins; ++age, w *= decay) {
+    const std::size_t row = static_cast<std::size_t>((head_bin_ + kBins - age) % kBins) * zones;
+    const float* __restrict sp = slot_people_.data() + row;
+    const float* __restrict sw = slot_weight_.data() + row;
+    float* __restrict p = people_.data();
+    float* __restrict q = weight_.data();
+    for (std::size_t z = 0; z < zones; ++z) {
+      p[z] += w * sp[z];
+      q[z] += w * sw[z];
+    }
+  }
+
+  // Fuse per arc and report the delays that moved.
+  for (std::size_t i = 0; i < arcs_.size(); ++i) {
+    float people = 0.0f;
+    float weight = 0.0f;
+    for (std::uint32_t k = arc_zone_offsets_[i]; k < arc_zone_offsets_[i + 1]; ++k) {
+      people += people_[arc_zones_[k]];
+      weight += weight_[arc_zones_[k]];
+    }
+    const float delay = weight > 0.0f ? people / weight / arc_flow_pps_[i] : 0.0f;
+    const float moved = std::fabs(delay - published_[i]);
+    if (moved < params_.min_change_s && !(delay == 0.0f && published_[i] != 0.0f)) continue;
+    published_[i] = delay;
+    updates_.push_back({arcs_[i], delay});
+  }
+  return updates_;
+}
+
+}  // namespace evac
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "ingest/ingest_pipeline.hpp"
+#include "ingest/sensor_map.hpp"
+
+namespace evac {
+
+struct OccupancyParams {
+  std::uint64_t bin_us = 1'000'000;  // width of one ring slot
+  float half_life_s = 2.0f;          // a slot's weight halves every half life
+  float camera_trust = 1.0f;         // weight of one camera head count
+  float wifi_trust = 0.25f;          // Wi-Fi is noisier: phones off, people without one
+  float people_per_device = 0.8f;
+  float default_flow_pps = 1.3f;     // for arcs the plan leaves unconstrained
+  float min_change_s = 0.5f;         // smaller moves of an arc's delay are not reported
+};
+
+struct CongestionUpdate {
+  EdgeId edge = kInvalidEdge;
+  float delay_s = 0.0f;
+};
+
+// Live occupancy per zone, fused from cameras (head counts) and Wi-Fi
+// (associated devices), turned into per-arc queueing delays for routing.
+//
+// A zone is one occupancy or Wi-Fi sensor. Each keeps a fixed ring of kBins
+// time slots holding the trust-weighted sum of its readings and the sum of
+// their trust; a reading lands in its slot in O(1), and slots that fall out
+// of the window are cleared as the ring turns, so no history is ever rescanned.
+// Slots are stored slot-major, one contiguous row per slot, so the decayed
+// window sums are a few straight multiply-add sweeps over all zones at once.
+//
+// update() runs once per published routing snapshot: an arc's occupancy is
+// the decayed, trust-weighted mean over every zone covering it, which is how
+// a camera and an access point on the same corridor are fused, and its delay
+// is that many people passing at the arc's flow capacity. Only arcs whose
+// delay moved by min_change_s are returned.
+//
+// Consumer (routing thread) only. Timestamps are the readings' own, so a
+// replay of the same log reproduces the same delays.
+class OccupancyFusion {
+ public:
+  static constexpr std::size_t kBins = 8;
+  static constexpr std::uint32_t kNoZone = 0xffffffffu;
+
+  OccupancyFusion(const SensorMap& sensors, const BuildingGraph& g, OccupancyParams params = {});
+
+  std::size_t zone_count() const { return zone_sensor_.size(); }
+  std::size_t covered_arcs() const { return arcs_.size(); }
+
+  void add(const OccupancyReading& reading);
+  void add(std::span<const OccupancyReading> readings) {
+    for (const OccupancyReading& r : readings) add(r);
+  }
+
+  // Turns the ring to now_us and returns the changed arc delays; the span is
+  // valid until the next update().
+  std::span<const CongestionUpdate> update(std::uint64_t now_us);
+
+  // Decayed people estimate of zone z as of the last update(); 0 if unseen.
+  float zone_occupancy(std::uint32_t z) const {
+    return weight_[z] > 0.0f ? people_[z] / weight_[z] : 0.0f;
+  }
+  std::uint64_t dropped_late() const { return dropped_late_; }
+
+ private:
+  void advance_to(std::uint64_t bin);
+
+  OccupancyParams params_;
+  std::vector<std::uint32_t> zone_of_;      // per sensor index, kNoZone for hazard sensors
+  std::vector<std::uint32_t> zone_sensor_;  // per zone, sensor index
+  std::vector<float> trust_;                // per zone
+  std::vector<float> scale_;                // per zone, people per counted unit
+
+  // Ring: slot s of zone z at [s * zones + z].
+  std::vector<float> slot_people_;
+  std::vector<float> slot_weight_;
+  std::uint64_t head_bin_ = 0;  // absolute bin of the newest slot
+  bool started_ = false;
+
+  // Decayed window sums per zone, filled by update().
+  std::vector<float> people_;
+  std::vector<float> weight_;
+
+  // Arcs with at least one zone, their zones (CSR), flows and published delays.
+  std::vector<EdgeId> arcs_;
+  std::vector<std::uint32_t> arc_zone_offsets_{0};
+  std::vector<std::uint32_t> arc_zones_;
+  std::vector<float> arc_flow_pps_;
+  std::vector<float> published_;
+  std::vector<CongestionUpdate> updates_;
+  std::uint64_t dropped_late_ = 0;
+};
+
+}  // namespace evac
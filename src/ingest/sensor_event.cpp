@@ -0,0 +1,76 @@
+#include "ingest/sensor_event.hpp"
+
+#include <cstring>
+
+namespace evac {
+namespace {
+
+template <class T>
+void store_le(std::byte* p, T v) {
+  for (std::size_t i = 0; i < sizeof(T); ++i) p[i] = static_cast<std::byte>((v >> (8 * i)) & 0xff);
+}
+
+}  // namespace
+
+const char* to_string(SensorKind kind) {
+  switch (kind) {
+    case SensorKind::Smoke: return "smoke";
+    case SensorKind::Heat: return "heat";
+    case SensorKind::DoorContact: return "door";
+    case SensorKind::Occupancy: return "occupancy";
+    case SensorKind::Wifi: return "wifi";
+  }
+  return "?";
+}
+
+bool parse_sensor_kind(const char* name, SensorKind& out) {
+  for (SensorKind k :
+       {SensorKind::Smoke, SensorKind::Heat, SensorKind::DoorContact, SensorKind::Occupancy, SensorKind::Wifi}) {
+    if (std::strcmp(name, to_string(k)) == 0) {
+      out = k;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* to_string(DecodeStatus status) {
+  switch (status) {
+    case DecodeStatus::Ok: return "ok";
+    case DecodeStatus::Truncated: return "truncated";
+    case DecodeStatus::BadMagic: return "bad magic";
+    case DecodeStatus::BadVersion: return "bad version";
+    case DecodeStatus::BadKind: return "bad sensor kind";
+  }
+  return "?";
+}
+
+float detail::load_le_float(const std::byte* p) {
+  const auto bits = load_le<std::uint32_t>(p);
+  float f;
+  std::memcpy(&f, &bits, sizeof f);
+  return f;
+}
+
+void encode_event_frame(std::span<const SensorEvent> events, std::vector<std::byte>& out) {
+  const std::size_t base = out.size();
+  out.resize(base + kEventFrameHeaderSize + events.size() * kEventRecordSize);
+  std::byte* p = out.data() + base;
+  store_le<std::uint16_t>(p, kEventFrameMagic);
+  p[2] = static_cast<std::byte>(kEventFrameVersion);
+  p[3] = std::byte{0};
+  store_le<std::uint32_t>(p + 4, static_cast<std::uint32_t>(events.size()));
+  p += kEventFrameHeaderSize;
+  for (const SensorEvent& e : events) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &e.value, sizeof bits);
+    store_le<std::uint64_t>(p, e.timestamp_us);
+    store_le<std::uint32_t>(p + 8, e.sensor_id);
+    p[12] = static_cast<std::byte>(e.kind);
+    p[13] = p[14] = p[15] = std::byte{0};
+    store_le<std::uint32_t>(p + 16, bits);
+    p += kEventRecordSize;
+  }
+}
+
+}  // namespace evac
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace evac {
+
+enum class SensorKind : std::uint8_t { Smoke, Heat, DoorContact, Occupancy, Wifi };
+
+const char* to_string(SensorKind kind);
+bool parse_sensor_kind(const char* name, SensorKind& out);
+// Kinds that count people rather than sense a hazard.
+inline bool is_occupancy_sensor(SensorKind kind) { return kind == SensorKind::Occupancy || kind == SensorKind::Wifi; }
+
+// One decoded reading. `value` is sensor-specific: smoke obscuration 0..1,
+// temperature in degC, door contact 1 = blocked/locked, occupancy (camera)
+// head count, Wi-Fi associated device count.
+struct SensorEvent {
+  std::uint64_t timestamp_us = 0;
+  std::uint32_t sensor_id = 0;
+  SensorKind kind = SensorKind::Smoke;
+  float value = 0.0f;
+};
+
+// Gateway frame, little-endian:
+//   u16 magic 'E','V' | u8 version (1) | u8 reserved | u32 record count
+//   count x { u64 timestamp_us | u32 sensor_id | u8 kind | u8[3] pad | f32 value }
+inline constexpr std::uint16_t kEventFrameMagic = 0x5645;  // "EV"
+inline constexpr std::uint8_t kEventFrameVersion = 1;
+inline constexpr std::size_t kEventFrameHeaderSize = 8;
+inline constexpr std::size_t kEventRecordSize = 20;
+
+enum class DecodeStatus { Ok, Truncated, BadMagic, BadVersion, BadKind };
+
+const char* to_string(DecodeStatus status);
+
+// Decodes a whole frame, calling sink(const SensorEvent&) per record. Records
+// before a bad one are delivered; the status names the first problem.
+template <class Sink>
+DecodeStatus decode_event_frame(std::span<const std::byte> frame, Sink&& sink);
+
+void encode_event_frame(std::span<const SensorEvent> events, std::vector<std::byte>& out);
+
+namespace detail {
+
+template <class T>
+T load_le(const std::byte* p) {
+  T v{};
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    v = static_cast<T>(v | (static_cast<T>(std::to_integer<std::uint8_t>(p[i])) << (8 * i)));
+  }
+  return v;
+}
+
+float load_le_float(const std::byte* p);
+
+}  // namespace detail
+
+template <class Sink>
+DecodeStatus decode_event_frame(std::span<const std::byte> frame, Sink&& sink) {
+  if (frame.size() < kEventFrameHeaderSize) return DecodeStatus::Truncated;
+  const std::byte* p = frame.data();
+  if (detail::load_le<std::uint16_t>(p) != kEventFrameMagic) return DecodeStatus::BadMagic;
+  if (std::to_integer<std::uint8_t>(p[2]) != kEventFrameVersion) return DecodeStatus::BadVersion;
+  const auto count = detail::load_le<std::uint32_t>(p + 4);
+  p += kEventFrameHeaderSize;
+  const std::size_t available = (frame.size() - kEventFrameHeaderSize) / kEventRecordSize;
+  const std::size_t usable = count < available ? count : available;
+  for (std::size_t i = 0; i < usable; ++i, p += kEventRecordSize) {
+    const auto kind = std::to_integer<std::uint8_t>(p[12]);
+    if (kind > static_cast<std::uint8_t>(SensorKind::Wifi)) return DecodeStatus::BadKind;
+    SensorEvent e;
+    e.timestamp_us = detail::load_le<std::uint64_t>(p);
+    e.sensor_id = detail::load_le<std::uint32_t>(p + 8);
+    e.kind = static_cast<SensorKind>(kind);
+    e.value = detail::load_le_float(p + 16);
+    sink(e);
+  }
+  return usable == count ? DecodeStatus::Ok : DecodeStatus::Truncated;
+}
+
+}  // namespace evac
@@ -0,0 +1,90 @@
+#include "ingest/sensor_map.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace evac {
+
+void SensorMap::add_sensor(std::uint32_t sensor_id, SensorKind kind, std::span<const EdgeId> edges) {
+  if (index_.count(sensor_id) != 0) throw std::invalid_argument("duplicate sensor " + std::to_string(sensor_id));
+  index_.emplace(sensor_id, static_cast<std::uint32_t>(ids_.size()));
+  ids_.push_back(sensor_id);
+  kinds_.push_back(kind);
+  edges_.insert(edges_.end(), edges.begin(), edges.end());
+  edge_offsets_.push_back(static_cast<std::uint32_t>(edges_.size()));
+}
+
+void SensorMap::finalize(std::size_t edge_count) {
+  sensor_offsets_.assign(edge_count + 1, 0);
+  for (EdgeId e : edges_) ++sensor_offsets_[e + 1];
+  for (std::size_t e = 0; e < edge_count; ++e) sensor_offsets_[e + 1] += sensor_offsets_[e];
+  std::vector<std::uint32_t> cursor(sensor_offsets_.begin(), sensor_offsets_.end() - 1);
+  sensors_.resize(edges_.size());
+  for (std::uint32_t s = 0; s < ids_.size(); ++s) {
+    for (EdgeId e : edges_of(s)) sensors_[cursor[e]++] = s;
+  }
+}
+
+SensorMap load_sensor_map(std::istream& in, const BuildingGraph& g, const std::string& source_name) {
+  SensorMap map;
+  std::string line;
+  std::size_t line_no = 0;
+  std::vector<EdgeId> edges;
+  while (std::getline(in, line)) {
+    ++line_no;
+    if (auto hash = line.find('#'); hash != std::string::npos) line.resize(hash);
+    std::istringstream fields(line);
+    std::string record;
+    if (!(fields >> record)) continue;
+    const auto fail = [&](const std::string& what) {
+      throw std::runtime_error(source_name + ":" + std::to_string(line_no) + ": " + what);
+    };
+    if (record != "sensor") fail("unknown record '" + record + "'");
+
+    std::uint32_t id = 0;
+    std::string kind_name;
+    SensorKind kind;
+    if (!(fields >> id >> kind_name)) fail("malformed sensor");
+    if (!parse_sensor_kind(kind_name.c_str(), kind)) fail("unknown sensor kind '" + kind_name + "'");
+    edges.clear();
+    NodeId a = 0;
+    NodeId b = 0;
+    while (fields >> a >> b) {
+      if (a >= g.node_count() || b >= g.node_count()) fail("sensor references unknown node");
+      const EdgeId e = g.find_edge(a, b);
+      if (e == kInvalidEdge) fail("no connection " + std::to_string(a) + "-" + std::to_string(b));
+      edges.push_back(e);
+      if (const EdgeId twin = g.edge_twin(e); twin != kInvalidEdge) edges.push_back(twin);
+    }
+    if (edges.empty()) fail("sensor covers no connection");
+    try {
+      map.add_sensor(id, kind, edges);
+    } catch (const std::invalid_argument& e) {
+      fail(e.what());
+    }
+  }
+  map.finalize(g.edge_count());
+  return map;
+}
+
+SensorMap load_sensor_map_file(const std::string& path, const BuildingGraph& g) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot open sensor map " + path);
+  return load_sensor_map(in, g, path);
+}
+
+float hazard_from_reading(SensorKind kind, float value) {
+  switch (kind) {
+    case SensorKind::Smoke: return std::clamp(value, 0.0f, 1.0f);
+    // Tenable up to ~40 degC, untenable from ~80 degC.
+    case SensorKind::Heat: return std::clamp((value - 40.0f) / 40.0f, 0.0f, 1.0f);
+    case SensorKind::DoorContact: return value >= 0.5f ? 1.0f : 0.0f;
+    case SensorKind::Occupancy:
+    case SensorKind::Wifi: break;
+  }
+  return 0.0f;
+}
+
+}  // namespace evac
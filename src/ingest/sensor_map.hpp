@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "ingest/sensor_event.hpp"
+
+namespace evac {
+
+// Which arcs each sensor covers. Text format, one sensor per line:
+//
+//   sensor <id> <kind> <a> <b> [<a> <b> ...]
+//
+// where each a-b pair is a connection; both of its arcs are covered. Sensor
+// ids are hardware addresses and may be sparse; they are mapped to dense
+// indices once at load so the hot path only indexes arrays.
+class SensorMap {
+ public:
+  static constexpr std::uint32_t kUnknown = 0xffffffffu;
+
+  std::size_t sensor_count() const { return ids_.size(); }
+  std::uint32_t index_of(std::uint32_t sensor_id) const {
+    const auto it = index_.find(sensor_id);
+    return it == index_.end() ? kUnknown : it->second;
+  }
+  std::uint32_t sensor_id(std::uint32_t index) const { return ids_[index]; }
+  SensorKind kind(std::uint32_t index) const { return kinds_[index]; }
+
+  std::span<const EdgeId> edges_of(std::uint32_t index) const {
+    return {edges_.data() + edge_offsets_[index], edge_offsets_[index + 1] - edge_offsets_[index]};
+  }
+  // Sensors covering arc e (dense indices).
+  std::span<const std::uint32_t> sensors_of(EdgeId e) const {
+    return {sensors_.data() + sensor_offsets_[e], sensor_offsets_[e + 1] - sensor_offsets_[e]};
+  }
+
+  void add_sensor(std::uint32_t sensor_id, SensorKind kind, std::span<const EdgeId> edges);
+  // Builds the arc -> sensors index; call once after the last add_sensor().
+  void finalize(std::size_t edge_count);
+
+ private:
+  std::unordered_map<std::uint32_t, std::uint32_t> index_;
+  std::vector<std::uint32_t> ids_;
+  std::vector<SensorKind> kinds_;
+  std::vector<std::uint32_t> edge_offsets_{0};
+  std::vector<EdgeId> edges_;
+  std::vector<std::uint32_t> sensor_offsets_;
+  std::vector<std::uint32_t> sensors_;
+};
+
+// Throws std::runtime_error naming the offending line.
+SensorMap load_sensor_map(std::istream& in, const BuildingGraph& g, const std::string& source_name = "<stream>");
+SensorMap load_sensor_map_file(const std::string& path, const BuildingGraph& g);
+
+// Hazard level (0 clear .. 1 impassable) implied by one reading; occupancy
+// and Wi-Fi sensors carry no hazard.
+float hazard_from_reading(SensorKind kind, float value);
+
+}  // namespace evac
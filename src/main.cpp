@@ -0,0 +1,56 @@
+#include <cstdio>
+#include <exception>
+#include <string_view>
+
+#include "app/commands.hpp"
+
+namespace {
+
+struct Command {
+  std::string_view name;
+  int (*run)(const evac::app::Args&);
+  std::string_view help;
+};
+
+constexpr Command kCommands[] = {
+    {"info", evac::app::cmd_info, "info <plan>                 summarise a floor plan"},
+    {"compile", evac::app::cmd_compile, "compile <plan> <model>      compile a plan into a mapped model"},
+    {"analyze", evac::app::cmd_analyze, "analyze <plan> [options]    bottleneck connections and exit cuts"},
+    {"route", evac::app::cmd_route, "route <plan> [options]      exit routes, hazard updates on stdin"},
+    {"plan", evac::app::cmd_plan, "plan <plan> [options]       capacity-aware evacuation plan"},
+    {"simulate", evac::app::cmd_simulate, "simulate <plan> [options]   agent-based crowd evacuation"},
+    {"ingest", evac::app::cmd_ingest, "ingest <plan> <sensors>     sensor ingestion load test"},
+    {"forecast", evac::app::cmd_forecast, "forecast <plan> --fire <n>  smoke forecast feeding the router"},
+    {"scenario", evac::app::cmd_scenario, "scenario <plan> [options]   Monte Carlo what-if comparison"},
+    {"replay", evac::app::cmd_replay, "replay <plan> <map> <log>   re-drive an ingest event log"},
+    {"gateway", evac::app::cmd_gateway, "gateway <plan> <sensors>    MQTT and Modbus/TCP device front end"},
+    {"district", evac::app::cmd_district, "district <plan> [options]   partitioned multi-node routing and crowd"},
+    {"restore", evac::app::cmd_restore, "restore <plan> <checkpoint> standby warm start from a checkpoint"},
+};
+
+void usage() {
+  std::fprintf(stderr, "usage: main <command> [args...]\n\ncommands:\n");
+  for (const Command& c : kCommands) std::fprintf(stderr, "  %.*s\n", int(c.help.size()), c.help.data());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    usage();
+    return 2;
+  }
+  const std::string_view name = argv[1];
+  for (const Command& c : kCommands) {
+    if (c.name != name) continue;
+    evac::app::Args args(argv + 2, argv + argc);
+    try {
+      return c.run(args);
+    } catch (const std::exception& e) {
+      std::fprintf(stderr, "main %s: %s\n", argv[1], e.what());
+      return 1;
+    }
+  }
+  usage();
+  return 2;
+}
@@ -0,0 +1,214 @@
+#include "model/mapped_model.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include "graph/plan_loader.hpp"
+#include "model/model_writer.hpp"
+
+namespace evac {
+namespace {
+
+[[noreturn]] void fail(const std::string& path, const std::string& what) {
+  throw std::runtime_error(path + ": " + what);
+}
+
+struct ExpectedSection {
+  SectionId id;
+  std::uint32_t element_size;
+  bool per_node;   // count must be node_count (+1 for offsets)
+  bool offsets;
+};
+
+constexpr ExpectedSection kGraphSections[] = {
+    {SectionId::RowOffsets, sizeof(EdgeId), true, true},
+    {SectionId::EdgeSource, sizeof(NodeId), false, false},
+    {SectionId::EdgeTarget, sizeof(NodeId), false, false},
+    {SectionId::EdgeTwin, sizeof(EdgeId), false, false},
+    {SectionId::InOffsets, sizeof(EdgeId), true, true},
+    {SectionId::InEdges, sizeof(EdgeId), false, false},
+    {SectionId::EdgeKind, sizeof(EdgeKind), false, false},
+    {SectionId::EdgeLength, sizeof(float), false, false},
+    {SectionId::EdgeCapacity, sizeof(float), false, false},
+    {SectionId::EdgeHazard, sizeof(float), false, false},
+    {SectionId::NodeKind, sizeof(NodeKind), true, false},
+    {SectionId::NodeFloor, sizeof(std::int16_t), true, false},
+    {SectionId::NodeX, sizeof(float), true, false},
+    {SectionId::NodeY, sizeof(float), true, false},
+    {SectionId::NodeCapacity, sizeof(std::uint32_t), true, false},
+};
+
+}  // namespace
+
+std::shared_ptr<const MappedModel> MappedModel::open(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) fail(path, "cannot open model file");
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    fail(path, "cannot stat model file");
+  }
+  const auto size = static_cast<std::size_t>(st.st_size);
+  if (size < sizeof(ModelHeader)) {
+    ::close(fd);
+    fail(path, "truncated model header");
+  }
+  void* base = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);  // the mapping keeps the file referenced
+  if (base == MAP_FAILED) fail(path, "mmap failed");
+  // Start readahead now; routing touches the CSR arrays right after load.
+  ::madvise(base, size, MADV_WILLNEED);
+  std::shared_ptr<const MappedModel> model(new MappedModel(path, base, size));
+
+  const ModelHeader& h = model->header();
+  if (std::memcmp(h.magic, kModelMagic, sizeof(h.magic)) != 0) fail(path, "not a model file");
+  if (h.endian_tag != kModelEndianTag) fail(path, "model compiled for the other byte order");
+  if (h.version != kModelVersion) {
+    fail(path, "model version " + std::to_string(h.version) + ", expected " + std::to_string(kModelVersion));
+  }
+  if (h.file_size != size) fail(path, "file size does not match header (truncated copy?)");
+  const std::uint64_t table_end = sizeof(ModelHeader) + std::uint64_t(h.section_count) * sizeof(SectionEntry);
+  if (table_end > size) fail(path, "section table out of bounds");
+  for (const SectionEntry& s : model->sections()) {
+    const std::uint64_t bytes = std::uint64_t(s.element_size) * s.count;
+    if (s.offset % kModelAlignment != 0 || s.offset < table_end || s.offset > size || bytes > size - s.offset) {
+      fail(path, "section " + std::to_string(s.id) + " out of bounds or misaligned");
+    }
+  }
+  return model;
+}
+
+MappedModel::~MappedModel() {
+  if (base_) ::munmap(base_, size_);
+}
+
+std::span<const SectionEntry> MappedModel::sections() const {
+  return {reinterpret_cast<const SectionEntry*>(static_cast<const char*>(base_) + sizeof(ModelHeader)),
+          header().section_count};
+}
+
+const SectionEntry* MappedModel::find(SectionId id) const {
+  for (const SectionEntry& s : sections()) {
+    if (s.id == static_cast<std::uint32_t>(id)) return &s;
+  }
+  return nullptr;
+}
+
+void MappedModel::check_element_size(const SectionEntry& s, std::size_t expected) const {
+  if (s.element_size != expected) {
+    fail(path_, "section " + std::to_string(s.id) + " has element size " + std::to_string(s.element_size) +
+                    ", expected " + std::to_string(expected));
+  }
+}
+
+std::uint32_t MappedModel::verify() const {
+  for (const SectionEntry& s : sections()) {
+    const char* data = static_cast<const char*>(base_) + s.offset;
+    if (fnv1a(data, std::size_t(s.element_size) * s.count) != s.checksum) return s.id;
+  }
+  return 0;
+}
+
+BuildingGraph graph_from_model(std::shared_ptr<const MappedModel> model) {
+  const ModelHeader& h = model->header();
+  const std::string& path = model->path();
+  // Only counts are checked here; contents are trusted to be what the
+  // compiler wrote (MappedModel::verify() checks them when asked).
+  for (const ExpectedSection& x : kGraphSections) {
+    const SectionEntry* s = model->find(x.id);
+    if (!s) fail(path, "missing graph section " + std::to_string(static_cast<std::uint32_t>(x.id)));
+    const std::uint64_t want = x.per_node ? h.node_count + (x.offsets ? 1 : 0) : h.edge_count;
+    if (s->count != want || s->element_size != x.element_size) {
+      fail(path, "graph section " + std::to_string(s->id) + " has the wrong shape");
+    }
+  }
+
+  GraphColumns c;
+  c.row_offsets = model->section<EdgeId>(SectionId::RowOffsets);
+  c.edge_source = model->section<NodeId>(SectionId::EdgeSource);
+  c.edge_target = model->section<NodeId>(SectionId::EdgeTarget);
+  c.edge_twin = model->section<EdgeId>(SectionId::EdgeTwin);
+  c.in_offsets = model->section<EdgeId>(SectionId::InOffsets);
+  c.in_edges = model->section<EdgeId>(SectionId::InEdges);
+  c.edge_kind = model->section<EdgeKind>(SectionId::EdgeKind);
+  c.edge_length = model->section<float>(SectionId::EdgeLength);
+  c.edge_capacity = model->section<float>(SectionId::EdgeCapacity);
+  c.node_kind = model->section<NodeKind>(SectionId::NodeKind);
+  c.node_floor = model->section<std::int16_t>(SectionId::NodeFloor);
+  c.node_x = model->section<float>(SectionId::NodeX);
+  c.node_y = model->section<float>(SectionId::NodeY);
+  c.node_capacity = model->section<std::uint32_t>(SectionId::NodeCapacity);
+  c.exits = model->section<NodeId>(SectionId::Exits);
+  c.floor_count = h.floor_count;
+  c.min_floor = h.min_floor;
+  if (c.row_offsets.back() != h.edge_count || c.in_offsets.back() != h.edge_count) {
+    fail(path, "CSR offsets do not cover the arcs");
+  }
+  const std::span<const float> hazards = model->section<float>(SectionId::EdgeHazard);
+  return BuildingGraph::adopt(c, hazards, std::move(model));
+}
+
+ContingencyTables contingencies_from_model(std::shared_ptr<const MappedModel> model, const BuildingGraph& g) {
+  const auto entries = model->section<ContingencyEntry>(SectionId::ContingencyIndex);
+  if (entries.empty()) return {};
+  const auto next_edge = model->section<EdgeId>(SectionId::ContingencyNextEdge);
+  const auto distance = model->section<Cost>(SectionId::ContingencyDistance);
+  try {
+    return ContingencyTables(g, entries, next_edge, distance, model);
+  } catch (const std::invalid_argument& e) {
+    fail(model->path(), e.what());
+  }
+}
+
+bool is_model_file(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(kModelMagic)] = {};
+  return in.read(magic, sizeof(magic)) && std::memcmp(magic, kModelMagic, sizeof(magic)) == 0;
+}
+
+BuildingGraph load_building(const std::string& path) {
+  if (is_model_file(path)) return graph_from_model(MappedModel::open(path));
+  return load_plan_file(path);
+}
+
+CriticalityView criticality_from_model(std::shared_ptr<const MappedModel> model, const BuildingGraph& g) {
+  CriticalityView view;
+  view.cuts = model->section<ExitCutSummary>(SectionId::ExitCuts);
+  if (view.cuts.empty()) return view;
+  view.edge_betweenness = model->section<float>(SectionId::EdgeBetweenness);
+  view.cut_arcs = model->section<EdgeId>(SectionId::ExitCutArcs);
+  if (view.edge_betweenness.size() != g.edge_count()) fail(model->path(), "betweenness does not match the arcs");
+  for (const ExitCutSummary& c : view.cuts) {
+    if (std::size_t(c.first_arc) + c.arc_count > view.cut_arcs.size()) fail(model->path(), "exit cut out of range");
+  }
+  for (const EdgeId e : view.cut_arcs) {
+    if (e >= g.edge_count()) fail(model->path(), "exit cut names no arc of the building");
+  }
+  view.model = std::move(model);
+  return view;
+}
+
+void write_graph_model(const BuildingGraph& g, const std::string& path, const ModelAnalyses& analyses) {
+  ModelWriter writer;
+  writer.add_graph(g);
+  if (const ContingencyBuild* contingencies = analyses.contingencies) {
+    writer.add_section(SectionId::ContingencyIndex, std::span<const ContingencyEntry>(contingencies->entries));
+    writer.add_section(SectionId::ContingencyNextEdge, std::span<const EdgeId>(contingencies->next_edge));
+    writer.add_section(SectionId::ContingencyDistance, std::span<const Cost>(contingencies->distance));
+  }
+  if (const CriticalityBuild* criticality = analyses.criticality) {
+    writer.add_section(SectionId::EdgeBetweenness, std::span<const float>(criticality->edge_betweenness));
+    writer.add_section(SectionId::ExitCuts, std::span<const ExitCutSummary>(criticality->cuts));
+    writer.add_section(SectionId::ExitCutArcs, std::span<const EdgeId>(criticality->cut_arcs));
+  }
+  writer.write(path);
+}
+
+}  // namespace evac
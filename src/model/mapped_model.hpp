@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "analysis/criticality.hpp"
+#include "graph/building_graph.hpp"
+#include "model/model_format.hpp"
+#include "routing/contingency_tables.hpp"
+
+namespace evac {
+
+// Read-only shared mapping of a compiled model file. Opening validates the
+// header and the section table (bounds, alignment, element sizes) but never
+// touches section contents, so the cost is independent of building size and
+// pages are faulted in from the page cache on first use; every process that
+// maps the same file shares those physical pages.
+class MappedModel {
+ public:
+  // Throws std::runtime_error naming the file on any structural problem.
+  static std::shared_ptr<const MappedModel> open(const std::string& path);
+  ~MappedModel();
+  MappedModel(const MappedModel&) = delete;
+  MappedModel& operator=(const MappedModel&) = delete;
+
+  const ModelHeader& header() const { return *static_cast<const ModelHeader*>(base_); }
+  std::span<const SectionEntry> sections() const;
+  const SectionEntry* find(SectionId id) const;
+  std::size_t size_bytes() const { return size_; }
+  const std::string& path() const { return path_; }
+
+  // Typed view of a section; empty when absent. Throws if the element size
+  // does not match T.
+  template <class T>
+  std::span<const T> section(SectionId id) const {
+    const SectionEntry* s = find(id);
+    if (!s) return {};
+    check_element_size(*s, sizeof(T));
+    return {reinterpret_cast<const T*>(static_cast<const char*>(base_) + s->offset), s->count};
+  }
+
+  // Recomputes every section checksum; returns the first bad section id or 0.
+  std::uint32_t verify() const;
+
+ private:
+  MappedModel(std::string path, void* base, std::size_t size) : path_(std::move(path)), base_(base), size_(size) {}
+  void check_element_size(const SectionEntry& s, std::size_t expected) const;
+
+  std::string path_;
+  void* base_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Graph whose immutable columns live in the mapping; only the hazard column
+// is copied into process memory. The graph keeps the mapping alive.
+BuildingGraph graph_from_model(std::shared_ptr<const MappedModel> model);
+
+// Contingency tables stored in the model, viewed in place; empty when the
+// model was compiled without them. `g` must be the model's graph.
+ContingencyTables contingencies_from_model(std::shared_ptr<const MappedModel> model, const BuildingGraph& g);
+
+// Criticality analysis stored in the model, viewed in place; every span is
+// empty when the model was compiled without one.
+struct CriticalityView {
+  std::shared_ptr<const MappedModel> model;
+  std::span<const float> edge_betweenness;
+  std::span<const ExitCutSummary> cuts;
+  std::span<const EdgeId> cut_arcs;
+
+  bool empty() const { return cuts.empty(); }
+  std::span<const EdgeId> arcs(const ExitCutSummary& cut) const { return cut_arcs.subspan(cut.first_arc, cut.arc_count); }
+};
+CriticalityView criticality_from_model(std::shared_ptr<const MappedModel> model, const BuildingGraph& g);
+
+// True when the file starts with the model magic.
+bool is_model_file(const std::string& path);
+
+// Loads either a compiled model (mapped) or a text floor plan (parsed), so
+// every command accepts both.
+BuildingGraph load_building(const std::string& path);
+
+// Precomputed analyses to store alongside the graph; null members are skipped.
+struct ModelAnalyses {
+  const ContingencyBuild* contingencies = nullptr;
+  const CriticalityBuild* criticality = nullptr;
+};
+
+// Compiles a graph into a model file at `path`.
+void write_graph_model(const BuildingGraph& g, const std::string& path, const ModelAnalyses& analyses = {});
+
+}  // namespace evac
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace evac {
+
+// On-disk layout of a compiled building model (.evm). The file is a header, a
+// section table and the sections themselves, each padded to a 64-byte
+// boundary so every column can be used in place as a typed, SIMD-aligned
+// array once the file is mapped. All integers are host byte order; the
+// endian tag lets a reader reject files compiled on the other byte order.
+//
+//   ModelHeader | SectionEntry[section_count] | pad | section 0 | pad | ...
+//
+// Readers ignore section ids they do not know, so new sections can be added
+// without a version bump. kModelVersion changes only when an existing
+// section changes meaning or layout.
+inline constexpr char kModelMagic[8] = {'E', 'V', 'A', 'C', 'M', 'D', 'L', '\0'};
+inline constexpr std::uint32_t kModelVersion = 1;
+inline constexpr std::uint32_t kModelEndianTag = 0x01020304u;
+inline constexpr std::size_t kModelAlignment = 64;
+
+enum class SectionId : std::uint32_t {
+  RowOffsets = 1,
+  EdgeSource = 2,
+  EdgeTarget = 3,
+  EdgeTwin = 4,
+  InOffsets = 5,
+  InEdges = 6,
+  EdgeKind = 7,
+  EdgeLength = 8,
+  EdgeCapacity = 9,
+  EdgeHazard = 10,  // initial hazards, copied into the process on load
+  NodeKind = 11,
+  NodeFloor = 12,
+  NodeX = 13,
+  NodeY = 14,
+  NodeCapacity = 15,
+  Exits = 16,
+  // Optional precomputed analyses.
+  ContingencyIndex = 17,     // ContingencyEntry[k]
+  ContingencyNextEdge = 18,  // EdgeId[k * node_count], one exit field per entry
+  ContingencyDistance = 19,  // Cost[k * node_count]
+  EdgeBetweenness = 20,      // float[edge_count], sampled
+  ExitCuts = 21,             // ExitCutSummary[], site first, then per floor
+  ExitCutArcs = 22,          // EdgeId[], ranges named by ExitCuts
+};
+
+struct ModelHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t endian_tag;
+  std::uint64_t file_size;
+  std::uint64_t node_count;
+  std::uint64_t edge_count;
+  std::uint32_t section_count;
+  std::int32_t floor_count;
+  std::int16_t min_floor;
+  std::uint16_t reserved0;
+  std::uint32_t reserved1;
+};
+
+struct SectionEntry {
+  std::uint32_t id;
+  std::uint32_t element_size;
+  std::uint64_t offset;  // from the start of the file, kModelAlignment-aligned
+  std::uint64_t count;   // elements
+  std::uint64_t checksum;  // FNV-1a over the section bytes, checked on demand
+};
+
+static_assert(sizeof(ModelHeader) == 56);
+static_assert(sizeof(SectionEntry) == 32);
+
+inline std::uint64_t fnv1a(const void* data, std::size_t bytes) {
+  const auto* p = static_cast<const unsigned char*>(data);
+  std::uint64_t h = 0xcbf29ce484222325ull;
+  for (std::size_t i = 0; i < bytes; ++i) {
+    h ^= p[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+}  // namespace evac
@@ -0,0 +1,95 @@
+#include "model/model_writer.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace evac {
+namespace {
+
+std::uint64_t align_up(std::uint64_t v) { return (v + kModelAlignment - 1) / kModelAlignment * kModelAlignment; }
+
+}  // namespace
+
+void ModelWriter::add_raw(SectionId id, std::uint32_t element_size, const void* data, std::size_t count) {
+  Pending* slot = nullptr;
+  for (Pending& p : sections_) {
+    if (p.id == id) slot = &p;  // re-adding a section replaces it
+  }
+  if (!slot) slot = &sections_.emplace_back();
+  slot->id = id;
+  slot->element_size = element_size;
+  slot->count = count;
+  slot->bytes.resize(static_cast<std::size_t>(element_size) * count);
+  if (!slot->bytes.empty()) std::memcpy(slot->bytes.data(), data, slot->bytes.size());
+}
+
+void ModelWriter::add_graph(const BuildingGraph& g) {
+  const GraphColumns c = g.columns();
+  add_section(SectionId::RowOffsets, c.row_offsets);
+  add_section(SectionId::EdgeSource, c.edge_source);
+  add_section(SectionId::EdgeTarget, c.edge_target);
+  add_section(SectionId::EdgeTwin, c.edge_twin);
+  add_section(SectionId::InOffsets, c.in_offsets);
+  add_section(SectionId::InEdges, c.in_edges);
+  add_section(SectionId::EdgeKind, c.edge_kind);
+  add_section(SectionId::EdgeLength, c.edge_length);
+  add_section(SectionId::EdgeCapacity, c.edge_capacity);
+  add_section(SectionId::EdgeHazard, g.edge_hazards());
+  add_section(SectionId::NodeKind, c.node_kind);
+  add_section(SectionId::NodeFloor, c.node_floor);
+  add_section(SectionId::NodeX, c.node_x);
+  add_section(SectionId::NodeY, c.node_y);
+  add_section(SectionId::NodeCapacity, c.node_capacity);
+  add_section(SectionId::Exits, c.exits);
+  node_count_ = g.node_count();
+  edge_count_ = g.edge_count();
+  floor_count_ = g.floor_count();
+  min_floor_ = g.min_floor();
+}
+
+void ModelWriter::write(const std::string& path) const {
+  std::vector<SectionEntry> table(sections_.size());
+  std::uint64_t offset = align_up(sizeof(ModelHeader) + table.size() * sizeof(SectionEntry));
+  for (std::size_t i = 0; i < sections_.size(); ++i) {
+    const Pending& p = sections_[i];
+    table[i] = {static_cast<std::uint32_t>(p.id), p.element_size, offset, p.count,
+                fnv1a(p.bytes.data(), p.bytes.size())};
+    offset = align_up(offset + p.bytes.size());
+  }
+
+  ModelHeader header{};
+  std::memcpy(header.magic, kModelMagic, sizeof(header.magic));
+  header.version = kModelVersion;
+  header.endian_tag = kModelEndianTag;
+  header.file_size = offset;
+  header.node_count = node_count_;
+  header.edge_count = edge_count_;
+  header.section_count = static_cast<std::uint32_t>(table.size());
+  header.floor_count = floor_count_;
+  header.min_floor = min_floor_;
+
+  std::vector<unsigned char> image(offset, 0);
+  std::memcpy(image.data(), &header, sizeof(header));
+  if (!table.empty()) std::memcpy(image.data() + sizeof(header), table.data(), table.size() * sizeof(SectionEntry));
+  for (std::size_t i = 0; i < sections_.size(); ++i) {
+    if (!sections_[i].bytes.empty()) {
+      std::memcpy(image.data() + table[i].offset, sections_[i].bytes.data(), sections_[i].bytes.size());
+    }
+  }
+
+  const std::string tmp = path + ".tmp";
+  std::FILE* f = std::fopen(tmp.c_str(), "wb");
+  if (!f) throw std::runtime_error(path + ": cannot create model file");
+  const bool ok = std::fwrite(image.data(), 1, image.size(), f) == image.size();
+  if (std::fclose(f) != 0 || !ok) {
+    std::remove(tmp.c_str());
+    throw std::runtime_error(path + ": short write");
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    throw std::runtime_error(path + ": cannot replace model file");
+  }
+}
+
+}  // namespace evac
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "model/model_format.hpp"
+
+namespace evac {
+
+// Assembles a model file in memory and writes it atomically (temp file and
+// rename), so processes that map the previous version keep valid pages.
+// add_graph() emits every graph section; extra sections (precomputed
+// analyses) can be added alongside with add_section().
+class ModelWriter {
+ public:
+  void add_graph(const BuildingGraph& g);
+
+  template <class T>
+  void add_section(SectionId id, std::span<const T> values) {
+    add_raw(id, sizeof(T), values.data(), values.size());
+  }
+  void add_raw(SectionId id, std::uint32_t element_size, const void* data, std::size_t count);
+
+  // Throws std::runtime_error when the file cannot be written.
+  void write(const std::string& path) const;
+  std::size_t section_count() const { return sections_.size(); }
+
+ private:
+  struct Pending {
+    SectionId id;
+    std::uint32_t element_size;
+    std::vector<unsigned char> bytes;
+    std::size_t count;
+  };
+
+  std::vector<Pending> sections_;
+  std::uint64_t node_count_ = 0;
+  std::uint64_t edge_count_ = 0;
+  std::int32_t floor_count_ = 0;
+  std::int16_t min_floor_ = 0;
+};
+
+}  // namespace evac
@@ -0,0 +1,190 @@
+#include "net/event_loop.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace evac {
+namespace {
+
+constexpr int kMaxEvents = 256;
+
+}  // namespace
+
+EventLoop::EventLoop() {
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epoll_fd_ < 0 || wake_fd_ < 0) {
+    const std::string what = std::strerror(errno);
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    throw std::runtime_error("event loop: " + what);
+  }
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.fd = wake_fd_;
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+}
+
+EventLoop::~EventLoop() {
+  ::close(wake_fd_);
+  ::close(epoll_fd_);
+}
+
+void EventLoop::run() {
+  epoll_event events[kMaxEvents];
+  while (!stopping()) {
+    const int n = ::epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+    for (int i = 0; i < n; ++i) {
+      const int fd = events[i].data.fd;
+      if (fd == wake_fd_) {
+        std::uint64_t count;
+        [[maybe_unused]] const ssize_t r = ::read(wake_fd_, &count, sizeof count);
+      } else {
+        wake(fd);
+      }
+    }
+  }
+  // Every attempt() fails once stopping, so this unwinds all parked tasks.
+  for (std::size_t fd = 0; fd < waiting_.size(); ++fd) wake(static_cast<int>(fd));
+}
+
+void EventLoop::stop() {
+  stopping_.store(true, std::memory_order_relaxed);
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const ssize_t n = ::write(wake_fd_, &one, sizeof one);
+}
+
+void EventLoop::watch(int fd) {
+  epoll_event ev{};
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  ev.data.fd = fd;
+  if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    throw std::runtime_error(std::string("event loop: watch: ") + std::strerror(errno));
+  }
+  if (waiting_.size() <= static_cast<std::size_t>(fd)) waiting_.resize(fd + 1, nullptr);
+}
+
+void EventLoop::forget(int fd) {
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  if (waiting_[fd]) {
+    waiting_[fd] = nullptr;
+    --parked_;
+  }
+}
+
+void EventLoop::park(int fd, IoOperation& op) {
+  waiting_[fd] = &op;
+  ++parked_;
+}
+
+void EventLoop::wake(int fd) {
+  IoOperation* op = waiting_[fd];
+  if (!op || !op->attempt()) return;
+  waiting_[fd] = nullptr;
+  --parked_;
+  op->waiter.resume();
+}
+
+AsyncSocket::AsyncSocket(EventLoop& loop, int fd) : loop_(loop), fd_(fd) {
+  const int flags = ::fcntl(fd_, F_GETFL);
+  if (!(flags & O_NONBLOCK)) ::fcntl(fd_, F_SETFL, flags | O_NONBLOCK);
+  loop_.watch(fd_);
+}
+
+AsyncSocket::AsyncSocket(AsyncSocket&& other) noexcept : loop_(other.loop_), fd_(other.fd_) { other.fd_ = -1; }
+
+AsyncSocket::~AsyncSocket() {
+  if (fd_ < 0) return;
+  loop_.forget(fd_);
+  ::close(fd_);
+}
+
+bool AsyncSocket::Read::attempt() {
+  if (socket_.loop_.stopping()) {
+    result_ = -1;
+    return true;
+  }
+  for (;;) {
+    const ssize_t n = ::recv(socket_.fd_, buf_.data(), buf_.size(), 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+    result_ = n;
+    return true;
+  }
+}
+
+bool AsyncSocket::Write::attempt() {
+  if (socket_.loop_.stopping()) {
+    result_ = -1;
+    return true;
+  }
+  while (written_ < data_.size()) {
+    const ssize_t n = ::send(socket_.fd_, data_.data() + written_, data_.size() - written_, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+    if (n < 0) {
+      result_ = -1;
+      return true;
+    }
+    written_ += static_cast<std::size_t>(n);
+  }
+  result_ = static_cast<ssize_t>(written_);
+  return true;
+}
+
+AsyncListener::AsyncListener(EventLoop& loop, std::uint16_t port, bool loopback_only, bool reuse_port)
+    : loop_(loop) {
+  fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) throw std::runtime_error(std::string("listen: socket: ") + std::strerror(errno));
+  const int yes = 1;
+  ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof yes);
+  if (reuse_port) ::setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof yes);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+  if (::bind(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0 || ::listen(fd_, SOMAXCONN) != 0) {
+    const std::string what = std::strerror(errno);
+    ::close(fd_);
+    throw std::runtime_error("listen: port " + std::to_string(port) + ": " + what);
+  }
+  socklen_t len = sizeof addr;
+  ::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+  port_ = ntohs(addr.sin_port);
+  loop_.watch(fd_);
+}
+
+AsyncListener::~AsyncListener() {
+  loop_.forget(fd_);
+  ::close(fd_);
+}
+
+// Out of descriptors (EMFILE) and similar leave the connection queued; the
+// next edge retries it.
+bool AsyncListener::Accept::attempt() {
+  if (listener_.loop_.stopping()) {
+    result_ = -1;
+    return true;
+  }
+  for (;;) {
+    const int fd = ::accept4(listener_.fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd >= 0) {
+      result_ = fd;
+      return true;
+    }
+    if (errno == EINTR || errno == ECONNABORTED) continue;
+    return false;
+  }
+}
+
+}  // namespace evac
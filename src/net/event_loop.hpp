@@ -0,0 +1,172 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <span>
+#include <vector>
+
+namespace evac {
+
+// Fire-and-forget coroutine: runs as soon as it is called, up to its first
+// suspension, and frees its own frame when it returns. Gateway sessions and
+// accept loops are Tasks, so a parked connection costs its frame and buffer
+// and nothing else. A Task must not let an exception escape.
+class Task {
+ public:
+  struct promise_type {
+    Task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+class EventLoop;
+
+// A pending non-blocking operation on one descriptor. The loop calls
+// attempt() each time the descriptor signals and resumes the coroutine only
+// once it returns true, so partial reads and writes never wake anybody.
+struct IoOperation {
+  virtual bool attempt() = 0;
+  std::coroutine_handle<> waiter;
+
+ protected:
+  ~IoOperation() = default;
+};
+
+// Single-threaded epoll reactor. Descriptors are registered edge-triggered
+// for both directions once, at watch(); an awaiting coroutine tries the
+// syscall first and parks only on EAGAIN, so no wakeup is ever lost and no
+// epoll_ctl happens per operation.
+class EventLoop {
+ public:
+  // Throws std::runtime_error if epoll or eventfd cannot be created.
+  EventLoop();
+  ~EventLoop();
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  // Dispatches until stop(). On the way out every parked operation fails so
+  // its coroutine can unwind and release its socket.
+  void run();
+  // Safe from any thread.
+  void stop();
+  bool stopping() const { return stopping_.load(std::memory_order_relaxed); }
+
+  void watch(int fd);
+  void forget(int fd);
+  // Parks `op` until its descriptor signals and op.attempt() succeeds.
+  void park(int fd, IoOperation& op);
+  std::size_t parked() const { return parked_; }
+
+ private:
+  void wake(int fd);
+
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::atomic<bool> stopping_{false};
+  std::vector<IoOperation*> waiting_;  // by fd
+  std::size_t parked_ = 0;
+};
+
+// Owned stream socket bound to a loop; adopting a descriptor makes it
+// non-blocking. The awaitables complete with the syscall's result: bytes
+// moved, 0 at end of stream, -1 on error (including loop shutdown).
+class AsyncSocket {
+ public:
+  AsyncSocket(EventLoop& loop, int fd);
+  AsyncSocket(AsyncSocket&& other) noexcept;
+  AsyncSocket& operator=(AsyncSocket&&) = delete;
+  ~AsyncSocket();
+
+  int fd() const { return fd_; }
+
+  class Read final : IoOperation {
+   public:
+    Read(AsyncSocket& s, std::span<std::byte> buf) : socket_(s), buf_(buf) {}
+    bool await_ready() { return attempt(); }
+    void await_suspend(std::coroutine_handle<> h) {
+      waiter = h;
+      socket_.loop_.park(socket_.fd_, *this);
+    }
+    ssize_t await_resume() const { return result_; }
+
+   private:
+    bool attempt() override;
+    AsyncSocket& socket_;
+    std::span<std::byte> buf_;
+    ssize_t result_ = -1;
+  };
+
+  // Completes once all of `data` is written (result data.size()) or on error.
+  class Write final : IoOperation {
+   public:
+    Write(AsyncSocket& s, std::span<const std::byte> data) : socket_(s), data_(data) {}
+    bool await_ready() { return attempt(); }
+    void await_suspend(std::coroutine_handle<> h) {
+      waiter = h;
+      socket_.loop_.park(socket_.fd_, *this);
+    }
+    ssize_t await_resume() const { return result_; }
+
+   private:
+    bool attempt() override;
+    AsyncSocket& socket_;
+    std::span<const std::byte> data_;
+    std::size_t written_ = 0;
+    ssize_t result_ = -1;
+  };
+
+  Read read_some(std::span<std::byte> buf) { return {*this, buf}; }
+  Write write_all(std::span<const std::byte> data) { return {*this, data}; }
+
+ private:
+  EventLoop& loop_;
+  int fd_;
+};
+
+// Non-blocking listening socket; accept() completes with a connected
+// descriptor, or -1 once the loop shuts down.
+class AsyncListener {
+ public:
+  // Binds 0.0.0.0 (or loopback). With reuse_port several loops can listen
+  // on one port and the kernel spreads connections across them. Port 0
+  // picks a free port; throws std::runtime_error if binding fails.
+  AsyncListener(EventLoop& loop, std::uint16_t port, bool loopback_only, bool reuse_port);
+  ~AsyncListener();
+  AsyncListener(const AsyncListener&) = delete;
+  AsyncListener& operator=(const AsyncListener&) = delete;
+
+  std::uint16_t port() const { return port_; }
+
+  class Accept final : IoOperation {
+   public:
+    explicit Accept(AsyncListener& l) : listener_(l) {}
+    bool await_ready() { return attempt(); }
+    void await_suspend(std::coroutine_handle<> h) {
+      waiter = h;
+      listener_.loop_.park(listener_.fd_, *this);
+    }
+    int await_resume() const { return result_; }
+
+   private:
+    bool attempt() override;
+    AsyncListener& listener_;
+    int result_ = -1;
+  };
+
+  Accept accept() { return Accept(*this); }
+
+ private:
+  EventLoop& loop_;
+  int fd_ = -1;
+  std::uint16_t port_ = 0;
+};
+
+}  // namespace evac
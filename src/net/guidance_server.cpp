@@ -0,0 +1,303 @@
+#include "net/guidance_server.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "telemetry/trace.hpp"
+
+namespace evac {
+namespace {
+
+constexpr int kPollMs = 100;
+constexpr int kMaxEvents = 256;
+constexpr std::size_t kMaxIov = 64;
+
+std::runtime_error os_error(const std::string& what) {
+  return std::runtime_error("guidance: " + what + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+GuidanceServer::GuidanceServer(const GuidancePublisher& publisher, std::uint16_t port, GuidanceServerOptions options)
+    : publisher_(publisher), options_(options) {
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) throw os_error("socket");
+  const int yes = 1;
+  ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof yes);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(options_.loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+  if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0 ||
+      ::listen(listen_fd_, SOMAXCONN) != 0) {
+    const std::runtime_error error = os_error("port " + std::to_string(port));
+    ::close(listen_fd_);
+    throw error;
+  }
+  socklen_t len = sizeof addr;
+  ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+  port_ = ntohs(addr.sin_port);
+
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epoll_fd_ < 0 || wake_fd_ < 0) {
+    const std::runtime_error error = os_error("epoll");
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    ::close(listen_fd_);
+    throw error;
+  }
+  for (const int fd : {listen_fd_, wake_fd_}) {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+  }
+  thread_ = std::thread([this] { serve(); });
+}
+
+GuidanceServer::~GuidanceServer() {
+  stopping_.store(true, std::memory_order_relaxed);
+  notify();
+  thread_.join();
+  ::close(wake_fd_);
+  ::close(epoll_fd_);
+  ::close(listen_fd_);
+}
+
+void GuidanceServer::notify() {
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const ssize_t n = ::write(wake_fd_, &one, sizeof one);
+}
+
+GuidanceServerCounters GuidanceServer::counters() const {
+  GuidanceServerCounters c;
+  c.clients = client_count_.load(std::memory_order_relaxed);
+  c.accepted = accepted_.load(std::memory_order_relaxed);
+  c.refused = refused_.load(std::memory_order_relaxed);
+  c.versions = versions_.load(std::memory_order_relaxed);
+  c.full_frames = full_frames_.load(std::memory_order_relaxed);
+  c.delta_frames = delta_frames_.load(std::memory_order_relaxed);
+  c.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+  return c;
+}
+
+void GuidanceServer::serve() {
+  set_trace_thread_name("guidance");
+  // Per-thread on Linux: only this thread yields to the router.
+  const auto tid = static_cast<id_t>(::gettid());
+  errno = 0;
+  const int nice = ::getpriority(PRIO_PROCESS, tid);
+  if (errno == 0) ::setpriority(PRIO_PROCESS, tid, nice + options_.nice);
+
+  epoll_event events[kMaxEvents];
+  while (!stopping_.load(std::memory_order_relaxed)) {
+    const int n = ::epoll_wait(epoll_fd_, events, kMaxEvents, kPollMs);
+    for (int i = 0; i < n; ++i) {
+      const int fd = events[i].data.fd;
+      if (fd == listen_fd_) {
+        accept_clients();
+      } else if (fd == wake_fd_) {
+        std::uint64_t count;
+        [[maybe_unused]] const ssize_t r = ::read(wake_fd_, &count, sizeof count);
+      } else if (static_cast<std::size_t>(fd) < clients_.size() && clients_[fd]) {
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) read_client(*clients_[fd]);
+        if ((events[i].events & EPOLLOUT) && clients_[fd]) flush(*clients_[fd]);
+      }
+    }
+    refresh();
+  }
+  for (auto& c : clients_) {
+    if (c) close_client(*c);
+  }
+}
+
+// Encodes a newly published snapshot once and starts it towards every idle
+// subscriber; clients still sending pick it up when their queue drains.
+void GuidanceServer::refresh() {
+  std::shared_ptr<const GuidanceSnapshot> snapshot = publisher_.current();
+  if (!snapshot || (!history_.empty() && history_.back()->snapshot == snapshot)) return;
+  auto encoded = std::make_shared<Encoded>();
+  encoded->snapshot = snapshot;
+  encoded->full = full_frame_header(*snapshot);
+  encoded->full_bytes = sizeof(WireHeader) + encoded->full.payload_bytes;
+  if (!history_.empty()) {
+    const GuidanceSnapshot& previous = *history_.back()->snapshot;
+    if (previous.node_count() == snapshot->node_count() && previous.hazards().size() == snapshot->hazards().size()) {
+      encoded->base_version = previous.version();
+      encode_delta_frame(previous, *snapshot, encoded->delta);
+    }
+  }
+  history_.push_back(std::move(encoded));
+  while (history_.size() > std::max<std::size_t>(1, options_.history)) history_.pop_front();
+  versions_.fetch_add(1, std::memory_order_relaxed);
+
+  for (std::size_t fd = 0; fd < clients_.size(); ++fd) {
+    Client* c = clients_[fd].get();
+    if (c && c->hello_bytes == sizeof c->hello && c->queue.empty()) flush(*c);
+  }
+}
+
+void GuidanceServer::accept_clients() {
+  for (;;) {
+    const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    if (client_count_.load(std::memory_order_relaxed) >= options_.max_clients) {
+      ::close(fd);
+      refused_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    const int yes = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof yes);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+      ::close(fd);
+      continue;
+    }
+    if (clients_.size() <= static_cast<std::size_t>(fd)) clients_.resize(fd + 1);
+    clients_[fd] = std::make_unique<Client>();
+    clients_[fd]->fd = fd;
+    client_count_.fetch_add(1, std::memory_order_relaxed);
+    accepted_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// The hello is the only thing a client ever says; later bytes are dropped
+// and reads just notice the connection closing.
+void GuidanceServer::read_client(Client& c) {
+  std::byte buf[512];
+  for (;;) {
+    const ssize_t n = ::recv(c.fd, buf, sizeof buf, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    if (n <= 0) {
+      close_client(c);
+      return;
+    }
+    if (c.hello_bytes == sizeof c.hello) continue;
+    const std::size_t take = std::min(sizeof c.hello - c.hello_bytes, static_cast<std::size_t>(n));
+    std::memcpy(c.hello + c.hello_bytes, buf, take);
+    c.hello_bytes += take;
+    if (c.hello_bytes == sizeof c.hello) {
+      std::memcpy(&c.version, c.hello, sizeof c.version);
+      flush(c);
+      return;  // flush may have closed it
+    }
+  }
+}
+
+void GuidanceServer::catch_up(Client& c) {
+  if (history_.empty()) return;
+  const Encoded& latest = *history_.back();
+  if (c.version == latest.full.version) return;
+  // Deltas chain back from the latest version to the one the client holds.
+  std::size_t first = history_.size();
+  std::size_t delta_bytes = 0;
+  if (c.version != 0) {
+    for (std::size_t i = history_.size(); i-- > 0;) {
+      const Encoded& e = *history_[i];
+      if (e.base_version == 0) break;
+      delta_bytes += e.delta.size();
+      if (e.base_version == c.version) {
+        first = i;
+        break;
+      }
+    }
+  }
+  if (first < history_.size() && delta_bytes < latest.full_bytes) {
+    for (std::size_t i = first; i < history_.size(); ++i) {
+      c.queue.push_back({history_[i], history_[i]->delta.data(), history_[i]->delta.size()});
+      delta_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+  } else {
+    const std::shared_ptr<const Encoded>& owner = history_.back();
+    c.queue.push_back({owner, reinterpret_cast<const std::byte*>(&owner->full), sizeof(WireHeader)});
+    for (const std::span<const std::byte> piece : full_frame_pieces(*owner->snapshot)) {
+      if (!piece.empty()) c.queue.push_back({owner, piece.data(), piece.size()});
+    }
+    full_frames_.fetch_add(1, std::memory_order_relaxed);
+  }
+  c.version = latest.full.version;
+}
+
+// Sends until the socket would block or the client is current. Each send is
+// one scatter-gather write over the queued pieces.
+void GuidanceServer::flush(Client& c) {
+  for (;;) {
+    if (c.queue.empty()) catch_up(c);
+    if (c.queue.empty()) break;
+    iovec iov[kMaxIov];
+    std::size_t count = 0;
+    for (auto it = c.queue.begin(); it != c.queue.end() && count < kMaxIov; ++it, ++count) {
+      const std::size_t skip = count == 0 ? c.front_offset : 0;
+      iov[count].iov_base = const_cast<std::byte*>(it->data + skip);
+      iov[count].iov_len = it->size - skip;
+    }
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    const ssize_t n = ::sendmsg(c.fd, &msg, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (!c.writing) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.fd = c.fd;
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, c.fd, &ev);
+        c.writing = true;
+      }
+      return;
+    }
+    if (n < 0) {
+      close_client(c);
+      return;
+    }
+    bytes_sent_.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed);
+    auto left = static_cast<std::size_t>(n);
+    while (left > 0) {
+      const std::size_t rest = c.queue.front().size - c.front_offset;
+      if (left < rest) {
+        c.front_offset += left;
+        break;
+      }
+      left -= rest;
+      c.queue.pop_front();
+      c.front_offset = 0;
+    }
+  }
+  if (c.writing) {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = c.fd;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, c.fd, &ev);
+    c.writing = false;
+  }
+}
+
+void GuidanceServer::close_client(Client& c) {
+  const int fd = c.fd;
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  ::close(fd);
+  clients_[fd].reset();
+  client_count_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+}  // namespace evac
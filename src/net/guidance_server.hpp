@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "net/guidance_wire.hpp"
+#include "routing/guidance_snapshot.hpp"
+
+namespace evac {
+
+struct GuidanceServerOptions {
+  std::size_t history = 16;         // versions kept for catching clients up by delta
+  std::size_t max_clients = 65536;
+  int nice = 10;                    // added to the server thread's niceness
+  bool loopback_only = true;
+};
+
+struct GuidanceServerCounters {
+  std::uint64_t clients = 0;        // connected now
+  std::uint64_t accepted = 0;
+  std::uint64_t refused = 0;        // over max_clients
+  std::uint64_t versions = 0;       // snapshots encoded
+  std::uint64_t full_frames = 0;
+  std::uint64_t delta_frames = 0;
+  std::uint64_t bytes_sent = 0;
+};
+
+// Guidance feed for signs and apps over TCP. A client connects, sends its
+// current version as a little-endian u64 (0 for none) and from then on
+// receives frames (net/guidance_wire.hpp) that keep it at the latest
+// published snapshot.
+//
+// Payloads are never built per client. A full frame is the snapshot's own
+// columns behind a shared header, and the delta from the previous version is
+// encoded once when the server first sees a snapshot; every client send is
+// a writev of iovecs into those buffers, which the client's queue keeps
+// alive. A client that falls behind never accumulates a backlog: it is
+// brought up to date only once its socket drains, by the chain of retained
+// deltas from its version or by one full frame, whichever is smaller.
+//
+// Everything runs on one epoll thread at lowered priority, and the router's
+// only part is publish() plus notify(), so fan-out to tens of thousands of
+// clients costs the routing thread one eventfd write per version.
+class GuidanceServer {
+ public:
+  // Port 0 picks a free port; throws std::runtime_error if binding fails.
+  GuidanceServer(const GuidancePublisher& publisher, std::uint16_t port, GuidanceServerOptions options = {});
+  ~GuidanceServer();
+  GuidanceServer(const GuidanceServer&) = delete;
+  GuidanceServer& operator=(const GuidanceServer&) = delete;
+
+  std::uint16_t port() const { return port_; }
+  // Call after publishing; the server also polls the publisher on its own.
+  void notify();
+  GuidanceServerCounters counters() const;
+
+ private:
+  // One snapshot in wire form.
+  struct Encoded {
+    std::shared_ptr<const GuidanceSnapshot> snapshot;
+    WireHeader full;
+    std::size_t full_bytes = 0;
+    std::uint64_t base_version = 0;  // version the delta applies to, 0 if none
+    std::vector<std::byte> delta;
+  };
+  struct Piece {
+    std::shared_ptr<const Encoded> owner;
+    const std::byte* data;
+    std::size_t size;
+  };
+  struct Client {
+    int fd = -1;
+    std::byte hello[8];
+    std::size_t hello_bytes = 0;
+    std::uint64_t version = 0;  // everything up to here is sent or queued
+    std::deque<Piece> queue;
+    std::size_t front_offset = 0;
+    bool writing = false;       // EPOLLOUT armed
+  };
+
+  void serve();
+  void refresh();
+  void accept_clients();
+  void read_client(Client& c);
+  void catch_up(Client& c);
+  void flush(Client& c);
+  void close_client(Client& c);
+
+  const GuidancePublisher& publisher_;
+  GuidanceServerOptions options_;
+  int listen_fd_ = -1;
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::uint16_t port_ = 0;
+  std::atomic<bool> stopping_{false};
+  std::deque<std::shared_ptr<const Encoded>> history_;  // oldest first
+  std::vector<std::unique_ptr<Client>> clients_;        // by fd
+
+  std::atomic<std::uint64_t> client_count_{0};
+  std::atomic<std::uint64_t> accepted_{0};
+  std::atomic<std::uint64_t> refused_{0};
+  std::atomic<std::uint64_t> versions_{0};
+  std::atomic<std::uint64_t> full_frames_{0};
+  std::atomic<std::uint64_t> delta_frames_{0};
+  std::atomic<std::uint64_t> bytes_sent_{0};
+  std::thread thread_;
+};
+
+}  // namespace evac
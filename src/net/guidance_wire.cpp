@@ -0,0 +1,157 @@
+#include "net/guidance_wire.hpp"
+
+#include <bit>
+
+namespace evac {
+
+// Columns go out as they sit in memory.
+static_assert(std::endian::native == std::endian::little, "guidance wire format is little-endian");
+static_assert(sizeof(NodeId) == 4 && sizeof(Cost) == 4 && sizeof(float) == 4);
+
+namespace {
+
+template <class T>
+void append(std::vector<std::byte>& out, const T& value) {
+  const auto* p = reinterpret_cast<const std::byte*>(&value);
+  out.insert(out.end(), p, p + sizeof value);
+}
+
+}  // namespace
+
+WireHeader full_frame_header(const GuidanceSnapshot& snapshot) {
+  WireHeader h{};
+  h.magic = kWireMagic;
+  h.format = kWireVersion;
+  h.kind = static_cast<std::uint16_t>(WireFrameKind::Full);
+  h.version = snapshot.version();
+  h.node_count = static_cast<std::uint32_t>(snapshot.node_count());
+  h.edge_count = static_cast<std::uint32_t>(snapshot.hazards().size());
+  h.node_entries = h.node_count;
+  h.edge_entries = h.edge_count;
+  h.payload_bytes = 12ull * h.node_count + 4ull * h.edge_count;
+  return h;
+}
+
+FullFramePieces full_frame_pieces(const GuidanceSnapshot& snapshot) {
+  return {std::as_bytes(snapshot.next_hops()), std::as_bytes(snapshot.exits()), std::as_bytes(snapshot.distances()),
+          std::as_bytes(snapshot.hazards())};
+}
+
+void encode_delta_frame(const GuidanceSnapshot& from, const GuidanceSnapshot& to, std::vector<std::byte>& out) {
+  const std::size_t start = out.size();
+  WireHeader h = full_frame_header(to);
+  h.kind = static_cast<std::uint16_t>(WireFrameKind::Delta);
+  h.base_version = from.version();
+  h.node_entries = 0;
+  h.edge_entries = 0;
+  append(out, h);
+
+  const std::span<const NodeId> hop0 = from.next_hops(), hop1 = to.next_hops();
+  const std::span<const NodeId> exit0 = from.exits(), exit1 = to.exits();
+  const std::span<const Cost> dist0 = from.distances(), dist1 = to.distances();
+  for (NodeId v = 0; v < hop1.size(); ++v) {
+    if (hop0[v] == hop1[v] && exit0[v] == exit1[v] && dist0[v] == dist1[v]) continue;
+    append(out, WireNodeDelta{v, hop1[v], exit1[v], dist1[v]});
+    ++h.node_entries;
+  }
+  // Compared bitwise so the replica ends up with exactly the server's column.
+  const std::span<const float> haz0 = from.hazards(), haz1 = to.hazards();
+  for (EdgeId e = 0; e < haz1.size(); ++e) {
+    if (std::bit_cast<std::uint32_t>(haz0[e]) == std::bit_cast<std::uint32_t>(haz1[e])) continue;
+    append(out, WireEdgeDelta{e, haz1[e]});
+    ++h.edge_entries;
+  }
+  h.payload_bytes = out.size() - start - sizeof h;
+  std::memcpy(out.data() + start, &h, sizeof h);
+}
+
+const char* to_string(WireStatus status) {
+  switch (status) {
+    case WireStatus::Ok: return "ok";
+    case WireStatus::Incomplete: return "incomplete";
+    case WireStatus::BadMagic: return "bad magic";
+    case WireStatus::BadVersion: return "bad version";
+    case WireStatus::BadSize: return "bad size";
+    case WireStatus::WrongBase: return "delta for another version";
+  }
+  return "?";
+}
+
+WireStatus WireFrameView::parse(std::span<const std::byte> in, WireFrameView& out, std::size_t& frame_bytes) {
+  if (in.size() < sizeof(WireHeader)) return WireStatus::Incomplete;
+  WireHeader h;
+  std::memcpy(&h, in.data(), sizeof h);
+  if (h.magic != kWireMagic) return WireStatus::BadMagic;
+  if (h.format != kWireVersion) return WireStatus::BadVersion;
+  std::uint64_t expected = 0;
+  if (h.kind == static_cast<std::uint16_t>(WireFrameKind::Full)) {
+    if (h.node_entries != h.node_count || h.edge_entries != h.edge_count) return WireStatus::BadSize;
+    expected = 12ull * h.node_count + 4ull * h.edge_count;
+  } else if (h.kind == static_cast<std::uint16_t>(WireFrameKind::Delta)) {
+    if (h.node_entries > h.node_count || h.edge_entries > h.edge_count) return WireStatus::BadSize;
+    expected = sizeof(WireNodeDelta) * std::uint64_t{h.node_entries} +
+               sizeof(WireEdgeDelta) * std::uint64_t{h.edge_entries};
+  } else {
+    return WireStatus::BadVersion;
+  }
+  if (h.payload_bytes != expected) return WireStatus::BadSize;
+  if (in.size() - sizeof h < h.payload_bytes) return WireStatus::Incomplete;
+  out.header_ = h;
+  out.payload_ = in.data() + sizeof h;
+  frame_bytes = sizeof h + static_cast<std::size_t>(h.payload_bytes);
+  return WireStatus::Ok;
+}
+
+WireStatus GuidanceReplica::feed(std::span<const std::byte> bytes) {
+  pending_.insert(pending_.end(), bytes.begin(), bytes.end());
+  std::size_t pos = 0;
+  WireStatus status = WireStatus::Ok;
+  while (true) {
+    WireFrameView frame;
+    std::size_t frame_bytes = 0;
+    const WireStatus parsed = WireFrameView::parse(std::span(pending_).subspan(pos), frame, frame_bytes);
+    if (parsed == WireStatus::Incomplete) break;
+    status = parsed == WireStatus::Ok ? apply(frame) : parsed;
+    if (status != WireStatus::Ok) break;
+    pos += frame_bytes;
+  }
+  pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(pos));
+  return status;
+}
+
+WireStatus GuidanceReplica::apply(const WireFrameView& frame) {
+  const WireHeader& h = frame.header();
+  if (frame.full()) {
+    next_hop_.resize(h.node_count);
+    exit_.resize(h.node_count);
+    distance_.resize(h.node_count);
+    hazard_.resize(h.edge_count);
+    for (NodeId v = 0; v < h.node_count; ++v) {
+      next_hop_[v] = frame.next_hop(v);
+      exit_[v] = frame.exit(v);
+      distance_[v] = frame.distance(v);
+    }
+    for (EdgeId e = 0; e < h.edge_count; ++e) hazard_[e] = frame.hazard(e);
+  } else {
+    if (h.base_version != version_ || h.node_count != distance_.size() || h.edge_count != hazard_.size()) {
+      return WireStatus::WrongBase;
+    }
+    for (std::size_t i = 0; i < h.node_entries; ++i) {
+      const WireNodeDelta d = frame.node_delta(i);
+      if (d.node >= h.node_count) return WireStatus::BadSize;
+      next_hop_[d.node] = d.next_hop;
+      exit_[d.node] = d.exit;
+      distance_[d.node] = d.distance;
+    }
+    for (std::size_t i = 0; i < h.edge_entries; ++i) {
+      const WireEdgeDelta d = frame.edge_delta(i);
+      if (d.edge >= h.edge_count) return WireStatus::BadSize;
+      hazard_[d.edge] = d.hazard;
+    }
+  }
+  version_ = h.version;
+  ++frames_;
+  return WireStatus::Ok;
+}
+
+}  // namespace evac
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+#include "routing/guidance_snapshot.hpp"
+
+namespace evac {
+
+// Guidance feed wire format. Every frame is a fixed header followed by flat
+// little-endian arrays at offsets the header determines, so a client reads
+// any field in place without a parse step, and the server sends a full frame
+// straight out of the published snapshot's columns.
+//
+//   Full:  WireHeader | u32 next_hop[n] | u32 exit[n] | u32 distance[n] | f32 hazard[m]
+//   Delta: WireHeader | WireNodeDelta[node_entries] | WireEdgeDelta[edge_entries]
+//
+// A delta brings a client at base_version to version. kInvalidNode and
+// kInfiniteCost travel as themselves. Frame sizes are multiples of 4, so
+// frames laid back to back in a buffer stay 4-byte aligned.
+inline constexpr std::uint32_t kWireMagic = 0x57475645;  // "EVGW"
+inline constexpr std::uint16_t kWireVersion = 1;
+
+enum class WireFrameKind : std::uint16_t { Full = 1, Delta = 2 };
+
+struct WireHeader {
+  std::uint32_t magic;
+  std::uint16_t format;         // kWireVersion
+  std::uint16_t kind;           // WireFrameKind
+  std::uint64_t version;        // snapshot version the frame brings the client to
+  std::uint64_t base_version;   // Delta: version it applies to; Full: 0
+  std::uint32_t node_count;
+  std::uint32_t edge_count;
+  std::uint32_t node_entries;   // Full: node_count; Delta: changed nodes
+  std::uint32_t edge_entries;   // Full: edge_count; Delta: changed arcs
+  std::uint64_t payload_bytes;  // after the header
+};
+static_assert(sizeof(WireHeader) == 48);
+
+struct WireNodeDelta {
+  NodeId node;
+  NodeId next_hop;
+  NodeId exit;
+  Cost distance;
+};
+static_assert(sizeof(WireNodeDelta) == 16);
+
+struct WireEdgeDelta {
+  EdgeId edge;
+  float hazard;
+};
+static_assert(sizeof(WireEdgeDelta) == 8);
+
+// The four columns of a full frame, in wire order, pointing into `snapshot`.
+using FullFramePieces = std::array<std::span<const std::byte>, 4>;
+
+WireHeader full_frame_header(const GuidanceSnapshot& snapshot);
+FullFramePieces full_frame_pieces(const GuidanceSnapshot& snapshot);
+
+// Appends the delta frame taking `from` to `to` (same building) to `out`.
+void encode_delta_frame(const GuidanceSnapshot& from, const GuidanceSnapshot& to, std::vector<std::byte>& out);
+
+enum class WireStatus { Ok, Incomplete, BadMagic, BadVersion, BadSize, WrongBase };
+
+const char* to_string(WireStatus status);
+
+// One frame inside a receive buffer; the accessors read straight from it.
+class WireFrameView {
+ public:
+  // Ok with `frame_bytes` set once `in` starts with a whole frame;
+  // Incomplete while it holds only part of one.
+  static WireStatus parse(std::span<const std::byte> in, WireFrameView& out, std::size_t& frame_bytes);
+
+  const WireHeader& header() const { return header_; }
+  bool full() const { return header_.kind == static_cast<std::uint16_t>(WireFrameKind::Full); }
+
+  // Full frames.
+  NodeId next_hop(NodeId v) const { return load<NodeId>(v * 4); }
+  NodeId exit(NodeId v) const { return load<NodeId>((std::size_t{header_.node_count} + v) * 4); }
+  Cost distance(NodeId v) const { return load<Cost>((2 * std::size_t{header_.node_count} + v) * 4); }
+  float hazard(EdgeId e) const { return load<float>((3 * std::size_t{header_.node_count} + e) * 4); }
+
+  // Delta frames.
+  WireNodeDelta node_delta(std::size_t i) const { return load<WireNodeDelta>(i * sizeof(WireNodeDelta)); }
+  WireEdgeDelta edge_delta(std::size_t i) const {
+    return load<WireEdgeDelta>(header_.node_entries * sizeof(WireNodeDelta) + i * sizeof(WireEdgeDelta));
+  }
+
+ private:
+  template <class T>
+  T load(std::size_t offset) const {
+    T v;
+    std::memcpy(&v, payload_ + offset, sizeof v);
+    return v;
+  }
+
+  WireHeader header_{};
+  const std::byte* payload_ = nullptr;
+};
+
+// Client-side copy of the guidance tables kept current from a frame stream;
+// what a sign controller or app runs. Bytes may arrive split anywhere.
+class GuidanceReplica {
+ public:
+  // Applies every whole frame in the buffered stream. Stops at the first bad
+  // frame (a delta for a version other than the one held is WrongBase).
+  WireStatus feed(std::span<const std::byte> bytes);
+
+  std::uint64_t version() const { return version_; }
+  std::size_t frames_applied() const { return frames_; }
+  GuidanceAnswer lookup(NodeId v) const {
+    if (v >= distance_.size()) return {v, kInvalidNode, kInvalidNode, kInfiniteCost};
+    return {v, next_hop_[v], exit_[v], distance_[v]};
+  }
+  std::span<const NodeId> next_hops() const { return next_hop_; }
+  std::span<const NodeId> exits() const { return exit_; }
+  std::span<const Cost> distances() const { return distance_; }
+  std::span<const float> hazards() const { return hazard_; }
+
+ private:
+  WireStatus apply(const WireFrameView& frame);
+
+  std::vector<std::byte> pending_;
+  std::uint64_t version_ = 0;
+  std::size_t frames_ = 0;
+  std::vector<NodeId> next_hop_;
+  std::vector<NodeId> exit_;
+  std::vector<Cost> distance_;
+  std::vector<float> hazard_;
+};
+
+}  // namespace evac
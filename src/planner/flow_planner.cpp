@@ -0,0 +1,278 @@
+#include "planner/flow_planner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+#include "routing/cost.hpp"
+
+namespace evac {
+namespace {
+
+constexpr std::uint32_t kUnbounded = 0x7fffffffu;
+constexpr std::uint32_t kNever = 0xffffffffu;
+constexpr std::uint32_t kWaveSlack = 2;
+
+}  // namespace
+
+FlowPlanner::FlowPlanner(const BuildingGraph& graph, PlannerOptions options)
+    : graph_(graph), options_(options) {
+  const std::size_t m = graph_.edge_count();
+  transit_layers_.resize(m);
+  arc_rate_.assign(m, -1.0);
+  arc_open_from_.assign(m, 0);
+  for (EdgeId e = 0; e < m; ++e) {
+    const Cost c = edge_cost(graph_, e);
+    if (c == kInfiniteCost) {
+      transit_layers_[e] = 0;
+    } else {
+      const float layers = std::ceil(static_cast<float>(c) / 10.0f / options_.step_seconds);
+      transit_layers_[e] = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(layers));
+    }
+
+    float pps = graph_.edge_capacity(e);
+    if (pps <= 0.0f) continue;
+    const EdgeId twin = graph_.edge_twin(e);
+    if (options_.contraflow && twin != kInvalidEdge) pps += graph_.edge_capacity(twin);
+    arc_rate_[capacity_key(e)] = static_cast<double>(pps) * options_.step_seconds;
+  }
+  remaining_.assign(graph_.node_count(), 0);
+  labels_.resize(graph_.node_count());
+  label_stamp_.assign(graph_.node_count(), 0);
+}
+
+std::uint32_t FlowPlanner::capacity_key(EdgeId e) const {
+  const EdgeId twin = graph_.edge_twin(e);
+  return options_.contraflow && twin != kInvalidEdge ? std::min(e, twin) : e;
+}
+
+std::uint32_t FlowPlanner::arc_residual(std::uint32_t layer, EdgeId e) const {
+  const std::uint32_t key = capacity_key(e);
+  const double rate = arc_rate_[key];
+  if (rate < 0.0) return kUnbounded;
+  // Whole occupants per layer, spread so every run of layers passes its share
+  // of the rate: a 1.3 pps door admits 1, 1, 1, 2, 1, 1, 2, ... at 1 s layers.
+  const auto cap = static_cast<std::uint32_t>(std::floor((layer + 1.0) * rate) - std::floor(layer * rate));
+  const std::uint32_t used = layers_.arc_use(layer, key);
+  return used >= cap ? 0 : cap - used;
+}
+
+std::uint32_t FlowPlanner::node_residual(std::uint32_t layer, NodeId v) const {
+  const std::uint32_t cap = graph_.node_capacity(v);
+  if (cap == 0 || graph_.node_kind(v) == NodeKind::Exit) return kUnbounded;
+  const std::uint32_t used = layers_.node_use(layer, v);
+  return used >= cap ? 0 : cap - used;
+}
+
+// Multi-source earliest-arrival Dijkstra over (node, layer) states, keeping one
+// label per node, with every origin available from layer `start`. Occupants
+// still waiting at their origin sit in rooms they already fill, so queueing at
+// the origin is not charged against room capacity; at every other node each
+// layer spent (arrival through departure) is. Where waiting is free, the
+// departure scan starts at the arc's first layer that is not full.
+bool FlowPlanner::earliest_arrival(std::uint32_t start, NodeId& exit_reached) {
+  if (++search_epoch_ == 0) {
+    std::fill(label_stamp_.begin(), label_stamp_.end(), 0);
+    search_epoch_ = 1;
+  }
+  auto label = [&](NodeId v) -> Label& {
+    if (label_stamp_[v] != search_epoch_) {
+      label_stamp_[v] = search_epoch_;
+      labels_[v] = {kNever, kInvalidEdge, 0};
+    }
+    return labels_[v];
+  };
+
+  ArenaScope scope(scratch_);
+  using Entry = std::pair<std::uint32_t, NodeId>;
+  arena_vector<Entry> queue{ArenaAllocator<Entry>(scratch_)};
+  queue.reserve(remaining_.size());
+  const auto push = [&](std::uint32_t t, NodeId v) {
+    queue.push_back({t, v});
+    std::push_heap(queue.begin(), queue.end(), std::greater<>());
+  };
+  for (NodeId v = 0; v < remaining_.size(); ++v) {
+    if (remaining_[v] == 0) continue;
+    label(v) = {start, kInvalidEdge, 0};
+    push(start, v);
+  }
+
+  while (!queue.empty()) {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+    const auto [arrive, v] = queue.back();
+    queue.pop_back();
+    const Label here = label(v);
+    if (arrive != here.arrive) continue;
+    if (graph_.node_kind(v) == NodeKind::Exit) {
+      exit_reached = v;
+      return true;
+    }
+    const bool origin = here.via == kInvalidEdge;
+    const bool free_wait = origin || graph_.node_capacity(v) == 0;
+
+    for (EdgeId e : graph_.out_edges(v)) {
+      const std::uint32_t transit = transit_layers_[e];
+      if (transit == 0) continue;
+      // Origins may hold back until the horizon; in transit, queueing is capped.
+      const std::uint32_t last_depart =
+          origin ? options_.horizon_layers : arrive + options_.max_wait_layers;
+      const NodeId w = graph_.edge_target(e);
+      std::uint32_t depart = kNever;
+      std::uint32_t d = free_wait ? std::max(arrive, arc_open_from_[capacity_key(e)]) : arrive;
+      for (; d <= last_depart && d + transit <= options_.horizon_layers; ++d) {
+        if (!free_wait && node_residual(d, v) == 0) break;
+        if (arc_residual(d, e) > 0 && node_residual(d + transit, w) > 0) {
+          depart = d;
+          break;
+        }
+      }
+      if (depart == kNever) continue;
+      const std::uint32_t next = depart + transit;
+      Label& there = label(w);
+      if (next < there.arrive) {
+        there = {next, e, depart};
+        push(next, w);
+      }
+    }
+  }
+  return false;
+}
+
+// Fits the next wave onto the found path. Arc i is entered at its first layer
+// with room at or after both the wave's arrival at its tail and departs[i],
+// the previous wave's entry, so waves never overtake; departs is updated in
+// place. Returns how many occupants the schedule admits, 0 if none fit.
+std::uint32_t FlowPlanner::schedule_wave(std::span<std::uint32_t> departs) const {
+  std::uint32_t amount = kUnbounded;
+  std::uint32_t arrive = departs[0];
+  for (std::size_t i = 0; i < path_edges_.size(); ++i) {
+    const EdgeId e = path_edges_[i];
+    const std::uint32_t transit = transit_layers_[e];
+    const NodeId u = graph_.edge_source(e);
+    const NodeId w = graph_.edge_target(e);
+    const bool free_wait = i == 0 || graph_.node_capacity(u) == 0;
+    const std::uint32_t last_depart = i == 0 ? options_.horizon_layers : arrive + options_.max_wait_layers;
+    std::uint32_t d = arrive;
+    if (free_wait) d = std::max({d, departs[i], arc_open_from_[capacity_key(e)]});
+    for (;; ++d) {
+      if (d > last_depart || d + transit > options_.horizon_layers) return 0;
+      // Queueing at an intermediate room, from arrival through departure.
+      if (!free_wait) {
+        const std::uint32_t room = node_residual(d, u);
+        if (room == 0) return 0;
+        amount = std::min(amount, room);
+      }
+      if (d >= departs[i] && arc_residual(d, e) > 0 && node_residual(d + transit, w) > 0) break;
+    }
+    amount = std::min(amount, arc_residual(d, e));
+    departs[i] = d;
+    arrive = d + transit;
+  }
+  return amount;
+}
+
+void FlowPlanner::reserve_wave(std::span<const std::uint32_t> departs, std::uint32_t amount) {
+  for (std::size_t i = 0; i < path_edges_.size(); ++i) {
+    const EdgeId e = path_edges_[i];
+    const std::uint32_t key = capacity_key(e);
+    if (arc_rate_[key] >= 0.0) {
+      layers_.reserve_arc(departs[i], key, amount);
+      if (departs[i] == arc_open_from_[key]) {
+        while (arc_residual(arc_open_from_[key], e) == 0) ++arc_open_from_[key];
+      }
+    }
+    if (i == 0) continue;
+    const NodeId u = graph_.edge_source(e);
+    if (graph_.node_capacity(u) == 0) continue;
+    for (std::uint32_t t = departs[i - 1] + transit_layers_[path_edges_[i - 1]]; t <= departs[i]; ++t) {
+      layers_.reserve_node(t, u, amount);
+    }
+  }
+}
+
+EvacuationPlan FlowPlanner::plan(std::span<const OccupantGroup> occupants) {
+  EvacuationPlan result;
+  result.step_seconds = options_.step_seconds;
+  layers_.clear();
+  std::fill(arc_open_from_.begin(), arc_open_from_.end(), 0);
+  std::fill(remaining_.begin(), remaining_.end(), 0);
+
+  std::uint64_t outstanding = 0;
+  for (const OccupantGroup& group : occupants) {
+    if (group.node >= graph_.node_count() || group.count == 0) continue;
+    if (graph_.node_kind(group.node) == NodeKind::Exit) {
+      result.evacuated += group.count;
+      continue;
+    }
+    remaining_[group.node] += group.count;
+    outstanding += group.count;
+  }
+
+  std::uint32_t start = 0;
+  std::uint32_t hold_back = 1;
+  // Searches later, doubling the delay while nobody gets out; false once the
+  // horizon itself has been searched.
+  const auto defer = [&] {
+    if (start >= options_.horizon_layers) return false;
+    start = std::min(options_.horizon_layers, start + hold_back);
+    hold_back = std::min(options_.horizon_layers, 2 * hold_back);
+    return true;
+  };
+  while (outstanding > 0) {
+    NodeId exit = kInvalidNode;
+    if (!earliest_arrival(start, exit)) {
+      if (!defer()) break;
+      continue;
+    }
+
+    // Walk the labels back to the origin.
+    PlannedRoute route;
+    std::vector<std::uint32_t> departs;
+    NodeId v = exit;
+    while (labels_[v].via != kInvalidEdge) {
+      route.edges.push_back(labels_[v].via);
+      departs.push_back(labels_[v].depart);
+      v = graph_.edge_source(labels_[v].via);
+    }
+    route.source = v;
+    std::reverse(route.edges.begin(), route.edges.end());
+    std::reverse(departs.begin(), departs.end());
+    path_edges_ = route.edges;
+
+    // The first wave takes the searched schedule; the next ones are fitted
+    // behind it until the path admits nobody or a wave would trail the one
+    // before by more than kWaveSlack layers, when a fresh search may do better.
+    std::uint32_t budget = remaining_[route.source];
+    if (options_.batch_limit != 0) budget = std::min(budget, options_.batch_limit);
+    while (route.people < budget) {
+      const std::uint32_t fits = schedule_wave(departs);
+      if (fits == 0) break;
+      const std::uint32_t arrive = departs.back() + transit_layers_[route.edges.back()];
+      if (!route.waves.empty() && arrive > route.arrive_layer + kWaveSlack) break;
+      const std::uint32_t amount = std::min(fits, budget - route.people);
+      reserve_wave(departs, amount);
+      route.waves.push_back({amount, departs, arrive});
+      route.people += amount;
+      route.arrive_layer = arrive;
+    }
+    if (route.people == 0) {
+      // The path was found but no wave fits on it yet; treat it as a miss.
+      if (!defer()) break;
+      continue;
+    }
+    hold_back = 1;
+
+    remaining_[route.source] -= route.people;
+    outstanding -= route.people;
+    result.evacuated += route.people;
+    result.egress_layers = std::max(result.egress_layers, route.arrive_layer);
+    result.routes.push_back(std::move(route));
+  }
+
+  result.stranded = outstanding;
+  result.materialised_layers = layers_.materialised_layers();
+  return result;
+}
+
+}  // namespace evac
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace evac {
+
+// Open-addressing counter map (uint32 key -> uint32 count). Reservations in a
+// time layer touch a handful of arcs and rooms out of hundreds of thousands, so
+// a sparse map per layer is far smaller than a dense column per layer.
+class FlatCounterMap {
+ public:
+  std::uint32_t get(std::uint32_t key) const {
+    if (keys_.empty()) return 0;
+    for (std::size_t i = slot_of(key);; i = (i + 1) & mask()) {
+      if (keys_[i] == key) return counts_[i];
+      if (keys_[i] == kEmpty) return 0;
+    }
+  }
+
+  void add(std::uint32_t key, std::uint32_t amount) {
+    if ((size_ + 1) * 4 > keys_.size() * 3) grow();
+    for (std::size_t i = slot_of(key);; i = (i + 1) & mask()) {
+      if (keys_[i] == key) {
+        counts_[i] += amount;
+        return;
+      }
+      if (keys_[i] == kEmpty) {
+        keys_[i] = key;
+        counts_[i] = amount;
+        ++size_;
+        return;
+      }
+    }
+  }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  static constexpr std::uint32_t kEmpty = 0xffffffffu;
+
+  std::size_t mask() const { return keys_.size() - 1; }
+  std::size_t slot_of(std::uint32_t key) const { return (key * 0x9e3779b1u) & mask(); }
+
+  void grow() {
+    std::vector<std::uint32_t> old_keys = std::move(keys_);
+    std::vector<std::uint32_t> old_counts = std::move(counts_);
+    const std::size_t capacity = old_keys.empty() ? 16 : old_keys.size() * 2;
+    keys_.assign(capacity, kEmpty);
+    counts_.assign(capacity, 0);
+    size_ = 0;
+    for (std::size_t i = 0; i < old_keys.size(); ++i) {
+      if (old_keys[i] != kEmpty) add(old_keys[i], old_counts[i]);
+    }
+  }
+
+  std::vector<std::uint32_t> keys_;
+  std::vector<std::uint32_t> counts_;
+  std::size_t size_ = 0;
+};
+
+// Capacity reservations of the time-expanded network, one layer per time step.
+// Layers are created the first time a reservation lands in them; reading a
+// layer that was never written costs nothing and reports zero usage.
+class LayerStore {
+ public:
+  std::uint32_t arc_use(std::uint32_t layer, std::uint32_t arc) const {
+    return layer < layers_.size() && layers_[layer] ? layers_[layer]->arcs.get(arc) : 0;
+  }
+  std::uint32_t node_use(std::uint32_t layer, std::uint32_t node) const {
+    return layer < layers_.size() && layers_[layer] ? layers_[layer]->nodes.get(node) : 0;
+  }
+  void reserve_arc(std::uint32_t layer, std::uint32_t arc, std::uint32_t amount) {
+    touch(layer).arcs.add(arc, amount);
+  }
+  void reserve_node(std::uint32_t layer, std::uint32_t node, std::uint32_t amount) {
+    touch(layer).nodes.add(node, amount);
+  }
+
+  std::size_t materialised_layers() const { return materialised_; }
+  void clear() {
+    layers_.clear();
+    materialised_ = 0;
+  }
+
+ private:
+  struct Layer {
+    FlatCounterMap arcs;
+    FlatCounterMap nodes;
+  };
+
+  Layer& touch(std::uint32_t layer) {
+    if (layer >= layers_.size()) layers_.resize(layer + 1);
+    if (!layers_[layer]) {
+      layers_[layer] = std::make_unique<Layer>();
+      ++materialised_;
+    }
+    return *layers_[layer];
+  }
+
+  std::vector<std::unique_ptr<Layer>> layers_;
+  std::size_t materialised_ = 0;
+};
+
+}  // namespace evac
@@ -0,0 +1,142 @@
+#include "routing/contingency_tables.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include "routing/exit_field.hpp"
+
+namespace evac {
+
+std::vector<ContingencyEntry> rank_contingencies(const BuildingGraph& g, std::size_t k,
+                                                 std::span<const float> edge_betweenness) {
+  const std::size_t n = g.node_count();
+  ExitField field;
+  solve_exit_field(g, field);
+
+  // Subtree sizes of the route tree, leaves first.
+  std::vector<NodeId> order;
+  order.reserve(n);
+  for (NodeId v = 0; v < n; ++v) {
+    if (field.distance[v] != kInfiniteCost) order.push_back(v);
+  }
+  std::sort(order.begin(), order.end(), [&](NodeId a, NodeId b) {
+    return field.distance[a] != field.distance[b] ? field.distance[a] > field.distance[b] : a < b;
+  });
+  std::vector<std::uint32_t> subtree(n, 1);
+  std::vector<std::uint32_t> arc_load(g.edge_count(), 0);
+  for (const NodeId v : order) {
+    const EdgeId e = field.next_edge[v];
+    if (e == kInvalidEdge) continue;
+    arc_load[e] += subtree[v];
+    subtree[g.edge_target(e)] += subtree[v];
+  }
+
+  std::vector<std::uint32_t> node_load(n, 0);
+  for (const NodeId v : order) node_load[v] = subtree[v] - 1;  // routes from other nodes
+  if (!edge_betweenness.empty()) {
+    std::fill(node_load.begin(), node_load.end(), 0);
+    for (EdgeId e = 0; e < g.edge_count(); ++e) {
+      arc_load[e] = static_cast<std::uint32_t>(std::lround(edge_betweenness[e]));
+      node_load[g.edge_target(e)] += arc_load[e];
+    }
+  }
+
+  std::vector<ContingencyEntry> ranked;
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    const EdgeId twin = g.edge_twin(e);
+    if (twin != kInvalidEdge && twin < e) continue;
+    const std::uint32_t load = arc_load[e] + (twin != kInvalidEdge ? arc_load[twin] : 0);
+    if (load != 0) ranked.push_back({static_cast<std::uint32_t>(ContingencyKind::Connection), e, load, 0});
+  }
+  for (NodeId v = 0; v < n; ++v) {
+    if (node_load[v] != 0) ranked.push_back({static_cast<std::uint32_t>(ContingencyKind::Node), v, node_load[v], 0});
+  }
+  const std::size_t keep = std::min(k, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(keep), ranked.end(),
+                    [](const ContingencyEntry& a, const ContingencyEntry& b) {
+                      if (a.load != b.load) return a.load > b.load;
+                      if (a.kind != b.kind) return a.kind < b.kind;
+                      return a.element < b.element;
+                    });
+  ranked.resize(keep);
+  return ranked;
+}
+
+void contingency_arcs(const BuildingGraph& g, const ContingencyEntry& entry, std::vector<EdgeId>& out) {
+  out.clear();
+  if (entry.kind == static_cast<std::uint32_t>(ContingencyKind::Connection)) {
+    out.push_back(entry.element);
+    if (const EdgeId twin = g.edge_twin(entry.element); twin != kInvalidEdge) out.push_back(twin);
+    return;
+  }
+  for (EdgeId e : g.out_edges(entry.element)) out.push_back(e);
+  for (EdgeId e : g.in_edges(entry.element)) out.push_back(e);
+}
+
+ContingencyBuild build_contingency_tables(const BuildingGraph& g, std::span<const ContingencyEntry> entries,
+                                          WorkStealingPool& pool) {
+  const std::size_t n = g.node_count();
+  ContingencyBuild build;
+  build.entries.assign(entries.begin(), entries.end());
+  build.next_edge.resize(entries.size() * n);
+  build.distance.resize(entries.size() * n);
+
+  // Per worker: a graph copy (shares the topology, owns its hazards) and a field.
+  struct Worker {
+    BuildingGraph graph;
+    ExitField field;
+    std::vector<EdgeId> arcs;
+    std::vector<float> saved;
+  };
+  std::vector<Worker> workers(pool.workers());
+  for (Worker& w : workers) w.graph = g;
+  pool.parallel_for(entries.size(), 1, [&](std::size_t b, std::size_t e, unsigned self) {
+    Worker& w = workers[self];
+    for (std::size_t i = b; i < e; ++i) {
+      contingency_arcs(w.graph, entries[i], w.arcs);
+      w.saved.clear();
+      for (EdgeId a : w.arcs) {
+        w.saved.push_back(w.graph.edge_hazard(a));
+        w.graph.set_edge_hazard(a, kImpassableHazard);
+      }
+      solve_exit_field(w.graph, w.field);
+      std::copy(w.field.next_edge.begin(), w.field.next_edge.end(), build.next_edge.begin() + i * n);
+      std::copy(w.field.distance.begin(), w.field.distance.end(), build.distance.begin() + i * n);
+      // In reverse, so an arc listed twice (a self-loop) gets its own hazard back.
+      for (std::size_t j = w.arcs.size(); j-- > 0;) w.graph.set_edge_hazard(w.arcs[j], w.saved[j]);
+    }
+  });
+  return build;
+}
+
+ContingencyTables::ContingencyTables(const BuildingGraph& g, std::span<const ContingencyEntry> entries,
+                                     std::span<const EdgeId> next_edge, std::span<const Cost> distance,
+                                     std::shared_ptr<const void> storage)
+    : storage_(std::move(storage)), node_count_(g.node_count()), entries_(entries), next_edge_(next_edge),
+      distance_(distance) {
+  if (next_edge.size() != entries.size() * node_count_ || distance.size() != next_edge.size()) {
+    throw std::invalid_argument("contingency tables do not match the building");
+  }
+  by_arc_.assign(g.edge_count(), kNone);
+  by_node_.assign(node_count_, kNone);
+  for (std::uint32_t i = 0; i < entries.size(); ++i) {
+    const ContingencyEntry& c = entries[i];
+    if (c.kind == static_cast<std::uint32_t>(ContingencyKind::Connection) && c.element < g.edge_count()) {
+      by_arc_[c.element] = i;
+      if (const EdgeId twin = g.edge_twin(c.element); twin != kInvalidEdge) by_arc_[twin] = i;
+    } else if (c.kind == static_cast<std::uint32_t>(ContingencyKind::Node) && c.element < node_count_) {
+      by_node_[c.element] = i;
+    } else {
+      throw std::invalid_argument("contingency entry " + std::to_string(i) + " names no element of the building");
+    }
+  }
+}
+
+ContingencyTables ContingencyTables::from_build(const BuildingGraph& g, ContingencyBuild build) {
+  auto owned = std::make_shared<ContingencyBuild>(std::move(build));
+  return ContingencyTables(g, owned->entries, owned->next_edge, owned->distance, owned);
+}
+
+}  // namespace evac
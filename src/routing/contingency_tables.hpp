@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "exec/work_stealing_pool.hpp"
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+
+namespace evac {
+
+enum class ContingencyKind : std::uint32_t { Connection = 1, Node = 2 };
+
+// One precomputed failure. For a connection, `element` is its lower arc id and
+// both arcs are closed; for a node, every arc into and out of it is closed.
+// `load` is what it was ranked by (see rank_contingencies()): by default how
+// many nodes' exit routes pass through it on the clear building.
+struct ContingencyEntry {
+  std::uint32_t kind;
+  std::uint32_t element;
+  std::uint32_t load;
+  std::uint32_t reserved;
+};
+static_assert(sizeof(ContingencyEntry) == 16);
+
+// The k connections and nodes carrying the most exit routes on the building as
+// it stands (its current hazards), most loaded first; ties go to connections,
+// then to the lower id. Elements no route uses are never ranked. Exit-route
+// betweenness is exact here: each node has one route, so an element's load is
+// the size of its subtree in the shortest-path tree, found in one sweep.
+//
+// With `edge_betweenness` (one value per arc, e.g. from a criticality
+// analysis) elements are ranked by that instead: a connection by the sum of
+// its arcs, a node by the sum of its in-arcs, rounded to whole paths.
+std::vector<ContingencyEntry> rank_contingencies(const BuildingGraph& g, std::size_t k,
+                                                 std::span<const float> edge_betweenness = {});
+
+// Exit fields for each entry, row-major: row i holds node_count values.
+struct ContingencyBuild {
+  std::vector<ContingencyEntry> entries;
+  std::vector<EdgeId> next_edge;
+  std::vector<Cost> distance;
+};
+
+// Solves every entry's field with SmokeCost on a copy of `g` with the element
+// closed, one entry per pool task. Offline work: `compile --contingencies`
+// stores the result in the model file.
+ContingencyBuild build_contingency_tables(const BuildingGraph& g, std::span<const ContingencyEntry> entries,
+                                          WorkStealingPool& pool);
+
+// Read-only view of a set of contingency tables, usually straight from a
+// mapped model. Matching a blockage to its table is an array lookup and each
+// table is a ready next-edge column, so switching guidance to it costs
+// nothing beyond that lookup; the incremental router then repairs towards the
+// exact field for the hazards actually present.
+class ContingencyTables {
+ public:
+  static constexpr std::uint32_t kNone = 0xffffffffu;
+
+  ContingencyTables() = default;
+  // `storage` keeps the memory behind the spans alive. Throws
+  // std::invalid_argument when the shapes disagree with `g`.
+  ContingencyTables(const BuildingGraph& g, std::span<const ContingencyEntry> entries,
+                    std::span<const EdgeId> next_edge, std::span<const Cost> distance,
+                    std::shared_ptr<const void> storage);
+  static ContingencyTables from_build(const BuildingGraph& g, ContingencyBuild build);
+
+  std::size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+  const ContingencyEntry& entry(std::uint32_t i) const { return entries_[i]; }
+
+  // Table for closing the connection of arc e (either direction), or kNone.
+  std::uint32_t match_connection(EdgeId e) const { return e < by_arc_.size() ? by_arc_[e] : kNone; }
+  std::uint32_t match_node(NodeId v) const { return v < by_node_.size() ? by_node_[v] : kNone; }
+
+  std::span<const EdgeId> next_edges(std::uint32_t i) const { return next_edge_.subspan(i * node_count_, node_count_); }
+  std::span<const Cost> distances(std::uint32_t i) const { return distance_.subspan(i * node_count_, node_count_); }
+
+ private:
+  std::shared_ptr<const void> storage_;
+  std::size_t node_count_ = 0;
+  std::span<const ContingencyEntry> entries_;
+  std::span<const EdgeId> next_edge_;
+  std::span<const Cost> distance_;
+  std::vector<std::uint32_t> by_arc_;
+  std::vector<std::uint32_t> by_node_;
+};
+
+// Arcs a contingency closes: both arcs of the connection, or every arc at the node.
+void contingency_arcs(const BuildingGraph& g, const ContingencyEntry& entry, std::vector<EdgeId>& out);
+
+}  // namespace evac
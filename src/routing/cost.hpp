@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "graph/building_graph.hpp"
+
+namespace evac {
+
+// Travel costs are quantised walking times in deciseconds. Integer costs keep
+// equality tests in the incremental engine exact and make distance fields
+// bit-identical between solvers.
+using Cost = std::uint32_t;
+
+inline constexpr Cost kInfiniteCost = std::numeric_limits<Cost>::max();
+
+// Hazard at or above this level closes the arc.
+inline constexpr float kImpassableHazard = 1.0f;
+// Partial hazard (light smoke) stretches travel time by up to this factor.
+inline constexpr float kHazardSlowdown = 4.0f;
+
+inline Cost saturating_add(Cost a, Cost b) {
+  const Cost s = a + b;
+  return s < a ? kInfiniteCost : s;
+}
+
+inline float walking_speed_mps(EdgeKind kind) {
+  switch (kind) {
+    case EdgeKind::Stairs: return 0.6f;
+    case EdgeKind::Elevator: return 0.4f;
+    case EdgeKind::Ramp: return 1.0f;
+    case EdgeKind::Corridor:
+    case EdgeKind::Door: break;
+  }
+  return 1.2f;
+}
+
+inline Cost base_travel_cost(EdgeKind kind, float length_m) {
+  const float ds = std::ceil(length_m / walking_speed_mps(kind) * 10.0f);
+  return ds < 1.0f ? Cost{1} : static_cast<Cost>(ds);
+}
+
+inline Cost hazard_adjusted_cost(Cost base, float hazard) {
+  if (hazard >= kImpassableHazard) return kInfiniteCost;
+  if (hazard <= 0.0f) return base;
+  return static_cast<Cost>(std::ceil(static_cast<float>(base) * (1.0f + kHazardSlowdown * hazard)));
+}
+
+// Waiting time in front of a congested arc, added to its walking time.
+inline Cost congestion_delay_cost(float delay_s) {
+  return delay_s <= 0.0f ? Cost{0} : static_cast<Cost>(std::ceil(delay_s * 10.0f));
+}
+
+inline Cost edge_cost(const BuildingGraph& g, EdgeId e) {
+  return saturating_add(hazard_adjusted_cost(base_travel_cost(g.edge_kind(e), g.edge_length(e)), g.edge_hazard(e)),
+                        congestion_delay_cost(g.edge_congestion(e)));
+}
+
+}  // namespace evac
@@ -0,0 +1,26 @@
+#include "routing/cost_policy.hpp"
+
+#include <cstring>
+
+namespace evac {
+
+const char* to_string(CostModel model) {
+  switch (model) {
+    case CostModel::Smoke: return "smoke";
+    case CostModel::Distance: return "distance";
+    case CostModel::Accessible: return "accessible";
+  }
+  return "?";
+}
+
+bool parse_cost_model(const char* text, CostModel& out) {
+  for (CostModel model : {CostModel::Smoke, CostModel::Distance, CostModel::Accessible}) {
+    if (std::strcmp(text, to_string(model)) == 0) {
+      out = model;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace evac
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+
+namespace evac {
+
+enum class CostModel : std::uint8_t { Smoke, Distance, Accessible };
+
+const char* to_string(CostModel model);
+// "smoke", "distance" or "accessible"; false leaves `out` untouched.
+bool parse_cost_model(const char* text, CostModel& out);
+
+// A cost policy prices one arc. Routing kernels are templates over the
+// policy, so each model compiles to its own relaxation loop with the arc
+// cost inlined: no virtual call and no per-arc test of which model is on.
+template <class P>
+concept CostPolicy = requires(const BuildingGraph& g, EdgeId e) {
+  { P::kModel } -> std::convertible_to<CostModel>;
+  { P::arc_cost(g, e) } -> std::same_as<Cost>;
+};
+
+// Walking time stretched by smoke; the default everywhere.
+struct SmokeCost {
+  static constexpr CostModel kModel = CostModel::Smoke;
+  static Cost arc_cost(const BuildingGraph& g, EdgeId e) { return edge_cost(g, e); }
+};
+
+// Walking time only. Closed arcs stay closed; partial smoke is ignored.
+struct DistanceCost {
+  static constexpr CostModel kModel = CostModel::Distance;
+  static Cost arc_cost(const BuildingGraph& g, EdgeId e) {
+    if (g.edge_hazard(e) >= kImpassableHazard) return kInfiniteCost;
+    return base_travel_cost(g.edge_kind(e), g.edge_length(e));
+  }
+};
+
+// Step-free routes for wheelchair users: stairs are closed, everything else
+// is priced as SmokeCost. Nodes reachable only by stairs get no route.
+struct AccessibleCost {
+  static constexpr CostModel kModel = CostModel::Accessible;
+  static Cost arc_cost(const BuildingGraph& g, EdgeId e) {
+    return g.edge_kind(e) == EdgeKind::Stairs ? kInfiniteCost : edge_cost(g, e);
+  }
+};
+
+// The one runtime switch: calls fn(Policy{}) for the chosen model. Commands
+// branch here once and run a fully specialised path from then on.
+template <class Fn>
+decltype(auto) with_cost_policy(CostModel model, Fn&& fn) {
+  switch (model) {
+    case CostModel::Distance: return fn(DistanceCost{});
+    case CostModel::Accessible: return fn(AccessibleCost{});
+    case CostModel::Smoke: break;
+  }
+  return fn(SmokeCost{});
+}
+
+}  // namespace evac
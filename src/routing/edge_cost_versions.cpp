@@ -0,0 +1,117 @@
+#include "routing/edge_cost_versions.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace evac {
+
+void CostVersion::copy_hazards(std::span<float> out) const {
+  for (std::size_t c = 0; c < chunks_.size(); ++c) {
+    const std::size_t first = c * CostChunk::kArcs;
+    const std::size_t count = std::min(CostChunk::kArcs, edges_ - first);
+    std::copy_n(chunks_[c]->hazard.begin(), count, out.begin() + static_cast<std::ptrdiff_t>(first));
+  }
+}
+
+EdgeCostVersions::EdgeCostVersions(const BuildingGraph& g, EpochDomain& domain, CostModel model)
+    : domain_(domain), model_(model), edges_(g.edge_count()) {
+  const std::size_t chunks = (edges_ + CostChunk::kArcs - 1) / CostChunk::kArcs;
+  auto first = std::make_unique<CostVersion>();
+  first->version_ = 1;
+  first->model_ = model;
+  first->edges_ = edges_;
+  first->chunks_.reserve(chunks);
+  with_cost_policy(model, [&](auto policy) {
+    using Policy = decltype(policy);
+    for (std::size_t c = 0; c < chunks; ++c) {
+      auto chunk = std::make_shared<CostChunk>();
+      const std::size_t end = std::min(edges_, (c + 1) * CostChunk::kArcs);
+      for (std::size_t i = c * CostChunk::kArcs; i < end; ++i) {
+        const auto e = static_cast<EdgeId>(i);
+        chunk->hazard[i % CostChunk::kArcs] = g.edge_hazard(e);
+        chunk->congestion[i % CostChunk::kArcs] = g.edge_congestion(e);
+        chunk->cost[i % CostChunk::kArcs] = Policy::arc_cost(g, e);
+      }
+      first->chunks_.push_back(std::move(chunk));
+    }
+  });
+  cloned_.assign(chunks, 0);
+  writable_.assign(chunks, nullptr);
+  owned_current_ = std::move(first);
+  current_.store(owned_current_.get(), std::memory_order_release);
+}
+
+EdgeCostVersions::~EdgeCostVersions() = default;
+
+void EdgeCostVersions::stage(EdgeId e, float hazard, float congestion, Cost cost) {
+  staged_.push_back({e, hazard, congestion, cost});
+}
+
+std::shared_ptr<CostChunk> EdgeCostVersions::take_chunk() {
+  if (spare_chunks_.empty()) return std::make_shared<CostChunk>();
+  std::shared_ptr<CostChunk> chunk = std::move(spare_chunks_.back());
+  spare_chunks_.pop_back();
+  return chunk;
+}
+
+std::uint64_t EdgeCostVersions::publish() {
+  const CostVersion& live = *owned_current_;
+  last_cloned_ = 0;
+  if (staged_.empty()) return live.version_;
+
+  std::unique_ptr<CostVersion> next;
+  if (spare_.empty()) {
+    next = std::make_unique<CostVersion>();
+  } else {
+    next = std::move(spare_.back());
+    spare_.pop_back();
+  }
+  next->version_ = live.version_ + 1;
+  next->model_ = model_;
+  next->edges_ = edges_;
+  next->chunks_.assign(live.chunks_.begin(), live.chunks_.end());
+  for (const Staged& s : staged_) {
+    const std::size_t c = s.edge / CostChunk::kArcs;
+    if (cloned_[c] != next->version_) {
+      std::shared_ptr<CostChunk> copy = take_chunk();
+      *copy = *next->chunks_[c];
+      writable_[c] = copy.get();
+      next->chunks_[c] = std::move(copy);
+      cloned_[c] = next->version_;
+      ++last_cloned_;
+    }
+    CostChunk& chunk = *writable_[c];
+    const std::size_t i = s.edge % CostChunk::kArcs;
+    chunk.hazard[i] = s.hazard;
+    chunk.congestion[i] = s.congestion;
+    chunk.cost[i] = s.cost;
+  }
+  staged_.clear();
+
+  current_.store(next.get(), std::memory_order_seq_cst);
+  retired_.push_back({domain_.advance(), std::move(owned_current_)});
+  owned_current_ = std::move(next);
+  reclaim();
+  return owned_current_->version_;
+}
+
+std::size_t EdgeCostVersions::reclaim() {
+  if (retired_.empty()) return 0;
+  const std::uint64_t oldest = domain_.oldest_pinned();
+  // Retired in epoch order, so everything before the first survivor goes.
+  const auto keep = std::find_if(retired_.begin(), retired_.end(),
+                                 [&](const Retired& r) { return r.epoch >= oldest; });
+  const std::size_t freed = static_cast<std::size_t>(keep - retired_.begin());
+  for (auto it = retired_.begin(); it != keep; ++it) {
+    // A chunk no other version shares was cloned for this one alone.
+    for (std::shared_ptr<const CostChunk>& chunk : it->version->chunks_) {
+      if (chunk.use_count() == 1) spare_chunks_.push_back(std::const_pointer_cast<CostChunk>(std::move(chunk)));
+    }
+    it->version->chunks_.clear();
+    spare_.push_back(std::move(it->version));
+  }
+  retired_.erase(retired_.begin(), keep);
+  return freed;
+}
+
+}  // namespace evac
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "exec/epoch_domain.hpp"
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+#include "routing/cost_policy.hpp"
+
+namespace evac {
+
+// A run of consecutive arcs' hazard, congestion delay and travel cost.
+struct CostChunk {
+  static constexpr std::size_t kArcs = 256;
+  std::array<float, kArcs> hazard{};
+  std::array<float, kArcs> congestion{};
+  std::array<Cost, kArcs> cost{};
+};
+
+// One immutable generation of per-arc hazards, congestion delays and the
+// travel costs the router priced them at. Generations share every chunk
+// neither of them changed, so a version costs a pointer per chunk plus the
+// chunks its own changes touched.
+class CostVersion {
+ public:
+  std::uint64_t version() const { return version_; }
+  CostModel model() const { return model_; }
+  std::size_t edge_count() const { return edges_; }
+
+  float hazard(EdgeId e) const { return chunks_[e / CostChunk::kArcs]->hazard[e % CostChunk::kArcs]; }
+  float congestion(EdgeId e) const { return chunks_[e / CostChunk::kArcs]->congestion[e % CostChunk::kArcs]; }
+  Cost cost(EdgeId e) const { return chunks_[e / CostChunk::kArcs]->cost[e % CostChunk::kArcs]; }
+
+  // Copies the hazard of every arc into `out` (edge_count() long).
+  void copy_hazards(std::span<float> out) const;
+
+ private:
+  friend class EdgeCostVersions;
+
+  std::uint64_t version_ = 0;
+  CostModel model_ = CostModel::Smoke;
+  std::size_t edges_ = 0;
+  // Only the writer copies these pointers; readers go through the accessors,
+  // so the reference counts never see reader traffic.
+  std::vector<std::shared_ptr<const CostChunk>> chunks_;
+};
+
+// Versioned edge costs shared by the routing thread (the single writer) and
+// API request threads. The router stages every arc a repair re-priced, with
+// the cost its own policy gave it, and publish() builds the next version by
+// cloning only the chunks those arcs live in, then swaps the published
+// pointer. A version no pinned reader can still see is recycled, and chunks
+// only it held go back to a spare pool, so steady-state publishing allocates
+// nothing. Readers load current() under an EpochDomain pin and see one
+// consistent generation for as long as they hold it, without ever blocking
+// the writer or each other.
+//
+//   EpochDomain::Reader reader(domain);   // once per thread
+//   auto pin = reader.pin();
+//   const CostVersion& costs = versions.current();
+//
+// See BasicIncrementalRouter::publish_costs() for the writer side.
+class EdgeCostVersions {
+ public:
+  // The first version prices the graph's current columns under `model`.
+  EdgeCostVersions(const BuildingGraph& g, EpochDomain& domain, CostModel model = CostModel::Smoke);
+  ~EdgeCostVersions();  // readers must be gone
+  EdgeCostVersions(const EdgeCostVersions&) = delete;
+  EdgeCostVersions& operator=(const EdgeCostVersions&) = delete;
+
+  // Readers, inside a pin of the same domain; the writer may read it freely.
+  const CostVersion& current() const { return *current_.load(std::memory_order_acquire); }
+
+  CostModel model() const { return model_; }
+  std::size_t edge_count() const { return edges_; }
+  std::size_t chunk_count() const { return cloned_.size(); }
+
+  // Writer only. Stages arc e's columns and its cost under model(); the
+  // latest stage of an arc wins.
+  void stage(EdgeId e, float hazard, float congestion, Cost cost);
+  // Publishes staged changes as a new version and returns its number (the
+  // current one when nothing is staged).
+  std::uint64_t publish();
+  // Chunks the last publish() had to clone.
+  std::size_t last_cloned_chunks() const { return last_cloned_; }
+  // Recycles retired versions no reader can still see; returns how many.
+  std::size_t reclaim();
+  std::size_t retired_count() const { return retired_.size(); }
+
+ private:
+  struct Staged {
+    EdgeId edge;
+    float hazard;
+    float congestion;
+    Cost cost;
+  };
+  struct Retired {
+    std::uint64_t epoch;
+    std::unique_ptr<CostVersion> version;
+  };
+
+  std::shared_ptr<CostChunk> take_chunk();
+
+  EpochDomain& domain_;
+  CostModel model_;
+  std::size_t edges_;
+  std::atomic<CostVersion*> current_{nullptr};
+  std::unique_ptr<CostVersion> owned_current_;
+  std::vector<Staged> staged_;
+  std::vector<Retired> retired_;
+  std::vector<std::unique_ptr<CostVersion>> spare_;
+  std::vector<std::shared_ptr<CostChunk>> spare_chunks_;
+  std::vector<std::uint64_t> cloned_;  // per chunk, the version that last cloned it
+  std::vector<CostChunk*> writable_;   // per chunk, its clone in the version being built
+  std::size_t last_cloned_ = 0;
+};
+
+}  // namespace evac
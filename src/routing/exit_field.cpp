@@ -0,0 +1,39 @@
+#include "routing/exit_field.hpp"
+
+namespace evac {
+
+template <CostPolicy Policy, class Queue>
+void solve_exit_field(const BuildingGraph& g, ExitField& field, Arena& scratch) {
+  const std::size_t n = g.node_count();
+  field.distance.assign(n, kInfiniteCost);
+  field.next_edge.assign(n, kInvalidEdge);
+
+  ArenaScope scope(scratch);
+  Queue queue(scratch, n + g.exits().size());
+  for (NodeId x : g.exits()) {
+    field.distance[x] = 0;
+    queue.push(0, x);
+  }
+  while (!queue.empty()) {
+    const auto [d, v] = queue.pop();
+    if (d != field.distance[v]) continue;
+    for (EdgeId e : g.in_edges(v)) {
+      const NodeId u = g.edge_source(e);
+      const Cost candidate = saturating_add(d, Policy::arc_cost(g, e));
+      if (candidate < field.distance[u]) {
+        field.distance[u] = candidate;
+        field.next_edge[u] = e;
+        queue.push(candidate, u);
+      }
+    }
+  }
+}
+
+template void solve_exit_field<SmokeCost, BinaryHeapQueue>(const BuildingGraph&, ExitField&, Arena&);
+template void solve_exit_field<DistanceCost, BinaryHeapQueue>(const BuildingGraph&, ExitField&, Arena&);
+template void solve_exit_field<AccessibleCost, BinaryHeapQueue>(const BuildingGraph&, ExitField&, Arena&);
+template void solve_exit_field<SmokeCost, RadixHeapQueue>(const BuildingGraph&, ExitField&, Arena&);
+template void solve_exit_field<DistanceCost, RadixHeapQueue>(const BuildingGraph&, ExitField&, Arena&);
+template void solve_exit_field<AccessibleCost, RadixHeapQueue>(const BuildingGraph&, ExitField&, Arena&);
+
+}  // namespace evac
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+#include "routing/cost_policy.hpp"
+#include "routing/search_queue.hpp"
+#include "util/arena.hpp"
+
+namespace evac {
+
+// Distance from every node to its nearest reachable exit, plus the first arc of
+// that route. next_edge is kInvalidEdge at exits and at nodes with no route.
+struct ExitField {
+  std::vector<Cost> distance;
+  std::vector<EdgeId> next_edge;
+
+  NodeId next_hop(const BuildingGraph& g, NodeId v) const {
+    const EdgeId e = next_edge[v];
+    return e == kInvalidEdge ? kInvalidNode : g.edge_target(e);
+  }
+};
+
+// Full multi-source Dijkstra over the reverse graph, rooted at all exits.
+// Reference solver: the incremental engine must reproduce its distances.
+// The queue lives in `scratch` (rewound on return); without one the calling
+// thread's scratch arena is used. `field` is reused in place. Instantiated
+// for SmokeCost, DistanceCost and AccessibleCost, each over BinaryHeapQueue
+// and RadixHeapQueue; the untemplated overloads use SmokeCost on the binary
+// heap. Both queues give the same distances, but where two routes tie the
+// radix heap may settle them in another order and pick the other first arc.
+template <CostPolicy Policy, class Queue = BinaryHeapQueue>
+void solve_exit_field(const BuildingGraph& g, ExitField& field, Arena& scratch);
+
+inline void solve_exit_field(const BuildingGraph& g, ExitField& field, Arena& scratch) {
+  solve_exit_field<SmokeCost>(g, field, scratch);
+}
+inline void solve_exit_field(const BuildingGraph& g, ExitField& field) {
+  solve_exit_field<SmokeCost>(g, field, scratch_arena());
+}
+
+}  // namespace evac
@@ -0,0 +1,136 @@
+#include "routing/guidance_snapshot.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "telemetry/trace.hpp"
+
+namespace evac {
+
+namespace {
+
+template <class ArcCost>
+void sweep_batch(const BuildingGraph& g, std::span<const NodeId> origins, std::span<GuidanceAnswer> out,
+                 Arena& scratch, ArcCost&& arc_cost) {
+  const std::size_t n = g.node_count();
+  ArenaScope scope(scratch);
+  const std::span<Cost> dist = scratch.allocate_array<Cost>(n);
+  const std::span<EdgeId> next = scratch.allocate_array<EdgeId>(n);
+  const std::span<NodeId> root = scratch.allocate_array<NodeId>(n);
+  const std::span<std::uint8_t> wanted = scratch.allocate_array<std::uint8_t>(n);
+  std::fill(dist.begin(), dist.end(), kInfiniteCost);
+  std::fill(wanted.begin(), wanted.end(), 0);
+
+  std::size_t outstanding = 0;
+  for (const NodeId v : origins) {
+    if (v < n && !wanted[v]) {
+      wanted[v] = 1;
+      ++outstanding;
+    }
+  }
+
+  using Entry = std::pair<Cost, NodeId>;
+  arena_vector<Entry> queue{ArenaAllocator<Entry>(scratch)};
+  queue.reserve(n);
+  const auto push = [&](Cost d, NodeId v) {
+    queue.push_back({d, v});
+    std::push_heap(queue.begin(), queue.end(), std::greater<>());
+  };
+  for (const NodeId x : g.exits()) {
+    dist[x] = 0;
+    next[x] = kInvalidEdge;
+    root[x] = x;
+    push(0, x);
+  }
+  while (!queue.empty() && outstanding > 0) {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+    const auto [d, v] = queue.back();
+    queue.pop_back();
+    if (d != dist[v]) continue;
+    if (wanted[v]) {
+      wanted[v] = 0;
+      --outstanding;
+    }
+    for (const EdgeId e : g.in_edges(v)) {
+      const NodeId u = g.edge_source(e);
+      const Cost candidate = saturating_add(d, arc_cost(e));
+      if (candidate < dist[u]) {
+        dist[u] = candidate;
+        next[u] = e;
+        root[u] = root[v];
+        push(candidate, u);
+      }
+    }
+  }
+
+  // Origins never settled have no route; their labels may be tentative.
+  for (std::size_t i = 0; i < origins.size(); ++i) {
+    const NodeId v = origins[i];
+    GuidanceAnswer& a = out[i];
+    a = {v, kInvalidNode, kInvalidNode, kInfiniteCost};
+    if (v >= n || dist[v] == kInfiniteCost || wanted[v]) continue;
+    a.distance = dist[v];
+    a.exit = root[v];
+    a.next_hop = next[v] == kInvalidEdge ? kInvalidNode : g.edge_target(next[v]);
+  }
+}
+
+}  // namespace
+
+template <CostPolicy Policy>
+void answer_batch(const BuildingGraph& g, std::span<const NodeId> origins, std::span<GuidanceAnswer> out,
+                  Arena& scratch) {
+  sweep_batch(g, origins, out, scratch, [&](EdgeId e) { return Policy::arc_cost(g, e); });
+}
+
+template void answer_batch<SmokeCost>(const BuildingGraph&, std::span<const NodeId>, std::span<GuidanceAnswer>,
+                                      Arena&);
+template void answer_batch<DistanceCost>(const BuildingGraph&, std::span<const NodeId>, std::span<GuidanceAnswer>,
+                                         Arena&);
+template void answer_batch<AccessibleCost>(const BuildingGraph&, std::span<const NodeId>,
+                                           std::span<GuidanceAnswer>, Arena&);
+
+void answer_batch(const BuildingGraph& g, const CostVersion& costs, std::span<const NodeId> origins,
+                  std::span<GuidanceAnswer> out, Arena& scratch) {
+  sweep_batch(g, origins, out, scratch, [&](EdgeId e) { return costs.cost(e); });
+}
+
+GuidanceSnapshot::GuidanceSnapshot(const BuildingGraph& g, std::span<const Cost> distance,
+                                   std::span<const EdgeId> next_edge, std::uint64_t version)
+    : version_(version), distance_(distance.begin(), distance.end()),
+      hazard_(g.edge_hazards().begin(), g.edge_hazards().end()) {
+  EVAC_TRACE_SPAN(TraceStage::Publish);
+  build_routes(g, next_edge);
+}
+
+GuidanceSnapshot::GuidanceSnapshot(const BuildingGraph& g, std::span<const Cost> distance,
+                                   std::span<const EdgeId> next_edge, const CostVersion& costs,
+                                   std::uint64_t version)
+    : version_(version), distance_(distance.begin(), distance.end()), hazard_(costs.edge_count()) {
+  EVAC_TRACE_SPAN(TraceStage::Publish);
+  costs.copy_hazards(hazard_);
+  build_routes(g, next_edge);
+}
+
+void GuidanceSnapshot::build_routes(const BuildingGraph& g, std::span<const EdgeId> next_edge) {
+  const std::size_t n = distance_.size();
+  next_hop_.resize(n);
+  for (NodeId v = 0; v < n; ++v) {
+    next_hop_[v] = next_edge[v] == kInvalidEdge ? kInvalidNode : g.edge_target(next_edge[v]);
+  }
+  // Exit of every route: settle nodes in increasing distance so each node's
+  // next hop (strictly closer) is resolved before it.
+  exit_.assign(n, kInvalidNode);
+  std::vector<NodeId> order;
+  order.reserve(n);
+  for (NodeId v = 0; v < n; ++v) {
+    if (distance_[v] != kInfiniteCost) order.push_back(v);
+  }
+  std::sort(order.begin(), order.end(), [&](NodeId a, NodeId b) { return distance_[a] < distance_[b]; });
+  for (const NodeId v : order) {
+    exit_[v] = next_hop_[v] == kInvalidNode ? v : exit_[next_hop_[v]];
+  }
+}
+
+}  // namespace evac
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+#include "routing/cost_policy.hpp"
+#include "routing/edge_cost_versions.hpp"
+#include "util/arena.hpp"
+
+namespace evac {
+
+// "Which way to the nearest safe exit" for one origin.
+struct GuidanceAnswer {
+  NodeId origin = kInvalidNode;
+  NodeId next_hop = kInvalidNode;  // kInvalidNode at an exit or with no route
+  NodeId exit = kInvalidNode;      // exit the route ends at
+  Cost distance = kInfiniteCost;
+};
+
+// Answers a batch of origins with one reverse sweep from all exits instead
+// of one search per origin. The sweep stops as soon as the last distinct
+// origin is settled, so a batch clustered near the exits costs a fraction of
+// a full field. Per-node labels live in `scratch` and are dropped on return.
+// Specialised per cost policy like solve_exit_field(); untemplated is SmokeCost.
+template <CostPolicy Policy>
+void answer_batch(const BuildingGraph& g, std::span<const NodeId> origins, std::span<GuidanceAnswer> out,
+                  Arena& scratch);
+inline void answer_batch(const BuildingGraph& g, std::span<const NodeId> origins, std::span<GuidanceAnswer> out,
+                         Arena& scratch) {
+  answer_batch<SmokeCost>(g, origins, out, scratch);
+}
+// The same sweep over one published cost version instead of the graph's
+// live columns, so request threads can run it under an epoch pin while the
+// router keeps repairing; only the graph's topology is read.
+void answer_batch(const BuildingGraph& g, const CostVersion& costs, std::span<const NodeId> origins,
+                  std::span<GuidanceAnswer> out, Arena& scratch);
+
+// Immutable next-hop tables for every node, plus the arc hazards they were
+// routed on, at one hazard version. Built once by the routing thread after a
+// repair and then shared read-only by every sign, gateway and app request
+// thread; nothing in it ever changes.
+class GuidanceSnapshot {
+ public:
+  // From an exit field (e.g. IncrementalRouter::distances()/next_edges()).
+  GuidanceSnapshot(const BuildingGraph& g, std::span<const Cost> distance, std::span<const EdgeId> next_edge,
+                   std::uint64_t version);
+  // Same, with the hazards taken from the cost version the field was
+  // repaired to (see BasicIncrementalRouter::publish_costs()).
+  GuidanceSnapshot(const BuildingGraph& g, std::span<const Cost> distance, std::span<const EdgeId> next_edge,
+                   const CostVersion& costs, std::uint64_t version);
+
+  std::uint64_t version() const { return version_; }
+  std::size_t node_count() const { return distance_.size(); }
+
+  GuidanceAnswer lookup(NodeId origin) const {
+    if (origin >= distance_.size()) return {origin, kInvalidNode, kInvalidNode, kInfiniteCost};
+    return {origin, next_hop_[origin], exit_[origin], distance_[origin]};
+  }
+  void answer(std::span<const NodeId> origins, std::span<GuidanceAnswer> out) const {
+    for (std::size_t i = 0; i < origins.size(); ++i) out[i] = lookup(origins[i]);
+  }
+
+  std::span<const NodeId> next_hops() const { return next_hop_; }
+  std::span<const Cost> distances() const { return distance_; }
+  std::span<const NodeId> exits() const { return exit_; }
+  std::span<const float> hazards() const { return hazard_; }
+
+ private:
+  void build_routes(const BuildingGraph& g, std::span<const EdgeId> next_edge);
+
+  std::uint64_t version_;
+  std::vector<Cost> distance_;
+  std::vector<NodeId> next_hop_;
+  std::vector<NodeId> exit_;
+  std::vector<float> hazard_;
+};
+
+// Single-writer publication point for guidance snapshots. Readers take the
+// current snapshot with one atomic load and keep it as long as they like;
+// the writer swaps in a new one without ever waiting for them, and the last
+// reader holding an old snapshot frees it.
+class GuidancePublisher {
+ public:
+  std::shared_ptr<const GuidanceSnapshot> current() const { return current_.load(std::memory_order_acquire); }
+
+  void publish(std::shared_ptr<const GuidanceSnapshot> snapshot) {
+    current_.store(std::move(snapshot), std::memory_order_release);
+  }
+
+ private:
+  std::atomic<std::shared_ptr<const GuidanceSnapshot>> current_;
+};
+
+}  // namespace evac
@@ -0,0 +1,259 @@
+#include "routing/incremental_router.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "telemetry/trace.hpp"
+
+namespace evac {
+
+template <CostPolicy Policy>
+BasicIncrementalRouter<Policy>::BasicIncrementalRouter(BuildingGraph& graph) : graph_(graph) {
+  const std::size_t n = graph_.node_count();
+  const std::size_t m = graph_.edge_count();
+  edge_cost_.resize(m);
+  for (EdgeId e = 0; e < m; ++e) edge_cost_[e] = Policy::arc_cost(graph_, e);
+
+  ExitField initial;
+  solve_exit_field<Policy>(graph_, initial, scratch_arena());
+  g_ = initial.distance;
+  rhs_ = std::move(initial.distance);
+  next_edge_ = std::move(initial.next_edge);
+
+  is_exit_.assign(n, false);
+  for (NodeId x : graph_.exits()) is_exit_[x] = true;
+  queue_.resize(n);
+  changed_stamp_.assign(n, 0);
+}
+
+template <CostPolicy Policy>
+BasicIncrementalRouter<Policy>::BasicIncrementalRouter(BuildingGraph& graph, std::span<const Cost> distance,
+                                                       std::span<const EdgeId> next_edge)
+    : graph_(graph) {
+  const std::size_t n = graph_.node_count();
+  const std::size_t m = graph_.edge_count();
+  if (distance.size() != n || next_edge.size() != n) {
+    throw std::invalid_argument("saved exit field does not match the building");
+  }
+  edge_cost_.resize(m);
+  for (EdgeId e = 0; e < m; ++e) edge_cost_[e] = Policy::arc_cost(graph_, e);
+  g_.assign(n, kInfiniteCost);
+  rhs_.assign(n, kInfiniteCost);
+  next_edge_.assign(n, kInvalidEdge);
+  is_exit_.assign(n, false);
+  for (NodeId x : graph_.exits()) {
+    is_exit_[x] = true;
+    rhs_[x] = 0;
+  }
+  queue_.resize(n);
+  changed_stamp_.assign(n, 0);
+  std::vector<Cost> guess(distance.begin(), distance.end());
+  for (NodeId x : graph_.exits()) guess[x] = 0;  // repair_from() takes exits as given
+  repair_from(guess, next_edge);
+}
+
+template <CostPolicy Policy>
+void BasicIncrementalRouter<Policy>::set_edge_hazard(EdgeId e, float hazard) {
+  graph_.set_edge_hazard(e, hazard);
+  pending_edges_.push_back(e);
+}
+
+template <CostPolicy Policy>
+void BasicIncrementalRouter<Policy>::set_edge_congestion(EdgeId e, float delay_s) {
+  graph_.set_edge_congestion(e, delay_s);
+  pending_edges_.push_back(e);
+}
+
+template <CostPolicy Policy>
+void BasicIncrementalRouter<Policy>::publish_costs(EdgeCostVersions* versions) {
+  if (versions && (versions->model() != Policy::kModel || versions->edge_count() != graph_.edge_count())) {
+    throw std::invalid_argument("cost versions do not match the router");
+  }
+  versions_ = versions;
+  if (!versions_) return;
+  const CostVersion& published = versions_->current();
+  for (EdgeId e = 0; e < graph_.edge_count(); ++e) {
+    if (published.cost(e) != edge_cost_[e] || published.hazard(e) != graph_.edge_hazard(e) ||
+        published.congestion(e) != graph_.edge_congestion(e)) {
+      stage_cost(e, edge_cost_[e]);
+    }
+  }
+  versions_->publish();
+}
+
+template <CostPolicy Policy>
+void BasicIncrementalRouter<Policy>::stage_cost(EdgeId e, Cost cost) {
+  versions_->stage(e, graph_.edge_hazard(e), graph_.edge_congestion(e), cost);
+}
+
+template <CostPolicy Policy>
+void BasicIncrementalRouter<Policy>::update_vertex(NodeId u) {
+  if (g_[u] != rhs_[u]) {
+    queue_.push_or_update(u, key(u));
+  } else {
+    queue_.erase(u);
+  }
+}
+
+template <CostPolicy Policy>
+void BasicIncrementalRouter<Policy>::recompute_rhs(NodeId u) {
+  Cost best = kInfiniteCost;
+  EdgeId best_edge = kInvalidEdge;
+  for (EdgeId e : graph_.out_edges(u)) {
+    const Cost c = saturating_add(edge_cost_[e], g_[graph_.edge_target(e)]);
+    if (c < best) {
+      best = c;
+      best_edge = e;
+    }
+  }
+  rhs_[u] = best;
+  next_edge_[u] = best_edge;
+}
+
+template <CostPolicy Policy>
+void BasicIncrementalRouter<Policy>::note_next_hop(NodeId u, EdgeId before) {
+  if (next_edge_[u] != before && changed_stamp_[u] != repair_epoch_) {
+    changed_stamp_[u] = repair_epoch_;
+    changed_next_hops_.push_back(u);
+  }
+}
+
+template <CostPolicy Policy>
+void BasicIncrementalRouter<Policy>::begin_repair() {
+  if (++repair_epoch_ == 0) {
+    changed_stamp_.assign(changed_stamp_.size(), 0);
+    repair_epoch_ = 1;
+  }
+  changed_next_hops_.clear();
+}
+
+template <CostPolicy Policy>
+RepairStats BasicIncrementalRouter<Policy>::repair() {
+  EVAC_TRACE_SPAN(TraceStage::Route);
+  RepairStats stats;
+  begin_repair();
+
+  for (EdgeId e : pending_edges_) {
+    const Cost updated = Policy::arc_cost(graph_, e);
+    const Cost old = edge_cost_[e];
+    // Staged even when the cost holds: the published columns still moved.
+    if (versions_) stage_cost(e, updated);
+    if (updated == old) continue;
+    edge_cost_[e] = updated;
+    ++stats.changed_edges;
+
+    const NodeId u = graph_.edge_source(e);
+    if (is_exit_[u]) continue;
+    const EdgeId before = next_edge_[u];
+    if (updated < old) {
+      const Cost c = saturating_add(updated, g_[graph_.edge_target(e)]);
+      if (c < rhs_[u]) {
+        rhs_[u] = c;
+        next_edge_[u] = e;
+      }
+    } else if (before == e) {
+      recompute_rhs(u);
+    }
+    note_next_hop(u, before);
+    update_vertex(u);
+  }
+  pending_edges_.clear();
+  settle(stats);
+  if (versions_) versions_->publish();
+  return stats;
+}
+
+template <CostPolicy Policy>
+RepairStats BasicIncrementalRouter<Policy>::repair_from(std::span<const Cost> distance,
+                                                        std::span<const EdgeId> next_edge) {
+  EVAC_TRACE_SPAN(TraceStage::Route);
+  if (distance.size() != graph_.node_count() || next_edge.size() != graph_.node_count()) {
+    throw std::invalid_argument("exit field does not match the building");
+  }
+  RepairStats stats;
+  begin_repair();
+  for (EdgeId e : pending_edges_) {
+    const Cost updated = Policy::arc_cost(graph_, e);
+    if (versions_) stage_cost(e, updated);
+    if (updated == edge_cost_[e]) continue;
+    edge_cost_[e] = updated;
+    ++stats.changed_edges;
+  }
+  pending_edges_.clear();
+
+  const std::size_t n = graph_.node_count();
+  std::vector<EdgeId> before(next_edge_.begin(), next_edge_.end());
+  std::copy(distance.begin(), distance.end(), g_.begin());
+  while (!queue_.empty()) queue_.pop();
+  for (NodeId u = 0; u < n; ++u) {
+    if (is_exit_[u]) continue;
+    // A guess is only a hint: one that is out of range or does not leave u
+    // (a damaged table, say) is ignored.
+    const EdgeId guess = next_edge[u];
+    recompute_rhs(u);
+    if (guess < graph_.edge_count() && graph_.edge_source(guess) == u && next_edge_[u] != guess &&
+        rhs_[u] != kInfiniteCost &&
+        saturating_add(edge_cost_[guess], g_[graph_.edge_target(guess)]) == rhs_[u]) {
+      next_edge_[u] = guess;
+    }
+    note_next_hop(u, before[u]);
+    update_vertex(u);
+  }
+  settle(stats);
+  // A poor guess moves hops that settling then puts back; report net changes only.
+  std::erase_if(changed_next_hops_, [&](NodeId v) { return next_edge_[v] == before[v]; });
+  stats.changed_next_hops = changed_next_hops_.size();
+  if (versions_) versions_->publish();
+  return stats;
+}
+
+template <CostPolicy Policy>
+void BasicIncrementalRouter<Policy>::settle(RepairStats& stats) {
+  while (!queue_.empty()) {
+    const NodeId u = queue_.pop();
+    ++stats.expanded_nodes;
+    if (g_[u] > rhs_[u]) {
+      // Overconsistent: the distance dropped; settle it and offer it upstream.
+      g_[u] = rhs_[u];
+      for (EdgeId e : graph_.in_edges(u)) {
+        const NodeId w = graph_.edge_source(e);
+        if (is_exit_[w]) continue;
+        const Cost c = saturating_add(edge_cost_[e], g_[u]);
+        if (c < rhs_[w]) {
+          const EdgeId before = next_edge_[w];
+          rhs_[w] = c;
+          next_edge_[w] = e;
+          note_next_hop(w, before);
+          update_vertex(w);
+        }
+      }
+    } else {
+      // Underconsistent: the distance rose. Invalidate it and re-derive every
+      // predecessor that was routing through u.
+      g_[u] = kInfiniteCost;
+      update_vertex(u);
+      for (EdgeId e : graph_.in_edges(u)) {
+        const NodeId w = graph_.edge_source(e);
+        if (is_exit_[w] || next_edge_[w] != e) continue;
+        recompute_rhs(w);
+        note_next_hop(w, e);
+        update_vertex(w);
+      }
+    }
+  }
+
+  stats.changed_next_hops = changed_next_hops_.size();
+}
+
+template <CostPolicy Policy>
+void BasicIncrementalRouter<Policy>::export_field(ExitField& out) const {
+  out.distance = g_;
+  out.next_edge = next_edge_;
+}
+
+template class BasicIncrementalRouter<SmokeCost>;
+template class BasicIncrementalRouter<DistanceCost>;
+template class BasicIncrementalRouter<AccessibleCost>;
+
+}  // namespace evac
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+#include "routing/cost_policy.hpp"
+#include "routing/edge_cost_versions.hpp"
+#include "routing/exit_field.hpp"
+#include "routing/indexed_heap.hpp"
+
+namespace evac {
+
+struct RepairStats {
+  std::size_t changed_edges = 0;
+  std::size_t expanded_nodes = 0;  // queue pops during the repair
+  std::size_t changed_next_hops = 0;
+};
+
+// Exit-distance field maintained with Lifelong Planning A* run backwards from
+// the exit super-source. There is no heuristic — every node is a goal — so the
+// key is min(g, rhs) and a repair only expands nodes whose distance actually
+// changes, instead of re-running the multi-source Dijkstra over the building.
+//
+// The router owns the graph's hazard and congestion columns: writes go
+// through set_edge_hazard() and set_edge_congestion() so the cached arc cost
+// stays in sync, and repair() brings the field back to consistency in one
+// batch. With publish_costs() each repair also publishes the arcs it
+// re-priced as a new EdgeCostVersions generation, for threads that must read
+// costs while the router keeps writing the columns.
+//
+// Arc costs come from the cost policy; IncrementalRouter is the SmokeCost
+// router, and the other models are instantiated alongside it.
+template <CostPolicy Policy>
+class BasicIncrementalRouter {
+ public:
+  using policy = Policy;
+
+  explicit BasicIncrementalRouter(BuildingGraph& graph);
+  // Starts from a saved field (a checkpoint of another router on the same
+  // building) instead of solving from scratch: one repair_from() pass, so the
+  // field is exact for the graph's current hazards even if the save is stale.
+  // Throws std::invalid_argument if the spans are not node_count long.
+  BasicIncrementalRouter(BuildingGraph& graph, std::span<const Cost> distance, std::span<const EdgeId> next_edge);
+
+  const BuildingGraph& graph() const { return graph_; }
+
+  // Records a hazard change; the field is stale until repair().
+  void set_edge_hazard(EdgeId e, float hazard);
+  // Records a queueing-delay change (see OccupancyFusion); same contract.
+  void set_edge_congestion(EdgeId e, float delay_s);
+  RepairStats repair();
+  // Like repair(), but first replaces the field with a precomputed one, e.g. a
+  // ContingencyTables row for the blockage just recorded. Every node's rhs is
+  // re-derived from the current arc costs in one linear pass, so the result is
+  // exact whatever else differs from the building the field was solved on; a
+  // good guess only makes the settling afterwards short. Next hops the guess
+  // already has are kept on ties, and changes are reported against the field
+  // as it was before the call; a next hop that does not leave its node is
+  // ignored. Throws std::invalid_argument if the spans are not node_count
+  // long.
+  RepairStats repair_from(std::span<const Cost> distance, std::span<const EdgeId> next_edge);
+
+  // Publishes to `versions` after every repair, priced by this router's
+  // policy. Attach between repairs: it first publishes any arc the current
+  // version disagrees on. Null
+  // detaches. Throws std::invalid_argument if `versions` was built for
+  // another cost model or building.
+  void publish_costs(EdgeCostVersions* versions);
+
+  Cost distance(NodeId v) const { return g_[v]; }
+  EdgeId next_edge(NodeId v) const { return next_edge_[v]; }
+  NodeId next_hop(NodeId v) const {
+    const EdgeId e = next_edge_[v];
+    return e == kInvalidEdge ? kInvalidNode : graph_.edge_target(e);
+  }
+  std::span<const Cost> distances() const { return g_; }
+  std::span<const EdgeId> next_edges() const { return next_edge_; }
+
+  // Copies the current field; used to cross-check against solve_exit_field().
+  void export_field(ExitField& out) const;
+
+  // Visits the nodes whose next hop changed during the last repair().
+  template <class Fn>
+  void for_each_changed_next_hop(Fn&& fn) const {
+    for (NodeId v : changed_next_hops_) fn(v);
+  }
+
+ private:
+  Cost key(NodeId v) const { return g_[v] < rhs_[v] ? g_[v] : rhs_[v]; }
+  void update_vertex(NodeId u);
+  void recompute_rhs(NodeId u);
+  void note_next_hop(NodeId u, EdgeId before);
+  void begin_repair();
+  void settle(RepairStats& stats);
+  void stage_cost(EdgeId e, Cost cost);
+
+  BuildingGraph& graph_;
+  EdgeCostVersions* versions_ = nullptr;
+  std::vector<Cost> edge_cost_;  // cached Policy::arc_cost()
+  std::vector<Cost> g_;
+  std::vector<Cost> rhs_;
+  std::vector<EdgeId> next_edge_;
+  std::vector<bool> is_exit_;
+  IndexedHeap queue_;
+
+  std::vector<EdgeId> pending_edges_;
+  std::vector<NodeId> changed_next_hops_;
+  std::vector<std::uint32_t> changed_stamp_;
+  std::uint32_t repair_epoch_ = 0;
+};
+
+extern template class BasicIncrementalRouter<SmokeCost>;
+extern template class BasicIncrementalRouter<DistanceCost>;
+extern template class BasicIncrementalRouter<AccessibleCost>;
+
+using IncrementalRouter = BasicIncrementalRouter<SmokeCost>;
+
+}  // namespace evac
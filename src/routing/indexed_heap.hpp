@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "routing/cost.hpp"
+
+namespace evac {
+
+// Binary min-heap over node ids with O(1) membership and in-place key updates,
+// as needed by LPA*, where a vertex's key can move up or down or the vertex can
+// leave the queue entirely. Keys and ids are stored interleaved so a sift only
+// touches one array.
+class IndexedHeap {
+ public:
+  static constexpr std::uint32_t kAbsent = std::numeric_limits<std::uint32_t>::max();
+
+  void resize(std::size_t ids) {
+    position_.assign(ids, kAbsent);
+    heap_.clear();
+  }
+
+  bool empty() const { return heap_.empty(); }
+  std::size_t size() const { return heap_.size(); }
+  bool contains(NodeId v) const { return position_[v] != kAbsent; }
+  Cost top_key() const { return heap_.empty() ? kInfiniteCost : heap_.front().key; }
+  NodeId top() const { return heap_.front().id; }
+
+  // Inserts v or moves it to the new key.
+  void push_or_update(NodeId v, Cost key) {
+    std::uint32_t i = position_[v];
+    if (i == kAbsent) {
+      i = static_cast<std::uint32_t>(heap_.size());
+      heap_.push_back({key, v});
+      position_[v] = i;
+      sift_up(i);
+      return;
+    }
+    const Cost old = heap_[i].key;
+    heap_[i].key = key;
+    if (key < old) sift_up(i);
+    else sift_down(i);
+  }
+
+  NodeId pop() {
+    const NodeId v = heap_.front().id;
+    remove_at(0);
+    return v;
+  }
+
+  void erase(NodeId v) {
+    if (const std::uint32_t i = position_[v]; i != kAbsent) remove_at(i);
+  }
+
+ private:
+  struct Slot {
+    Cost key;
+    NodeId id;
+  };
+
+  void remove_at(std::uint32_t i) {
+    position_[heap_[i].id] = kAbsent;
+    const Slot last = heap_.back();
+    heap_.pop_back();
+    if (i == heap_.size()) return;
+    heap_[i] = last;
+    position_[last.id] = i;
+    if (i > 0 && last.key < heap_[(i - 1) / 2].key) sift_up(i);
+    else sift_down(i);
+  }
+
+  void sift_up(std::uint32_t i) {
+    const Slot s = heap_[i];
+    while (i > 0) {
+      const std::uint32_t parent = (i - 1) / 2;
+      if (!(s.key < heap_[parent].key)) break;
+      place(i, heap_[parent]);
+      i = parent;
+    }
+    place(i, s);
+  }
+
+  void sift_down(std::uint32_t i) {
+    const Slot s = heap_[i];
+    const auto n = static_cast<std::uint32_t>(heap_.size());
+    for (;;) {
+      std::uint32_t child = 2 * i + 1;
+      if (child >= n) break;
+      if (child + 1 < n && heap_[child + 1].key < heap_[child].key) ++child;
+      if (!(heap_[child].key < s.key)) break;
+      place(i, heap_[child]);
+      i = child;
+    }
+    place(i, s);
+  }
+
+  void place(std::uint32_t i, const Slot& s) {
+    heap_[i] = s;
+    position_[s.id] = i;
+  }
+
+  std::vector<Slot> heap_;
+  std::vector<std::uint32_t> position_;
+};
+
+}  // namespace evac
@@ -0,0 +1,261 @@
+#include "routing/overlay_router.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "telemetry/trace.hpp"
+
+namespace evac {
+
+OverlayRouter::OverlayRouter(BuildingGraph& graph) : graph_(graph) {
+  const std::size_t n = graph_.node_count();
+  const std::size_t m = graph_.edge_count();
+  edge_cost_.resize(m);
+  for (EdgeId e = 0; e < m; ++e) edge_cost_[e] = edge_cost(graph_, e);
+  floors_ = static_cast<std::size_t>(std::max(1, graph_.floor_count()));
+
+  // Counting sort of nodes by floor.
+  floor_offsets_.assign(floors_ + 1, 0);
+  for (NodeId v = 0; v < n; ++v) ++floor_offsets_[floor_index(v) + 1];
+  for (std::size_t f = 0; f < floors_; ++f) floor_offsets_[f + 1] += floor_offsets_[f];
+  floor_node_list_.resize(n);
+  std::vector<std::uint32_t> slot(floor_offsets_.begin(), floor_offsets_.end() - 1);
+  for (NodeId v = 0; v < n; ++v) floor_node_list_[slot[floor_index(v)]++] = v;
+
+  std::vector<std::uint8_t> is_portal(n, 0);
+  for (EdgeId e = 0; e < m; ++e) {
+    if (!crosses_floor(e)) continue;
+    is_portal[graph_.edge_source(e)] = 1;
+    is_portal[graph_.edge_target(e)] = 1;
+  }
+  portal_of_.assign(n, kNoPortal);
+  portal_offsets_.assign(floors_ + 1, 0);
+  table_offset_.assign(floors_ + 1, 0);
+  for (std::uint32_t f = 0; f < floors_; ++f) {
+    for (const NodeId v : floor_nodes(f)) {
+      if (!is_portal[v]) continue;
+      portal_of_[v] = static_cast<std::uint32_t>(portal_nodes_.size());
+      portal_nodes_.push_back(v);
+    }
+    portal_offsets_[f + 1] = static_cast<std::uint32_t>(portal_nodes_.size());
+    const std::size_t p = portal_offsets_[f + 1] - portal_offsets_[f];
+    table_offset_[f + 1] = table_offset_[f] + p * p;
+  }
+
+  const std::size_t k = portal_nodes_.size();
+  table_.assign(table_offset_[floors_], kInfiniteCost);
+  exit_cost_.assign(k, kInfiniteCost);
+  overlay_.assign(k, kInfiniteCost);
+  cross_.assign(k, kInfiniteCost);
+  cross_via_.assign(k, kInvalidEdge);
+  dist_.assign(n, kInfiniteCost);
+  next_.assign(n, kInvalidEdge);
+  floor_dirty_.assign(floors_, 1);
+  field_valid_.assign(floors_, 0);
+  repair();
+}
+
+void OverlayRouter::set_edge_hazard(EdgeId e, float hazard) {
+  graph_.set_edge_hazard(e, hazard);
+  pending_edges_.push_back(e);
+}
+
+void OverlayRouter::floor_search(std::uint32_t f, std::span<const Seed> seeds, bool portals_only) {
+  for (const NodeId v : floor_nodes(f)) {
+    dist_[v] = kInfiniteCost;
+    next_[v] = kInvalidEdge;
+  }
+  ArenaScope scope(scratch_);
+  using Entry = std::pair<Cost, NodeId>;
+  arena_vector<Entry> queue{ArenaAllocator<Entry>(scratch_)};
+  queue.reserve(floor_nodes(f).size() + seeds.size());
+  const auto push = [&](Cost d, NodeId v) {
+    queue.push_back({d, v});
+    std::push_heap(queue.begin(), queue.end(), std::greater<>());
+  };
+  std::size_t portals_left = floor_portals(f).size();
+  for (const Seed& s : seeds) {
+    if (s.dist >= dist_[s.node]) continue;
+    dist_[s.node] = s.dist;
+    next_[s.node] = s.via;
+    push(s.dist, s.node);
+  }
+  while (!queue.empty()) {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+    const auto [d, v] = queue.back();
+    queue.pop_back();
+    if (d != dist_[v]) continue;
+    if (portals_only && portal_of_[v] != kNoPortal && --portals_left == 0) break;
+    for (const EdgeId e : graph_.in_edges(v)) {
+      const NodeId u = graph_.edge_source(e);
+      if (floor_index(u) != f) continue;
+      const Cost candidate = saturating_add(d, edge_cost_[e]);
+      if (candidate < dist_[u]) {
+        dist_[u] = candidate;
+        next_[u] = e;
+        push(candidate, u);
+      }
+    }
+  }
+}
+
+// One floor search per portal (distances to it) plus one from the floor's
+// exits, each stopping once the floor's portals are settled. Leaves dist_
+// clobbered for the floor, so its field is invalidated.
+void OverlayRouter::customise(std::uint32_t f) {
+  const std::span<const NodeId> portals = floor_portals(f);
+  const std::size_t p = portals.size();
+  Cost* table = table_.data() + table_offset_[f];
+  field_valid_[f] = 0;
+
+  Seed seed{};
+  for (std::size_t j = 0; j < p; ++j) {
+    seed = {portals[j], 0, kInvalidEdge};
+    floor_search(f, {&seed, 1}, true);
+    for (std::size_t i = 0; i < p; ++i) table[i * p + j] = dist_[portals[i]];
+  }
+
+  ArenaScope scope(scratch_);
+  arena_vector<Seed> exits{ArenaAllocator<Seed>(scratch_)};
+  for (const NodeId x : graph_.exits()) {
+    if (floor_index(x) == f) exits.push_back({x, 0, kInvalidEdge});
+  }
+  floor_search(f, exits, true);
+  for (std::size_t i = 0; i < p; ++i) exit_cost_[portal_offsets_[f] + i] = dist_[portals[i]];
+}
+
+// Reverse Dijkstra over the portals from a virtual exit sink: a portal starts
+// at its in-floor exit distance, cliques relax through the floor tables and
+// inter-floor arcs relax directly. Afterwards each portal's best inter-floor
+// continuation (cross_) is what seeds the floor-local fields.
+std::size_t OverlayRouter::solve_overlay() {
+  const std::size_t k = portal_nodes_.size();
+  ArenaScope scope(scratch_);
+  using Entry = std::pair<Cost, std::uint32_t>;
+  arena_vector<Entry> queue{ArenaAllocator<Entry>(scratch_)};
+  queue.reserve(k);
+  const auto push = [&](Cost d, std::uint32_t q) {
+    queue.push_back({d, q});
+    std::push_heap(queue.begin(), queue.end(), std::greater<>());
+  };
+  for (std::uint32_t q = 0; q < k; ++q) {
+    overlay_[q] = exit_cost_[q];
+    if (overlay_[q] != kInfiniteCost) push(overlay_[q], q);
+  }
+
+  std::size_t settled = 0;
+  while (!queue.empty()) {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+    const auto [d, q] = queue.back();
+    queue.pop_back();
+    if (d != overlay_[q]) continue;
+    ++settled;
+    const NodeId v = portal_nodes_[q];
+    const std::uint32_t f = floor_index(v);
+    const std::uint32_t first = portal_offsets_[f];
+    const std::size_t p = portal_offsets_[f + 1] - first;
+    const Cost* table = table_.data() + table_offset_[f];
+    const std::size_t j = q - first;
+    for (std::size_t i = 0; i < p; ++i) {
+      const Cost candidate = saturating_add(table[i * p + j], d);
+      if (candidate < overlay_[first + i]) {
+        overlay_[first + i] = candidate;
+        push(candidate, static_cast<std::uint32_t>(first + i));
+      }
+    }
+    for (const EdgeId e : graph_.in_edges(v)) {
+      if (!crosses_floor(e)) continue;
+      const std::uint32_t u = portal_of_[graph_.edge_source(e)];
+      const Cost candidate = saturating_add(edge_cost_[e], d);
+      if (candidate < overlay_[u]) {
+        overlay_[u] = candidate;
+        push(candidate, u);
+      }
+    }
+  }
+  return settled;
+}
+
+OverlayRepairStats OverlayRouter::repair() {
+  EVAC_TRACE_SPAN(TraceStage::Route);
+  OverlayRepairStats stats;
+  std::sort(pending_edges_.begin(), pending_edges_.end());
+  pending_edges_.erase(std::unique(pending_edges_.begin(), pending_edges_.end()), pending_edges_.end());
+  for (const EdgeId e : pending_edges_) {
+    const Cost c = edge_cost(graph_, e);
+    if (c == edge_cost_[e]) continue;
+    edge_cost_[e] = c;
+    ++stats.changed_edges;
+    // Inter-floor arcs live only in the overlay; in-floor arcs dirty their cell.
+    if (crosses_floor(e)) {
+      field_valid_[floor_index(graph_.edge_source(e))] = 0;
+    } else {
+      floor_dirty_[floor_index(graph_.edge_source(e))] = 1;
+    }
+  }
+  pending_edges_.clear();
+
+  for (std::uint32_t f = 0; f < floors_; ++f) {
+    if (!floor_dirty_[f]) continue;
+    customise(f);
+    floor_dirty_[f] = 0;
+    ++stats.customised_floors;
+  }
+  stats.overlay_nodes = solve_overlay();
+
+  // A floor's field depends only on its arcs and its portals' continuations.
+  for (std::uint32_t f = 0; f < floors_; ++f) {
+    bool changed = false;
+    for (std::uint32_t q = portal_offsets_[f]; q < portal_offsets_[f + 1]; ++q) {
+      Cost best = kInfiniteCost;
+      EdgeId via = kInvalidEdge;
+      for (const EdgeId e : graph_.out_edges(portal_nodes_[q])) {
+        if (!crosses_floor(e)) continue;
+        const Cost c = saturating_add(edge_cost_[e], overlay_[portal_of_[graph_.edge_target(e)]]);
+        if (c < best) {
+          best = c;
+          via = e;
+        }
+      }
+      if (best != cross_[q] || via != cross_via_[q]) changed = true;
+      cross_[q] = best;
+      cross_via_[q] = via;
+    }
+    if (changed && field_valid_[f]) field_valid_[f] = 0;
+    if (!field_valid_[f]) ++stats.invalidated_floors;
+  }
+  return stats;
+}
+
+void OverlayRouter::ensure_floor(std::uint32_t f) {
+  if (field_valid_[f]) return;
+  ArenaScope scope(scratch_);
+  arena_vector<Seed> seeds{ArenaAllocator<Seed>(scratch_)};
+  for (const NodeId x : graph_.exits()) {
+    if (floor_index(x) == f) seeds.push_back({x, 0, kInvalidEdge});
+  }
+  for (std::uint32_t q = portal_offsets_[f]; q < portal_offsets_[f + 1]; ++q) {
+    if (cross_[q] != kInfiniteCost) seeds.push_back({portal_nodes_[q], cross_[q], cross_via_[q]});
+  }
+  floor_search(f, seeds);
+  field_valid_[f] = 1;
+}
+
+Cost OverlayRouter::distance(NodeId v) {
+  ensure_floor(floor_index(v));
+  return dist_[v];
+}
+
+EdgeId OverlayRouter::next_edge(NodeId v) {
+  ensure_floor(floor_index(v));
+  return next_[v];
+}
+
+void OverlayRouter::export_field(ExitField& out) {
+  for (std::uint32_t f = 0; f < floors_; ++f) ensure_floor(f);
+  out.distance = dist_;
+  out.next_edge = next_;
+}
+
+}  // namespace evac
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+#include "routing/exit_field.hpp"
+#include "util/arena.hpp"
+
+namespace evac {
+
+struct OverlayRepairStats {
+  std::size_t changed_edges = 0;
+  std::size_t customised_floors = 0;   // floors whose portal tables were rebuilt
+  std::size_t invalidated_floors = 0;  // floors whose local field is stale until next queried
+  std::size_t overlay_nodes = 0;       // portals settled by the overlay search
+};
+
+// Two-level exit router in the style of customizable route planning, with
+// one cell per floor. Portals are the nodes touching an inter-floor arc
+// (stair and elevator landings). Customising a floor computes, inside that
+// floor only, the portal-to-portal distance table and each portal's distance
+// to the floor's own exits. The overlay graph is then just the portals:
+// table cliques plus the inter-floor arcs, a few hundred nodes for a
+// 100-storey tower.
+//
+// A hazard change re-customises only the floor it lies on (an inter-floor arc
+// re-customises nothing) and re-solves the overlay, so building-wide
+// re-planning costs one floor plus the overlay regardless of height. Per-node
+// distances and next hops are derived per floor on first query after a
+// change: a floor-local search seeded from the floor's exits and from each
+// portal's best inter-floor continuation.
+//
+// Queries mutate the per-floor caches and must come from the routing thread.
+class OverlayRouter {
+ public:
+  explicit OverlayRouter(BuildingGraph& graph);
+
+  const BuildingGraph& graph() const { return graph_; }
+
+  void set_edge_hazard(EdgeId e, float hazard);
+  OverlayRepairStats repair();
+
+  Cost distance(NodeId v);
+  EdgeId next_edge(NodeId v);
+  NodeId next_hop(NodeId v) {
+    const EdgeId e = next_edge(v);
+    return e == kInvalidEdge ? kInvalidNode : graph_.edge_target(e);
+  }
+
+  std::size_t portal_count() const { return portal_nodes_.size(); }
+  // Materialises every floor; for cross-checks against solve_exit_field().
+  void export_field(ExitField& out);
+
+ private:
+  struct Seed {
+    NodeId node;
+    Cost dist;
+    EdgeId via;
+  };
+
+  std::uint32_t floor_index(NodeId v) const {
+    return static_cast<std::uint32_t>(graph_.node_floor(v) - graph_.min_floor());
+  }
+  bool crosses_floor(EdgeId e) const {
+    return graph_.node_floor(graph_.edge_source(e)) != graph_.node_floor(graph_.edge_target(e));
+  }
+  std::span<const NodeId> floor_nodes(std::uint32_t f) const {
+    return {floor_node_list_.data() + floor_offsets_[f], floor_offsets_[f + 1] - floor_offsets_[f]};
+  }
+  std::span<const NodeId> floor_portals(std::uint32_t f) const {
+    return {portal_nodes_.data() + portal_offsets_[f], portal_offsets_[f + 1] - portal_offsets_[f]};
+  }
+
+  // Reverse multi-source Dijkstra restricted to floor f, writing dist_/next_.
+  // With portals_only it stops once every portal of the floor is settled.
+  void floor_search(std::uint32_t f, std::span<const Seed> seeds, bool portals_only = false);
+  void customise(std::uint32_t f);
+  std::size_t solve_overlay();
+  void ensure_floor(std::uint32_t f);
+
+  BuildingGraph& graph_;
+  std::vector<Cost> edge_cost_;
+  std::size_t floors_ = 0;
+
+  // Floor membership (CSR over floors).
+  std::vector<std::uint32_t> floor_offsets_;
+  std::vector<NodeId> floor_node_list_;
+
+  // Portals, grouped by floor; portal_of_[v] is the global portal index.
+  static constexpr std::uint32_t kNoPortal = 0xffffffffu;
+  std::vector<std::uint32_t> portal_offsets_;
+  std::vector<NodeId> portal_nodes_;
+  std::vector<std::uint32_t> portal_of_;
+
+  // Customisation results. table_[table_offset_[f] + i * P_f + j] is the
+  // in-floor distance from portal i to portal j of floor f.
+  std::vector<std::size_t> table_offset_;
+  std::vector<Cost> table_;
+  std::vector<Cost> exit_cost_;   // per portal, in-floor distance to an exit
+  std::vector<Cost> overlay_;     // per portal, building-wide exit distance
+  std::vector<Cost> cross_;       // per portal, best continuation via an inter-floor arc
+  std::vector<EdgeId> cross_via_;
+
+  std::vector<std::uint8_t> floor_dirty_;  // needs customise()
+  std::vector<std::uint8_t> field_valid_;  // dist_/next_ current for the floor
+  std::vector<EdgeId> pending_edges_;
+
+  // Per-node scratch for floor searches and the materialised fields.
+  std::vector<Cost> dist_;
+  std::vector<EdgeId> next_;
+  Arena scratch_;
+};
+
+}  // namespace evac
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "routing/cost.hpp"
+#include "util/arena.hpp"
+
+namespace evac {
+
+// Priority queues for label-setting searches with lazy deletion: a node is
+// pushed again whenever its label improves and stale entries are skipped on
+// pop. Both keep their storage in a scratch arena, so the caller's ArenaScope
+// releases it. Among equal keys the binary heap pops the lowest node id
+// first; the radix heap pops in no particular order.
+
+// std::push_heap/pop_heap over (cost, node) pairs; the reference queue.
+class BinaryHeapQueue {
+ public:
+  BinaryHeapQueue(Arena& arena, std::size_t reserve) : heap_{ArenaAllocator<Entry>(arena)} { heap_.reserve(reserve); }
+
+  bool empty() const { return heap_.empty(); }
+
+  void push(Cost key, NodeId v) {
+    heap_.push_back({key, v});
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<>());
+  }
+
+  std::pair<Cost, NodeId> pop() {
+    std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+    const Entry top = heap_.back();
+    heap_.pop_back();
+    return top;
+  }
+
+ private:
+  using Entry = std::pair<Cost, NodeId>;
+  arena_vector<Entry> heap_;
+};
+
+// Monotone radix heap for integer costs (Ahuja, Mehlhorn, Orlin and Tarjan).
+// Valid only when no key pushed is below the last key popped, which holds for
+// Dijkstra with non-negative arc costs. Bucket i > 0 holds keys whose highest
+// bit differing from the last popped key is bit i - 1; bucket 0 holds keys
+// equal to it. A pop that finds bucket 0 empty takes the first non-empty
+// bucket, makes its minimum the new last key and redistributes the rest into
+// strictly lower buckets, so each entry moves at most 32 times and push is a
+// bit scan and an append: no comparisons against other entries at all.
+class RadixHeapQueue {
+ public:
+  RadixHeapQueue(Arena& arena, std::size_t reserve)
+      : buckets_{make_buckets(arena, std::make_index_sequence<kBuckets>())} {
+    buckets_[0].reserve(reserve / 4 + 1);
+  }
+
+  bool empty() const { return size_ == 0; }
+
+  void push(Cost key, NodeId v) {
+    buckets_[bucket_of(key)].push_back({key, v});
+    ++size_;
+  }
+
+  std::pair<Cost, NodeId> pop() {
+    if (buckets_[0].empty()) refill();
+    const Entry top = buckets_[0].back();
+    buckets_[0].pop_back();
+    --size_;
+    return top;
+  }
+
+ private:
+  using Entry = std::pair<Cost, NodeId>;
+  static constexpr std::size_t kBuckets = 33;  // equal, then one per bit of a 32-bit cost
+
+  template <std::size_t... I>
+  static std::array<arena_vector<Entry>, kBuckets> make_buckets(Arena& arena, std::index_sequence<I...>) {
+    return {((void)I, arena_vector<Entry>{ArenaAllocator<Entry>(arena)})...};
+  }
+
+  std::size_t bucket_of(Cost key) const {
+    return key == last_ ? 0 : static_cast<std::size_t>(std::bit_width(key ^ last_));
+  }
+
+  void refill() {
+    std::size_t i = 1;
+    while (buckets_[i].empty()) ++i;
+    arena_vector<Entry>& from = buckets_[i];
+    Cost least = from.front().first;
+    for (const Entry& en : from) least = std::min(least, en.first);
+    last_ = least;
+    for (const Entry& en : from) buckets_[bucket_of(en.first)].push_back(en);
+    from.clear();
+  }
+
+  std::array<arena_vector<Entry>, kBuckets> buckets_;
+  Cost last_ = 0;
+  std::size_t size_ = 0;
+};
+
+}  // namespace evac
@@ -0,0 +1,94 @@
+#include "scenario/scenario_runner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "crowd/agents.hpp"
+#include "routing/cost.hpp"
+
+namespace evac {
+
+ScenarioOption close_nodes_option(const BuildingGraph& g, std::string name, std::span<const NodeId> nodes) {
+  ScenarioOption option;
+  option.name = std::move(name);
+  for (const NodeId v : nodes) {
+    for (const EdgeId e : g.out_edges(v)) option.overrides.push_back({e, kImpassableHazard});
+    for (const EdgeId e : g.in_edges(v)) option.overrides.push_back({e, kImpassableHazard});
+  }
+  return option;
+}
+
+ScenarioRunner::ScenarioRunner(const BuildingGraph& world, WorkStealingPool& pool) : world_(world), pool_(pool) {}
+
+RunOutcome ScenarioRunner::simulate(const Fork& fork, const MonteCarloParams& params, std::uint64_t seed) const {
+  AgentPopulation agents;
+  spawn_agents(fork.graph, params.agents, seed, agents);
+  WorkStealingPool inline_pool(1);
+  CrowdSimulator sim(fork.graph, inline_pool, params.crowd);
+  sim.set_next_edges(fork.field.next_edge);
+
+  const float dt = sim.params().dt;
+  const auto max_ticks = static_cast<std::uint64_t>(std::ceil(params.max_seconds / dt));
+  const std::size_t target90 = agents.size() - agents.size() * 9 / 10;
+  RunOutcome outcome;
+  TickStats stats;
+  stats.active = agents.size();
+  bool p90_seen = false;
+  while (stats.active != 0 && stats.tick < max_ticks) {
+    stats = sim.step(agents);
+    if (!p90_seen && stats.active <= target90) {
+      outcome.p90_seconds = static_cast<float>(stats.tick) * dt;
+      p90_seen = true;
+    }
+  }
+  outcome.egress_seconds = static_cast<float>(stats.tick) * dt;
+  outcome.stranded = stats.active;
+  if (!p90_seen) outcome.p90_seconds = outcome.egress_seconds;
+  return outcome;
+}
+
+std::vector<OptionSummary> ScenarioRunner::run(std::span<const ScenarioOption> options,
+                                               const MonteCarloParams& params) {
+  std::vector<Fork> forks;
+  forks.reserve(options.size());
+  for (const ScenarioOption& option : options) {
+    Fork& fork = forks.emplace_back(Fork{world_, {}});
+    for (const ArcOverride& o : option.overrides) fork.graph.set_edge_hazard(o.edge, o.hazard);
+    solve_exit_field(fork.graph, fork.field);
+  }
+
+  const std::size_t runs = params.runs;
+  std::vector<RunOutcome> outcomes(options.size() * runs);
+  pool_.parallel_for(outcomes.size(), 1, [&](std::size_t b, std::size_t e, unsigned) {
+    for (std::size_t k = b; k < e; ++k) outcomes[k] = simulate(forks[k / runs], params, params.seed + k % runs);
+  });
+
+  std::vector<OptionSummary> summaries(options.size());
+  for (std::size_t o = 0; o < options.size(); ++o) {
+    OptionSummary& s = summaries[o];
+    s.name = options[o].name;
+    s.runs.assign(outcomes.begin() + o * runs, outcomes.begin() + (o + 1) * runs);
+    std::sort(s.runs.begin(), s.runs.end(),
+              [](const RunOutcome& a, const RunOutcome& b) { return a.egress_seconds < b.egress_seconds; });
+    const Fork& fork = forks[o];
+    s.fork_bytes = fork.graph.edge_count() * sizeof(float) +
+                   fork.field.distance.size() * sizeof(Cost) + fork.field.next_edge.size() * sizeof(EdgeId);
+    if (s.runs.empty()) continue;
+    double total = 0.0;
+    for (const RunOutcome& r : s.runs) {
+      total += r.egress_seconds;
+      if (r.stranded != 0) ++s.incomplete;
+    }
+    const auto at = [&](double p) {
+      return s.runs[static_cast<std::size_t>(p * static_cast<double>(s.runs.size() - 1) + 0.5)].egress_seconds;
+    };
+    s.mean_egress = total / static_cast<double>(s.runs.size());
+    s.p10_egress = at(0.1);
+    s.p50_egress = at(0.5);
+    s.p90_egress = at(0.9);
+  }
+  return summaries;
+}
+
+}  // namespace evac
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "crowd/crowd_sim.hpp"
+#include "exec/work_stealing_pool.hpp"
+#include "graph/building_graph.hpp"
+#include "routing/exit_field.hpp"
+
+namespace evac {
+
+struct ArcOverride {
+  EdgeId edge = kInvalidEdge;
+  float hazard = 0.0f;
+};
+
+// One course of action to evaluate: hazard overrides on top of the world.
+struct ScenarioOption {
+  std::string name;
+  std::vector<ArcOverride> overrides;
+};
+
+// Closes every arc into or out of the given nodes (e.g. a stairwell's landings).
+ScenarioOption close_nodes_option(const BuildingGraph& g, std::string name, std::span<const NodeId> nodes);
+
+struct MonteCarloParams {
+  std::size_t runs = 16;          // stochastic runs per option
+  std::size_t agents = 1000;
+  std::uint64_t seed = 1;         // run r of every option uses seed + r
+  double max_seconds = 900.0;     // simulated; runs still going are cut off here
+  CrowdParams crowd;
+};
+
+struct RunOutcome {
+  float egress_seconds = 0.0f;  // last agent out, or max_seconds if cut off
+  float p90_seconds = 0.0f;     // 90% of agents out
+  std::size_t stranded = 0;     // still inside at the cut-off
+};
+
+struct OptionSummary {
+  std::string name;
+  std::vector<RunOutcome> runs;  // ascending egress time
+  double mean_egress = 0.0;
+  double p10_egress = 0.0;
+  double p50_egress = 0.0;
+  double p90_egress = 0.0;
+  std::size_t incomplete = 0;    // runs cut off at max_seconds
+  std::size_t fork_bytes = 0;    // private state of the option's fork
+};
+
+// Faster-than-real-time what-if runner. The world graph is forked once per
+// option: a BuildingGraph copy shares every topology and geometry column with
+// the live graph and owns only its hazard column, the option's overrides are
+// applied to it, and its exit field is solved once and shared read-only by
+// all of the option's runs. A run is then just an agent population and a
+// crowd simulator, built on whichever pool worker picks it up and dropped
+// when it finishes, so memory grows with the option count by a few arrays per
+// fork rather than by a world copy.
+//
+// All (option, run) pairs are spread over the pool; each run steps its crowd
+// inline on that worker. Run r of every option spawns from the same seed, so
+// options are compared on identical populations.
+class ScenarioRunner {
+ public:
+  ScenarioRunner(const BuildingGraph& world, WorkStealingPool& pool);
+
+  std::vector<OptionSummary> run(std::span<const ScenarioOption> options, const MonteCarloParams& params);
+
+ private:
+  struct Fork {
+    BuildingGraph graph;
+    ExitField field;
+  };
+
+  RunOutcome simulate(const Fork& fork, const MonteCarloParams& params, std::uint64_t seed) const;
+
+  const BuildingGraph& world_;
+  WorkStealingPool& pool_;
+};
+
+}  // namespace evac
@@ -0,0 +1,91 @@
+#include "signage/sign_frame.hpp"
+
+namespace evac {
+namespace {
+
+template <class T>
+void store_le(std::byte* p, T v) {
+  for (std::size_t i = 0; i < sizeof(T); ++i) p[i] = static_cast<std::byte>((v >> (8 * i)) & 0xff);
+}
+
+template <class T>
+T load_le(const std::byte* p) {
+  T v{};
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    v = static_cast<T>(v | (static_cast<T>(std::to_integer<std::uint8_t>(p[i])) << (8 * i)));
+  }
+  return v;
+}
+
+}  // namespace
+
+const char* to_string(SignMode mode) {
+  switch (mode) {
+    case SignMode::Dark: return "dark";
+    case SignMode::Arrow: return "arrow";
+    case SignMode::Up: return "up";
+    case SignMode::Down: return "down";
+    case SignMode::Exit: return "exit";
+    case SignMode::NoRoute: return "no-route";
+  }
+  return "?";
+}
+
+const char* to_string(SignFrameStatus status) {
+  switch (status) {
+    case SignFrameStatus::Ok: return "ok";
+    case SignFrameStatus::Truncated: return "truncated";
+    case SignFrameStatus::BadMagic: return "bad magic";
+    case SignFrameStatus::BadVersion: return "bad version";
+    case SignFrameStatus::BadMode: return "bad sign mode";
+  }
+  return "?";
+}
+
+void encode_sign_frame(const SignFrameHeader& header, std::span<const SignCommand> commands,
+                       std::vector<std::byte>& out) {
+  const std::size_t base = out.size();
+  out.resize(base + kSignFrameHeaderSize + commands.size() * kSignCommandSize);
+  std::byte* p = out.data() + base;
+  store_le<std::uint16_t>(p, kSignFrameMagic);
+  p[2] = static_cast<std::byte>(kSignFrameVersion);
+  p[3] = std::byte{0};
+  store_le<std::uint32_t>(p + 4, header.gateway_id);
+  store_le<std::uint32_t>(p + 8, header.sequence);
+  store_le<std::uint16_t>(p + 12, static_cast<std::uint16_t>(commands.size()));
+  store_le<std::uint16_t>(p + 14, 0);
+  p += kSignFrameHeaderSize;
+  for (const SignCommand& c : commands) {
+    store_le<std::uint32_t>(p, c.sign_id);
+    p[4] = static_cast<std::byte>(c.state.mode);
+    p[5] = std::byte{0};
+    store_le<std::uint16_t>(p + 6, c.state.heading_deg);
+    p += kSignCommandSize;
+  }
+}
+
+SignFrameStatus decode_sign_frame(std::span<const std::byte> frame, SignFrameHeader& header,
+                                  std::vector<SignCommand>& out) {
+  if (frame.size() < kSignFrameHeaderSize) return SignFrameStatus::Truncated;
+  const std::byte* p = frame.data();
+  if (load_le<std::uint16_t>(p) != kSignFrameMagic) return SignFrameStatus::BadMagic;
+  if (std::to_integer<std::uint8_t>(p[2]) != kSignFrameVersion) return SignFrameStatus::BadVersion;
+  header.gateway_id = load_le<std::uint32_t>(p + 4);
+  header.sequence = load_le<std::uint32_t>(p + 8);
+  header.count = load_le<std::uint16_t>(p + 12);
+  p += kSignFrameHeaderSize;
+  const std::size_t available = (frame.size() - kSignFrameHeaderSize) / kSignCommandSize;
+  const std::size_t usable = header.count < available ? header.count : available;
+  for (std::size_t i = 0; i < usable; ++i, p += kSignCommandSize) {
+    const auto mode = std::to_integer<std::uint8_t>(p[4]);
+    if (mode > static_cast<std::uint8_t>(SignMode::NoRoute)) return SignFrameStatus::BadMode;
+    SignCommand c;
+    c.sign_id = load_le<std::uint32_t>(p);
+    c.state.mode = static_cast<SignMode>(mode);
+    c.state.heading_deg = load_le<std::uint16_t>(p + 6);
+    out.push_back(c);
+  }
+  return usable == header.count ? SignFrameStatus::Ok : SignFrameStatus::Truncated;
+}
+
+}  // namespace evac
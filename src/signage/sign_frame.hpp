@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace evac {
+
+// What a dynamic exit sign shows. Arrow points along heading_deg in the plan's
+// frame (0 = +x, counter-clockwise); stairs and lifts show Up or Down; Exit is
+// "you are at an exit" and NoRoute the red cross. Dark is the state before the
+// first command.
+enum class SignMode : std::uint8_t { Dark, Arrow, Up, Down, Exit, NoRoute };
+
+const char* to_string(SignMode mode);
+
+struct SignState {
+  SignMode mode = SignMode::Dark;
+  std::uint16_t heading_deg = 0;  // Arrow only
+
+  bool operator==(const SignState&) const = default;
+};
+
+struct SignCommand {
+  std::uint32_t sign_id = 0;
+  SignState state;
+};
+
+// Sign bus frame, one per gateway per flush, little-endian:
+//   u16 magic 'S','G' | u8 version (1) | u8 reserved | u32 gateway id | u32 sequence
+//   | u16 command count | u16 reserved
+//   count x { u32 sign_id | u8 mode | u8 pad | u16 heading_deg }
+// The sequence increments per frame to a gateway, so it can detect a lost frame
+// and ask for a resync. Kept byte-packed: these go over 9600-baud serial links.
+inline constexpr std::uint16_t kSignFrameMagic = 0x4753;  // "SG"
+inline constexpr std::uint8_t kSignFrameVersion = 1;
+inline constexpr std::size_t kSignFrameHeaderSize = 16;
+inline constexpr std::size_t kSignCommandSize = 8;
+inline constexpr std::size_t kMaxSignCommands = 0xffff;
+
+struct SignFrameHeader {
+  std::uint32_t gateway_id = 0;
+  std::uint32_t sequence = 0;
+  std::uint16_t count = 0;
+};
+
+enum class SignFrameStatus { Ok, Truncated, BadMagic, BadVersion, BadMode };
+
+const char* to_string(SignFrameStatus status);
+
+// Appends one frame; commands.size() must not exceed kMaxSignCommands.
+void encode_sign_frame(const SignFrameHeader& header, std::span<const SignCommand> commands,
+                       std::vector<std::byte>& out);
+// Decodes a whole frame, appending its commands to `out`; commands before a
+// bad one are kept.
+SignFrameStatus decode_sign_frame(std::span<const std::byte> frame, SignFrameHeader& header,
+                                  std::vector<SignCommand>& out);
+
+}  // namespace evac
@@ -0,0 +1,64 @@
+#include "signage/sign_map.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace evac {
+
+void SignMap::add_sign(std::uint32_t sign_id, std::uint32_t gateway_id, NodeId node) {
+  if (index_.count(sign_id) != 0) throw std::invalid_argument("duplicate sign " + std::to_string(sign_id));
+  const auto [it, added] = gateway_index_.emplace(gateway_id, static_cast<std::uint32_t>(gateway_ids_.size()));
+  if (added) gateway_ids_.push_back(gateway_id);
+  index_.emplace(sign_id, static_cast<std::uint32_t>(ids_.size()));
+  ids_.push_back(sign_id);
+  nodes_.push_back(node);
+  gateway_of_.push_back(it->second);
+}
+
+void SignMap::finalize() {
+  sign_offsets_.assign(gateway_ids_.size() + 1, 0);
+  for (std::uint32_t gw : gateway_of_) ++sign_offsets_[gw + 1];
+  for (std::size_t gw = 0; gw < gateway_ids_.size(); ++gw) sign_offsets_[gw + 1] += sign_offsets_[gw];
+  std::vector<std::uint32_t> cursor(sign_offsets_.begin(), sign_offsets_.end() - 1);
+  signs_.resize(ids_.size());
+  for (std::uint32_t s = 0; s < ids_.size(); ++s) signs_[cursor[gateway_of_[s]]++] = s;
+}
+
+SignMap load_sign_map(std::istream& in, const BuildingGraph& g, const std::string& source_name) {
+  SignMap map;
+  std::string line;
+  std::size_t line_no = 0;
+  while (std::getline(in, line)) {
+    ++line_no;
+    if (auto hash = line.find('#'); hash != std::string::npos) line.resize(hash);
+    std::istringstream fields(line);
+    std::string record;
+    if (!(fields >> record)) continue;
+    const auto fail = [&](const std::string& what) {
+      throw std::runtime_error(source_name + ":" + std::to_string(line_no) + ": " + what);
+    };
+    if (record != "sign") fail("unknown record '" + record + "'");
+
+    std::uint32_t id = 0;
+    std::uint32_t gateway = 0;
+    NodeId node = 0;
+    if (!(fields >> id >> gateway >> node)) fail("malformed sign");
+    if (node >= g.node_count()) fail("sign at unknown node " + std::to_string(node));
+    try {
+      map.add_sign(id, gateway, node);
+    } catch (const std::invalid_argument& e) {
+      fail(e.what());
+    }
+  }
+  map.finalize();
+  return map;
+}
+
+SignMap load_sign_map_file(const std::string& path, const BuildingGraph& g) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot open sign map " + path);
+  return load_sign_map(in, g, path);
+}
+
+}  // namespace evac
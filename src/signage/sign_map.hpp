@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+
+namespace evac {
+
+// Which node each dynamic exit sign stands at and which field-bus gateway
+// drives it. Text format, one sign per line:
+//
+//   sign <id> <gateway> <node>
+//
+// Sign and gateway ids are bus addresses and may be sparse; both are mapped
+// to dense indices at load, and each gateway's signs are listed in file order.
+class SignMap {
+ public:
+  static constexpr std::uint32_t kUnknown = 0xffffffffu;
+
+  std::size_t sign_count() const { return ids_.size(); }
+  std::size_t gateway_count() const { return gateway_ids_.size(); }
+
+  std::uint32_t sign_id(std::uint32_t sign) const { return ids_[sign]; }
+  NodeId node(std::uint32_t sign) const { return nodes_[sign]; }
+  std::uint32_t gateway(std::uint32_t sign) const { return gateway_of_[sign]; }
+  std::uint32_t gateway_id(std::uint32_t gateway) const { return gateway_ids_[gateway]; }
+  std::uint32_t index_of(std::uint32_t sign_id) const {
+    const auto it = index_.find(sign_id);
+    return it == index_.end() ? kUnknown : it->second;
+  }
+
+  // Signs driven by one gateway (dense indices).
+  std::span<const std::uint32_t> signs_of(std::uint32_t gateway) const {
+    return {signs_.data() + sign_offsets_[gateway], sign_offsets_[gateway + 1] - sign_offsets_[gateway]};
+  }
+
+  // Throws std::invalid_argument on a duplicate sign id.
+  void add_sign(std::uint32_t sign_id, std::uint32_t gateway_id, NodeId node);
+  // Builds the gateway -> signs index; call once after the last add_sign().
+  void finalize();
+
+ private:
+  std::unordered_map<std::uint32_t, std::uint32_t> index_;
+  std::unordered_map<std::uint32_t, std::uint32_t> gateway_index_;
+  std::vector<std::uint32_t> ids_;
+  std::vector<NodeId> nodes_;
+  std::vector<std::uint32_t> gateway_of_;
+  std::vector<std::uint32_t> gateway_ids_;
+  std::vector<std::uint32_t> sign_offsets_{0};
+  std::vector<std::uint32_t> signs_;
+};
+
+// Throws std::runtime_error naming the offending line.
+SignMap load_sign_map(std::istream& in, const BuildingGraph& g, const std::string& source_name = "<stream>");
+SignMap load_sign_map_file(const std::string& path, const BuildingGraph& g);
+
+}  // namespace evac
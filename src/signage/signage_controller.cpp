@@ -0,0 +1,138 @@
+#include "signage/signage_controller.hpp"
+
+#include <cmath>
+#include <numbers>
+
+namespace evac {
+
+SignOutbox::SignOutbox(const SignMap& signs)
+    : signs_(signs), latest_(signs.sign_count()), sent_(signs.sign_count()), queued_(signs.sign_count(), 0),
+      pending_(signs.gateway_count()), sequence_(signs.gateway_count(), 0) {}
+
+void SignOutbox::post(std::uint32_t sign, SignState state) {
+  std::lock_guard lock(mu_);
+  latest_[sign] = state;
+  ++counters_.posted;
+  if (queued_[sign] != 0) return;
+  queued_[sign] = kQueued;
+  pending_[signs_.gateway(sign)].push_back(sign);
+}
+
+void SignOutbox::resync(std::uint32_t gateway) {
+  std::lock_guard lock(mu_);
+  for (const std::uint32_t s : signs_.signs_of(gateway)) {
+    if (queued_[s] == 0) pending_[gateway].push_back(s);
+    queued_[s] = kQueued | kForced;
+  }
+}
+
+bool SignOutbox::take(std::uint32_t gateway, std::vector<std::byte>& frame) {
+  std::lock_guard lock(mu_);
+  std::vector<std::uint32_t>& queue = pending_[gateway];
+  commands_.clear();
+  std::size_t used = 0;
+  for (; used < queue.size() && commands_.size() < kMaxSignCommands; ++used) {
+    const std::uint32_t s = queue[used];
+    const bool forced = (queued_[s] & kForced) != 0;
+    queued_[s] = 0;
+    if (!forced && latest_[s] == sent_[s]) {
+      ++counters_.collapsed;
+      continue;
+    }
+    sent_[s] = latest_[s];
+    commands_.push_back({signs_.sign_id(s), latest_[s]});
+  }
+  queue.erase(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(used));
+  if (commands_.empty()) return false;
+  const std::size_t before = frame.size();
+  encode_sign_frame({signs_.gateway_id(gateway), sequence_[gateway]++, 0}, commands_, frame);
+  ++counters_.frames;
+  counters_.commands += commands_.size();
+  counters_.bytes += frame.size() - before;
+  return true;
+}
+
+SignOutboxCounters SignOutbox::counters() const {
+  std::lock_guard lock(mu_);
+  return counters_;
+}
+
+SignageController::SignageController(const BuildingGraph& g, const SignMap& signs, SignOutbox& outbox,
+                                     SignageParams params)
+    : g_(g), signs_(signs), outbox_(outbox), params_(params), shown_hop_(signs.sign_count(), kInvalidNode),
+      shown_state_(signs.sign_count()), candidate_(signs.sign_count(), kInvalidNode),
+      streak_(signs.sign_count(), 0), changed_at_us_(signs.sign_count(), 0) {}
+
+SignState SignageController::state_for(NodeId at, NodeId hop, const GuidanceSnapshot& snapshot) const {
+  if (hop == kInvalidNode) {
+    return {snapshot.distances()[at] == 0 ? SignMode::Exit : SignMode::NoRoute, 0};
+  }
+  const EdgeId e = g_.find_edge(at, hop);
+  const EdgeKind kind = e == kInvalidEdge ? EdgeKind::Corridor : g_.edge_kind(e);
+  if ((kind == EdgeKind::Stairs || kind == EdgeKind::Elevator) && g_.node_floor(hop) != g_.node_floor(at)) {
+    return {g_.node_floor(hop) > g_.node_floor(at) ? SignMode::Up : SignMode::Down, 0};
+  }
+  const double deg = std::atan2(g_.node_y(hop) - g_.node_y(at), g_.node_x(hop) - g_.node_x(at)) * 180.0 /
+                     std::numbers::pi;
+  const long rounded = std::lround(deg < 0.0 ? deg + 360.0 : deg) % 360;
+  return {SignMode::Arrow, static_cast<std::uint16_t>(rounded)};
+}
+
+Cost SignageController::cost_via(NodeId at, NodeId hop, const GuidanceSnapshot& snapshot) const {
+  if (hop == kInvalidNode) return kInfiniteCost;
+  const EdgeId e = g_.find_edge(at, hop);
+  if (e == kInvalidEdge) return kInfiniteCost;
+  return saturating_add(edge_cost(g_, e), snapshot.distances()[hop]);
+}
+
+void SignageController::show(std::uint32_t sign, NodeId hop, SignState state, std::uint64_t now_us) {
+  shown_hop_[sign] = hop;
+  candidate_[sign] = kInvalidNode;
+  streak_[sign] = 0;
+  changed_at_us_[sign] = now_us;
+  if (state == shown_state_[sign]) return;  // a different hop in the same direction
+  ++stats_.changes;
+  shown_state_[sign] = state;
+  outbox_.post(sign, state);
+}
+
+void SignageController::update(const GuidanceSnapshot& snapshot, std::uint64_t now_us) {
+  ++stats_.snapshots;
+  const std::span<const NodeId> hops = snapshot.next_hops();
+  for (std::uint32_t s = 0; s < signs_.sign_count(); ++s) {
+    const NodeId at = signs_.node(s);
+    const NodeId hop = hops[at];
+    if (shown_state_[s].mode == SignMode::Dark) {
+      show(s, hop, state_for(at, hop, snapshot), now_us);
+      continue;
+    }
+    if (hop == shown_hop_[s]) {
+      streak_[s] = 0;
+      continue;
+    }
+    const Cost via_shown = cost_via(at, shown_hop_[s], snapshot);
+    if (via_shown == kInfiniteCost) {
+      ++stats_.urgent;
+      show(s, hop, state_for(at, hop, snapshot), now_us);
+      continue;
+    }
+    const Cost best = snapshot.distances()[at];
+    const bool keep = static_cast<double>(via_shown) <= static_cast<double>(best) * (1.0 + params_.keep_margin);
+    if (keep) {
+      streak_[s] = 0;
+    } else {
+      if (candidate_[s] != hop) {
+        candidate_[s] = hop;
+        streak_[s] = 0;
+      }
+      ++streak_[s];
+    }
+    if (keep || streak_[s] < params_.hold_snapshots || now_us - changed_at_us_[s] < params_.min_dwell_us) {
+      ++stats_.suppressed;
+      continue;
+    }
+    show(s, hop, state_for(at, hop, snapshot), now_us);
+  }
+}
+
+}  // namespace evac
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "graph/building_graph.hpp"
+#include "routing/cost.hpp"
+#include "routing/guidance_snapshot.hpp"
+#include "signage/sign_frame.hpp"
+#include "signage/sign_map.hpp"
+
+namespace evac {
+
+struct SignOutboxCounters {
+  std::uint64_t posted = 0;     // state changes handed over by the controller
+  std::uint64_t frames = 0;
+  std::uint64_t commands = 0;   // sent inside those frames
+  std::uint64_t collapsed = 0;  // changes undone before their link flushed
+  std::uint64_t bytes = 0;
+};
+
+// Hand-off between the signage controller (routing thread) and the sign bus
+// links, one per gateway, which flush at whatever rate their bus allows. The
+// router never waits on a device: post() records the latest state of a sign
+// and queues it on its gateway once. take() drains a gateway's queue into a
+// single frame, skipping signs whose latest state is what the device already
+// shows, so a slow link sees at most one command per sign however many times
+// the sign changed while the previous frame was on the wire.
+class SignOutbox {
+ public:
+  explicit SignOutbox(const SignMap& signs);
+
+  void post(std::uint32_t sign, SignState state);
+  // Queues every sign of the gateway again, e.g. after a device restart or a
+  // gap in the frame sequence.
+  void resync(std::uint32_t gateway);
+
+  // Link side: appends one frame with the gateway's pending commands (at most
+  // kMaxSignCommands; the rest stay queued) to `frame`. False if none.
+  bool take(std::uint32_t gateway, std::vector<std::byte>& frame);
+  SignOutboxCounters counters() const;
+
+ private:
+  static constexpr std::uint8_t kQueued = 1;
+  static constexpr std::uint8_t kForced = 2;
+
+  const SignMap& signs_;
+  mutable std::mutex mu_;
+  std::vector<SignState> latest_;  // per sign, as last posted
+  std::vector<SignState> sent_;    // per sign, as last framed
+  std::vector<std::uint8_t> queued_;
+  std::vector<std::vector<std::uint32_t>> pending_;  // per gateway, in queue order
+  std::vector<std::uint32_t> sequence_;              // per gateway
+  std::vector<SignCommand> commands_;
+  SignOutboxCounters counters_;
+};
+
+struct SignageParams {
+  std::uint32_t hold_snapshots = 3;        // a new direction must win this many snapshots in a row
+  std::uint64_t min_dwell_us = 5'000'000;  // and the sign must have shown its current one this long
+  float keep_margin = 0.1f;                // keep the shown route while it is within 10% of the best
+};
+
+struct SignageStats {
+  std::uint64_t snapshots = 0;
+  std::uint64_t changes = 0;     // sign states posted
+  std::uint64_t urgent = 0;      // of which forced at once: the shown route had closed
+  std::uint64_t suppressed = 0;  // sign-snapshots where the router's hop differed from the sign's
+};
+
+// Turns published guidance into sign states with change suppression. Per
+// snapshot it diffs each sign's next hop against the direction the sign
+// shows; only on a difference does it look further:
+//
+//  - if the shown route has closed (its arc is impassable or the node behind
+//    it lost its route), the sign switches at once;
+//  - if the shown route still costs within keep_margin of the best, the sign
+//    stays, since a tie flipping back and forth is not worth a sign change;
+//  - otherwise the new direction must be the router's choice for
+//    hold_snapshots snapshots running and the sign must have dwelt
+//    min_dwell_us on its current state before it moves.
+//
+// Changed states go to the outbox; nothing is sent for signs that stay.
+// Routing thread only: `g` is the router's graph, carrying the hazards and
+// congestion the snapshot was routed on.
+class SignageController {
+ public:
+  SignageController(const BuildingGraph& g, const SignMap& signs, SignOutbox& outbox, SignageParams params = {});
+
+  void update(const GuidanceSnapshot& snapshot, std::uint64_t now_us);
+
+  SignState shown(std::uint32_t sign) const { return shown_state_[sign]; }
+  const SignageStats& stats() const { return stats_; }
+
+ private:
+  SignState state_for(NodeId at, NodeId hop, const GuidanceSnapshot& snapshot) const;
+  Cost cost_via(NodeId at, NodeId hop, const GuidanceSnapshot& snapshot) const;
+  void show(std::uint32_t sign, NodeId hop, SignState state, std::uint64_t now_us);
+
+  const BuildingGraph& g_;
+  const SignMap& signs_;
+  SignOutbox& outbox_;
+  SignageParams params_;
+  std::vector<NodeId> shown_hop_;
+  std::vector<SignState> shown_state_;
+  std::vector<NodeId> candidate_;
+  std::vector<std::uint32_t> streak_;
+  std::vector<std::uint64_t> changed_at_us_;
+  SignageStats stats_;
+};
+
+}  // namespace evac
@@ -0,0 +1,159 @@
+#include "spatial/cell_grid.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace evac {
+namespace {
+
+constexpr std::size_t kAgentGrain = 4096;
+constexpr std::size_t kCellGrain = 1024;
+
+template <class T>
+void grow_to(T& v, std::size_t n) {
+  if (v.size() < n) v.resize(n);
+}
+
+}  // namespace
+
+std::uint32_t CellGridLayout::cell_of(float x, float y, std::int16_t floor) const {
+  const auto clamp_axis = [&](float v, std::uint32_t cells) {
+    const float c = std::floor(v / cell_size);
+    if (!(c > 0.0f)) return 0u;
+    return std::min(cells - 1, static_cast<std::uint32_t>(c));
+  };
+  const std::uint32_t col = clamp_axis(x - origin_x, cols);
+  const std::uint32_t row = clamp_axis(y - origin_y, rows);
+  const auto f = static_cast<std::uint32_t>(std::clamp<int>(floor - min_floor, 0, int(floors) - 1));
+  return (f * rows + row) * cols + col;
+}
+
+CellGridLayout grid_layout_for(const BuildingGraph& g, float cell_size) {
+  CellGridLayout layout = grid_layout_for(g, {}, cell_size);
+  layout.floors = static_cast<std::uint32_t>(std::max(1, g.floor_count()));
+  layout.min_floor = g.min_floor();
+  return layout;
+}
+
+CellGridLayout grid_layout_for(const BuildingGraph& g, std::span<const NodeId> nodes, float cell_size) {
+  const bool all = nodes.empty();
+  const std::size_t count = all ? g.node_count() : nodes.size();
+  float lo_x = 0.0f, hi_x = 0.0f, lo_y = 0.0f, hi_y = 0.0f;
+  int lo_f = 0, hi_f = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    const NodeId v = all ? static_cast<NodeId>(i) : nodes[i];
+    const float x = g.node_x(v);
+    const float y = g.node_y(v);
+    const int f = g.node_floor(v);
+    if (i == 0 || x < lo_x) lo_x = x;
+    if (i == 0 || x > hi_x) hi_x = x;
+    if (i == 0 || y < lo_y) lo_y = y;
+    if (i == 0 || y > hi_y) hi_y = y;
+    if (i == 0 || f < lo_f) lo_f = f;
+    if (i == 0 || f > hi_f) hi_f = f;
+  }
+  CellGridLayout layout;
+  layout.cell_size = cell_size;
+  layout.origin_x = lo_x - cell_size;
+  layout.origin_y = lo_y - cell_size;
+  layout.cols = static_cast<std::uint32_t>((hi_x - layout.origin_x) / cell_size) + 2;
+  layout.rows = static_cast<std::uint32_t>((hi_y - layout.origin_y) / cell_size) + 2;
+  layout.floors = static_cast<std::uint32_t>(hi_f - lo_f + 1);
+  layout.min_floor = static_cast<std::int16_t>(lo_f);
+  return layout;
+}
+
+CellGrid::CellGrid(const CellGridLayout& layout) : layout_(layout) {
+  counts_.assign(layout_.cell_count(), 0);
+  offsets_.assign(layout_.cell_count() + 1, 0);
+}
+
+void CellGrid::rebuild(const AgentPopulation& agents, WorkStealingPool& pool) {
+  const std::size_t n = agents.size();
+  const std::size_t cells = layout_.cell_count();
+  agent_count_ = n;
+  grow_to(agent_cell_, n);
+  grow_to(sorted_, n);
+  grow_to(sorted_x_, n);
+  grow_to(sorted_y_, n);
+  grow_to(sorted_r_, n);
+
+  // 1. Zero the histogram, then key and count every active agent.
+  pool.parallel_for(cells, kCellGrain, [&](std::size_t b, std::size_t e, unsigned) {
+    std::fill(counts_.begin() + b, counts_.begin() + e, 0);
+  });
+  pool.parallel_for(n, kAgentGrain, [&](std::size_t b, std::size_t e, unsigned) {
+    for (std::size_t i = b; i < e; ++i) {
+      if (agents.evacuated[i]) {
+        agent_cell_[i] = kNoCell;
+        continue;
+      }
+      const std::uint32_t c = layout_.cell_of(agents.x[i], agents.y[i], agents.floor[i]);
+      agent_cell_[i] = c;
+      std::atomic_ref<std::uint32_t>(counts_[c]).fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+
+  // 2. Exclusive scan of the counts in blocks: block totals in parallel, a
+  //    short serial scan over the totals, then the per-block prefix pass.
+  const std::size_t blocks = (cells + kCellGrain - 1) / kCellGrain;
+  grow_to(block_sums_, blocks + 1);
+  pool.parallel_for(blocks, 1, [&](std::size_t b, std::size_t e, unsigned) {
+    for (std::size_t blk = b; blk < e; ++blk) {
+      const std::size_t first = blk * kCellGrain;
+      const std::size_t last = std::min(cells, first + kCellGrain);
+      std::uint32_t sum = 0;
+      for (std::size_t c = first; c < last; ++c) sum += counts_[c];
+      block_sums_[blk + 1] = sum;
+    }
+  });
+  block_sums_[0] = 0;
+  for (std::size_t blk = 0; blk < blocks; ++blk) block_sums_[blk + 1] += block_sums_[blk];
+  pool.parallel_for(blocks, 1, [&](std::size_t b, std::size_t e, unsigned) {
+    for (std::size_t blk = b; blk < e; ++blk) {
+      const std::size_t first = blk * kCellGrain;
+      const std::size_t last = std::min(cells, first + kCellGrain);
+      std::uint32_t running = block_sums_[blk];
+      for (std::size_t c = first; c < last; ++c) {
+        offsets_[c] = running;
+        running += counts_[c];
+        counts_[c] = offsets_[c];  // becomes the scatter cursor
+      }
+    }
+  });
+  offsets_[cells] = block_sums_[blocks];
+
+  // 3. Scatter ids through the cursors; order inside a cell is arbitrary here.
+  pool.parallel_for(n, kAgentGrain, [&](std::size_t b, std::size_t e, unsigned) {
+    for (std::size_t i = b; i < e; ++i) {
+      const std::uint32_t c = agent_cell_[i];
+      if (c == kNoCell) continue;
+      const std::uint32_t slot = std::atomic_ref<std::uint32_t>(counts_[c]).fetch_add(1, std::memory_order_relaxed);
+      sorted_[slot] = static_cast<std::uint32_t>(i);
+    }
+  });
+
+  // 4. Restore ascending ids per cell (insertion sort; cells hold a handful of
+  //    agents) and copy the kernel columns into cell order.
+  pool.parallel_for(cells, kCellGrain, [&](std::size_t b, std::size_t e, unsigned) {
+    for (std::size_t c = b; c < e; ++c) {
+      std::uint32_t* first = sorted_.data() + offsets_[c];
+      std::uint32_t* last = sorted_.data() + offsets_[c + 1];
+      for (std::uint32_t* p = first + 1; p < last; ++p) {
+        const std::uint32_t v = *p;
+        std::uint32_t* q = p;
+        for (; q > first && q[-1] > v; --q) *q = q[-1];
+        *q = v;
+      }
+      for (std::uint32_t k = offsets_[c]; k < offsets_[c + 1]; ++k) {
+        const std::uint32_t i = sorted_[k];
+        sorted_x_[k] = agents.x[i];
+        sorted_y_[k] = agents.y[i];
+        sorted_r_[k] = agents.radius[i];
+      }
+    }
+  });
+}
+
+}  // namespace evac
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "crowd/agents.hpp"
+#include "exec/work_stealing_pool.hpp"
+#include "graph/building_graph.hpp"
+#include "util/aligned_buffer.hpp"
+
+namespace evac {
+
+// Per-floor uniform grids stacked into one cell index space:
+// cell = (floor * rows + row) * cols + col.
+struct CellGridLayout {
+  float origin_x = 0.0f;
+  float origin_y = 0.0f;
+  float cell_size = 2.0f;
+  std::uint32_t cols = 1;
+  std::uint32_t rows = 1;
+  std::uint32_t floors = 1;
+  std::int16_t min_floor = 0;
+
+  std::size_t cell_count() const { return std::size_t{cols} * rows * floors; }
+  std::uint32_t cell_of(float x, float y, std::int16_t floor) const;
+};
+
+// Bounding box of the graph's nodes plus one cell of margin on every side.
+CellGridLayout grid_layout_for(const BuildingGraph& g, float cell_size);
+// Bounding box and floor range of `nodes` only (all nodes when empty), for a
+// simulator that covers part of a site. Agents outside clamp to edge cells.
+CellGridLayout grid_layout_for(const BuildingGraph& g, std::span<const NodeId> nodes, float cell_size);
+
+// Cell list over the agent population, rebuilt every tick by a parallel
+// counting sort: count agents per cell with atomic increments, scan the counts
+// into offsets, scatter ids, then sort each (small) cell by id so the order is
+// the same for every thread count. Positions and radii are also copied into
+// cell order so a 3x3 neighbourhood is three contiguous runs.
+//
+// All buffers grow to the high-water mark and are reused: once warmed up,
+// rebuild() does not allocate.
+class CellGrid {
+ public:
+  explicit CellGrid(const CellGridLayout& layout);
+
+  const CellGridLayout& layout() const { return layout_; }
+  std::size_t cell_count() const { return layout_.cell_count(); }
+
+  // Evacuated agents are left out of the index.
+  void rebuild(const AgentPopulation& agents, WorkStealingPool& pool);
+
+  std::uint32_t cell_begin(std::uint32_t cell) const { return offsets_[cell]; }
+  std::uint32_t cell_end(std::uint32_t cell) const { return offsets_[cell + 1]; }
+  std::uint32_t cell_population(std::uint32_t cell) const { return offsets_[cell + 1] - offsets_[cell]; }
+  // Indexed agents in cell order; agent id and sorted columns share the index.
+  std::size_t indexed_count() const { return offsets_.empty() ? 0 : offsets_.back(); }
+  std::span<const std::uint32_t> sorted_agents() const { return {sorted_.data(), indexed_count()}; }
+  const float* sorted_x() const { return sorted_x_.data(); }
+  const float* sorted_y() const { return sorted_y_.data(); }
+  const float* sorted_r() const { return sorted_r_.data(); }
+  // Cell of each agent from the last rebuild, kNoCell if not indexed.
+  std::span<const std::uint32_t> agent_cells() const { return {agent_cell_.data(), agent_count_}; }
+
+  // Visits every indexed agent in the 3x3 cells around (x, y) on `floor`, in
+  // cell order; fn(agent_id, sorted_index).
+  template <class Fn>
+  void for_each_near(float x, float y, std::int16_t floor, Fn&& fn) const {
+    const std::uint32_t c = layout_.cell_of(x, y, floor);
+    for_each_run(c, [&](std::uint32_t begin, std::uint32_t end) {
+      for (std::uint32_t k = begin; k < end; ++k) fn(sorted_[k], k);
+    });
+  }
+
+  // The 3x3 neighbourhood of `cell` as up to three contiguous sorted ranges
+  // (one per row); fn(begin, end).
+  template <class Fn>
+  void for_each_run(std::uint32_t cell, Fn&& fn) const {
+    const std::uint32_t col = cell % layout_.cols;
+    const std::uint32_t row = (cell / layout_.cols) % layout_.rows;
+    const std::uint32_t row_base = cell - col;
+    const std::uint32_t first_col = col == 0 ? 0 : col - 1;
+    const std::uint32_t last_col = col + 1 == layout_.cols ? col : col + 1;
+    for (int dr = -1; dr <= 1; ++dr) {
+      if ((row == 0 && dr < 0) || (row + 1 == layout_.rows && dr > 0)) continue;
+      const std::uint32_t base = row_base + static_cast<std::uint32_t>(dr * int(layout_.cols));
+      const std::uint32_t begin = offsets_[base + first_col];
+      const std::uint32_t end = offsets_[base + last_col + 1];
+      if (begin != end) fn(begin, end);
+    }
+  }
+
+  static constexpr std::uint32_t kNoCell = 0xffffffffu;
+
+ private:
+  CellGridLayout layout_;
+  std::size_t agent_count_ = 0;
+  std::vector<std::uint32_t> counts_;      // per cell; reused as scatter cursor
+  std::vector<std::uint32_t> offsets_;     // cell_count + 1
+  std::vector<std::uint32_t> block_sums_;  // scan partials
+  std::vector<std::uint32_t> agent_cell_;
+  std::vector<std::uint32_t> sorted_;
+  aligned_vector<float> sorted_x_;
+  aligned_vector<float> sorted_y_;
+  aligned_vector<float> sorted_r_;
+};
+
+}  // namespace evac
@@ -0,0 +1,102 @@
+#include "synth/synthetic_building.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "util/rng.hpp"
+
+namespace evac {
+namespace {
+
+constexpr float kRoomPitch = 6.0f;   // metres of spine per room pair
+constexpr float kRoomDepth = 5.0f;   // door to room centre
+constexpr float kCoreOffset = 4.0f;  // spine to stairwell landing
+constexpr float kFlightLength = 9.0f;
+
+}  // namespace
+
+std::string SyntheticSpec::tag() const {
+  return "f" + std::to_string(floors) + "_r" + std::to_string(rooms_per_floor) + "_s" +
+         std::to_string(stair_cores);
+}
+
+BuildingGraph make_synthetic_building(const SyntheticSpec& spec) {
+  SplitMix64 rng(spec.seed);
+  const std::uint32_t floors = std::max<std::uint32_t>(1, spec.floors);
+  const std::uint32_t cores = std::max<std::uint32_t>(1, spec.stair_cores);
+  const std::uint32_t pairs = std::max<std::uint32_t>(1, (spec.rooms_per_floor + 1) / 2);
+  // One spine node per room pair; cores attach to evenly spaced spine nodes.
+  const std::uint32_t spine = std::max(pairs, cores);
+
+  GraphBuilder b;
+  b.reserve(floors * (spine + spec.rooms_per_floor + cores) + 2, floors * (2 * spine + spec.rooms_per_floor + 2 * cores));
+  std::vector<NodeId> core_nodes(static_cast<std::size_t>(floors) * cores);
+  std::vector<NodeId> spine_nodes(spine);
+
+  for (std::uint32_t f = 0; f < floors; ++f) {
+    const auto floor = static_cast<std::int16_t>(f);
+    for (std::uint32_t i = 0; i < spine; ++i) {
+      spine_nodes[i] = b.add_node({NodeKind::Corridor, floor, i * kRoomPitch, 0.0f, 60});
+      if (i > 0) {
+        b.add_connection(spine_nodes[i - 1], spine_nodes[i], EdgeKind::Corridor,
+                         kRoomPitch * rng.uniform(0.95f, 1.05f), 2.6f);
+      }
+    }
+    for (std::uint32_t r = 0; r < spec.rooms_per_floor; ++r) {
+      const std::uint32_t at = std::min(r / 2, spine - 1);
+      const float side = r % 2 == 0 ? 1.0f : -1.0f;
+      const NodeId room = b.add_node({NodeKind::Room, floor, at * kRoomPitch, side * kRoomDepth, spec.room_capacity});
+      b.add_connection(room, spine_nodes[at], EdgeKind::Door, kRoomDepth * rng.uniform(0.9f, 1.1f),
+                       rng.uniform(1.1f, 1.5f));
+    }
+    for (std::uint32_t c = 0; c < cores; ++c) {
+      const std::uint32_t at = cores == 1 ? spine / 2 : c * (spine - 1) / (cores - 1);
+      const NodeId landing =
+          b.add_node({NodeKind::Stairwell, floor, at * kRoomPitch, -kCoreOffset - kRoomDepth, 40});
+      b.add_connection(spine_nodes[at], landing, EdgeKind::Door, kCoreOffset, 1.3f);
+      core_nodes[f * cores + c] = landing;
+      if (f > 0) {
+        b.add_connection(core_nodes[(f - 1) * cores + c], landing, EdgeKind::Stairs, kFlightLength, 1.1f);
+      }
+      if (f == 0) {
+        const NodeId exit =
+            b.add_node({NodeKind::Exit, floor, at * kRoomPitch, -2.0f * kCoreOffset - kRoomDepth, 0});
+        b.add_connection(landing, exit, EdgeKind::Door, kCoreOffset, 1.3f);
+      }
+    }
+    if (f == 0) {
+      const NodeId west = b.add_node({NodeKind::Exit, floor, -kRoomPitch, 0.0f, 0});
+      const NodeId east = b.add_node({NodeKind::Exit, floor, spine * kRoomPitch, 0.0f, 0});
+      b.add_connection(west, spine_nodes.front(), EdgeKind::Door, kRoomPitch, 1.3f);
+      b.add_connection(spine_nodes.back(), east, EdgeKind::Door, kRoomPitch, 1.3f);
+    }
+  }
+  return std::move(b).build();
+}
+
+SensorMap make_synthetic_sensors(const BuildingGraph& g) {
+  SensorMap map;
+  std::uint32_t next_id = 100000;
+  std::vector<EdgeId> covered;
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    const EdgeId twin = g.edge_twin(e);
+    if (twin != kInvalidEdge && twin < e) continue;  // one sensor per connection
+    const NodeKind from = g.node_kind(g.edge_source(e));
+    const NodeKind to = g.node_kind(g.edge_target(e));
+    SensorKind kind;
+    if (g.edge_kind(e) == EdgeKind::Door && (from == NodeKind::Room || to == NodeKind::Room)) {
+      kind = SensorKind::Smoke;
+    } else if (g.edge_kind(e) == EdgeKind::Door && (from == NodeKind::Stairwell || to == NodeKind::Stairwell)) {
+      kind = SensorKind::DoorContact;
+    } else {
+      continue;
+    }
+    covered.assign({e});
+    if (twin != kInvalidEdge) covered.push_back(twin);
+    map.add_sensor(next_id++, kind, covered);
+  }
+  map.finalize(g.edge_count());
+  return map;
+}
+
+}  // namespace evac
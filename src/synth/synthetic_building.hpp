@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "graph/building_graph.hpp"
+#include "ingest/sensor_map.hpp"
+
+namespace evac {
+
+struct SyntheticSpec {
+  std::uint32_t floors = 4;
+  std::uint32_t rooms_per_floor = 20;  // split evenly between both sides of the spine
+  std::uint32_t stair_cores = 2;       // spread along the spine; ground floor cores exit
+  std::uint32_t room_capacity = 30;
+  std::uint64_t seed = 1;
+
+  // Compact tag for reports, e.g. "f4_r20_s2".
+  std::string tag() const;
+};
+
+// Double-loaded corridor building: per floor a corridor spine with rooms on
+// both sides, stair cores spaced along the spine and linked floor to floor,
+// and exits at both spine ends and at every ground-floor core. Lengths and
+// door widths get a small seeded jitter so equal-cost ties are rare, and the
+// same spec always produces the same graph.
+BuildingGraph make_synthetic_building(const SyntheticSpec& spec);
+
+// One smoke sensor per room door and one door-contact sensor per stair door,
+// with ids 100000 + index.
+SensorMap make_synthetic_sensors(const BuildingGraph& g);
+
+}  // namespace evac
@@ -0,0 +1,46 @@
+#include "telemetry/hdr_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace evac {
+
+void HdrHistogram::merge(const HdrHistogram& other) {
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    const std::uint64_t c = other.counts_[i].load(std::memory_order_relaxed);
+    if (c != 0) bump(counts_[i], c);
+  }
+  bump(count_, other.count_.load(std::memory_order_relaxed));
+  bump(sum_, other.sum_.load(std::memory_order_relaxed));
+  const std::uint64_t m = other.max_.load(std::memory_order_relaxed);
+  if (m > max_.load(std::memory_order_relaxed)) max_.store(m, std::memory_order_relaxed);
+}
+
+void HdrHistogram::clear() {
+  for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+double HdrHistogram::mean() const {
+  const std::uint64_t n = count();
+  return n == 0 ? 0.0 : static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(n);
+}
+
+std::uint64_t HdrHistogram::percentile(double p) const {
+  // Buckets are summed afresh: count_ may run ahead of them mid-record.
+  std::uint64_t total = 0;
+  for (const auto& c : counts_) total += c.load(std::memory_order_relaxed);
+  if (total == 0) return 0;
+  const double clamped = std::clamp(p, 0.0, 100.0);
+  const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * total)));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    seen += counts_[i].load(std::memory_order_relaxed);
+    if (seen >= target) return std::min(highest_of(i), max());
+  }
+  return max();
+}
+
+}  // namespace evac
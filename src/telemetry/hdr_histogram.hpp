@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace evac {
+
+// Log-linear latency histogram in the style of HdrHistogram: 2^kSubBucketBits
+// linear sub-buckets per power of two, so every recorded value is kept to
+// within 1/128 of itself from 1 ns up to kMaxValue (larger values saturate
+// into the top bucket). Fixed size, never allocates.
+//
+// Single writer, any number of readers: the owning thread bumps counters with
+// relaxed load/store pairs (no locked instructions), and merge()/percentiles
+// from other threads see a slightly stale but never torn state.
+class HdrHistogram {
+ public:
+  static constexpr unsigned kSubBucketBits = 8;
+  static constexpr unsigned kMaxValueBits = 36;  // ~68 s in nanoseconds
+  static constexpr std::uint64_t kMaxValue = (std::uint64_t{1} << kMaxValueBits) - 1;
+  static constexpr std::size_t kHalf = std::size_t{1} << (kSubBucketBits - 1);
+  static constexpr std::size_t kBuckets = (kMaxValueBits - kSubBucketBits + 2) * kHalf;
+
+  void record(std::uint64_t value) {
+    if (value > kMaxValue) value = kMaxValue;
+    bump(counts_[index_of(value)], 1);
+    bump(count_, 1);
+    bump(sum_, value);
+    if (value > max_.load(std::memory_order_relaxed)) max_.store(value, std::memory_order_relaxed);
+  }
+
+  // Adds `other` into this histogram; only the owner of this one may call it.
+  void merge(const HdrHistogram& other);
+  void clear();
+
+  std::uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  std::uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+  double mean() const;
+  // Highest value equivalent to the p-th percentile sample (p in [0, 100]).
+  std::uint64_t percentile(double p) const;
+
+  static std::size_t index_of(std::uint64_t v) {
+    if (v < 2 * kHalf) return static_cast<std::size_t>(v);
+    const unsigned e = static_cast<unsigned>(std::bit_width(v)) - kSubBucketBits;
+    return e * kHalf + static_cast<std::size_t>(v >> e);
+  }
+  // Largest value that lands in bucket i.
+  static std::uint64_t highest_of(std::size_t i) {
+    if (i < 2 * kHalf) return i;
+    const std::size_t e = i / kHalf - 1;
+    const std::uint64_t m = i - e * kHalf;
+    return ((m + 1) << e) - 1;
+  }
+
+ private:
+  static void bump(std::atomic<std::uint64_t>& c, std::uint64_t by) {
+    c.store(c.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<std::uint64_t>, kBuckets> counts_{};
+  std::atomic<std::uint64_t> count_{0};
+  std::atomic<std::uint64_t> sum_{0};
+  std::atomic<std::uint64_t> max_{0};
+};
+
+}  // namespace evac
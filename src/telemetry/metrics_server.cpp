@@ -0,0 +1,101 @@
+#include "telemetry/metrics_server.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "telemetry/trace.hpp"
+
+namespace evac {
+namespace {
+
+constexpr int kPollMs = 100;
+
+void send_all(int fd, const std::string& data) {
+  std::size_t sent = 0;
+  while (sent < data.size()) {
+    const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return;
+    sent += static_cast<std::size_t>(n);
+  }
+}
+
+std::string response(const char* status, const char* type, const std::string& body) {
+  return std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + type +
+         "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+}
+
+}  // namespace
+
+MetricsServer::MetricsServer(std::uint16_t port, bool loopback_only) {
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) throw std::runtime_error(std::string("metrics: socket: ") + std::strerror(errno));
+  const int yes = 1;
+  ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof yes);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+  if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0 ||
+      ::listen(listen_fd_, 16) != 0) {
+    const std::string what = std::strerror(errno);
+    ::close(listen_fd_);
+    throw std::runtime_error("metrics: port " + std::to_string(port) + ": " + what);
+  }
+  socklen_t len = sizeof addr;
+  ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+  port_ = ntohs(addr.sin_port);
+  thread_ = std::thread([this] { serve(); });
+}
+
+MetricsServer::~MetricsServer() {
+  stopping_.store(true, std::memory_order_relaxed);
+  thread_.join();
+  ::close(listen_fd_);
+}
+
+void MetricsServer::serve() {
+  set_trace_thread_name("metrics");
+  while (!stopping_.load(std::memory_order_relaxed)) {
+    pollfd p{listen_fd_, POLLIN, 0};
+    if (::poll(&p, 1, kPollMs) <= 0) continue;
+    const int client = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0) continue;
+    handle(client);
+    ::close(client);
+  }
+}
+
+void MetricsServer::handle(int client) {
+  // Only the request line matters; wait briefly for it.
+  char buf[1024];
+  std::size_t got = 0;
+  while (got < sizeof buf - 1) {
+    pollfd p{client, POLLIN, 0};
+    if (::poll(&p, 1, kPollMs * 10) <= 0) return;
+    const ssize_t n = ::recv(client, buf + got, sizeof buf - 1 - got, 0);
+    if (n <= 0) return;
+    got += static_cast<std::size_t>(n);
+    if (std::memchr(buf, '\n', got)) break;
+  }
+  buf[got] = '\0';
+  const std::string line(buf, std::strcspn(buf, "\r\n"));
+  if (line.rfind("GET /metrics", 0) == 0) {
+    send_all(client, response("200 OK", "text/plain; version=0.0.4", metrics_text()));
+  } else if (line.rfind("GET /trace", 0) == 0) {
+    send_all(client, response("200 OK", "application/json", chrome_trace_json()));
+  } else {
+    send_all(client, response("404 Not Found", "text/plain", "try /metrics or /trace\n"));
+  }
+  served_.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace evac
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace evac {
+
+// Minimal HTTP endpoint for scrapers and field engineers:
+//   GET /metrics  Prometheus text from metrics_text()
+//   GET /trace    Chrome trace JSON of the buffered spans
+// One background thread serves one connection at a time (responses are
+// small and built from the lock-free telemetry, so nothing on the pipeline
+// ever waits on it). Binds to loopback unless told otherwise.
+class MetricsServer {
+ public:
+  // Port 0 picks a free port; throws std::runtime_error if binding fails.
+  explicit MetricsServer(std::uint16_t port, bool loopback_only = true);
+  ~MetricsServer();
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer& operator=(const MetricsServer&) = delete;
+
+  std::uint16_t port() const { return port_; }
+  std::uint64_t requests_served() const { return served_.load(std::memory_order_relaxed); }
+
+ private:
+  void serve();
+  void handle(int client);
+
+  int listen_fd_ = -1;
+  std::uint16_t port_ = 0;
+  std::atomic<bool> stopping_{false};
+  std::atomic<std::uint64_t> served_{0};
+  std::thread thread_;
+};
+
+}  // namespace evac
@@ -0,0 +1,121 @@
+#include "telemetry/trace.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace evac {
+namespace {
+
+// Threads register once; entries are never removed.
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadTelemetry>> threads;
+};
+
+Registry& registry() {
+  static Registry r;
+  return r;
+}
+
+template <class Fn>
+void for_each_thread(Fn&& fn) {
+  Registry& r = registry();
+  std::lock_guard lock(r.mutex);
+  for (const auto& t : r.threads) fn(*t);
+}
+
+}  // namespace
+
+const char* to_string(TraceStage stage) {
+  switch (stage) {
+    case TraceStage::Ingest: return "ingest";
+    case TraceStage::Coalesce: return "coalesce";
+    case TraceStage::Hazard: return "hazard";
+    case TraceStage::Route: return "route";
+    case TraceStage::Publish: return "publish";
+    case TraceStage::SensorToSign: return "sensor_to_sign";
+    case TraceStage::Count: break;
+  }
+  return "?";
+}
+
+ThreadTelemetry& thread_telemetry() {
+  thread_local ThreadTelemetry* mine = [] {
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    const auto tid = static_cast<std::uint32_t>(r.threads.size() + 1);
+    r.threads.push_back(std::make_unique<ThreadTelemetry>(tid));
+    return r.threads.back().get();
+  }();
+  return *mine;
+}
+
+void set_trace_thread_name(const char* name) { thread_telemetry().set_name(name); }
+
+void merged_histogram(TraceStage stage, HdrHistogram& out) {
+  out.clear();
+  for_each_thread([&](const ThreadTelemetry& t) { out.merge(t.histogram(stage)); });
+}
+
+std::string metrics_text() {
+  std::string out;
+  char line[256];
+  const auto emit = [&](const char* fmt, const char* stage, auto value) {
+    std::snprintf(line, sizeof line, fmt, stage, value);
+    out += line;
+  };
+  out += "# TYPE evac_stage_latency_ns summary\n";
+  const auto merged = std::make_unique<HdrHistogram>();
+  for (std::size_t s = 0; s < kTraceStageCount; ++s) {
+    const auto stage = static_cast<TraceStage>(s);
+    merged_histogram(stage, *merged);
+    const char* name = to_string(stage);
+    emit("evac_stage_latency_ns{stage=\"%s\",quantile=\"0.5\"} %" PRIu64 "\n", name, merged->percentile(50.0));
+    emit("evac_stage_latency_ns{stage=\"%s\",quantile=\"0.99\"} %" PRIu64 "\n", name, merged->percentile(99.0));
+    emit("evac_stage_latency_ns{stage=\"%s\",quantile=\"0.999\"} %" PRIu64 "\n", name, merged->percentile(99.9));
+    emit("evac_stage_latency_ns_max{stage=\"%s\"} %" PRIu64 "\n", name, merged->max());
+    emit("evac_stage_latency_ns_mean{stage=\"%s\"} %.1f\n", name, merged->mean());
+    emit("evac_stage_latency_ns_count{stage=\"%s\"} %" PRIu64 "\n", name, merged->count());
+  }
+  return out;
+}
+
+std::string chrome_trace_json() {
+  std::string out = "{\"traceEvents\":[";
+  char buf[256];
+  bool first = true;
+  const auto append = [&](const char* text) {
+    if (!first) out += ',';
+    first = false;
+    out += text;
+  };
+  for_each_thread([&](const ThreadTelemetry& t) {
+    if (t.named()) {
+      std::snprintf(buf, sizeof buf,
+                    "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", t.tid(),
+                    t.name().c_str());
+      append(buf);
+    }
+    t.for_each_span([&](TraceStage stage, std::uint64_t start_ns, std::uint64_t ns) {
+      std::snprintf(buf, sizeof buf, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    to_string(stage), t.tid(), static_cast<double>(start_ns) / 1000.0,
+                    static_cast<double>(ns) / 1000.0);
+      append(buf);
+    });
+  });
+  out += "],\"displayTimeUnit\":\"ns\"}\n";
+  return out;
+}
+
+bool write_chrome_trace(const std::string& path) {
+  const std::string json = chrome_trace_json();
+  std::FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) return false;
+  const bool ok = std::fwrite(json.data(), 1, json.size(), f) == json.size();
+  return std::fclose(f) == 0 && ok;
+}
+
+}  // namespace evac
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "telemetry/hdr_histogram.hpp"
+
+// Trace spans compile to nothing with -DEVAC_TRACE=0; explicit
+// trace_record() calls (end-to-end latencies) and the exporters remain.
+#ifndef EVAC_TRACE
+#define EVAC_TRACE 1
+#endif
+
+namespace evac {
+
+// Pipeline stages, sensor frame to published guidance.
+enum class TraceStage : std::uint8_t {
+  Ingest,        // frame decode and hand-off, on I/O threads
+  Coalesce,      // IngestPipeline::drain()
+  Hazard,        // smoke forecast cycle
+  Route,         // exit-field repair
+  Publish,       // guidance snapshot build
+  SensorToSign,  // oldest reading of a batch to its guidance being published
+  Count,
+};
+inline constexpr std::size_t kTraceStageCount = static_cast<std::size_t>(TraceStage::Count);
+
+const char* to_string(TraceStage stage);
+
+inline std::uint64_t trace_now_ns() {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+// Per-thread telemetry: one histogram per stage plus a ring of the most
+// recent spans for the Chrome trace. Created on a thread's first record and
+// kept for the life of the process, so a finished thread's latencies still
+// appear in reports.
+class ThreadTelemetry {
+ public:
+  static constexpr std::size_t kRingSize = 1 << 14;
+
+  explicit ThreadTelemetry(std::uint32_t tid) : tid_(tid) {}
+
+  void record(TraceStage stage, std::uint64_t ns) { histograms_[static_cast<std::size_t>(stage)].record(ns); }
+  void span(TraceStage stage, std::uint64_t start_ns, std::uint64_t ns) {
+    record(stage, ns);
+    const std::uint64_t h = head_.load(std::memory_order_relaxed);
+    Event& ev = ring_[h % kRingSize];
+    ev.start_ns.store(start_ns, std::memory_order_relaxed);
+    ev.packed.store((ns << 8) | static_cast<std::uint64_t>(stage), std::memory_order_relaxed);
+    head_.store(h + 1, std::memory_order_release);
+  }
+
+  std::uint32_t tid() const { return tid_; }
+  const HdrHistogram& histogram(TraceStage stage) const { return histograms_[static_cast<std::size_t>(stage)]; }
+
+  // Owner thread, once; other threads read it only after named() is true.
+  void set_name(const char* name) {
+    name_ = name;
+    named_.store(true, std::memory_order_release);
+  }
+  bool named() const { return named_.load(std::memory_order_acquire); }
+  const std::string& name() const { return name_; }
+
+  // fn(stage, start_ns, duration_ns) for the buffered spans, oldest first.
+  // Spans overwritten while the walk runs may come out mixed with newer ones.
+  template <class Fn>
+  void for_each_span(Fn&& fn) const {
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    for (std::uint64_t i = head > kRingSize ? head - kRingSize : 0; i < head; ++i) {
+      const Event& ev = ring_[i % kRingSize];
+      const std::uint64_t packed = ev.packed.load(std::memory_order_relaxed);
+      fn(static_cast<TraceStage>(packed & 0xff), ev.start_ns.load(std::memory_order_relaxed), packed >> 8);
+    }
+  }
+
+ private:
+  struct Event {
+    std::atomic<std::uint64_t> start_ns{0};
+    std::atomic<std::uint64_t> packed{0};  // duration << 8 | stage
+  };
+
+  std::uint32_t tid_;
+  HdrHistogram histograms_[kTraceStageCount];
+  Event ring_[kRingSize];
+  std::atomic<std::uint64_t> head_{0};
+  std::string name_;
+  std::atomic<bool> named_{false};
+};
+
+// The calling thread's telemetry, registered on first use.
+ThreadTelemetry& thread_telemetry();
+// Label for the calling thread in the Chrome trace; call once, early.
+void set_trace_thread_name(const char* name);
+
+inline void trace_record(TraceStage stage, std::uint64_t ns) { thread_telemetry().record(stage, ns); }
+
+// Every thread's histogram for `stage`, merged.
+void merged_histogram(TraceStage stage, HdrHistogram& out);
+// Prometheus text exposition: count, mean, max and p50/p99/p99.9 per stage.
+std::string metrics_text();
+// Chrome trace-event JSON (chrome://tracing, Perfetto) of the buffered spans.
+std::string chrome_trace_json();
+bool write_chrome_trace(const std::string& path);
+
+// Times its scope into the calling thread's histogram and span ring.
+class TraceSpan {
+ public:
+  explicit TraceSpan(TraceStage stage) : stage_(stage), start_(trace_now_ns()) {}
+  ~TraceSpan() { thread_telemetry().span(stage_, start_, trace_now_ns() - start_); }
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  TraceStage stage_;
+  std::uint64_t start_;
+};
+
+}  // namespace evac
+
+#define EVAC_TRACE_CONCAT_(a, b) a##b
+#define EVAC_TRACE_CONCAT(a, b) EVAC_TRACE_CONCAT_(a, b)
+#if EVAC_TRACE
+#define EVAC_TRACE_SPAN(stage) const ::evac::TraceSpan EVAC_TRACE_CONCAT(evac_trace_span_, __LINE__)(stage)
+#else
+#define EVAC_TRACE_SPAN(stage) static_cast<void>(0)
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace evac {
+
+// Cache-line (and AVX-512 register) alignment for arrays swept by SIMD kernels.
+inline constexpr std::size_t kSimdAlignment = 64;
+
+template <class T, std::size_t Alignment = kSimdAlignment>
+struct AlignedAllocator {
+  using value_type = T;
+
+  template <class U>
+  struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() noexcept = default;
+  template <class U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+  }
+  void deallocate(T* p, std::size_t) noexcept { ::operator delete(p, std::align_val_t{Alignment}); }
+
+  template <class U>
+  bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+    return true;
+  }
+};
+
+template <class T>
+using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+
+}  // namespace evac
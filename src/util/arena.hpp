@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "util/aligned_buffer.hpp"
+
+namespace evac {
+
+// Monotonic scratch arena. Allocation bumps a pointer inside the current
+// chunk; nothing is freed individually, and reset() releases everything at
+// once at the end of a tick or query. When a tick needed more than one chunk,
+// reset() replaces them with a single chunk large enough for the whole tick,
+// so after the first few ticks the steady state makes no system allocations
+// at all.
+//
+// Not thread-safe: each worker owns its arena (see CrowdSimulator), and
+// query paths take the caller's arena or the calling thread's scratch_arena().
+class Arena {
+ public:
+  static constexpr std::size_t kDefaultChunk = 64 * 1024;
+
+  explicit Arena(std::size_t initial_bytes = kDefaultChunk) : next_chunk_(initial_bytes) {}
+  ~Arena() { release(); }
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  Arena(Arena&& o) noexcept { *this = std::move(o); }
+  Arena& operator=(Arena&& o) noexcept {
+    if (this != &o) {
+      release();
+      chunks_ = std::move(o.chunks_);
+      current_ = std::exchange(o.current_, 0);
+      offset_ = std::exchange(o.offset_, 0);
+      next_chunk_ = o.next_chunk_;
+      used_ = std::exchange(o.used_, 0);
+      high_water_ = o.high_water_;
+      system_allocations_ = o.system_allocations_;
+    }
+    return *this;
+  }
+
+  void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+    if (!chunks_.empty()) {
+      Chunk& c = chunks_[current_];
+      const std::size_t start = (offset_ + align - 1) & ~(align - 1);
+      if (start + bytes <= c.size) {
+        used_ += start + bytes - offset_;
+        offset_ = start + bytes;
+        return c.data + start;
+      }
+    }
+    return allocate_slow(bytes, align);
+  }
+
+  // Uninitialised array of n trivially destructible T (never destroyed).
+  template <class T>
+  std::span<T> allocate_array(std::size_t n, std::size_t align = alignof(T)) {
+    static_assert(std::is_trivially_destructible_v<T>, "arena memory is never destroyed");
+    return {static_cast<T*>(allocate(n * sizeof(T), align < alignof(T) ? alignof(T) : align)), n};
+  }
+
+  // Position to rewind to; everything allocated after it is dropped.
+  struct Mark {
+    std::size_t chunk;
+    std::size_t offset;
+    std::size_t used;
+  };
+  Mark mark() const { return {current_, offset_, used_}; }
+  void rewind(const Mark& m) {
+    current_ = m.chunk;
+    offset_ = m.offset;
+    used_ = m.used;
+  }
+
+  void reset() {
+    if (chunks_.size() > 1) {
+      // Coalesce: next time the whole tick fits in one chunk.
+      std::size_t total = 0;
+      for (const Chunk& c : chunks_) total += c.size;
+      release();
+      add_chunk(total);
+    }
+    current_ = 0;
+    offset_ = 0;
+    used_ = 0;
+  }
+
+  std::size_t used() const { return used_; }
+  std::size_t high_water() const { return high_water_; }
+  std::size_t capacity() const {
+    std::size_t total = 0;
+    for (const Chunk& c : chunks_) total += c.size;
+    return total;
+  }
+  // Chunks obtained from the system over the arena's lifetime.
+  std::uint64_t system_allocations() const { return system_allocations_; }
+
+ private:
+  struct Chunk {
+    std::byte* data;
+    std::size_t size;
+  };
+
+  void* allocate_slow(std::size_t bytes, std::size_t align) {
+    // Later chunks left over from a rewind may already be big enough.
+    while (current_ + 1 < chunks_.size()) {
+      used_ += chunks_[current_].size - offset_;  // the tail of the old chunk is lost
+      ++current_;
+      offset_ = 0;
+      if (bytes + align <= chunks_[current_].size) return allocate(bytes, align);
+    }
+    if (!chunks_.empty()) used_ += chunks_[current_].size - offset_;
+    std::size_t size = next_chunk_;
+    while (size < bytes + align) size *= 2;
+    add_chunk(size);
+    current_ = chunks_.size() - 1;
+    offset_ = 0;
+    next_chunk_ = size * 2;
+    return allocate(bytes, align);
+  }
+
+  void add_chunk(std::size_t size) {
+    auto* data = static_cast<std::byte*>(::operator new(size, std::align_val_t{kSimdAlignment}));
+    chunks_.push_back({data, size});
+    ++system_allocations_;
+    if (size > next_chunk_) next_chunk_ = size;
+    std::size_t total = 0;
+    for (const Chunk& c : chunks_) total += c.size;
+    if (total > high_water_) high_water_ = total;
+  }
+
+  void release() {
+    for (const Chunk& c : chunks_) ::operator delete(c.data, std::align_val_t{kSimdAlignment});
+    chunks_.clear();
+    current_ = 0;
+    offset_ = 0;
+  }
+
+  std::vector<Chunk> chunks_;
+  std::size_t current_ = 0;
+  std::size_t offset_ = 0;
+  std::size_t next_chunk_ = kDefaultChunk;
+  std::size_t used_ = 0;
+  std::size_t high_water_ = 0;  // peak capacity, bytes
+  std::uint64_t system_allocations_ = 0;
+};
+
+// Rewinds the arena on scope exit, so a query can borrow a shared arena
+// without disturbing allocations made by its caller.
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena& arena) : arena_(arena), mark_(arena.mark()) {}
+  ~ArenaScope() { arena_.rewind(mark_); }
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+  Arena& arena() { return arena_; }
+
+ private:
+  Arena& arena_;
+  Arena::Mark mark_;
+};
+
+// Standard allocator over an arena; deallocation is a no-op.
+template <class T>
+struct ArenaAllocator {
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena& arena) noexcept : arena(&arena) {}
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U>& o) noexcept : arena(o.arena) {}
+
+  T* allocate(std::size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+  void deallocate(T*, std::size_t) noexcept {}
+
+  template <class U>
+  bool operator==(const ArenaAllocator<U>& o) const noexcept {
+    return arena == o.arena;
+  }
+
+  Arena* arena;
+};
+
+template <class T>
+using arena_vector = std::vector<T, ArenaAllocator<T>>;
+
+// The calling thread's scratch arena, for entry points used without an
+// explicit one. Callers borrow it through an ArenaScope.
+inline Arena& scratch_arena() {
+  thread_local Arena arena;
+  return arena;
+}
+
+}  // namespace evac
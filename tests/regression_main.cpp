@@ -0,0 +1,910 @@
+// Correctness regression suite. Every optimised path is cross-checked against
+// a slow reference on randomised synthetic buildings and random hazards:
+//
+//   route_incremental  LPA* repair (each cost model) against a full solve
+//   route_from_table   repair started from a contingency table, other smoke present; damaged rows refused
+//   route_radix        radix-heap solver against the binary heap
+//   route_overlay      floor-overlay router against the flat solve
+//   cost_versions      published arc costs against the router's policy, pinned readers see whole versions
+//   district           partitioned exchange against the flat solve
+//   force_isa          AVX2 / AVX-512 repulsion against scalar, bit for bit
+//   crowd_threads      crowd ticks on 1 and 4 workers and each kernel, by state checksum
+//   crowd_cuda         device ticks against CPU ticks (EVAC_WITH_CUDA builds with a device)
+//   crowd_lod          level-of-detail crowd keeps its head count and agents only on active floors;
+//                      people loaded as flow towards an exit or an active floor get there
+//   checkpoint         mapped restore reproduces the last capture; a torn header falls back a slot
+//   betweenness        Brandes from every source against brute-force path counting (up to 400 nodes)
+//   exit_cut           cut arcs sum to the max flow, and no route avoids them
+//   planner            full rooms all get out on connected routes within every arc and room capacity,
+//                      also at 48k occupants (f20_r80_s4, full runs only)
+//
+// Results stream to test_output.txt as they finish, one line per check and
+// building, with the reference and optimised timings side by side:
+//
+//   PASS route_incremental  f3_r24_s2_x17      cost=smoke     cases=40    failures=0    ref_us=112.4      opt_us=9.8
+//
+// Exit status is 1 when any check fails. Seeds are fixed unless --seed is given.
+//
+//   regression [--quick] [--out path] [--seed s]
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "analysis/criticality.hpp"
+#include "checkpoint/checkpoint_writer.hpp"
+#include "checkpoint/mapped_checkpoint.hpp"
+#include "crowd/agents.hpp"
+#include "crowd/crowd_backend.hpp"
+#include "crowd/crowd_sim.hpp"
+#include "crowd/cuda_crowd.hpp"
+#include "crowd/force_kernel.hpp"
+#include "crowd/hybrid_crowd.hpp"
+#include "district/district.hpp"
+#include "district/region_partition.hpp"
+#include "exec/epoch_domain.hpp"
+#include "exec/work_stealing_pool.hpp"
+#include "planner/flow_planner.hpp"
+#include "routing/contingency_tables.hpp"
+#include "routing/cost_policy.hpp"
+#include "routing/edge_cost_versions.hpp"
+#include "routing/exit_field.hpp"
+#include "routing/guidance_snapshot.hpp"
+#include "routing/incremental_router.hpp"
+#include "routing/overlay_router.hpp"
+#include "routing/search_queue.hpp"
+#include "synth/synthetic_building.hpp"
+#include "util/aligned_buffer.hpp"
+#include "util/rng.hpp"
+
+namespace {
+
+using namespace evac;
+using Clock = std::chrono::steady_clock;
+
+class Log {
+ public:
+  explicit Log(std::FILE* out) : out_(out) {}
+
+  // Timings are medians in microseconds; negative means not measured.
+  void check(const std::string& name, const std::string& building, const std::string& param, std::size_t cases,
+             std::size_t failures, double ref_us, double opt_us) {
+    write(failures == 0 ? "PASS" : "FAIL", name, building, param, cases, failures, ref_us, opt_us);
+    ++checks_;
+    failed_ += failures != 0;
+  }
+
+  void skip(const std::string& name, const std::string& building, const std::string& reason) {
+    write("SKIP", name, building, reason, 0, 0, -1.0, -1.0);
+  }
+
+  std::size_t checks() const { return checks_; }
+  std::size_t failed() const { return failed_; }
+
+ private:
+  void write(const char* status, const std::string& name, const std::string& building, const std::string& param,
+             std::size_t cases, std::size_t failures, double ref_us, double opt_us) {
+    char line[512];
+    std::snprintf(line, sizeof(line), "%s %-18s %-18s %-14s cases=%-5zu failures=%-4zu ref_us=%-10.1f opt_us=%.1f\n",
+                  status, name.c_str(), building.c_str(), param.c_str(), cases, failures, ref_us, opt_us);
+    std::fputs(line, out_);
+    std::fflush(out_);
+    std::fputs(line, stdout);
+    std::fflush(stdout);
+  }
+
+  std::FILE* out_;
+  std::size_t checks_ = 0;
+  std::size_t failed_ = 0;
+};
+
+// Median of the samples, which are reordered.
+double median(std::vector<double>& samples) {
+  if (samples.empty()) return -1.0;
+  std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+  return samples[samples.size() / 2];
+}
+
+double elapsed_us(const std::function<void()>& fn) {
+  const auto t0 = Clock::now();
+  fn();
+  return std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+}
+
+std::size_t distance_mismatches(std::span<const Cost> got, std::span<const Cost> want) {
+  std::size_t bad = 0;
+  for (std::size_t v = 0; v < want.size(); ++v) bad += got[v] != want[v];
+  return bad;
+}
+
+// Random hazards on `count` random connections: a third closed, the rest
+// clear or smoked; written through `set` so routers see them too.
+template <class Set>
+void random_flips(const BuildingGraph& g, SplitMix64& rng, std::size_t count, Set&& set) {
+  for (std::size_t k = 0; k < count; ++k) {
+    const EdgeId e = rng.below(static_cast<std::uint32_t>(g.edge_count()));
+    const std::uint32_t pick = rng.below(3);
+    const float h = pick == 0 ? kImpassableHazard : pick == 1 ? 0.0f : rng.uniform(0.1f, 0.9f);
+    set(e, h);
+    if (const EdgeId twin = g.edge_twin(e); twin != kInvalidEdge) set(twin, h);
+  }
+}
+
+struct Building {
+  SyntheticSpec spec;
+  std::string tag;
+};
+
+std::vector<Building> random_buildings(std::uint64_t seed, bool quick) {
+  SplitMix64 rng(seed);
+  std::vector<Building> out;
+  for (std::size_t i = 0; i < (quick ? 3u : 8u); ++i) {
+    SyntheticSpec spec;
+    spec.floors = 1 + rng.below(quick ? 4 : 8);
+    spec.rooms_per_floor = 4 + 2 * rng.below(quick ? 20 : 60);
+    spec.stair_cores = 1 + rng.below(3);
+    spec.seed = rng.next() % 100000;
+    out.push_back({spec, spec.tag() + "_x" + std::to_string(spec.seed)});
+  }
+  return out;
+}
+
+template <CostPolicy Policy>
+void check_incremental(Log& log, const Building& b, bool quick) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  BasicIncrementalRouter<Policy> router(g);
+  SplitMix64 rng(b.spec.seed * 13 + static_cast<std::uint64_t>(Policy::kModel));
+  ExitField reference;
+  std::vector<double> ref_us;
+  std::vector<double> opt_us;
+  std::size_t failures = 0;
+  const std::size_t cases = quick ? 10 : 40;
+  for (std::size_t c = 0; c < cases; ++c) {
+    random_flips(g, rng, 1 + rng.below(16), [&](EdgeId e, float h) { router.set_edge_hazard(e, h); });
+    opt_us.push_back(elapsed_us([&] { router.repair(); }));
+    ref_us.push_back(elapsed_us([&] { solve_exit_field<Policy>(g, reference, scratch_arena()); }));
+    failures += distance_mismatches(router.distances(), reference.distance) != 0;
+  }
+  log.check("route_incremental", b.tag, std::string("cost=") + to_string(Policy::kModel), cases, failures,
+            median(ref_us), median(opt_us));
+}
+
+void check_from_table(Log& log, const Building& b, WorkStealingPool& pool, bool quick) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  const ContingencyTables tables =
+      ContingencyTables::from_build(g, build_contingency_tables(g, rank_contingencies(g, 8), pool));
+  IncrementalRouter router(g);
+  SplitMix64 rng(b.spec.seed * 29);
+  ExitField reference;
+  std::vector<EdgeId> arcs;
+  std::vector<double> ref_us;
+  std::vector<double> opt_us;
+  std::size_t failures = 0;
+  std::size_t cases = 0;
+  for (std::size_t rep = 0; rep < (quick ? 1u : 3u); ++rep) {
+    for (std::uint32_t i = 0; i < tables.size(); ++i, ++cases) {
+      // Unrelated smoke first, so the table is only a guess for the building as it is.
+      random_flips(g, rng, rng.below(8), [&](EdgeId e, float h) { router.set_edge_hazard(e, h); });
+      router.repair();
+      contingency_arcs(g, tables.entry(i), arcs);
+      for (EdgeId e : arcs) router.set_edge_hazard(e, kImpassableHazard);
+      opt_us.push_back(elapsed_us([&] { router.repair_from(tables.distances(i), tables.next_edges(i)); }));
+      ref_us.push_back(elapsed_us([&] { solve_exit_field(g, reference); }));
+      failures += distance_mismatches(router.distances(), reference.distance) != 0;
+      for (EdgeId e : arcs) router.set_edge_hazard(e, 0.0f);
+      router.repair();
+    }
+  }
+  log.check("route_from_table", b.tag, "k=" + std::to_string(tables.size()), cases, failures, median(ref_us),
+            median(opt_us));
+
+  // A damaged row: next hops out of range or leaving some other node must
+  // not be adopted, and a row of the wrong length is refused.
+  if (tables.size() == 0) return;
+  std::vector<double> bad_us;
+  std::size_t bad_failures = 0;
+  const std::size_t bad_cases = quick ? 2 : 6;
+  std::vector<EdgeId> damaged;
+  for (std::size_t c = 0; c < bad_cases; ++c) {
+    const std::uint32_t i = rng.below(static_cast<std::uint32_t>(tables.size()));
+    const std::span<const EdgeId> row = tables.next_edges(i);
+    damaged.assign(row.begin(), row.end());
+    for (EdgeId& e : damaged) {
+      const std::uint32_t r = rng.below(3);
+      if (r == 0) e = static_cast<EdgeId>(g.edge_count() + rng.below(1000));
+      else if (r == 1) e = rng.below(static_cast<std::uint32_t>(g.edge_count()));
+    }
+    bad_us.push_back(elapsed_us([&] { router.repair_from(tables.distances(i), damaged); }));
+    solve_exit_field(g, reference);
+    bool bad = distance_mismatches(router.distances(), reference.distance) != 0;
+    const std::span<const EdgeId> hops = router.next_edges();
+    for (NodeId u = 0; u < g.node_count(); ++u) {
+      bad |= hops[u] != kInvalidEdge && (hops[u] >= g.edge_count() || g.edge_source(hops[u]) != u);
+    }
+    try {
+      router.repair_from(tables.distances(i).first(g.node_count() - 1), damaged);
+      bad = true;
+    } catch (const std::invalid_argument&) {
+    }
+    bad_failures += bad;
+  }
+  log.check("route_from_table", b.tag, "damaged", bad_cases, bad_failures, median(ref_us), median(bad_us));
+}
+
+void check_radix(Log& log, const Building& b, bool quick) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  SplitMix64 rng(b.spec.seed * 41);
+  ExitField reference;
+  ExitField radix;
+  std::vector<double> ref_us;
+  std::vector<double> opt_us;
+  std::size_t failures = 0;
+  const std::size_t cases = quick ? 5 : 20;
+  for (std::size_t c = 0; c < cases; ++c) {
+    random_flips(g, rng, rng.below(32), [&](EdgeId e, float h) { g.set_edge_hazard(e, h); });
+    ref_us.push_back(elapsed_us([&] { solve_exit_field(g, reference); }));
+    opt_us.push_back(elapsed_us([&] { solve_exit_field<SmokeCost, RadixHeapQueue>(g, radix, scratch_arena()); }));
+    failures += distance_mismatches(radix.distance, reference.distance) != 0;
+  }
+  log.check("route_radix", b.tag, "-", cases, failures, median(ref_us), median(opt_us));
+}
+
+void check_overlay(Log& log, const Building& b, bool quick) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  OverlayRouter router(g);
+  SplitMix64 rng(b.spec.seed * 43);
+  ExitField reference;
+  ExitField overlay;
+  std::vector<double> ref_us;
+  std::vector<double> opt_us;
+  std::size_t failures = 0;
+  const std::size_t cases = quick ? 10 : 40;
+  for (std::size_t c = 0; c < cases; ++c) {
+    random_flips(g, rng, 1 + rng.below(16), [&](EdgeId e, float h) { router.set_edge_hazard(e, h); });
+    opt_us.push_back(elapsed_us([&] { router.repair(); }));
+    ref_us.push_back(elapsed_us([&] { solve_exit_field(g, reference); }));
+    router.export_field(overlay);
+    failures += distance_mismatches(overlay.distance, reference.distance) != 0;
+  }
+  log.check("route_overlay", b.tag, "-", cases, failures, median(ref_us), median(opt_us));
+}
+
+// The router publishes a cost version per repair. After each one every arc
+// must carry the router's own price and columns, and a sweep over the version
+// must match a full solve. Meanwhile a pinned reader checks that each version
+// it sees is whole: the first and last arc always move together, and every
+// cost agrees with the version's own hazard and congestion.
+void check_cost_versions(Log& log, const Building& b, bool quick) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  IncrementalRouter router(g);
+  EpochDomain domain;
+  EdgeCostVersions versions(g, domain);
+  router.publish_costs(&versions);
+  const auto m = static_cast<EdgeId>(g.edge_count());
+  std::atomic<bool> running{true};
+  std::atomic<std::size_t> torn{0};
+  std::thread reader_thread([&] {
+    EpochDomain::Reader reader(domain);
+    SplitMix64 rng(b.spec.seed * 59);
+    while (running.load(std::memory_order_acquire)) {
+      const auto pin = reader.pin();
+      const CostVersion& costs = versions.current();
+      bool whole = costs.hazard(0) == costs.hazard(m - 1);
+      for (int k = 0; k < 16; ++k) {
+        const EdgeId e = rng.below(m);
+        const Cost want = saturating_add(
+            hazard_adjusted_cost(base_travel_cost(g.edge_kind(e), g.edge_length(e)), costs.hazard(e)),
+            congestion_delay_cost(costs.congestion(e)));
+        whole = whole && costs.cost(e) == want;
+      }
+      torn.fetch_add(whole ? 0 : 1, std::memory_order_relaxed);
+      std::this_thread::yield();
+    }
+  });
+
+  SplitMix64 rng(b.spec.seed * 61);
+  ExitField reference;
+  Arena scratch;
+  std::vector<NodeId> origins(g.node_count());
+  for (NodeId v = 0; v < g.node_count(); ++v) origins[v] = v;
+  std::vector<GuidanceAnswer> answers(origins.size());
+  std::vector<double> ref_us;
+  std::vector<double> opt_us;
+  std::size_t failures = 0;
+  const std::size_t cases = quick ? 10 : 40;
+  for (std::size_t c = 0; c < cases; ++c) {
+    random_flips(g, rng, 1 + rng.below(16), [&](EdgeId e, float h) { router.set_edge_hazard(e, h); });
+    for (std::size_t k = rng.below(8); k > 0; --k) router.set_edge_congestion(rng.below(m), rng.uniform(0.0f, 30.0f));
+    const float sentinel = c % 2 == 0 ? 0.5f : 0.0f;
+    router.set_edge_hazard(0, sentinel);
+    router.set_edge_hazard(m - 1, sentinel);
+    opt_us.push_back(elapsed_us([&] { router.repair(); }));
+    ref_us.push_back(elapsed_us([&] { solve_exit_field(g, reference); }));
+    const CostVersion& costs = versions.current();
+    std::size_t bad = 0;
+    for (EdgeId e = 0; e < m; ++e) {
+      bad += costs.cost(e) != SmokeCost::arc_cost(g, e) || costs.hazard(e) != g.edge_hazard(e) ||
+             costs.congestion(e) != g.edge_congestion(e);
+    }
+    answer_batch(g, costs, origins, answers, scratch);
+    for (NodeId v = 0; v < g.node_count(); ++v) bad += answers[v].distance != reference.distance[v];
+    failures += bad != 0;
+    std::this_thread::yield();
+  }
+  running.store(false, std::memory_order_release);
+  reader_thread.join();
+  log.check("cost_versions", b.tag, "readers=1", cases, failures + torn.load(), median(ref_us), median(opt_us));
+}
+
+void check_district(Log& log, const Building& b, WorkStealingPool& pool, bool quick) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  PartitionParams params;
+  params.regions = std::clamp<std::uint32_t>(static_cast<std::uint32_t>(g.node_count() / 40), 1, 4);
+  District district(g, partition_building(g, params), pool);
+  district.exchange();
+  SplitMix64 rng(b.spec.seed * 47);
+  ExitField reference;
+  ExitField assembled;
+  std::vector<double> ref_us;
+  std::vector<double> opt_us;
+  std::size_t failures = 0;
+  const std::size_t cases = quick ? 5 : 20;
+  for (std::size_t c = 0; c < cases; ++c) {
+    random_flips(g, rng, 1 + rng.below(8), [&](EdgeId e, float h) {
+      g.set_edge_hazard(e, h);
+      district.set_edge_hazard(e, h);
+    });
+    opt_us.push_back(elapsed_us([&] { district.exchange(); }));
+    ref_us.push_back(elapsed_us([&] { solve_exit_field(g, reference); }));
+    district.export_field(assembled);
+    failures += distance_mismatches(assembled.distance, reference.distance) != 0;
+  }
+  log.check("district", b.tag, "regions=" + std::to_string(params.regions), cases, failures, median(ref_us),
+            median(opt_us));
+}
+
+// Random neighbour blocks around an agent, padded with the sentinel; every
+// kernel the CPU runs must return the scalar forces bit for bit.
+void check_force(Log& log, std::uint64_t seed, bool quick) {
+  SplitMix64 rng(seed * 53);
+  const RepulsionParams p;
+  for (const ForceIsa isa : {ForceIsa::Avx2, ForceIsa::Avx512}) {
+    ForceIsa chosen = ForceIsa::Scalar;
+    const RepulsionKernel kernel = select_repulsion_kernel(isa, &chosen);
+    if (chosen != isa) {
+      log.skip("force_isa", "random", std::string("isa=") + to_string(isa) + " unsupported");
+      continue;
+    }
+    aligned_vector<float> x;
+    aligned_vector<float> y;
+    aligned_vector<float> r;
+    std::vector<double> ref_us;
+    std::vector<double> opt_us;
+    std::size_t failures = 0;
+    const std::size_t cases = quick ? 2000 : 20000;
+    for (std::size_t c = 0; c < cases; ++c) {
+      const std::size_t count = rng.below(80);
+      const std::size_t padded = padded_neighbour_count(count);
+      x.assign(padded, kNeighbourSentinel);
+      y.assign(padded, kNeighbourSentinel);
+      r.assign(padded, 0.0f);
+      for (std::size_t k = 0; k < count; ++k) {
+        x[k] = rng.uniform(-2.5f, 2.5f);
+        y[k] = rng.uniform(-2.5f, 2.5f);
+        r[k] = rng.uniform(0.2f, 0.3f);
+      }
+      const NeighbourBlock nb{x.data(), y.data(), r.data(), padded};
+      float sx = 0.0f;
+      float sy = 0.0f;
+      float vx = 0.0f;
+      float vy = 0.0f;
+      ref_us.push_back(elapsed_us([&] { repulsion_scalar(0.0f, 0.0f, 0.25f, nb, p, sx, sy); }));
+      opt_us.push_back(elapsed_us([&] { kernel(0.0f, 0.0f, 0.25f, nb, p, vx, vy); }));
+      failures += std::memcmp(&sx, &vx, sizeof sx) != 0 || std::memcmp(&sy, &vy, sizeof sy) != 0;
+    }
+    log.check("force_isa", "random", std::string("isa=") + to_string(isa), cases, failures, median(ref_us),
+              median(opt_us));
+  }
+}
+
+std::uint64_t state_checksum(const AgentPopulation& agents) {
+  std::uint64_t h = 0xcbf29ce484222325ull;
+  const auto mix = [&](float f) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof bits);
+    for (int k = 0; k < 4; ++k) {
+      h ^= (bits >> (8 * k)) & 0xffu;
+      h *= 0x100000001b3ull;
+    }
+  };
+  for (std::size_t i = 0; i < agents.size(); ++i) {
+    mix(agents.x[i]);
+    mix(agents.y[i]);
+  }
+  return h;
+}
+
+// The reference is one worker with the scalar kernel; the tick is a Jacobi
+// update, so worker count and kernel must not change a bit of the state.
+void check_crowd(Log& log, const Building& b, bool quick) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  IncrementalRouter router(g);
+  const std::size_t agents_n = quick ? 300 : 1500;
+  const std::uint64_t ticks = quick ? 20 : 60;
+  const auto run = [&](unsigned workers, ForceIsa isa, double& us) {
+    WorkStealingPool pool(workers);
+    CrowdParams params;
+    params.isa = isa;
+    CrowdSimulator sim(g, pool, params);
+    sim.set_next_edges(router.next_edges());
+    AgentPopulation agents;
+    spawn_agents(g, agents_n, b.spec.seed, agents);
+    us = elapsed_us([&] {
+      for (std::uint64_t t = 0; t < ticks; ++t) sim.step(agents);
+    }) / static_cast<double>(ticks);
+    return state_checksum(agents);
+  };
+  double ref_us = 0.0;
+  const std::uint64_t want = run(1, ForceIsa::Scalar, ref_us);
+  for (const ForceIsa isa : {ForceIsa::Scalar, ForceIsa::Auto}) {
+    double us = 0.0;
+    const bool same = run(4, isa, us) == want;
+    log.check("crowd_threads", b.tag, std::string("w=4,isa=") + to_string(isa), 1, same ? 0 : 1, ref_us, us);
+  }
+#if EVAC_WITH_CUDA
+  if (crowd_backend_available(CrowdBackend::Cuda)) {
+    CudaCrowdSimulator sim(g);
+    sim.set_next_edges(router.next_edges());
+    AgentPopulation agents;
+    spawn_agents(g, agents_n, b.spec.seed, agents);
+    sim.upload(agents);
+    const double us = elapsed_us([&] {
+      for (std::uint64_t t = 0; t < ticks; ++t) sim.step();
+    }) / static_cast<double>(ticks);
+    sim.download(agents);
+    log.check("crowd_cuda", b.tag, "-", 1, state_checksum(agents) == want ? 0 : 1, ref_us, us);
+    return;
+  }
+#endif
+  log.skip("crowd_cuda", b.tag, "no-device");
+}
+
+// The hybrid model against itself: the head count (agents, flow and
+// evacuated) holds to rounding through activations, hazard changes and
+// repairs, and agents live only on active floors. The full social-force tick
+// on the same crowd is the reference timing.
+void check_lod(Log& log, const Building& b, WorkStealingPool& pool, bool quick) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  IncrementalRouter router(g);
+  SplitMix64 rng(b.spec.seed * 61);
+  random_flips(g, rng, 2, [&](EdgeId e, float h) { router.set_edge_hazard(e, h); });
+  router.repair();
+  AgentPopulation agents;
+  spawn_agents(g, quick ? 300 : 1500, b.spec.seed, agents);
+
+  HybridParams params;
+  params.calm_seconds = 5.0f;  // let floors come and go within the run
+  HybridCrowd lod(g, pool, params);
+  lod.set_next_edges(router.next_edges());
+  lod.load(agents);
+  CrowdSimulator full(g, pool);
+  full.set_next_edges(router.next_edges());
+
+  const double total = lod.people();
+  const std::size_t ticks = quick ? 300 : 1200;
+  std::vector<double> ref_us;
+  std::vector<double> opt_us;
+  std::size_t failures = 0;
+  for (std::size_t t = 0; t < ticks; ++t) {
+    if (t % 100 == 99) {
+      random_flips(g, rng, 2, [&](EdgeId e, float h) { router.set_edge_hazard(e, h); });
+      router.repair();
+      lod.set_next_edges(router.next_edges());
+      full.set_next_edges(router.next_edges());
+    }
+    opt_us.push_back(elapsed_us([&] { lod.step(); }));
+    ref_us.push_back(elapsed_us([&] { full.step(agents); }));
+    bool bad = std::abs(lod.people() - total) > 1e-6 * std::max(1.0, total);
+    for (int f = 0; f < g.floor_count(); ++f) {
+      const auto floor = static_cast<std::int16_t>(g.min_floor() + f);
+      const AgentPopulation& on = lod.floor_agents(floor);
+      bad |= !lod.floor_active(floor) && on.size() != 0;
+      for (std::size_t i = 0; i < on.size(); ++i) bad |= on.floor[i] != floor || on.evacuated[i] != 0;
+    }
+    failures += bad;
+  }
+  log.check("crowd_lod", b.tag, "mass", ticks, failures, median(ref_us), median(opt_us));
+}
+
+// People loaded on a flow floor whose waypoint is an exit, or a node of the
+// active top floor, must be counted out or become agents there at once
+// rather than wait in a node queue nothing releases.
+void check_lod_goals(Log& log, const Building& b, WorkStealingPool& pool) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  if (g.floor_count() < 2) {
+    log.skip("crowd_lod", b.tag, "one-floor");
+    return;
+  }
+  const auto top = static_cast<std::int16_t>(g.min_floor() + g.floor_count() - 1);
+  IncrementalRouter router(g);
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    if (g.node_floor(g.edge_source(e)) == top) {
+      router.set_edge_hazard(e, 0.5f);
+      break;
+    }
+  }
+  router.repair();
+
+  AgentPopulation agents;
+  std::size_t to_exit = 0;
+  std::size_t to_top = 0;
+  for (NodeId v = 0; v < g.node_count(); ++v) {
+    if (g.node_floor(v) == top) continue;
+    for (NodeId goal = 0; goal < g.node_count(); ++goal) {
+      const bool exit = g.node_kind(goal) == NodeKind::Exit;
+      if (!exit && (g.node_floor(goal) != top || g.node_kind(goal) != NodeKind::Room)) continue;
+      agents.add(g.node_x(v), g.node_y(v), g.node_floor(v), goal, 0.25f, 1.2f);
+      ++(exit ? to_exit : to_top);
+      if (!exit) break;  // one per start node keeps the top floor sparse
+    }
+  }
+
+  HybridCrowd lod(g, pool);
+  lod.set_next_edges(router.next_edges());
+  lod.load(agents);
+  std::vector<double> opt_us;
+  HybridStats stats;
+  opt_us.push_back(elapsed_us([&] { stats = lod.step(); }));
+  std::size_t failures = 0;
+  failures += !lod.floor_active(top);
+  failures += stats.evacuated < static_cast<double>(to_exit);
+  failures += lod.counters().spawned < to_top;
+  failures += std::abs(lod.people() - static_cast<double>(agents.size())) > 1e-6 * static_cast<double>(agents.size());
+  log.check("crowd_lod", b.tag, "goals", to_exit + to_top, failures, 0.0, median(opt_us));
+}
+
+template <class T, class Column>
+bool same_bits(std::span<const T> got, const Column& want) {
+  return got.size() == want.size() && std::memcmp(got.data(), want.data(), got.size() * sizeof(T)) == 0;
+}
+
+bool same_agents(const AgentPopulation& a, const AgentPopulation& b) {
+  return same_bits<float>(a.x, b.x) && same_bits<float>(a.y, b.y) && same_bits<float>(a.vx, b.vx) &&
+         same_bits<float>(a.vy, b.vy) && same_bits<float>(a.radius, b.radius) &&
+         same_bits<float>(a.desired_speed, b.desired_speed) && same_bits<std::int16_t>(a.floor, b.floor) &&
+         same_bits<NodeId>(a.goal, b.goal) && same_bits<std::uint8_t>(a.evacuated, b.evacuated);
+}
+
+// What a checkpoint must hold: the controller's columns at submit().
+struct Captured {
+  std::vector<float> hazard;
+  std::vector<float> congestion;
+  std::vector<Cost> distance;
+  std::vector<EdgeId> next_edge;
+  AgentPopulation agents;
+};
+
+bool restores(const RestoredState& r, const Captured& c) {
+  return same_bits<float>(r.edge_hazard, c.hazard) && same_bits<float>(r.edge_congestion, c.congestion) &&
+         same_bits<Cost>(r.distance, c.distance) && same_bits<EdgeId>(r.next_edge, c.next_edge) &&
+         same_agents(r.agents, c.agents);
+}
+
+// Checkpoints of a running crowd with hazards and queueing delays changing
+// between them: the newest one read back through the mapping is the last
+// capture bit for bit, and a standby router built from it has the distances
+// of a full solve on the restored building. Then the newest slot's header is
+// damaged on disk and the reader must fall back to the capture before it.
+// Reference timing is the cold router a standby would otherwise build.
+void check_checkpoint(Log& log, const Building& b, WorkStealingPool& pool, bool quick) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  IncrementalRouter router(g);
+  SplitMix64 rng(b.spec.seed * 67);
+  AgentPopulation agents;
+  spawn_agents(g, quick ? 200 : 800, b.spec.seed, agents);
+  CrowdSimulator sim(g, pool);
+  const std::string path = "regression_checkpoint_" + b.tag + ".ckpt";
+  CheckpointWriter writer(path, CheckpointShape{g.node_count(), g.edge_count(), 0, agents.size()});
+  const auto checkpoint = MappedCheckpoint::open(path);
+
+  const std::size_t cases = quick ? 6 : 20;
+  Captured last;
+  Captured previous;
+  RestoredState restored;
+  ExitField reference;
+  std::vector<double> ref_us;
+  std::vector<double> opt_us;
+  std::size_t failures = 0;
+  for (std::size_t c = 0; c < cases; ++c) {
+    random_flips(g, rng, 1 + rng.below(8), [&](EdgeId e, float h) { router.set_edge_hazard(e, h); });
+    router.set_edge_congestion(rng.below(static_cast<std::uint32_t>(g.edge_count())), rng.uniform(0.0f, 30.0f));
+    router.repair();
+    sim.set_next_edges(router.next_edges());
+    for (int t = 0; t < 5; ++t) sim.step(agents);
+    CheckpointState state;
+    state.time_us = c;
+    state.edge_hazard = g.edge_hazards();
+    state.edge_congestion = g.edge_congestions();
+    state.distance = router.distances();
+    state.next_edge = router.next_edges();
+    state.agents = &agents;
+    writer.submit(state);
+    previous = std::move(last);
+    last = {{state.edge_hazard.begin(), state.edge_hazard.end()},
+            {state.edge_congestion.begin(), state.edge_congestion.end()},
+            {state.distance.begin(), state.distance.end()},
+            {state.next_edge.begin(), state.next_edge.end()},
+            agents};
+    writer.flush();
+
+    BuildingGraph standby = make_synthetic_building(b.spec);
+    bool ok = false;
+    std::unique_ptr<IncrementalRouter> warm;
+    opt_us.push_back(elapsed_us([&] {
+      ok = read_latest_checkpoint(*checkpoint, restored);
+      apply_checkpoint(restored, standby);
+      warm = std::make_unique<IncrementalRouter>(standby, restored.distance, restored.next_edge);
+    }));
+    ref_us.push_back(elapsed_us([&] { IncrementalRouter cold(standby); }));
+    solve_exit_field(standby, reference);
+    failures += !ok || distance_mismatches(warm->distances(), reference.distance) != 0 || writer.failed() ||
+                restored.slot.time_us != c || !restores(restored, last) ||
+                !checkpoint->verify(checkpoint->latest_slot());
+  }
+
+  const int newest = checkpoint->latest_slot();
+  const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+  const std::uint64_t garbage = 0x5a5a5a5a5a5a5a5aull;
+  const bool damaged = fd >= 0 && newest >= 0 &&
+                       ::pwrite(fd, &garbage, sizeof garbage,
+                                static_cast<off_t>(slot_offset(checkpoint->header(), newest) +
+                                                   offsetof(SlotHeader, time_us))) == sizeof garbage;
+  if (fd >= 0) ::close(fd);
+  const bool fell_back = damaged && read_latest_checkpoint(*checkpoint, restored) &&
+                         checkpoint->latest_slot() == 1 - newest && restored.slot.time_us == cases - 2 &&
+                         restores(restored, previous);
+  std::remove(path.c_str());
+  log.check("checkpoint", b.tag, "round_trip", cases, failures, median(ref_us), median(opt_us));
+  log.check("checkpoint", b.tag, "torn_header", 1, fell_back ? 0 : 1, -1.0, -1.0);
+}
+
+// Arc betweenness by definition: for every ordered pair, the share of its
+// shortest paths through the arc, from all-pairs distances and path counts.
+std::vector<double> brute_force_betweenness(const BuildingGraph& g) {
+  const std::size_t n = g.node_count();
+  std::vector<Cost> cost(g.edge_count());
+  for (EdgeId e = 0; e < g.edge_count(); ++e) cost[e] = edge_cost(g, e);
+  std::vector<Cost> dist(n * n, kInfiniteCost);
+  std::vector<double> paths(n * n, 0.0);
+  for (NodeId s = 0; s < n; ++s) {
+    Cost* d = &dist[s * n];
+    double* sigma = &paths[s * n];
+    std::vector<bool> done(n, false);
+    d[s] = 0;
+    sigma[s] = 1.0;
+    for (;;) {  // O(n^2) Dijkstra: slow on purpose, no queue to get wrong
+      NodeId u = kInvalidNode;
+      for (NodeId v = 0; v < n; ++v) {
+        if (!done[v] && d[v] != kInfiniteCost && (u == kInvalidNode || d[v] < d[u])) u = v;
+      }
+      if (u == kInvalidNode) break;
+      done[u] = true;
+      for (EdgeId e : g.out_edges(u)) {
+        if (cost[e] == kInfiniteCost) continue;
+        const NodeId v = g.edge_target(e);
+        const Cost c = d[u] + cost[e];
+        if (c < d[v]) {
+          d[v] = c;
+          sigma[v] = sigma[u];
+        } else if (c == d[v]) {
+          sigma[v] += sigma[u];
+        }
+      }
+    }
+  }
+  std::vector<double> out(g.edge_count(), 0.0);
+  for (EdgeId e = 0; e < g.edge_count(); ++e) {
+    if (cost[e] == kInfiniteCost) continue;
+    const NodeId a = g.edge_source(e);
+    const NodeId b = g.edge_target(e);
+    for (NodeId s = 0; s < n; ++s) {
+      if (dist[s * n + a] == kInfiniteCost) continue;
+      for (NodeId t = 0; t < n; ++t) {
+        const Cost st = dist[s * n + t];
+        if (s == t || st == kInfiniteCost || dist[b * n + t] == kInfiniteCost) continue;
+        if (static_cast<std::uint64_t>(dist[s * n + a]) + cost[e] + dist[b * n + t] != st) continue;
+        out[e] += paths[s * n + a] * paths[b * n + t] / paths[s * n + t];
+      }
+    }
+  }
+  return out;
+}
+
+void check_criticality(Log& log, const Building& b, WorkStealingPool& pool) {
+  BuildingGraph g = make_synthetic_building(b.spec);
+  SplitMix64 rng(b.spec.seed * 59);
+  random_flips(g, rng, 4, [&](EdgeId e, float h) { g.set_edge_hazard(e, h); });
+
+  if (g.node_count() > 400) {
+    log.skip("betweenness", b.tag, "nodes>400");  // the reference is cubic
+  } else {
+    std::vector<double> want;
+    std::vector<float> got;
+    const double ref_us = elapsed_us([&] { want = brute_force_betweenness(g); });
+    const double opt_us = elapsed_us([&] { got = sampled_edge_betweenness(g, {g.node_count(), 1}, pool); });
+    std::size_t failures = 0;
+    for (EdgeId e = 0; e < g.edge_count(); ++e) {
+      failures += std::abs(got[e] - want[e]) > 1e-3 * std::max(1.0, want[e]);
+    }
+    log.check("betweenness", b.tag, "exact", g.edge_count(), failures, ref_us, opt_us);
+  }
+
+  // A cut is right when its arcs' capacities add up to the flow and removing
+  // them leaves no room with a route out.
+  ExitCut cut;
+  const double cut_us = elapsed_us([&] { cut = exit_min_cut(g); });
+  if (std::isinf(cut.capacity_pps)) {
+    log.skip("exit_cut", b.tag, "unbounded");
+    return;
+  }
+  double sum = 0.0;
+  for (const EdgeId e : cut.arcs) sum += g.edge_capacity(e);
+  for (const EdgeId e : cut.arcs) g.set_edge_hazard(e, kImpassableHazard);
+  ExitField field;
+  const double ref_cut_us = elapsed_us([&] { solve_exit_field(g, field); });
+  std::size_t escaping = 0;
+  for (NodeId v = 0; v < g.node_count(); ++v) {
+    escaping += g.node_kind(v) == NodeKind::Room && field.distance[v] != kInfiniteCost;
+  }
+  const bool sums = std::abs(sum - cut.capacity_pps) <= 1e-3 * std::max(1.0, sum);
+  log.check("exit_cut", b.tag, "site", cut.arcs.size(), escaping + (sums ? 0 : 1), ref_cut_us, cut_us);
+}
+
+// Replays a plan against the building: every wave walks a connected path
+// from its room to an exit, never leaves an arc before arriving at its tail,
+// and no layer carries more than an arc passes or a room holds. Returns the
+// number of violations.
+std::size_t plan_violations(const BuildingGraph& g, const PlannerOptions& options, const EvacuationPlan& plan) {
+  const auto key_of = [&](EdgeId e) {
+    const EdgeId twin = g.edge_twin(e);
+    return options.contraflow && twin != kInvalidEdge ? std::min(e, twin) : e;
+  };
+  const auto transit_of = [&](EdgeId e) {
+    const float layers = std::ceil(static_cast<float>(edge_cost(g, e)) / 10.0f / options.step_seconds);
+    return std::max<std::uint32_t>(1, static_cast<std::uint32_t>(layers));
+  };
+  std::map<std::pair<std::uint32_t, EdgeId>, std::uint64_t> arc_use;
+  std::map<std::pair<std::uint32_t, NodeId>, std::uint64_t> node_use;
+  std::size_t bad = 0;
+  for (const PlannedRoute& r : plan.routes) {
+    std::uint64_t people = 0;
+    bad += r.edges.empty() || g.edge_source(r.edges.front()) != r.source ||
+           g.node_kind(g.edge_target(r.edges.back())) != NodeKind::Exit;
+    for (std::size_t i = 1; i < r.edges.size(); ++i) bad += g.edge_source(r.edges[i]) != g.edge_target(r.edges[i - 1]);
+    for (const PlannedWave& w : r.waves) {
+      people += w.people;
+      if (w.depart_layers.size() != r.edges.size()) {
+        ++bad;
+        continue;
+      }
+      for (std::size_t i = 0; i < r.edges.size(); ++i) {
+        arc_use[{w.depart_layers[i], key_of(r.edges[i])}] += w.people;
+        if (i == 0) continue;
+        const std::uint32_t arrive = w.depart_layers[i - 1] + transit_of(r.edges[i - 1]);
+        bad += w.depart_layers[i] < arrive || w.depart_layers[i] > arrive + options.max_wait_layers;
+        for (std::uint32_t t = arrive; t <= w.depart_layers[i]; ++t) {
+          node_use[{t, g.edge_source(r.edges[i])}] += w.people;
+        }
+      }
+      bad += w.arrive_layer != w.depart_layers.back() + transit_of(r.edges.back());
+    }
+    bad += people != r.people;
+  }
+  for (const auto& [at, used] : arc_use) {
+    const EdgeId e = at.second;
+    double pps = g.edge_capacity(e);
+    if (pps <= 0.0) continue;
+    if (options.contraflow && g.edge_twin(e) != kInvalidEdge) pps += g.edge_capacity(g.edge_twin(e));
+    const double rate = pps * options.step_seconds;
+    const double cap = std::floor((at.first + 1.0) * rate) - std::floor(at.first * rate);
+    bad += static_cast<double>(used) > cap;
+  }
+  for (const auto& [at, used] : node_use) {
+    const std::uint32_t cap = g.node_capacity(at.second);
+    bad += cap != 0 && used > cap;
+  }
+  return bad;
+}
+
+// Rooms filled to capacity: everyone must get out (the synthetic buildings
+// are connected and drain well within the horizon), with a plan that replays
+// cleanly.
+void check_planner(Log& log, const Building& b) {
+  const BuildingGraph g = make_synthetic_building(b.spec);
+  std::vector<OccupantGroup> occupants;
+  std::uint64_t total = 0;
+  for (NodeId v = 0; v < g.node_count(); ++v) {
+    if (g.node_kind(v) != NodeKind::Room) continue;
+    occupants.push_back({v, g.node_capacity(v)});
+    total += g.node_capacity(v);
+  }
+  for (const bool contraflow : {false, true}) {
+    PlannerOptions options;
+    options.contraflow = contraflow;
+    EvacuationPlan plan;
+    const double opt_us = elapsed_us([&] { plan = FlowPlanner(g, options).plan(occupants); });
+    std::size_t bad = 0;
+    const double ref_us = elapsed_us([&] { bad = plan_violations(g, options, plan); });
+    bad += plan.stranded != 0 || plan.evacuated != total;
+    log.check("planner", b.tag, contraflow ? "contraflow" : "people=" + std::to_string(total), plan.routes.size(),
+              bad, ref_us, opt_us);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool quick = false;
+  std::string out = "test_output.txt";
+  std::uint64_t seed = 2024;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--quick") {
+      quick = true;
+    } else if (a == "--out" && i + 1 < argc) {
+      out = argv[++i];
+    } else if (a == "--seed" && i + 1 < argc) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::fprintf(stderr, "usage: regression [--quick] [--out path] [--seed s]\n");
+      return 2;
+    }
+  }
+  std::FILE* f = std::fopen(out.c_str(), "w");
+  if (!f) {
+    std::fprintf(stderr, "%s: cannot write results\n", out.c_str());
+    return 1;
+  }
+
+  Log log(f);
+  WorkStealingPool pool(std::max(2u, std::thread::hardware_concurrency()));
+  check_force(log, seed, quick);
+  for (const Building& b : random_buildings(seed, quick)) {
+    check_incremental<SmokeCost>(log, b, quick);
+    check_incremental<DistanceCost>(log, b, quick);
+    check_incremental<AccessibleCost>(log, b, quick);
+    check_from_table(log, b, pool, quick);
+    check_radix(log, b, quick);
+    check_overlay(log, b, quick);
+    check_cost_versions(log, b, quick);
+    check_district(log, b, pool, quick);
+    check_crowd(log, b, quick);
+    check_lod(log, b, pool, quick);
+    check_lod_goals(log, b, pool);
+    check_checkpoint(log, b, pool, quick);
+    check_criticality(log, b, pool);
+    check_planner(log, b);
+  }
+  if (!quick) {
+    SyntheticSpec tower{20, 80, 4};
+    check_planner(log, {tower, tower.tag()});
+  }
+  std::fprintf(f, "%zu checks, %zu failed\n", log.checks(), log.failed());
+  std::printf("%zu checks, %zu failed\n", log.checks(), log.failed());
+  std::fclose(f);
+  return log.failed() == 0 ? 0 : 1;
+}